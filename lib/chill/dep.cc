@@ -21,6 +21,10 @@
 *****************************************************************************/
 
 #include "dep.hh"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
 
 //-----------------------------------------------------------------------------
 // Class: DependeceVector
@@ -328,6 +332,26 @@ bool DependenceVector::canPermute(const std::vector<int> &pi) const {
   return true;
 }
 
+// Whether permuting by pi would make this dependence lexicographically
+// negative, which permute() reports as a dependence violation.
+bool DependenceVector::violatesPermutation(const std::vector<int> &pi) const {
+  if (pi.size() != lbounds.size())
+    throw std::invalid_argument(
+                                "permute dimensionality do not match dependence space");
+  
+  if (quasi || is_scalar_dependence)
+    return false;
+  
+  for (size_t i = 0; i < pi.size(); i++) {
+    if (lbounds[pi[i]] > 0)
+      return false;
+    else if (lbounds[pi[i]] < 0)
+      return true;
+  }
+  
+  return false;
+}
+
 std::vector<DependenceVector> DependenceVector::normalize() const {
   std::vector<DependenceVector> result;
   
@@ -370,19 +394,8 @@ std::vector<DependenceVector> DependenceVector::permute(
     dv.ubounds[i] = ubounds[pi[i]];
   }
   
-  int violated = 0;
-  
-  for (int i = 0; i < n; i++) {
-    if (dv.lbounds[i] > 0)
-      break;
-    else if (dv.lbounds[i] < 0)
-      violated = 1;
-  }
-  
-  if (((violated == 1) && !quasi) && !is_scalar_dependence) {
+  if (violatesPermutation(pi))
     throw ir_error("dependence violation");
-    
-  }
   
   return dv.normalize();
 }
@@ -506,6 +519,42 @@ DependenceGraph DependenceGraph::permute(const std::vector<int> &pi,
   return g;
 }
 
+bool DependenceGraph::canPermute(const std::vector<int> &pi,
+                                 const std::set<int> &active) const {
+  std::vector<DependenceEdge> batch;
+  getEdges(active, active, batch);
+  return findViolation(batch, [&pi](const DependenceEdge &e) {
+      return e.dv->violatesPermutation(pi);
+    }) < 0;
+}
+
+void DependenceGraph::getEdges(int from, int to,
+                               std::vector<DependenceEdge> &batch) const {
+  EdgeList::const_iterator j = vertex[from].second.find(to);
+  if (j == vertex[from].second.end())
+    return;
+  for (size_t k = 0; k < j->second.size(); k++) {
+    DependenceEdge e = {from, to, &j->second[k]};
+    batch.push_back(e);
+  }
+}
+
+void DependenceGraph::getEdges(const std::set<int> &from,
+                               const std::set<int> &to,
+                               std::vector<DependenceEdge> &batch) const {
+  for (size_t i = 0; i < vertex.size(); i++) {
+    if (!from.empty() && from.find(i) == from.end())
+      continue;
+    for (EdgeList::const_iterator j = vertex[i].second.begin();
+         j != vertex[i].second.end(); j++)
+      if (to.empty() || to.find(j->first) != to.end())
+        for (size_t k = 0; k < j->second.size(); k++) {
+          DependenceEdge e = {static_cast<int>(i), j->first, &j->second[k]};
+          batch.push_back(e);
+        }
+  }
+}
+
 // DependenceGraph DependenceGraph::matrix(const std::vector<std::vector<int> > &M) const {
 //   DependenceGraph g;
 
@@ -574,3 +623,68 @@ bool DependenceGraph::hasNegative(int dim) const {
   
   return true;
 }
+
+
+//-----------------------------------------------------------------------------
+// Batched legality checks
+//-----------------------------------------------------------------------------
+
+namespace {
+  // Each check is a handful of comparisons, so threads only pay off once
+  // every worker gets a few thousand dependence vectors.
+  const int min_vectors_per_thread = 2048;
+}
+
+int findViolation(const std::vector<DependenceEdge> &batch,
+                  const std::function<bool(const DependenceEdge &)> &violates) {
+  const int n = batch.size();
+  int n_threads = std::min<int>(std::thread::hardware_concurrency(),
+                                n / min_vectors_per_thread);
+  if (n_threads < 2) {
+    for (int i = 0; i < n; i++)
+      if (violates(batch[i]))
+        return i;
+    return -1;
+  }
+
+  // first is the lowest index known to violate (or to have thrown); a
+  // worker gives up on its range once it passes first.
+  std::atomic<int> first(n);
+  std::vector<int> thrown_at(n_threads, n);
+  std::vector<std::exception_ptr> errors(n_threads);
+  auto work = [&](int t) {
+    int lo = (long long)n * t / n_threads;
+    int hi = (long long)n * (t + 1) / n_threads;
+    for (int i = lo; i < hi && i < first.load(std::memory_order_relaxed); i++) {
+      bool found;
+      try {
+        found = violates(batch[i]);
+      } catch (...) {
+        errors[t] = std::current_exception();
+        thrown_at[t] = i;
+        found = true;
+      }
+      if (found) {
+        int cur = first.load();
+        while (i < cur && !first.compare_exchange_weak(cur, i))
+          ;
+        return;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (int t = 1; t < n_threads; t++)
+    workers.push_back(std::thread(work, t));
+  work(0);
+  for (size_t t = 0; t < workers.size(); t++)
+    workers[t].join();
+
+  int result = first.load();
+  if (result == n)
+    return -1;
+  for (int t = 0; t < n_threads; t++)
+    if (thrown_at[t] == result)
+      std::rethrow_exception(errors[t]);
+  return result;
+}
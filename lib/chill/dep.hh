@@ -14,6 +14,7 @@
  * dependence vectors are returned.
  */
 
+#include <functional>
 #include <omega.h>
 #include "graph.hh"
 #include "ir_code.hh"
@@ -69,6 +70,7 @@ struct DependenceVector {
   bool hasNegative(int dim) const;
   bool isCarried(int dim, omega::coef_t distance = posInfinity) const;
   bool canPermute(const std::vector<int> &pi) const;
+  bool violatesPermutation(const std::vector<int> &pi) const;
   
   std::vector<DependenceVector> normalize() const;
   std::vector<DependenceVector> permute(const std::vector<int> &pi) const;
@@ -80,6 +82,15 @@ struct DependenceVector {
 
 
 
+//! One dependence vector of a DependenceGraph and the edge it labels.
+struct DependenceEdge {
+  int from;
+  int to;
+  const DependenceVector *dv;
+};
+
+
+
 class DependenceGraph: public Graph<Empty, DependenceVector> {
   
 protected:
@@ -95,9 +106,27 @@ public:
                           const std::set<int> &active = std::set<int>()) const;
   // DependenceGraph matrix(const std::vector<std::vector<int> > &M) const;
   DependenceGraph subspace(int dim) const;
+  //! Same check permute() makes, without building the permuted graph.
+  bool canPermute(const std::vector<int> &pi,
+                  const std::set<int> &active = std::set<int>()) const;
+  void getEdges(int from, int to, std::vector<DependenceEdge> &batch) const;
+  //! Edges from a statement in \a from to one in \a to; an empty set
+  //! stands for every statement.
+  void getEdges(const std::set<int> &from, const std::set<int> &to,
+                std::vector<DependenceEdge> &batch) const;
   bool isPositive() const;
   bool hasPositive(int dim) const;
   bool hasNegative(int dim) const;
 };
 
+/*!
+ * \brief Index of the first entry in \a batch that \a violates, or -1.
+ *
+ * Large batches are split over worker threads, which stop once an earlier
+ * entry is known to violate, so the answer is the same as a serial scan.
+ * \a violates must only read the Loop and the dependence graph.
+ */
+int findViolation(const std::vector<DependenceEdge> &batch,
+                  const std::function<bool(const DependenceEdge &)> &violates);
+
 #endif
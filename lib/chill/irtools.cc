@@ -258,6 +258,36 @@ std::vector<omega::CG_outputRepr *> collect_loop_inductive_and_conditionals(
 }
 
 
+// relation2dependences through the dependence cache. The relation string
+// does not name the array, so the symbol of a cached vector is replaced
+// with the one of this reference.
+static std::pair<std::vector<DependenceVector>, std::vector<DependenceVector> > cached_relation2dependences(
+  const IR_ArrayRef *ref_src, const IR_ArrayRef *ref_dst, const Relation &r, DependenceCache *cache) {
+  if (cache == NULL)
+    return relation2dependences(ref_src, ref_dst, r);
+  
+  std::string key;
+  key += ref_src->is_write() ? 'w' : 'r';
+  key += ref_dst->is_write() ? 'w' : 'r';
+  key += *ref_src == *ref_dst ? '=' : '~';
+  key += copy(r).print_with_subs_to_string(true);
+  
+  DependenceCache::iterator it = cache->find(key);
+  if (it == cache->end())
+    return (*cache)[key] = relation2dependences(ref_src, ref_dst, r);
+  
+  std::pair<std::vector<DependenceVector>, std::vector<DependenceVector> > dv = it->second;
+  for (size_t k = 0; k < dv.first.size(); k++) {
+    delete dv.first[k].sym;
+    dv.first[k].sym = ref_src->symbol();
+  }
+  for (size_t k = 0; k < dv.second.size(); k++) {
+    delete dv.second[k].sym;
+    dv.second[k].sym = ref_src->symbol();
+  }
+  return dv;
+}
+
 // Test data dependences between two statements. The first statement
 // in parameter must be lexically before the second statement in
 // parameter.  Returned dependences are all lexicographically
@@ -271,7 +301,8 @@ std::pair<std::vector<DependenceVector>, std::vector<DependenceVector> > test_da
                                                                                                int nestLeveli, int nestLevelj, std::map<std::string, std::vector<omega::CG_outputRepr * > > &uninterpreted_symbols,
                                                                                                std::map<std::string, std::vector<omega::CG_outputRepr * > > &uninterpreted_symbols_stringrepr,
                                                                                                std::map<std::string, std::vector<omega::Relation > > &unin_rel,
-                                                                                               std::vector<omega::Relation> &dep_relation) {
+                                                                                               std::vector<omega::Relation> &dep_relation,
+                                                                                               DependenceCache *cache) {
   std::pair<std::vector<DependenceVector>, std::vector<DependenceVector> > result;
 
   if (repr1 == repr2) {
@@ -318,7 +349,7 @@ std::pair<std::vector<DependenceVector>, std::vector<DependenceVector> > test_da
 
           std::pair<std::vector<DependenceVector>,
               std::vector<DependenceVector> > dv =
-              relation2dependences(a, b, r);
+              cached_relation2dependences(a, b, r, cache);
 
           // Manu:: check if the array references belong to the same statement
           // If yes, set the flag in the dependence vector
@@ -402,7 +433,7 @@ std::pair<std::vector<DependenceVector>, std::vector<DependenceVector> > test_da
           dep_relation.push_back(copy(r));
           std::pair<std::vector<DependenceVector>,
               std::vector<DependenceVector> > dv =
-              relation2dependences(a, b, r);
+              cached_relation2dependences(a, b, r, cache);
 
           result.first.insert(result.first.end(), dv.first.begin(),
                               dv.first.end());
@@ -59,6 +59,16 @@ std::vector<ir_tree_node *> extract_ir_stmts(
 
 bool is_dependence_valid(ir_tree_node *src_node, ir_tree_node *dst_node,
                          const DependenceVector &dv, bool before);
+/*!
+ * @brief Dependence vectors of reference pairs already tested
+ *
+ * Keyed by the dependence relation of the pair, which already encodes both
+ * access functions and iteration spaces, and by the kinds of the two
+ * references. Rebuilding the dependence graph after a transformation then
+ * only runs relation2dependences for pairs whose statements changed.
+ */
+typedef std::map<std::string, std::pair<std::vector<DependenceVector>, std::vector<DependenceVector> > > DependenceCache;
+
 /*!
  * @brief test data dependeces between two statements
  *
@@ -79,6 +89,7 @@ bool is_dependence_valid(ir_tree_node *src_node, ir_tree_node *dst_node,
  * @param uninterpreted_symbols_stringrepr
  * @param unin_rel
  * @param dep_relation
+ * @param cache results of earlier reference pair tests, or NULL
  * @return
  */
 std::pair<std::vector<DependenceVector>, std::vector<DependenceVector> > test_data_dependences(Loop *loop,
@@ -88,7 +99,8 @@ std::pair<std::vector<DependenceVector>, std::vector<DependenceVector> > test_da
                                                                                                int nestLeveli, int nestLevelj, std::map<std::string, std::vector<omega::CG_outputRepr * > > &uninterpreted_symbols,
                                                                                                std::map<std::string, std::vector<omega::CG_outputRepr * > > &uninterpreted_symbols_stringrepr,
                                                                                                std::map<std::string, std::vector<omega::Relation > > &unin_rel,
-                                                                                               std::vector<omega::Relation> &dep_relation);
+                                                                                               std::vector<omega::Relation> &dep_relation,
+                                                                                               DependenceCache *cache = NULL);
 
 std::vector<omega::CG_outputRepr *> collect_loop_inductive_and_conditionals(ir_tree_node * stmt_node);
 
@@ -978,7 +978,8 @@ Loop::Loop(const IR_Control *control) {
                                                                            stmt_nesting_level_[i],
                                                                            stmt_nesting_level_[j],
                                                                            uninterpreted_symbols[i],
-                                                                           uninterpreted_symbols_stringrepr[i], unin_rel[i], dep_relation);
+                                                                           uninterpreted_symbols_stringrepr[i], unin_rel[i], dep_relation,
+                                                                           &dep_cache);
       
       debug_fprintf(stderr, "dv.first.size() %d\n", (int)dv.first.size()); 
       for (int k = 0; k < dv.first.size(); k++) {
@@ -140,6 +140,7 @@ public:
   std::map<std::string, int> array_dims;
   DependenceGraph dep;
   std::vector<omega::Relation> dep_relation; // TODO What is this for: Anand's
+  DependenceCache dep_cache; // reference pairs tested so far, reused when the graph is rebuilt
   int num_dep_dim;
   omega::Relation known;
   omega::CG_outputRepr *init_code;
@@ -64,6 +64,36 @@ void Loop::permute(int stmt_num, int level, const std::vector<int> &pi) {
       throw std::invalid_argument(
         "invalid permutation for statement " + to_string(*i));
 
+  // get the permuation for dependence vectors
+  std::vector<int> t;
+  for (int i = 0; i < pi.size(); i++)
+    if (stmt[stmt_num].loop_level[pi[i] - 1].type == LoopLevelOriginal)
+      t.push_back(stmt[stmt_num].loop_level[pi[i] - 1].payload);
+  int max_dep_dim = -1;
+  int min_dep_dim = dep.num_dim();
+  for (int i = 0; i < t.size(); i++) {
+    if (t[i] > max_dep_dim)
+      max_dep_dim = t[i];
+    if (t[i] < min_dep_dim)
+      min_dep_dim = t[i];
+  }
+  std::vector<int> dep_pi;
+  if (min_dep_dim <= max_dep_dim) {
+    if (max_dep_dim - min_dep_dim + 1 != t.size())
+      throw loop_error("cannot update the dependence graph after permuation");
+    dep_pi.resize(dep.num_dim());
+    for (int i = 0; i < min_dep_dim; i++)
+      dep_pi[i] = i;
+    for (int i = min_dep_dim; i <= max_dep_dim; i++)
+      dep_pi[i] = t[i - min_dep_dim];
+    for (int i = max_dep_dim + 1; i < dep.num_dim(); i++)
+      dep_pi[i] = i;
+    
+    // check legality before touching any statement
+    if (!dep.canPermute(dep_pi, active))
+      throw ir_error("dependence violation");
+  }
+
   invalidateCodeGen();
 
   // Update transformation relations
@@ -95,32 +125,8 @@ void Loop::permute(int stmt_num, int level, const std::vector<int> &pi) {
     stmt[*i].xform.simplify();
   }
   
-  // get the permuation for dependence vectors
-  std::vector<int> t;
-  for (int i = 0; i < pi.size(); i++)
-    if (stmt[stmt_num].loop_level[pi[i] - 1].type == LoopLevelOriginal)
-      t.push_back(stmt[stmt_num].loop_level[pi[i] - 1].payload);
-  int max_dep_dim = -1;
-  int min_dep_dim = dep.num_dim();
-  for (int i = 0; i < t.size(); i++) {
-    if (t[i] > max_dep_dim)
-      max_dep_dim = t[i];
-    if (t[i] < min_dep_dim)
-      min_dep_dim = t[i];
-  }
-  if (min_dep_dim > max_dep_dim)
+  if (dep_pi.empty())
     return;
-  if (max_dep_dim - min_dep_dim + 1 != t.size())
-    throw loop_error("cannot update the dependence graph after permuation");
-  std::vector<int> dep_pi(dep.num_dim());
-  for (int i = 0; i < min_dep_dim; i++)
-    dep_pi[i] = i;
-  for (int i = min_dep_dim; i <= max_dep_dim; i++)
-    dep_pi[i] = t[i - min_dep_dim];
-  for (int i = max_dep_dim + 1; i < dep.num_dim(); i++)
-    dep_pi[i] = i;
-  
-  dep.permute(dep_pi, active);
   
   // update the dependence graph
   DependenceGraph g(dep.num_dim());
@@ -295,6 +301,36 @@ void Loop::permute(const std::set<int> &active, const std::vector<int> &pi) {
     }
   }
 
+  // get the permuation for dependence vectors
+  std::vector<int> t;
+  for (int i = 0; i < pi.size(); i++)
+    if (stmt[ref_stmt_num].loop_level[pi[i] - 1].type == LoopLevelOriginal)
+      t.push_back(stmt[ref_stmt_num].loop_level[pi[i] - 1].payload);
+  int max_dep_dim = -1;
+  int min_dep_dim = num_dep_dim;
+  for (int i = 0; i < t.size(); i++) {
+    if (t[i] > max_dep_dim)
+      max_dep_dim = t[i];
+    if (t[i] < min_dep_dim)
+      min_dep_dim = t[i];
+  }
+  std::vector<int> dep_pi;
+  if (min_dep_dim <= max_dep_dim) {
+    if (max_dep_dim - min_dep_dim + 1 != t.size())
+      throw loop_error("cannot update the dependence graph after permuation");
+    dep_pi.resize(num_dep_dim);
+    for (int i = 0; i < min_dep_dim; i++)
+      dep_pi[i] = i;
+    for (int i = min_dep_dim; i <= max_dep_dim; i++)
+      dep_pi[i] = t[i - min_dep_dim];
+    for (int i = max_dep_dim + 1; i < num_dep_dim; i++)
+      dep_pi[i] = i;
+    
+    // check legality before touching any statement
+    if (!dep.canPermute(dep_pi, active))
+      throw ir_error("dependence violation");
+  }
+
   invalidateCodeGen();
 
   // Update transformation relations
@@ -327,32 +363,9 @@ void Loop::permute(const std::set<int> &active, const std::vector<int> &pi) {
     stmt[*i].xform.simplify();
   }
   
-  // get the permuation for dependence vectors
-  std::vector<int> t;
-  for (int i = 0; i < pi.size(); i++)
-    if (stmt[ref_stmt_num].loop_level[pi[i] - 1].type == LoopLevelOriginal)
-      t.push_back(stmt[ref_stmt_num].loop_level[pi[i] - 1].payload);
-  int max_dep_dim = -1;
-  int min_dep_dim = num_dep_dim;
-  for (int i = 0; i < t.size(); i++) {
-    if (t[i] > max_dep_dim)
-      max_dep_dim = t[i];
-    if (t[i] < min_dep_dim)
-      min_dep_dim = t[i];
-  }
-  if (min_dep_dim > max_dep_dim)
+  if (dep_pi.empty())
     return;
-  if (max_dep_dim - min_dep_dim + 1 != t.size())
-    throw loop_error("cannot update the dependence graph after permuation");
-  std::vector<int> dep_pi(num_dep_dim);
-  for (int i = 0; i < min_dep_dim; i++)
-    dep_pi[i] = i;
-  for (int i = min_dep_dim; i <= max_dep_dim; i++)
-    dep_pi[i] = t[i - min_dep_dim];
-  for (int i = max_dep_dim + 1; i < num_dep_dim; i++)
-    dep_pi[i] = i;
-  
-  dep.permute(dep_pi, active);
+  
   
   // update the dependence graph
   DependenceGraph g(dep.num_dim());
@@ -926,6 +939,81 @@ void Loop::skew(const std::set<int> &stmt_nums, int level,
         throw std::invalid_argument("invalid skewing formula");
   }
 
+  // bounds at the skewed loop level of a dependence from statement s
+  auto skewed_bounds = [&](int s, const DependenceVector &dv,
+                           coef_t &lb, coef_t &ub) {
+    lb = 0;
+    ub = 0;
+    for (int kk = 0; kk < skew_amount.size(); kk++) {
+      int cur_dep_dim = get_dep_dim_of(s, kk + 1);
+      if (skew_amount[kk] > 0) {
+        if (lb != -posInfinity
+            && stmt[s].loop_level[kk].type == LoopLevelOriginal
+            && dv.lbounds[cur_dep_dim] != -posInfinity)
+          lb += skew_amount[kk] * dv.lbounds[cur_dep_dim];
+        else {
+          if (cur_dep_dim != -1
+              && !(dv.lbounds[cur_dep_dim] == 0
+                   && dv.ubounds[cur_dep_dim]== 0))
+            lb = -posInfinity;
+        }
+        if (ub != posInfinity
+            && stmt[s].loop_level[kk].type == LoopLevelOriginal
+            && dv.ubounds[cur_dep_dim] != posInfinity)
+          ub += skew_amount[kk] * dv.ubounds[cur_dep_dim];
+        else {
+          if (cur_dep_dim != -1
+              && !(dv.lbounds[cur_dep_dim] == 0
+                   && dv.ubounds[cur_dep_dim] == 0))
+            ub = posInfinity;
+        }
+      } else if (skew_amount[kk] < 0) {
+        if (lb != -posInfinity
+            && stmt[s].loop_level[kk].type == LoopLevelOriginal
+            && dv.ubounds[cur_dep_dim] != posInfinity)
+          lb += skew_amount[kk] * dv.ubounds[cur_dep_dim];
+        else {
+          if (cur_dep_dim != -1
+              && !(dv.lbounds[cur_dep_dim] == 0
+                   && dv.ubounds[cur_dep_dim] == 0))
+            lb = -posInfinity;
+        }
+        if (ub != posInfinity
+            && stmt[s].loop_level[kk].type == LoopLevelOriginal
+            && dv.lbounds[cur_dep_dim] != -posInfinity)
+          ub += skew_amount[kk] * dv.lbounds[cur_dep_dim];
+        else {
+          if (cur_dep_dim != -1
+              && !(dv.lbounds[cur_dep_dim] == 0
+                   && dv.ubounds[cur_dep_dim] == 0))
+            ub = posInfinity;
+        }
+      }
+    }
+  };
+
+  // check legality before touching any statement
+  if (stmt[ref_stmt_num].loop_level[level - 1].type == LoopLevelOriginal) {
+    int dep_dim = stmt[ref_stmt_num].loop_level[level - 1].payload;
+    std::vector<DependenceEdge> batch;
+    dep.getEdges(stmt_nums, stmt_nums, batch);
+    int k = findViolation(batch, [&](const DependenceEdge &e) {
+        if (!e.dv->is_data_dependence())
+          return false;
+        // bounds only, a full copy would clone the symbol
+        DependenceVector dv;
+        dv.lbounds = e.dv->lbounds;
+        dv.ubounds = e.dv->ubounds;
+        skewed_bounds(e.from, *e.dv, dv.lbounds[dep_dim], dv.ubounds[dep_dim]);
+        bool quasi = e.dv->quasi
+          && !(dv.isCarried(dep_dim) && dv.hasPositive(dep_dim));
+        return dv.isCarried(dep_dim) && dv.hasNegative(dep_dim) && !quasi;
+      });
+    if (k >= 0)
+      throw loop_error(
+        "loop error: Skewing is illegal, dependence violation!");
+  }
+
   invalidateCodeGen();
 
   // set trasformation relations
@@ -964,74 +1052,13 @@ void Loop::skew(const std::set<int> &stmt_nums, int level,
           for (int k = 0; k < dvs.size(); k++) {
             DependenceVector &dv = dvs[k];
             if (dv.is_data_dependence()) {
-              coef_t lb = 0;
-              coef_t ub = 0;
-              for (int kk = 0; kk < skew_amount.size(); kk++) {
-                int cur_dep_dim = get_dep_dim_of(*i, kk + 1);
-                if (skew_amount[kk] > 0) {
-                  if (lb != -posInfinity
-                      && stmt[*i].loop_level[kk].type == LoopLevelOriginal
-                      && dv.lbounds[cur_dep_dim] != -posInfinity)
-                    lb += skew_amount[kk] * dv.lbounds[cur_dep_dim];
-                  else {
-                    if (cur_dep_dim != -1
-                        && !(dv.lbounds[cur_dep_dim] == 0
-                             && dv.ubounds[cur_dep_dim]== 0))
-                      lb = -posInfinity;
-                  }
-                  if (ub != posInfinity
-                      && stmt[*i].loop_level[kk].type == LoopLevelOriginal
-                      && dv.ubounds[cur_dep_dim] != posInfinity)
-                    ub += skew_amount[kk] * dv.ubounds[cur_dep_dim];
-                  else {
-                    if (cur_dep_dim != -1
-                        && !(dv.lbounds[cur_dep_dim] == 0
-                             && dv.ubounds[cur_dep_dim] == 0))
-                      ub = posInfinity;
-                  }
-                } else if (skew_amount[kk] < 0) {
-                  if (lb != -posInfinity
-                      && stmt[*i].loop_level[kk].type == LoopLevelOriginal
-                      && dv.ubounds[cur_dep_dim] != posInfinity)
-                    lb += skew_amount[kk] * dv.ubounds[cur_dep_dim];
-                  else {
-                    if (cur_dep_dim != -1
-                        && !(dv.lbounds[cur_dep_dim] == 0
-                             && dv.ubounds[cur_dep_dim] == 0))
-                      lb = -posInfinity;
-                  }
-                  if (ub != posInfinity
-                      && stmt[*i].loop_level[kk].type == LoopLevelOriginal
-                      && dv.lbounds[cur_dep_dim] != -posInfinity)
-                    ub += skew_amount[kk] * dv.lbounds[cur_dep_dim];
-                  else {
-                    if (cur_dep_dim != -1
-                        && !(dv.lbounds[cur_dep_dim] == 0
-                             && dv.ubounds[cur_dep_dim] == 0))
-                      ub = posInfinity;
-                  }
-                }
-              }
+              coef_t lb, ub;
+              skewed_bounds(*i, dv, lb, ub);
               dv.lbounds[dep_dim] = lb;
               dv.ubounds[dep_dim] = ub;
               if ((dv.isCarried(dep_dim) && dv.hasPositive(dep_dim)) 
                   && dv.quasi)
                 dv.quasi = false;
-              
-              if ((dv.isCarried(dep_dim) && dv.hasNegative(dep_dim)) 
-                  && !dv.quasi)
-                throw loop_error(
-                  "loop error: Skewing is illegal, dependence violation!");
-              dv.lbounds[dep_dim] = lb;
-              dv.ubounds[dep_dim] = ub;
-              if ((dv.isCarried(dep_dim)
-                   && dv.hasPositive(dep_dim)) && dv.quasi)
-                dv.quasi = false;
-              
-              if ((dv.isCarried(dep_dim)
-                   && dv.hasNegative(dep_dim)) && !dv.quasi)
-                throw loop_error(
-                  "loop error: Skewing is illegal, dependence violation!");
             }
           }
           j->second = dvs;
@@ -1220,6 +1247,7 @@ void Loop::fuse(const std::set<int> &stmt_nums, int level) {
   
   int dep_dim = get_dep_dim_of(ref_stmt_num, level);
   
+  std::vector<DependenceEdge> batch;
   for (std::set<int>::iterator i = lex_values.begin(); i != lex_values.end();
        i++) {
     ref_lex[dim - 1] = *i;
@@ -1232,26 +1260,19 @@ void Loop::fuse(const std::set<int> &stmt_nums, int level) {
       for (std::set<int>::iterator ii = a.begin(); ii != a.end(); ii++)
         for (std::set<int>::iterator jj = b.begin(); jj != b.end();
              jj++) {
-          std::vector<DependenceVector> dvs;
-          dvs = dep.getEdge(*ii, *jj);
-          for (int k = 0; k < dvs.size(); k++)
-            if (dvs[k].isCarried(dep_dim)
-                && dvs[k].hasNegative(dep_dim))
-              throw loop_error(
-                "loop error: statements " + to_string(*ii)
-                + " and " + to_string(*jj)
-                + " cannot be fused together due to negative dependence");
-          dvs = dep.getEdge(*jj, *ii);
-          for (int k = 0; k < dvs.size(); k++)
-            if (dvs[k].isCarried(dep_dim)
-                && dvs[k].hasNegative(dep_dim))
-              throw loop_error(
-                "loop error: statements " + to_string(*jj)
-                + " and " + to_string(*ii)
-                + " cannot be fused together due to negative dependence");
+          dep.getEdges(*ii, *jj, batch);
+          dep.getEdges(*jj, *ii, batch);
         }
     }
   }
+  int k = findViolation(batch, [dep_dim](const DependenceEdge &e) {
+      return e.dv->isCarried(dep_dim) && e.dv->hasNegative(dep_dim);
+    });
+  if (k >= 0)
+    throw loop_error(
+      "loop error: statements " + to_string(batch[k].from)
+      + " and " + to_string(batch[k].to)
+      + " cannot be fused together due to negative dependence");
   
   std::set<int> same_loop = getStatements(ref_lex, dim - 3);
   
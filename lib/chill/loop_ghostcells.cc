@@ -746,7 +746,7 @@ void Loop::generate_ghostcells_v2(std::vector<int> stmt_num, int level, int ghos
                                                                            freevar, index, stmt_nesting_level_[i],
                                                                            stmt_nesting_level_[j],
                                                                            uninterpreted_symbols[ i ],  // ??? 
-                                                                           uninterpreted_symbols_stringrepr[ i ], unin_rel[i], dep_relation); // ??? );
+                                                                           uninterpreted_symbols_stringrepr[ i ], unin_rel[i], dep_relation, &dep_cache); // ??? );
       
       
 
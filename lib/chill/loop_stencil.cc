@@ -1198,7 +1198,8 @@ void Loop::stencilASEPadded(int stmt_num)   {
                                                                            stmt_nesting_level_[i],
                                                                            stmt_nesting_level_[j],
                                                                            uninterpreted_symbols[ i ],  // ??? 
-                                                                           uninterpreted_symbols_stringrepr[ i ],unin_rel[i], dep_relation);
+                                                                           uninterpreted_symbols_stringrepr[ i ],unin_rel[i], dep_relation,
+                                                                           &dep_cache);
       // TODO dep_relation is out-dated: from Anand's
       
       for (int k = 0; k < dv.first.size(); k++) {
@@ -54,54 +54,41 @@ void Loop::tile(int stmt_num, int level, int tile_size, int outer_level,
   std::set<int> same_tile_controlling_loop = getStatements(lex,
                                                            outer_dim - 1);
   
-  for (std::set<int>::iterator i = same_tiled_loop.begin();
-       i != same_tiled_loop.end(); i++) {
-    for (DependenceGraph::EdgeList::iterator j =
-           dep.vertex[*i].second.begin(); j != dep.vertex[*i].second.end();
-         j++) {
-      if (same_tiled_loop.find(j->first) != same_tiled_loop.end())
-        for (int k = 0; k < j->second.size(); k++) {
-          DependenceVector dv = j->second[k];
-          int dim2 = level - 1;
-          if ((dv.type != DEP_CONTROL) && (dv.type != DEP_UNKNOWN)) {
-            while (stmt[*i].loop_level[dim2].type == LoopLevelTile) {
-              dim2 = stmt[*i].loop_level[dim2].payload - 1;
-            }
-            dim2 = stmt[*i].loop_level[dim2].payload;
-            
-            if (dv.hasNegative(dim2) && (!dv.quasi)) {
-              for (int l = outer_level; l < level; l++)
-                if (stmt[*i].loop_level[l - 1].type
-                    != LoopLevelTile) {
-                  if (dv.isCarried(
-                                   stmt[*i].loop_level[l - 1].payload)
-                      && dv.hasPositive(
-                                        stmt[*i].loop_level[l - 1].payload))
-                    throw loop_error(
-                                     "loop error: Tiling is illegal, dependence violation!");
-                } else {
-                  
-                  int dim3 = l - 1;
-                  while (stmt[*i].loop_level[l - 1].type
-                         != LoopLevelTile) {
-                    dim3 =
-                      stmt[*i].loop_level[l - 1].payload
-                      - 1;
-                    
-                  }
-                  
-                  dim3 = stmt[*i].loop_level[l - 1].payload;
-                  if (dim3 < level - 1)
-                    if (dv.isCarried(dim3)
-                        && dv.hasPositive(dim3))
-                      throw loop_error(
-                                       "loop error: Tiling is illegal, dependence violation!");
-                }
+  std::vector<DependenceEdge> batch;
+  dep.getEdges(same_tiled_loop, same_tiled_loop, batch);
+  int violation = findViolation(batch, [&](const DependenceEdge &e) {
+      const DependenceVector &dv = *e.dv;
+      const int i = e.from;
+      int dim2 = level - 1;
+      if ((dv.type != DEP_CONTROL) && (dv.type != DEP_UNKNOWN)) {
+        while (stmt[i].loop_level[dim2].type == LoopLevelTile) {
+          dim2 = stmt[i].loop_level[dim2].payload - 1;
+        }
+        dim2 = stmt[i].loop_level[dim2].payload;
+        
+        if (dv.hasNegative(dim2) && (!dv.quasi)) {
+          for (int l = outer_level; l < level; l++)
+            if (stmt[i].loop_level[l - 1].type
+                != LoopLevelTile) {
+              if (dv.isCarried(
+                               stmt[i].loop_level[l - 1].payload)
+                  && dv.hasPositive(
+                                    stmt[i].loop_level[l - 1].payload))
+                return true;
+            } else {
+              int dim3 = stmt[i].loop_level[l - 1].payload;
+              if (dim3 < level - 1)
+                if (dv.isCarried(dim3)
+                    && dv.hasPositive(dim3))
+                  return true;
             }
-          }
         }
-    }
-  }
+      }
+      return false;
+    });
+  if (violation >= 0)
+    throw loop_error(
+                     "loop error: Tiling is illegal, dependence violation!");
 
   // special case for no tiling
   if (tile_size == 0) {
@@ -35,6 +35,22 @@ typedef int coef_t;  // type of coefficients
 #define negInfinity (-0x7ffffff)
 #endif
 
+// A type twice as wide as coef_t, used to redo row arithmetic that
+// overflowed; see combineGEQ() in oc.h.
+#if ! LONG_LONG_COEF
+typedef long long wide_coef_t;
+#define HAVE_WIDE_COEF 1
+#elif ! defined BOGUS_LONG_DOUBLE_COEF && defined __SIZEOF_INT128__
+typedef __int128 wide_coef_t;
+#define HAVE_WIDE_COEF 1
+#endif
+
+// The overflow builtins cost a flag test, so integer coefficients are
+// checked in every build.
+#if defined __GNUC__ && ! defined BOGUS_LONG_DOUBLE_COEF
+#define CHECKED_COEF_BUILTINS 1
+#endif
+
 
 template<typename T> inline const T& max(const T &x, const T &y) {
 	if (x >= y) return x; else return y;
@@ -122,7 +138,12 @@ template<class T> inline void set_min(T &m, const T &x) {
 /* inline LONGLONG abs(LONGLONG c) { return (c>=0?c:(-c)); }  */
 
 template<typename T> inline T check_mul(const T &x, const T &y) {
-#if defined NDEBUG && ! defined STILL_CHECK_MULT
+#if defined CHECKED_COEF_BUILTINS
+  T z;
+  if (__builtin_mul_overflow(x, y, &z))
+    throw std::overflow_error("coefficient multiply overflow");
+  return z;
+#elif defined NDEBUG && ! defined STILL_CHECK_MULT
   return x*y;
 #else
   if (x == 0 || y == 0)
@@ -137,21 +158,28 @@ template<typename T> inline T check_mul(const T &x, const T &y) {
     throw std::overflow_error("coefficient multiply overflow");
 
   return z;
+#endif
+}
 
-  /* if (x > 0) { */
-  /*   if (y > 0) { */
-  /*     assert(x*y > 0); */
-  /*   } */
-  /*   else */
-  /*     assert(x*y < 0); */
-  /* } */
-  /* else { */
-  /*   if (y > 0) */
-  /*     assert(x*y < 0); */
-  /*   else */
-  /*     assert(x*y > 0); */
-  /* } */
-  /* return x*y; */
+template<typename T> inline T check_add(const T &x, const T &y) {
+#if defined CHECKED_COEF_BUILTINS
+  T z;
+  if (__builtin_add_overflow(x, y, &z))
+    throw std::overflow_error("coefficient add overflow");
+  return z;
+#else
+  return x+y;
+#endif
+}
+
+template<typename T> inline T check_sub(const T &x, const T &y) {
+#if defined CHECKED_COEF_BUILTINS
+  T z;
+  if (__builtin_sub_overflow(x, y, &z))
+    throw std::overflow_error("coefficient subtract overflow");
+  return z;
+#else
+  return x-y;
 #endif
 }
 
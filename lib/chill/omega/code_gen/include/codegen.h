@@ -6,6 +6,9 @@
 #include <code_gen/CG_outputBuilder.h>
 #include <vector>
 #include <string>
+#include <list>
+#include <map>
+#include <mutex>
 
 namespace omega {
 
@@ -13,6 +16,8 @@ class CodeGen {
 public:
   static const std::string loop_var_name_prefix;
   static const int var_substitution_threshold;
+  //! Threads, the caller's included, that build sibling subtrees in buildAST()
+  static int build_threads;
   
 protected:
   std::vector<std::vector<Relation> > projected_IS_; //!< projected_IS_[level-1][new stmt#]
@@ -34,6 +39,8 @@ public:
   
 private:
   CG_result *buildAST(int level, const BoolSet<> &active, bool split_on_const, const Relation &restriction);
+  std::vector<CG_result *> buildSiblings(int level, const std::vector<BoolSet<> > &active,
+                                        const std::vector<Relation> &restrictions);
 
   friend class CG_result;
   friend class CG_split;
@@ -41,5 +48,63 @@ private:
   friend class CG_leaf;
 };
 
+/**
+ * @brief Memoized code generation
+ *
+ * Autotuning and repeated builds hand CodeGen the same iteration spaces and
+ * transformations again and again, often from separate calculator runs.
+ * Entries are keyed by the printed form of the transformations, iteration
+ * spaces and known condition, by the effort, and by the split levels,
+ * statement names and syncs that CodeGen otherwise takes through globals.
+ * Each keeps only the code printed for its key, so it holds no relation or
+ * variable declaration and outlives the relations it was built from.  At
+ * most capacity() entries are kept; the least recently used one is dropped
+ * first.
+ */
+class CodeGenMemo {
+public:
+  typedef std::vector<std::vector<int> > SplitLevels;
+  typedef std::vector<std::vector<std::string> > IndexNames;
+  typedef std::vector<std::pair<int, std::string> > Syncs;
+
+  explicit CodeGenMemo(int capacity = 64): capacity_(capacity), hits_(0), misses_(0) {}
+  ~CodeGenMemo() { clear(); }
+
+  //! CodeGen(xforms, IS, known, ...).buildAST(effort)->printString(), false if there is no code
+  /*!
+   * The globals are only set, and restored afterwards, when the code has
+   * not been printed before.
+   */
+  bool printString(const std::vector<Relation> &xforms, const std::vector<Relation> &IS,
+                   const Relation &known, int effort, std::string &code,
+                   const SplitLevels &smtNonSplitLevels_ = SplitLevels(),
+                   const IndexNames &loopIdxNames_ = IndexNames(),
+                   const Syncs &syncs_ = Syncs());
+
+  void clear();
+  int size() const { return entries_.size(); }
+  int capacity() const { return capacity_; }
+  //! Calls that found their code cached
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+
+private:
+  struct Entry {
+    bool has_code;
+    std::string code;
+    std::list<std::string>::iterator use;
+  };
+
+  CodeGenMemo(const CodeGenMemo &);
+  CodeGenMemo &operator=(const CodeGenMemo &);
+
+  std::map<std::string, Entry> entries_;
+  std::list<std::string> uses_; //!< keys of entries_, most recently used first
+  std::mutex mutex_;
+  int capacity_;
+  int hits_;
+  int misses_;
+};
+
 }
 #endif
@@ -23,6 +23,11 @@
 #include <cmath>
 #include <vector>
 #include <algorithm>
+#include <sstream>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <system_error>
 
 #include "chill_io.hh"
 
@@ -36,6 +41,7 @@ namespace omega {
 
 const std::string CodeGen::loop_var_name_prefix = "t";
 const int CodeGen::var_substitution_threshold = 10;
+int CodeGen::build_threads = 1;
 
 //Anand--adding stuff to make Chun's code work with Gabe's
 std::vector< std::vector<int> > smtNonSplitLevels;
@@ -202,6 +208,8 @@ CG_result *CodeGen::buildAST(int level, const BoolSet<> &active, bool split_on_c
 
     std::vector<Relation> split_cond;
     std::vector<CG_result *> split_child;
+    std::vector<BoolSet<> > split_active;
+    std::vector<Relation> split_restriction;
 
     coef_t prev_val = -posInfinity;
     coef_t next_val = bounds[0].first.second;
@@ -230,11 +238,9 @@ CG_result *CodeGen::buildAST(int level, const BoolSet<> &active, bool split_on_c
 
         Relation new_restriction = Intersection(copy(r), copy(restriction));
         new_restriction.simplify(2, 4);
-        CG_result *child = buildAST(level, next_active, false, new_restriction);
-        if (child != NULL) {
-          split_cond.push_back(copy(r));
-          split_child.push_back(child);
-        }
+        split_cond.push_back(copy(r));
+        split_active.push_back(next_active);
+        split_restriction.push_back(new_restriction);
         next_active.unset_all();
         prev_val = next_val;
         next_val = bounds[i].first.second;
@@ -251,19 +257,25 @@ CG_result *CodeGen::buildAST(int level, const BoolSet<> &active, bool split_on_c
       }
       Relation new_restriction = Intersection(copy(r), copy(restriction));
       new_restriction.simplify(2, 4);
-      CG_result *child = buildAST(level, next_active, false, new_restriction);
-      if (child != NULL) {
-        split_cond.push_back(copy(r));
-        split_child.push_back(child);
-      }
+      split_cond.push_back(copy(r));
+      split_active.push_back(next_active);
+      split_restriction.push_back(new_restriction);
     }
 
+    std::vector<CG_result *> children = buildSiblings(level, split_active, split_restriction);
+    std::vector<Relation> child_cond;
+    for (size_t k = 0; k < children.size(); k++)
+      if (children[k] != NULL) {
+        child_cond.push_back(copy(split_cond[k]));
+        split_child.push_back(children[k]);
+      }
+
     if (split_child.size() == 0)
       return NULL;
     else if (split_child.size() == 1)
       return split_child[0];
     else
-      return new CG_split(this, active, split_cond, split_child);
+      return new CG_split(this, active, child_cond, split_child);
   }
   // check bound conditions exhaustively for non-overlap iteration space splitting
   else {
@@ -299,29 +311,44 @@ CG_result *CodeGen::buildAST(int level, const BoolSet<> &active, bool split_on_c
         if ((*e).has_wildcards())
           continue;
             
-        Relation cond = Relation::True(num_level());
+        coef_t level_coef = (*e).get_coef(hull.set_var(level));
+        if (level_coef == 0)
+          continue;
+
+        // The condition and its complement are each a single inequality,
+        // so build both directly instead of through Complement/Difference.
+        Relation ge = Relation::True(num_level());
+        ge.and_with_GEQ(*e);
+        Relation lt = Relation::True(num_level());
+        GEQ_Handle h = lt.and_with_GEQ(*e);
+        std::vector<std::pair<Variable_ID, coef_t> > terms;
+        for (Constr_Vars_Iter cvi(h); cvi; cvi++)
+          terms.push_back(std::make_pair(cvi.curr_var(), cvi.curr_coef()));
+        for (size_t k = 0; k < terms.size(); k++)
+          h.update_coef(terms[k].first, -2*terms[k].second);
+        h.update_const(-2*(*e).get_const() - 1);
+        ge.simplify();
+        lt.simplify();
+
         BoolSet<> first_chunk(active.size());
         BoolSet<> second_chunk(active.size());
-
-        if ((*e).get_coef(hull.set_var(level)) > 0) {
-          cond.and_with_GEQ(*e);
-          cond = Complement(cond);;
-          cond.simplify();
+        Relation cond, complement_cond;
+        if (level_coef > 0) {
+          cond = lt;
+          complement_cond = ge;
           second_chunk.set(*i);
         }
-        else if ((*e).get_coef(hull.set_var(level)) < 0) {
-          cond.and_with_GEQ(*e);
-          cond.simplify();
+        else {
+          cond = ge;
+          complement_cond = lt;
           first_chunk.set(*i);
         }
-        else
-          continue;
 
         bool is_proper_split_cond = true;
         for (BoolSet<>::const_iterator j = active.begin(); j != active.end(); j++)
           if ( *j != *i) {
           bool in_first = Intersection(copy(Rs[*j]), copy(cond)).is_upper_bound_satisfiable();
-          bool in_second = Difference(copy(Rs[*j]), copy(cond)).is_upper_bound_satisfiable();
+          bool in_second = Intersection(copy(Rs[*j]), copy(complement_cond)).is_upper_bound_satisfiable();
 
           if (in_first && in_second) {
             is_proper_split_cond = false;
@@ -335,8 +362,15 @@ CG_result *CodeGen::buildAST(int level, const BoolSet<> &active, bool split_on_c
           }
 
         if (is_proper_split_cond && first_chunk.num_elem() != 0 && second_chunk.num_elem() != 0) {
-          CG_result *first_cg = buildAST(level, first_chunk, false, copy(cond));
-          CG_result *second_cg = buildAST(level, second_chunk, false, Complement(copy(cond)));
+          std::vector<BoolSet<> > chunks;
+          chunks.push_back(first_chunk);
+          chunks.push_back(second_chunk);
+          std::vector<Relation> conds;
+          conds.push_back(copy(cond));
+          conds.push_back(copy(complement_cond));
+          std::vector<CG_result *> children = buildSiblings(level, chunks, conds);
+          CG_result *first_cg = children[0];
+          CG_result *second_cg = children[1];
           if (first_cg == NULL)
             return second_cg;
           else if (second_cg == NULL)
@@ -346,7 +380,7 @@ CG_result *CodeGen::buildAST(int level, const BoolSet<> &active, bool split_on_c
             std::vector<CG_result *> split_child;
             split_cond.push_back(copy(cond));
             split_child.push_back(first_cg);
-            split_cond.push_back(Complement(copy(cond)));
+            split_cond.push_back(copy(complement_cond));
             split_child.push_back(second_cg);
 
             return new CG_split(this, active, split_cond, split_child);
@@ -359,7 +393,80 @@ CG_result *CodeGen::buildAST(int level, const BoolSet<> &active, bool split_on_c
 }
 
 
+namespace {
+  // helper threads running in buildSiblings, across all CodeGens
+  std::atomic<int> busy_helpers(0);
+}
+
+/**
+ * @brief Build sibling subtrees, in order
+ *
+ * Siblings share no relations, so while CodeGen::build_threads allows,
+ * all but the last are handed to helper threads.  Each thread holds the
+ * Presburger lock except while the core solver runs, and the children
+ * come back in the order of active whatever thread built them.
+ */
+std::vector<CG_result *> CodeGen::buildSiblings(int level, const std::vector<BoolSet<> > &active,
+                                                const std::vector<Relation> &restrictions) {
+  size_t n = active.size();
+  std::vector<CG_result *> children(n, NULL);
+  std::vector<std::future<CG_result *> > helpers(n);
+  for (size_t k = 0; k + 1 < n; k++) {
+    if (busy_helpers.fetch_add(1) < build_threads - 1) {
+      try {
+        helpers[k] = std::async(std::launch::async, [this, level, &active, &restrictions, k]() {
+            Presburger_Lock lock;
+            return buildAST(level, active[k], false, restrictions[k]);
+          });
+        continue;
+      }
+      catch (const std::system_error &) {
+        // no thread to be had, build it here
+      }
+    }
+    busy_helpers--;
+  }
+
+  std::exception_ptr error;
+  for (size_t k = 0; k < n; k++)
+    if (!helpers[k].valid()) {
+      try {
+        children[k] = buildAST(level, active[k], false, restrictions[k]);
+      }
+      catch (...) {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  {
+    Presburger_Unlock unlock;
+    for (size_t k = 0; k < n; k++)
+      if (helpers[k].valid())
+        helpers[k].wait();
+  }
+  for (size_t k = 0; k < n; k++)
+    if (helpers[k].valid()) {
+      busy_helpers--;
+      try {
+        children[k] = helpers[k].get();
+      }
+      catch (...) {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+
+  if (error) {
+    for (size_t k = 0; k < n; k++)
+      delete children[k];
+    std::rethrow_exception(error);
+  }
+  return children;
+}
+
+
 CG_result *CodeGen::buildAST(int effort) {
+  Presburger_Lock lock;
   debug_fprintf(stderr, "CodeGen::buildAST( effort %d )\n", effort); 
   if (remap_.size() == 0)
     return NULL;
@@ -394,4 +501,94 @@ CG_result *CodeGen::buildAST(int effort) {
   return result.first;
 }
 
+
+namespace {
+  // Relations are printed from a copy, since printing simplifies them.
+  void appendKey(std::ostringstream &key, const Relation &r) {
+    if (r.is_null())
+      key << "null";
+    else {
+      Relation c = copy(r);
+      key << c.print_with_subs_to_string(true, false);
+    }
+    key << '\n';
+  }
+}
+
+bool CodeGenMemo::printString(const std::vector<Relation> &xforms, const std::vector<Relation> &IS,
+                               const Relation &known, int effort, std::string &code,
+                               const SplitLevels &smtNonSplitLevels_, const IndexNames &loopIdxNames_,
+                               const Syncs &syncs_) {
+  std::ostringstream key;
+  key << IS.size() << ' ' << effort << '\n';
+  for (size_t i = 0; i < xforms.size(); i++)
+    appendKey(key, xforms[i]);
+  for (size_t i = 0; i < IS.size(); i++)
+    appendKey(key, IS[i]);
+  appendKey(key, known);
+  for (size_t i = 0; i < smtNonSplitLevels_.size(); i++) {
+    for (size_t j = 0; j < smtNonSplitLevels_[i].size(); j++)
+      key << smtNonSplitLevels_[i][j] << ' ';
+    key << ';';
+  }
+  key << '\n';
+  for (size_t i = 0; i < loopIdxNames_.size(); i++) {
+    for (size_t j = 0; j < loopIdxNames_[i].size(); j++)
+      key << loopIdxNames_[i][j] << ' ';
+    key << ';';
+  }
+  key << '\n';
+  for (size_t i = 0; i < syncs_.size(); i++)
+    key << syncs_[i].first << ' ' << syncs_[i].second << ';';
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<std::string, Entry>::iterator it = entries_.find(key.str());
+  if (it != entries_.end()) {
+    hits_++;
+    uses_.splice(uses_.begin(), uses_, it->second.use);
+    code = it->second.code;
+    return it->second.has_code;
+  }
+
+  misses_++;
+  SplitLevels oldSplitLevels = smtNonSplitLevels;
+  IndexNames oldIdxNames = loopIdxNames;
+  Syncs oldSyncs = syncs;
+  Entry entry;
+  try {
+    CodeGen codegen(xforms, IS, known, smtNonSplitLevels_, loopIdxNames_, syncs_);
+    CG_result *cgr = codegen.buildAST(effort);
+    entry.has_code = cgr != NULL;
+    if (cgr != NULL) {
+      entry.code = cgr->printString();
+      delete cgr;
+    }
+  }
+  catch (...) {
+    smtNonSplitLevels = oldSplitLevels;
+    loopIdxNames = oldIdxNames;
+    syncs = oldSyncs;
+    throw;
+  }
+  smtNonSplitLevels = oldSplitLevels;
+  loopIdxNames = oldIdxNames;
+  syncs = oldSyncs;
+
+  while (!uses_.empty() && (int)uses_.size() >= capacity_) {
+    entries_.erase(uses_.back());
+    uses_.pop_back();
+  }
+  uses_.push_front(key.str());
+  entry.use = uses_.begin();
+  entries_[key.str()] = entry;
+  code = entry.code;
+  return entry.has_code;
+}
+
+void CodeGenMemo::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  uses_.clear();
+}
+
 }
@@ -62,6 +62,7 @@
 #include <omega/pres_conj.h>
 #include <omega/pres_cmpr.h>
 #include <omega/Relation.h>
+#include <omega/pres_solver.h>
 
 #include <omega/Rel_map.h>
 #include <omega/farkas.h>
@@ -3,6 +3,7 @@
 
 #include <omega/pres_gen.h>
 #include <omega/pres_var.h>
+#include <vector>
 
 namespace omega {
 
@@ -31,15 +32,12 @@ namespace omega {
  */
 class Mapping {
 public:
-  inline  Mapping(int no_in, int no_out): n_input(no_in), n_output(no_out) {}
-  inline  Mapping(int no_set): n_input(no_set), n_output(0){}
-  inline  Mapping(const Mapping &m): n_input(m.n_input), n_output(m.n_output) {
-    int i;
-    for(i=1; i<=n_input; i++) map_in_kind[i] = m.map_in_kind[i];
-    for(i=1; i<=n_input; i++) map_in_pos[i]  = m.map_in_pos[i];
-    for(i=1; i<=n_output;i++) map_out_kind[i] = m.map_out_kind[i];
-    for(i=1; i<=n_output;i++) map_out_pos[i] = m.map_out_pos[i];
-  }
+  inline  Mapping(int no_in, int no_out): n_input(no_in), n_output(no_out),
+    map_in_kind(no_in+1), map_in_pos(no_in+1),
+    map_out_kind(no_out+1), map_out_pos(no_out+1) {}
+  inline  Mapping(int no_set): n_input(no_set), n_output(0),
+    map_in_kind(no_set+1), map_in_pos(no_set+1),
+    map_out_kind(1), map_out_pos(1) {}
 
   inline void set_map (Var_Kind in_kind, int pos, Var_Kind type, int map) {
     if(in_kind==Input_Var)
@@ -151,10 +149,10 @@ public:
 private:
   int  n_input;
   int  n_output;
-  Var_Kind map_in_kind[maxVars]; ///< New kind for old input vars, also reused for setvar
-  int      map_in_pos[maxVars];  ///< New position for old input vars, also reused for setvar
-  Var_Kind map_out_kind[maxVars]; ///< New kind for old output vars
-  int      map_out_pos[maxVars];  ///< New position for old output vars
+  std::vector<Var_Kind> map_in_kind; ///< New kind for old input vars, also reused for setvar
+  std::vector<int>      map_in_pos;  ///< New position for old input vars, also reused for setvar
+  std::vector<Var_Kind> map_out_kind; ///< New kind for old output vars
+  std::vector<int>      map_out_pos;  ///< New position for old output vars
 };
 
 } // namespace
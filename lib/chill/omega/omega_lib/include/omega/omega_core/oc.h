@@ -2,7 +2,10 @@
 #define Already_Included_OC 1
 
 #include <stdio.h>
+#include <stddef.h>
+#include <string.h>
 #include <string>
+#include <vector>
 #include <basic/util.h>
 #include <omega/omega_core/debugging.h>
 #include <basic/Tuple.h>
@@ -11,7 +14,8 @@ namespace omega {
 
 // Manu:: commented the line below  -- fortran bug workaround
 //#define maxVars 256 /* original 56, increased by chun */
-#define maxVars 100
+// No longer a hard limit either: rows are sized for the variables of the
+// problem they belong to, see Problem::reserveVars().
 
 extern int maxGEQs;
 extern int maxEQs;
@@ -19,6 +23,9 @@ extern int maxEQs;
 // Manu:: commented the lines below  -- fortran bug workaround
 //const int maxmaxGEQs = 2048; // original 512, increaded by chun
 //const int maxmaxEQs = 512;   // original 256, increased by chun
+// No longer hard limits: a Problem grows its EQs and GEQs as needed.  These
+// size the initial constraint hash table and bound how many constraints
+// quickKill may add while combining.
 const int maxmaxGEQs = 512;
 const int maxmaxEQs = 256;
 
@@ -34,25 +41,35 @@ typedef int EqnKey;
 enum {EQ_BLACK = 0, EQ_RED = 1};
 enum {OC_SOLVE_UNKNOWN = 2, OC_SOLVE_SIMPLIFY = 3};
 
+// A constraint.  coef[0..nVars] lives in the block of rows it was made
+// with by newEqns(), sized for the variables of its problem, so rows are
+// copied with eqnncpy() and never by assignment.
 struct eqn {
   EqnKey  key;
   coef_t  touched;  // see oc_simple.c
   int     color;
   int     essential;
   int     varCount;
-  coef_t  coef[maxVars + 1];
+  coef_t *coef;
+
+  eqn(): coef(NULL) {}
+private:
+  eqn(const eqn &);
+  eqn &operator=(const eqn &);
 };
 
+// Single variable inequalities are keyed by +-variable and all others by
+// +-(keyBase + n), so the two kinds never collide.
+const int keyBase = 1 << 24;
+
 // typedef eqn * Eqn;
 enum redType {notRed=0, redEQ, redGEQ, redLEQ, redStride};
 enum redCheck {noRed=0, redFalse, redConstraints};
 enum normalizeReturnType {normalize_false, normalize_uncoupled,
                           normalize_coupled};
 
-extern char wildName[200][20];
-
 extern FILE *outputFile; /* printProblem writes its output to this file */
-#define doTrace (trace && TRACE)
+#define doTrace (ctx->trace && TRACE)
 #define isRed(e) (desiredResult == OC_SOLVE_SIMPLIFY && (e)->color)
 // #define eqnncpy(e1,e2,s) {int *p00,*q00,*r00; p00 = (int *)(e1); q00 = (int *)(e2); r00 = &p00[headerWords+1+s]; while(p00 < r00) *p00++ = *q00++; }
 // #define eqncpy(e1,e2) eqnncpy(e1,e2,nVars)
@@ -62,16 +79,32 @@ extern FILE *outputFile; /* printProblem writes its output to this file */
 //void eqnncpy(eqn *dest, eqn *src, int);
 //void eqnnzero(eqn *e, int);
 
-inline void eqnncpy(eqn *dest, eqn *src, int nVars) {
-  dest->key = src->key;
-  dest->touched = src->touched;
-  dest->color = src->color;
-  dest->essential = src->essential;
-  dest->varCount = src->varCount;
-  for (int i = 0; i <= nVars; i++)
-    dest->coef[i] = src->coef[i];
-}
+// n rows with room for coef[0..nVars] each, allocated as one block.
+eqn *newEqns(int n, int nVars);
+void deleteEqns(eqn *rows);
+
+// Rows from newEqns() freed with the buffer, for scratch constraints.
+class EqnBuffer {
+public:
+  EqnBuffer(int n, int nVars): rows(newEqns(n, nVars)) {}
+  ~EqnBuffer() { deleteEqns(rows); }
+  eqn &operator[](int i) const { return rows[i]; }
+private:
+  EqnBuffer(const EqnBuffer &);
+  EqnBuffer &operator=(const EqnBuffer &);
+  eqn *rows;
+};
 
+inline void eqnncpy(eqn *dest, const eqn *src, int nVars) {
+  if (dest != src) {
+    dest->key = src->key;
+    dest->touched = src->touched;
+    dest->color = src->color;
+    dest->essential = src->essential;
+    dest->varCount = src->varCount;
+    memcpy(dest->coef, src->coef, (nVars + 1) * sizeof(coef_t));
+  }
+}
 
 inline void eqnnzero(eqn *e, int nVars) {
   e->key = 0;
@@ -79,11 +112,17 @@ inline void eqnnzero(eqn *e, int nVars) {
   e->color = EQ_BLACK;
   e->essential = 0;
   e->varCount = 0;
-  for (int i = 0; i <= nVars; i++)
-    e->coef[i] = 0;
+  memset(e->coef, 0, (nVars + 1) * sizeof(coef_t));
 }
 
-extern int mayBeRed;
+// dest = c1*e1 + c2*e2 over coef[0..nVars], plus extra on the constant.
+// Only the coefficients of dest are written and dest may alias e1 or e2.
+// The usual case is plain overflow-checked coef_t arithmetic.  A row that
+// overflows is recomputed in wide_coef_t and, being an inequality, divided
+// by the gcd of its variable coefficients; overflow_error is thrown only
+// if it still does not fit.
+void combineGEQ(eqn *dest, const eqn *e1, coef_t c1, const eqn *e2, coef_t c2,
+                int nVars, coef_t extra = 0);
 
 #ifdef SPEED
 #define TRACE 0
@@ -102,34 +141,144 @@ public:
   coef_t  stride;
   redType kind;
   coef_t  constantTerm;
-  coef_t  coef[maxVars + 1];
-  int     var[maxVars + 1];
+  std::vector<coef_t> coef;
+  std::vector<int>    var;
 };
 
 /* #define headerWords ((4*sizeof(int) + sizeof(coef_t))/sizeof(int)) */
 
 void check_number_EQs(int);
 void check_number_GEQs(int);
-extern eqn SUBs[];
-extern Memory redMemory[];
+
+class Problem;
+
+/*
+ * State the solver keeps between the calls that make up one simplification:
+ * the constraint hash table, substitutions, red memories, wildcard names,
+ * and the mode flags.  A Problem has no context of its own, it uses the one
+ * current on the calling thread, so problems on different threads can be
+ * simplified at the same time and a problem may move between threads.  A
+ * context itself must only be used by one thread at a time.
+ *
+ * Only the omega core is covered.  Relations and the code generator share
+ * global state, so threads that use them hold the Presburger mutex (see
+ * Presburger_Lock in pres_gen.h); CodeGen takes it around every build.
+ * Conjunct::simplifyProblem and redSimplifyProblem let go of it for the core
+ * solve, the only part that runs unlocked, each thread in its own context.
+ */
+class SolverContext {
+public:
+  SolverContext();
+
+  // Context of the calling thread: the innermost Scope, or else a
+  // context of its own that lives as long as the thread.
+  static SolverContext &current() {
+    return active != NULL ? *active : threadDefault();
+  }
+
+  // A hash version no context has used yet, so that keys computed in one
+  // context are never taken as valid in another.
+  static int newHashVersion();
+
+  // Makes a context current on the calling thread while it exists.
+  class Scope {
+  public:
+    explicit Scope(SolverContext &ctx);
+    ~Scope();
+  private:
+    Scope(const Scope &);
+    Scope &operator=(const Scope &);
+    SolverContext *previous;
+  };
+
+  int newVar;
+  int findingImplicitEqualities;
+  int firstCheckForRedundantEquations;
+  int doItAgain;
+  int conservative;
+  int trace;
+  int depth;
+  int solveDepth;
+  int inApproximateMode;
+  int inStridesAllowedMode;
+  int addingOuterEqualities;
+  int outerColor;
+  int pleaseNoEqualitiesInSimplifiedProblems;
+  int mayBeRed;
+  Problem *originalProblem;
+
+  char wildName[200][20];
+  int nextWildcard;
+
+  // One substitution and red memory per variable at most.
+  eqn *SUBs;
+  std::vector<Memory> redMemory;
+
+  // Hash table is used to hash all inequalties for all problems of this
+  // context.  It persists across problems for quick problem merging in
+  // case.  When the table is filled to 1/3 full, it is flushed and the
+  // filling process starts all over again.  A single problem that needs
+  // more keys than fit grows the table instead, see growHashTable().
+  std::vector<int> packing;
+  int hashVersion;
+  int hashTableSize;
+  int maxKeys;
+  eqn *hashMaster;
+  std::vector<int> fastLookup;  // indexed by maxKeys + key -+ keyBase
+  std::vector<int> varLookup;   // indexed by nVars + key
+  int nextKey;
+
+  // Variables the rows of SUBs and hashMaster have room for.
+  int nVars;
+
+  // Makes room for problems with up to n variables.
+  void reserveVars(int n);
+
+  // Doubles the hash table and the key space, keeping all entries.
+  void growHashTable();
+
+  // Where the inequality with the given key was last seen.
+  int &lookup(EqnKey key) {
+    if (-keyBase < key && key < keyBase)
+      return varLookup[nVars + key];
+    return fastLookup[maxKeys + (key > 0 ? key - keyBase : key + keyBase)];
+  }
+
+  ~SolverContext();
+
+private:
+  SolverContext(const SolverContext &);
+  SolverContext &operator=(const SolverContext &);
+
+  static thread_local SolverContext *active;
+  static SolverContext &threadDefault();
+};
 
 class Problem {
 public:
   short     nVars, safeVars;
-  short     nEQs, nGEQs,nSUBs,nMemories,allocEQs,allocGEQs;
+  int       nEQs, nGEQs, allocEQs, allocGEQs;
+  short     nSUBs,nMemories;
   short varsOfInterest;
   bool variablesInitialized;
   bool variablesFreed;
-  short     var[maxVars+2];
-  short     forwardingAddress[maxVars+2];
+  std::vector<short> var;
+  std::vector<short> forwardingAddress;
   // int     variableColor[maxVars+2];
   int  hashVersion;
   const char *(*get_var_name)(unsigned int var, void *args);
   void *getVarNameArgs;
   eqn *GEQs;
   eqn *EQs;
+  int allocVars;  // rows have room for coef[0..allocVars]
   bool isTemporary;
 
+  // Looks up the calling thread's context on every use.
+  struct CurrentContext {
+    SolverContext *operator->() const { return &SolverContext::current(); }
+  };
+  CurrentContext ctx;
+
   Problem(int in_eqs=0, int in_geqs=0);
   Problem(const Problem &);
   ~Problem();
@@ -137,24 +286,27 @@ public:
 
 /* Allocation parameters and functions */
 
-  static const int min_alloc,first_alloc_pad;
+  static const int min_alloc,first_alloc_pad,min_alloc_vars;
   int padEQs(int oldalloc, int newreq) {
     check_number_EQs(newreq);
-    return min((newreq < 2*oldalloc ? 2*oldalloc : 2*newreq),maxmaxEQs);
+    return (newreq < 2*oldalloc ? 2*oldalloc : 2*newreq);
   }
   int padGEQs(int oldalloc, int newreq) {
     check_number_GEQs(newreq);
-    return min((newreq < 2*oldalloc ? 2*oldalloc : 2*newreq),maxmaxGEQs);
+    return (newreq < 2*oldalloc ? 2*oldalloc : 2*newreq);
   }
   int padEQs(int newreq) {
     check_number_EQs(newreq);
-    return min(max(newreq+first_alloc_pad,min_alloc), maxmaxEQs);
+    return max(newreq+first_alloc_pad,min_alloc);
   }
   int padGEQs(int newreq) {
     check_number_GEQs(newreq);
-    return min(max(newreq+first_alloc_pad,min_alloc), maxmaxGEQs);
+    return max(newreq+first_alloc_pad,min_alloc);
   }
 
+  // Makes room for n variables and the scratch one after them.  Call
+  // before nVars grows.
+  void reserveVars(int n);
 
   void zeroVariable(int i);
 
@@ -166,6 +318,7 @@ public:
   int newGEQ();
   int newEQ();
   int newSUB(){
+    ctx->reserveVars(allocVars);
     return nSUBs++;
   }
 
@@ -281,7 +434,7 @@ public:
     return ((i == 0) ?   //  cfront likes this form better
             "1" :
             ((i < 0) ?
-             wildName[-i] :
+             ctx->wildName[-i] :
              (*get_var_name)(i,getVarNameArgs)));
   };
   const char * variable(int i) const { 
@@ -336,7 +489,6 @@ void setOutputFile(FILE *file);
 
 extern void check_number_EQs(int nEQs);
 extern void check_number_GEQs(int nGEQs);
-extern void checkVars(int nVars);
 
 } // namespace
 
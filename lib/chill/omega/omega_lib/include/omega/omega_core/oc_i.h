@@ -4,6 +4,7 @@
 #include <basic/util.h>
 #include <omega/omega_core/oc.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <assert.h>
 #include <string>
 #include <vector>
@@ -12,42 +13,55 @@ namespace omega {
 
 #define maxWildcards 18
 
-extern int findingImplicitEqualities;
-extern int firstCheckForRedundantEquations;
 extern int use_ugly_names;
-extern int doItAgain;
-extern int newVar;
-extern int conservative;
 extern FILE *outputFile; /* printProblem writes its output to this file */
-extern int nextWildcard;
-extern int trace;
-extern int depth;
-extern int packing[maxVars];
 extern int headerLevel;
-extern int inApproximateMode;
-extern int inStridesAllowedMode;
-extern int addingOuterEqualities;
-extern int outerColor;
 
 const int keyMult = 31;
-const int hashTableSize =5*maxmaxGEQs;
-const int maxKeys = 8*maxmaxGEQs;
-extern int hashVersion;
-extern eqn hashMaster[hashTableSize];
-extern int fastLookup[maxKeys*2];
-extern int nextKey;
 
 extern int reduceWithSubs;
-extern int pleaseNoEqualitiesInSimplifiedProblems;
 
 #define noProblem ((Problem *) 0)
 
-extern Problem *originalProblem;
 int checkIfSingleVar(eqn *e, int i);
 /* Solve e = factor alpha for x_j and substitute */
 
 void negateCoefficients(eqn * eqn, int nV);
 
+// Signs of a constraint's coefficients as bitsets (bit i-1 for
+// variable i) and a hash of its direction, i.e. the coefficients
+// divided by their gcd with the first nonzero one made positive.
+// Parallel constraints hash alike, so the quick kill passes can
+// reject pairs and triples of inequalities a word at a time before
+// comparing any coefficients.
+inline int signatureWords(int nVars) {
+  return nVars / 64 + 1;
+}
+
+struct eqnSignature {
+  uint64_t *pos;
+  uint64_t *neg;
+  uint64_t *zero;
+  uint64_t direction;
+
+  void compute(const eqn &e, int nVars);
+};
+
+// Signatures of n constraints over nVars variables, with the bitsets of
+// all of them in one buffer.
+class eqnSignatures {
+public:
+  eqnSignatures(int n, int nVars);
+  eqnSignature &operator[](int e) { return sig[e]; }
+private:
+  std::vector<uint64_t> bits;
+  std::vector<eqnSignature> sig;
+};
+
+// Lists the variables set in any of the bitsets, highest first, and
+// returns how many there are.
+int signatureVars(const uint64_t *bits, int words, int *vars);
+
 extern int omegaInitialized;
 extern Problem full_answer, context,redProblem;
 
@@ -11,7 +11,7 @@ namespace omega {
 class Comp_Constraints {
 public:
   Comp_Constraints(eqn *constrs, int no_constrs, int no_vars);
-  void UncompressConstr(eqn *constrs, short &pn_constrs);
+  void UncompressConstr(eqn *constrs, int &pn_constrs);
   ~Comp_Constraints();
   bool no_constraints() const
   { return n_constrs == 0; }
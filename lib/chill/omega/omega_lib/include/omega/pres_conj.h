@@ -262,6 +262,7 @@ private:
 
   // Substitutions are a wrapper around a low-level Problem operation
   friend class Substitutions;
+  friend class Relation_Solver;
 
   // private functions to call problem functions 
   int simplifyProblem();
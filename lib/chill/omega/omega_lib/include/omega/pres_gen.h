@@ -46,6 +46,34 @@ extern int use_ugly_names;
 
 extern negation_control pres_legal_negations;
 
+//
+// Relations share variable declarations, reference counts and counters, so
+// threads that work on relations at the same time each hold the Presburger
+// lock.  The core solver only touches its Problem and its thread's
+// SolverContext, so conjuncts release the lock while they are solved.
+// A thread that never takes the lock is not affected.
+//
+
+class Presburger_Lock {
+public:
+  Presburger_Lock();
+  ~Presburger_Lock();
+private:
+  Presburger_Lock(const Presburger_Lock &);
+  Presburger_Lock &operator=(const Presburger_Lock &);
+};
+
+//! Gives up the Presburger lock, if this thread holds it, until destroyed
+class Presburger_Unlock {
+public:
+  Presburger_Unlock();
+  ~Presburger_Unlock();
+private:
+  Presburger_Unlock(const Presburger_Unlock &);
+  Presburger_Unlock &operator=(const Presburger_Unlock &);
+  int depth;
+};
+
 
 //
 // Lots of things refer to each other,
@@ -0,0 +1,87 @@
+#ifndef Already_Included_Pres_Solver
+#define Already_Included_Pres_Solver
+
+#include <omega/Relation.h>
+#include <utility>
+#include <vector>
+
+/** @file */
+
+namespace omega {
+
+/**
+ * @brief Incremental satisfiability queries against a fixed relation
+ *
+ * Asking whether R plus a few extra constraints is satisfiable normally
+ * means copying R, adding the constraints with and_with_and() and
+ * simplifying the whole relation again.  Relation_Solver simplifies R's
+ * conjuncts once and keeps the reduced problems; constraints are added
+ * in scopes that push() opens and pop() discards, and a query only runs
+ * the omega core on the rows added since the enclosing scope was solved.
+ *
+ * Variables are named by the input, output (or set) and global variables
+ * of any relation with R's arity; wildcards are not allowed.
+ *
+ *   Relation_Solver s(dep);
+ *   s.push();
+ *   s.add_GEQ(terms, -1);
+ *   if (!s.is_satisfiable()) ...
+ *   s.pop();
+ */
+class Relation_Solver {
+public:
+  typedef std::vector<std::pair<Variable_ID, coef_t> > Terms;
+
+  Relation_Solver(NOT_CONST Relation &R);
+  ~Relation_Solver();
+
+  void push();
+  void pop();
+  //! Number of scopes opened by push() and not yet popped.
+  int depth() const { return levels.size() - 2; }
+
+  //! Adds sum(terms) + constant >= 0 to the current scope.
+  void add_GEQ(const Terms &terms, coef_t constant = 0);
+  //! Adds sum(terms) + constant = 0 to the current scope.
+  void add_EQ(const Terms &terms, coef_t constant = 0);
+
+  bool is_upper_bound_satisfiable();
+  bool is_lower_bound_satisfiable();
+  bool is_satisfiable();
+
+private:
+  struct Row {
+    bool is_eq;
+    std::vector<coef_t> coef;  // indexed by solver column, 0 is the constant
+  };
+
+  // Rows added in one scope and, once solved, the problem of every
+  // conjunct with them applied (NULL when the conjunct became false).
+  // columns[c][k] is the problem column holding solver column k, or 0
+  // if the problem does not constrain it.
+  struct Level {
+    std::vector<Row> rows;
+    int applied;
+    bool solved;
+    std::vector<Problem *> problems;
+    std::vector<std::vector<int> > columns;
+    Level(): applied(0), solved(false) {}
+  };
+
+  int column_of(Variable_ID v);
+  void add_row(bool is_eq, const Terms &terms, coef_t constant);
+  void solve(int l);
+  void clear(Level &level);
+
+  int n_in, n_io;
+  std::vector<std::pair<Global_Var_ID, Argument_Tuple> > globals;
+  std::vector<bool> exact;
+  std::vector<Level> levels;
+
+  Relation_Solver(const Relation_Solver &);
+  Relation_Solver &operator=(const Relation_Solver &);
+};
+
+} // namespace
+
+#endif
@@ -37,7 +37,7 @@ static bool try_to_sub(Problem *p, int col) {
   }
 
   assert(col <= p->nVars);
-  assert(!inApproximateMode);
+  assert(!p->ctx->inApproximateMode);
 
   for(e=0;e<p->nEQs;e++)
     if (p->EQs[e].coef[col] == 1 || p->EQs[e].coef[col] == -1) {
@@ -45,7 +45,7 @@ static bool try_to_sub(Problem *p, int col) {
       p->doElimination(e, col);
       if (col != p->nVars + 1)
         p->forwardingAddress[p->var[p->nVars+1]] = col;
-      assert(p->SUBs[p->nSUBs-1].key = var);
+      assert(p->ctx->SUBs[p->nSUBs-1].key = var);
       p->forwardingAddress[var] = -p->nSUBs;
       break;
     }
@@ -61,7 +61,7 @@ static bool try_to_sub(Problem *p, int col) {
   if (e < p->nEQs) eqnncpy(&p->EQs[e], &p->EQs[p->nEQs], p->nVars);
 
   for (i = 0; i < p->nSUBs; i++) {
-    assert(p->forwardingAddress[p->SUBs[i].key] == -i - 1);
+    assert(p->forwardingAddress[p->ctx->SUBs[i].key] == -i - 1);
   }
 
   return true;
@@ -44,8 +44,6 @@ static Global_Var_Decl constant_term("constantTerm");
 
 Global_Var_ID coefficient_of_constant_term = &constant_term;
 
-extern int inApproximateMode;
-
 int farkas_debug = 0;
 
 coef_t farkasDifficulty;
@@ -446,8 +444,8 @@ Relation Farkas(NOT_CONST Relation &input_R, Farkas_Type op, bool early_bailout)
     }
   }
   catch (const std::overflow_error &e) {
-    // clear global variables
-    inApproximateMode = 0;
+    // clear solver state
+    SolverContext::current().inApproximateMode = 0;
     use_ugly_names = saved_use_ugly_names;
 
     if (early_bailout) {
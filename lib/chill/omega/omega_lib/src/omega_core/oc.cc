@@ -16,18 +16,15 @@
 
 namespace omega {
 
-eqn SUBs[maxVars+1];
-Memory redMemory[maxVars+1];
-
 int Problem::reduceProblem() {
   int result;
-  checkVars(nVars+1);
+  reserveVars(nVars);
   assert(omegaInitialized);
   if (nVars > nEQs + 3 * safeVars)
     freeEliminations(safeVars);
 
   check();
-  if (!mayBeRed && nSUBs == 0 && safeVars == 0) {
+  if (!ctx->mayBeRed && nSUBs == 0 && safeVars == 0) {
     result = solve(OC_SOLVE_UNKNOWN);
     nGEQs = 0;
     nEQs = 0;
@@ -48,21 +45,21 @@ int Problem::reduceProblem() {
 
 
 int Problem::simplifyProblem(int verify, int subs, int redundantElimination) {
-  checkVars(nVars+1);
+  reserveVars(nVars);
   assert(omegaInitialized);
   setInternals();
   check();
   if (!reduceProblem())  goto returnFalse;
   if (verify) {
-    addingOuterEqualities++;
+    ctx->addingOuterEqualities++;
     int r = verifyProblem();
-    addingOuterEqualities--;
+    ctx->addingOuterEqualities--;
     if (!r) goto returnFalse;
     if (nEQs) { // found some equality constraints during verification
       int numRed = 0;
-      if (mayBeRed) 
+      if (ctx->mayBeRed) 
         for (int e = nGEQs - 1; e >= 0; e--) if (GEQs[e].color == EQ_RED) numRed++;
-      if (mayBeRed && nVars == safeVars && numRed == 1)
+      if (ctx->mayBeRed && nVars == safeVars && numRed == 1)
         nEQs = 0; // discard them
       else if (!reduceProblem()) {
         assert(0 && "Added equality constraint to verified problem generates false");
@@ -106,11 +103,11 @@ returnFalse:
 
 int Problem::simplifyApproximate(bool strides_allowed) {
   int result;
-  checkVars(nVars+1);
-  assert(inApproximateMode  == 0);
+  reserveVars(nVars);
+  assert(ctx->inApproximateMode  == 0);
 
-  inApproximateMode = 1;
-  inStridesAllowedMode = strides_allowed;
+  ctx->inApproximateMode = 1;
+  ctx->inStridesAllowedMode = strides_allowed;
   if (TRACE)
     fprintf(outputFile, "Entering Approximate Mode [\n");
 
@@ -130,9 +127,9 @@ int Problem::simplifyApproximate(bool strides_allowed) {
   if (TRACE)
     fprintf(outputFile, "] Leaving Approximate Mode\n");
     
-  assert(inApproximateMode  == 1);
-  inApproximateMode=0;
-  inStridesAllowedMode = 0;
+  assert(ctx->inApproximateMode  == 1);
+  ctx->inApproximateMode=0;
+  ctx->inStridesAllowedMode = 0;
 
   assert(nMemories == 0);
   return (result);
@@ -157,9 +154,9 @@ redCheck Problem::redSimplifyProblem(int effort, int computeGist) {
   int result;
   int e;
 
-  checkVars(nVars+1);
-  assert(mayBeRed >= 0);
-  mayBeRed++;
+  reserveVars(nVars);
+  assert(ctx->mayBeRed >= 0);
+  ctx->mayBeRed++;
 
   assert(omegaInitialized);
   if (TRACE) {
@@ -195,7 +192,7 @@ redCheck Problem::redSimplifyProblem(int effort, int computeGist) {
 #endif
 
   // Save known integer modular equations, -- by chun 12/10/2006
-  eqn ModularEQs[nEQs];
+  EqnBuffer ModularEQs(nEQs, nVars);
   int nModularEQs = 0;
   int old_nVars = nVars;
   for (int e = 0; e < nEQs; e++)
@@ -223,7 +220,7 @@ redCheck Problem::redSimplifyProblem(int effort, int computeGist) {
       EQs[neweq].color = EQ_RED;
       EQs[neweq].coef[0] = 1;
     }
-    mayBeRed--;
+    ctx->mayBeRed--;
     return redFalse;
   }
 
@@ -245,7 +242,7 @@ redCheck Problem::redSimplifyProblem(int effort, int computeGist) {
       EQs[neweq].color = EQ_RED;
       EQs[neweq].coef[0] = 1;
     }
-    mayBeRed--;
+    ctx->mayBeRed--;
     return redFalse;
   }
 
@@ -262,7 +259,7 @@ redCheck Problem::redSimplifyProblem(int effort, int computeGist) {
       nMemories = 0;
       nEQs = 0;
     }
-    mayBeRed--;
+    ctx->mayBeRed--;
     return noRed;
   }
 
@@ -287,7 +284,7 @@ redCheck Problem::redSimplifyProblem(int effort, int computeGist) {
       EQs[neweq].color = EQ_RED;
       EQs[neweq].coef[0] = 1;
     }
-    mayBeRed--;
+    ctx->mayBeRed--;
     return redFalse;
   }
 
@@ -306,7 +303,7 @@ redCheck Problem::redSimplifyProblem(int effort, int computeGist) {
       nMemories = 0;
       nEQs = 0;
     }
-    mayBeRed--;
+    ctx->mayBeRed--;
     return noRed;
   }
 
@@ -336,7 +333,7 @@ redCheck Problem::redSimplifyProblem(int effort, int computeGist) {
         nMemories = 0;
         nEQs = 0;
       }
-      mayBeRed--;
+      ctx->mayBeRed--;
       return noRed;
     }
      
@@ -352,10 +349,10 @@ redCheck Problem::redSimplifyProblem(int effort, int computeGist) {
     // Restore saved modular equations into EQs without affecting the problem
     if (nEQs+nModularEQs > allocEQs) {
       allocEQs = padEQs(allocEQs, nEQs+nModularEQs);
-      eqn *new_eqs = new eqn[allocEQs];
+      eqn *new_eqs = newEqns(allocEQs, allocVars);
       for (int e = 0; e < nEQs; e++)
         eqnncpy(&(new_eqs[e]), &(EQs[e]), nVars);
-      delete[] EQs;
+      deleteEqns(EQs);
       EQs= new_eqs;
     }
    
@@ -481,7 +478,7 @@ redCheck Problem::redSimplifyProblem(int effort, int computeGist) {
   }
   
   setExternals();
-  mayBeRed--;
+  ctx->mayBeRed--;
   assert(nMemories == 0);
   return redConstraints;
 }
@@ -59,7 +59,6 @@ void Problem::simplifyStrideConstraints() {
 void Problem::doMod(coef_t factor, int e, int j) {
 	/* Solve e = factor alpha for x_j and substitute */
 	int k;
-	eqn eq;
 	coef_t nFactor;
 
 	int alpha;
@@ -71,8 +70,10 @@ void Problem::doMod(coef_t factor, int e, int j) {
 		EQs[e].color = EQ_BLACK;
 	}
 	alpha = addNewUnprotectedWildcard();
+	EqnBuffer buf(1, nVars);
+	eqn &eq = buf[0];
 	eqnncpy(&eq, &EQs[e], nVars);
-	newVar = alpha;
+	ctx->newVar = alpha;
 
 	if (DEBUG) {
 		fprintf(outputFile, "doing moding: ");
@@ -95,7 +96,7 @@ void Problem::doMod(coef_t factor, int e, int j) {
 
 	eq.coef[j] = 0;
 	substitute(&eq, j, nFactor);
-	newVar = -1;
+	ctx->newVar = -1;
 	deleteVariable(j);
 	for (k = nVars; k >= 0; k--) {
 		assert(EQs[e].coef[k] % factor == 0);
@@ -138,7 +139,7 @@ void Problem::substitute(eqn *sub, int i, coef_t c) {
 			if (!(GEQs[e].color || !GEQs[e].coef[i]))
 				unsafeSub = true;
 		for (e = nSUBs - 1; e >= 0; e--)
-			if (SUBs[e].coef[i])
+			if (ctx->SUBs[e].coef[i])
 				unsafeSub = true;
 		if (unsafeSub) {
 			fprintf(outputFile, "UNSAFE RED SUBSTITUTION\n");
@@ -159,7 +160,7 @@ void Problem::substitute(eqn *sub, int i, coef_t c) {
 			k = check_mul(k, c); // Should be k = k/c, but same effect since abs(c) == 1
 			eq->coef[i] = 0;
 			for (j = nVars; j >= 0; j--) {
-				eq->coef[j] -= check_mul(sub->coef[j], k);
+				eq->coef[j] = check_sub(eq->coef[j], check_mul(sub->coef[j], k));
 			}
 		}
 		if (DEBUG) {
@@ -178,7 +179,7 @@ void Problem::substitute(eqn *sub, int i, coef_t c) {
 			eq->coef[i] = 0;
 			zero = 1;
 			for (j = nVars; j >= 0; j--) {
-				eq->coef[j] -= check_mul(sub->coef[j], k);
+				eq->coef[j] = check_sub(eq->coef[j], check_mul(sub->coef[j], k));
 				if (j > 0 && eq->coef[j])
 					zero = 0;
 			}
@@ -242,7 +243,7 @@ void Problem::substitute(eqn *sub, int i, coef_t c) {
 	if (recordSubstitution) {
 		int s = nSUBs++;
 		int kk;
-		eqn *eq = &(SUBs[s]);
+		eqn *eq = &(ctx->SUBs[s]);
 		for (kk = nVars; kk >= 0; kk--)
 			eq->coef[kk] = check_mul(-c, (sub->coef[kk]));
 		eq->key = var[i];
@@ -263,13 +264,13 @@ void Problem::substitute(eqn *sub, int i, coef_t c) {
 	}
 
 	for (e = nSUBs - 1; e >= 0; e--) {
-		eqn *eq = &(SUBs[e]);
+		eqn *eq = &(ctx->SUBs[e]);
 		k = eq->coef[i];
 		if (k != 0) {
 			k = check_mul(k, c); // Should be k = k/c, but same effect since abs(c) == 1
 			eq->coef[i] = 0;
 			for (j = nVars; j >= 0; j--) {
-				eq->coef[j] -= check_mul(sub->coef[j], k);
+				eq->coef[j] = check_sub(eq->coef[j], check_mul(sub->coef[j], k));
 			}
 		}
 		if (DEBUG) {
@@ -291,7 +292,8 @@ void Problem::doElimination(int e, int i) {
 	if (DBUG || doTrace)
 		fprintf(outputFile, "eliminating variable %s\n", variable(i));
 
-	eqn sub;
+	EqnBuffer buf(1, nVars);
+	eqn &sub = buf[0];
 	eqnncpy(&sub, &EQs[e], nVars);
 	coef_t c = sub.coef[i];
 	sub.coef[i] = 0;
@@ -305,7 +307,7 @@ void Problem::doElimination(int e, int i) {
 					"performing non-exact elimination, c = " coef_fmt "\n", c);
 		if (DBUG)
 			printProblem();
-		assert(inApproximateMode);
+		assert(ctx->inApproximateMode);
 
 		for (int e2 = nEQs - 1; e2 >= 0; e2--) {
 			eqn *eq = &(EQs[e2]);
@@ -320,7 +322,7 @@ void Problem::doElimination(int e, int i) {
 				if (k < 0)
 					scale2 = -scale2;
 				for (int j = nVars; j >= 0; j--)
-					eq->coef[j] -= check_mul(sub.coef[j], scale2);
+					eq->coef[j] = check_sub(eq->coef[j], check_mul(sub.coef[j], scale2));
 				eq->color |= sub.color;
 			}
 		}
@@ -337,13 +339,13 @@ void Problem::doElimination(int e, int i) {
 				if (k < 0)
 					scale2 = -scale2;
 				for (int j = nVars; j >= 0; j--)
-					eq->coef[j] -= check_mul(sub.coef[j], scale2);
+					eq->coef[j] = check_sub(eq->coef[j], check_mul(sub.coef[j], scale2));
 				eq->color |= sub.color;
 				eq->touched = 1;
 			}
 		}
 		for (int e2 = nSUBs - 1; e2 >= 0; e2--)
-			if (SUBs[e2].coef[i]) {
+			if (ctx->SUBs[e2].coef[i]) {
 				eqn *eq = &(EQs[e2]);
 				assert(0);
 				// We can't handle this since we can't multiply
@@ -354,7 +356,7 @@ void Problem::doElimination(int e, int i) {
 				coef_t k = eq->coef[i];
 				eq->coef[i] = 0;
 				for (int j = nVars; j >= 0; j--)
-					eq->coef[j] -= check_mul(sub.coef[j], k / c);
+					eq->coef[j] = check_sub(eq->coef[j], check_mul(sub.coef[j], k / c));
 			}
 	}
 	deleteVariable(i);
@@ -393,7 +395,7 @@ int Problem::solveEQ() {
 				delay[e] += 0;
 			else if (unitWildCards >= 1 && nonunitWildCards == 0)
 				delay[e] += 1;
-			else if (inApproximateMode && nonunitWildCards > 0)
+			else if (ctx->inApproximateMode && nonunitWildCards > 0)
 				delay[e] += 2;
 			else if (unit == 1 && nonUnit == 0 && nonunitWildCards == 0)
 				delay[e] += 3;
@@ -415,7 +417,8 @@ int Problem::solveEQ() {
 				int tmp = delay[slowest];
 				delay[slowest] = delay[e];
 				delay[e] = tmp;
-				eqn eq;
+				EqnBuffer buf(1, nVars);
+				eqn &eq = buf[0];
 				eqnncpy(&eq, &EQs[slowest], nVars);
 				eqnncpy(&EQs[slowest], &EQs[e], nVars);
 				eqnncpy(&EQs[e], &eq, nVars);
@@ -429,7 +432,7 @@ int Problem::solveEQ() {
 		eqn *eq = &(EQs[e]);
 		coef_t g, g2;
 
-		assert(mayBeRed || !eq->color);
+		assert(ctx->mayBeRed || !eq->color);
 
 		check();
 
@@ -454,7 +457,7 @@ int Problem::solveEQ() {
 
 		// approximate mode bypass integer modular test; in Farkas(),
 		// existential variable lambda's are rational numbers.
-		if (inApproximateMode && g2 != 0)
+		if (ctx->inApproximateMode && g2 != 0)
 			g = gcd(abs(eq->coef[0]), g);
 
 		// simple test to see if the equation is satisfiable
@@ -548,7 +551,7 @@ int Problem::solveEQ() {
 					if (e2 >= 0)
 						continue;
 					for (e2 = nSUBs - 1; e2 >= 0; e2--)
-						if (SUBs[e2].coef[k])
+						if (ctx->SUBs[e2].coef[k])
 							break;
 					if (e2 >= 0)
 						continue;
@@ -584,13 +587,14 @@ int Problem::solveEQ() {
 		}
 
 		// insert new stride constraint
-		if (g2 > 1 && !(inApproximateMode && !inStridesAllowedMode)) {
+		if (g2 > 1 && !(ctx->inApproximateMode && !ctx->inStridesAllowedMode)) {
 			int newvar = addNewProtectedWildcard();
 			int neweq = newEQ();
 			assert(neweq == e+1);
 			// we were working on highest-numbered EQ
 			eqnnzero(&EQs[neweq], nVars);
-			eqnncpy(&EQs[neweq], eq, safeVars);
+			// both calls above may have moved the rows eq pointed into
+			eqnncpy(&EQs[neweq], &EQs[e], safeVars);
 
 			for (int k = nVars; k >= 0; k--) {
 				EQs[neweq].coef[k] = int_mod_hat(EQs[neweq].coef[k], g2);
@@ -603,7 +607,7 @@ int Problem::solveEQ() {
 		}
 
 		// inexact elimination of unprotected variable
-		if (g2 > 0 && inApproximateMode) {
+		if (g2 > 0 && ctx->inApproximateMode) {
 			int pos = 0;
 			for (int k = nVars; k > safeVars; k--)
 				if (eq->coef[k] != 0) {
@@ -617,7 +621,7 @@ int Problem::solveEQ() {
 			if (abs(eq->coef[pos]) > 1) {
 				int e2;
 				for (e2 = nSUBs - 1; e2 >= 0; e2--)
-					if (SUBs[e2].coef[pos])
+					if (ctx->SUBs[e2].coef[pos])
 						break;
 				if (e2 >= 0) {
 					protectWildcard(pos);
@@ -13,7 +13,6 @@
 *****************************************************************************/
 
 #include <omega/omega_core/oc_i.h>
-#include <basic/boolset.h>
 #include <vector>
 
 namespace omega {
@@ -23,11 +22,11 @@ int Problem::expensiveKill() {
   if (TRACE) fprintf(outputFile,"Performing expensive kill tests: [\n");
   if (DBUG) printProblem();
   Problem tmpProblem;
-  int oldTrace = trace;
+  int oldTrace = ctx->trace;
   int constraintsRemoved = 0;
 
-  trace = 0;
-  conservative++;
+  ctx->trace = 0;
+  ctx->conservative++;
 
   for (e = nGEQs - 1; e >= 0; e--)
     if (!GEQs[e].essential) {
@@ -57,8 +56,8 @@ int Problem::expensiveKill() {
     if (TRACE) fprintf(outputFile,"%d Constraints removed!!\n",constraintsRemoved);
   }
 
-  trace = oldTrace;
-  conservative--;
+  ctx->trace = oldTrace;
+  ctx->conservative--;
   if (TRACE) fprintf(outputFile,"] expensive kill tests done\n");
   return 1;
 }
@@ -67,11 +66,11 @@ int Problem::expensiveRedKill() {
   int e;
   if (TRACE) fprintf(outputFile,"Performing expensive red kill tests: [\n");
   Problem tmpProblem;
-  int oldTrace = trace;
+  int oldTrace = ctx->trace;
   int constraintsRemoved = 0;
 
-  trace = 0;
-  conservative++;
+  ctx->trace = 0;
+  ctx->conservative++;
 
   for (e = nGEQs - 1; e >= 0; e--)
     if (!GEQs[e].essential && GEQs[e].color) {
@@ -99,8 +98,8 @@ int Problem::expensiveRedKill() {
     if (TRACE) fprintf(outputFile,"%d Constraints removed!!\n",constraintsRemoved);
   }
 
-  trace = oldTrace;
-  conservative--;
+  ctx->trace = oldTrace;
+  ctx->conservative--;
   if (TRACE) fprintf(outputFile,"] expensive red kill tests done\n");
   return 1;
 }
@@ -111,11 +110,11 @@ int Problem::expensiveEqualityCheck() {
   return 1;
   if (TRACE) fprintf(outputFile,"Performing expensive equality tests: [\n");
   Problem tmpProblem;
-  int oldTrace = trace;
+  int oldTrace = ctx->trace;
   int equalitiesFound = 0;
 
-  trace = 0;
-  conservative++;
+  ctx->trace = 0;
+  ctx->conservative++;
 
   for (e = nGEQs - 1; e >= 0; e--) {
     if (DEBUG) {
@@ -142,8 +141,8 @@ int Problem::expensiveEqualityCheck() {
     if (TRACE) fprintf(outputFile,"%d Equalities found!!\n",equalitiesFound);
   }
 
-  trace = oldTrace;
-  conservative--;
+  ctx->trace = oldTrace;
+  ctx->conservative--;
   if (equalitiesFound) {
     if (!solveEQ()) return 0;
     if (!normalize()) return 0;
@@ -171,9 +170,12 @@ void Problem::quickRedKill(int computeGist) {
 
   int isDead[nGEQs];
   int deadCount = 0;
-  std::vector<BoolSet<> > P(nGEQs, BoolSet<>(nVars)), Z(nGEQs, BoolSet<>(nVars)), N(nGEQs, BoolSet<>(nVars));
-  BoolSet<> PP, PZ, PN; /* possible Positives, possible zeros & possible negatives */
-  BoolSet<> MZ; /* must zeros */
+  eqnSignatures sig(nGEQs, nVars);
+  const int words = signatureWords(nVars);
+  std::vector<uint64_t> PP(words), PZ(words), PN(words); /* possible Positives, possible zeros & possible negatives */
+  std::vector<uint64_t> MZ(words); /* must zeros */
+  std::vector<uint64_t> support(words);
+  std::vector<int> vars(nVars + 1);
   
   int equationsToKill = 0;
   for (int e = nGEQs - 1; e >= 0; e--) {
@@ -184,14 +186,7 @@ void Problem::quickRedKill(int computeGist) {
         if (DBUG) fprintf(outputFile, "] quickRedKill\n");
         return;
       }
-    for (int i = nVars; i >= 1; i--) {
-      if (GEQs[e].coef[i] > 0)
-        P[e].set(i-1);
-      else if (GEQs[e].coef[i] < 0)
-        N[e].set(i-1);
-      else
-        Z[e].set(i-1);
-    }
+    sig[e].compute(GEQs[e], nVars);
   }
 
   if (!equationsToKill) 
@@ -204,10 +199,26 @@ void Problem::quickRedKill(int computeGist) {
     if (!isDead[e])
       for (int e2 = e - 1; e2 >= 0; e2--)
         if (!isDead[e2]) {
+          const eqnSignature &s1 = sig[e], &s2 = sig[e2];
+          for (int w = 0; w < words; w++)
+            support[w] = s1.pos[w] | s1.neg[w] | s2.pos[w] | s2.neg[w];
+          int nSupport = signatureVars(&support[0], words, &vars[0]);
+
+          // first nonzero 2x2 minor, scanning from the highest variable
           coef_t a = 0;
           int i, j;
-          for (i = nVars; i > 1; i--) {
-            for (j = i - 1; j > 0; j--) {
+          if (s1.direction == s2.direction && nSupport > 0) {
+            int k;
+            for (k = 0; k < nSupport; k++)
+              if (GEQs[e].coef[vars[k]] * GEQs[e2].coef[vars[0]] != GEQs[e2].coef[vars[k]] * GEQs[e].coef[vars[0]])
+                break;
+            if (k == nSupport)
+              continue;  // parallel
+          }
+          for (int ii = 0; ii < nSupport; ii++) {
+            for (int jj = ii + 1; jj < nSupport; jj++) {
+              i = vars[ii];
+              j = vars[jj];
               a = (GEQs[e].coef[i] * GEQs[e2].coef[j] - GEQs[e2].coef[i] * GEQs[e].coef[j]);
               if (a != 0)
                 goto foundPair;
@@ -225,17 +236,27 @@ void Problem::quickRedKill(int computeGist) {
             fprintf(outputFile, "\n");
           }
 
-          MZ = (Z[e] & Z[e2]);
-          PZ = MZ |  (P[e] & N[e2]) | (N[e] & P[e2]);
-          PP = P[e] | P[e2];
-          PN = N[e] | N[e2];
+          for (int w = 0; w < words; w++) {
+            MZ[w] = s1.zero[w] & s2.zero[w];
+            PZ[w] = MZ[w] | (s1.pos[w] & s2.neg[w]) | (s1.neg[w] & s2.pos[w]);
+            PP[w] = s1.pos[w] | s2.pos[w];
+            PN[w] = s1.neg[w] | s2.neg[w];
+          }
 
           for (int e3 = nGEQs - 1; e3 >= 0; e3--)
             if (e3 != e && e3 != e2 && GEQs[e3].color && !GEQs[e3].essential) {
               coef_t alpha1, alpha2, alpha3;
 
-              if (!PZ.imply(Z[e3]) || MZ.imply(~Z[e3])) continue;
-              if (!PP.imply(P[e3]) || !PN.imply(N[e3])) continue;
+              const eqnSignature &s3 = sig[e3];
+              bool possible = true, mustZero = true;
+              for (int w = 0; w < words; w++) {
+                uint64_t nonzero3 = s3.pos[w] | s3.neg[w];
+                if ((s3.zero[w] & ~PZ[w]) | (s3.pos[w] & ~PP[w]) | (s3.neg[w] & ~PN[w]))
+                  possible = false;
+                if (nonzero3 & ~MZ[w])
+                  mustZero = false;
+              }
+              if (!possible || mustZero) continue;
 
               if (a > 0) {
                 alpha1 = GEQs[e2].coef[j] * GEQs[e3].coef[i] - GEQs[e2].coef[i] * GEQs[e3].coef[j];
@@ -254,19 +275,22 @@ void Problem::quickRedKill(int computeGist) {
                   printGEQ(&(GEQs[e3]));
                   fprintf(outputFile, "\n");
                 }
+                // all three are zero outside the support
                 coef_t c;
                 int k;
-                for (k = nVars; k >= 0; k--) {
-                  c = alpha1 * GEQs[e].coef[k] + alpha2 * GEQs[e2].coef[k];
-                  if (DEBUG) {
-                    if (k>0) 
-                      fprintf(outputFile, " %s: " coef_fmt ", " coef_fmt "\n", variable(k), c, alpha3 * GEQs[e3].coef[k]);
-                    else fprintf(outputFile, " constant: " coef_fmt ", " coef_fmt "\n", c, alpha3 * GEQs[e3].coef[k]);
-                  }
-                  if (c != alpha3 * GEQs[e3].coef[k])
+                for (k = 0; k < nSupport; k++) {
+                  c = alpha1 * GEQs[e].coef[vars[k]] + alpha2 * GEQs[e2].coef[vars[k]];
+                  if (DEBUG)
+                    fprintf(outputFile, " %s: " coef_fmt ", " coef_fmt "\n", variable(vars[k]), c, alpha3 * GEQs[e3].coef[vars[k]]);
+                  if (c != alpha3 * GEQs[e3].coef[vars[k]])
                     break;
                 }
-                if (k < 0 || (k == 0 && c < alpha3 * (GEQs[e3].coef[k]+1))) {
+                if (k < nSupport)
+                  continue;
+                c = alpha1 * GEQs[e].coef[0] + alpha2 * GEQs[e2].coef[0];
+                if (DEBUG)
+                  fprintf(outputFile, " constant: " coef_fmt ", " coef_fmt "\n", c, alpha3 * GEQs[e3].coef[0]);
+                if (c < alpha3 * (GEQs[e3].coef[0]+1)) {
                   if (DEBUG) {
                     deadCount++;
                     fprintf(outputFile, "red equation#%d is dead (%d dead so far, %d remain)\n", e3, deadCount, nGEQs - deadCount);
@@ -79,7 +79,7 @@ std::string Problem::print_sub_to_string(int v) const {
   if (v > 0) 
     s = variable(v);
   else 
-    s = print_term_to_string(&SUBs[-v-1], 1);
+    s = print_term_to_string(&ctx->SUBs[-v-1], 1);
   return s;
 }
 
@@ -91,17 +91,17 @@ void Problem::clearSubs() {
 
 
 void Problem::printEqn(const eqn *e, int test, int extra) const {
-  char buf[maxVars * 12 + 180]; // original buf[maxVars * 12 + 80]
+  std::vector<char> buf((nVars + 1) * 12 + 180); // original buf[maxVars * 12 + 80]
 
-  sprintEqn(buf, e, test, extra);
-  fprintf(outputFile, "%s", buf);
+  sprintEqn(&buf[0], e, test, extra);
+  fprintf(outputFile, "%s", &buf[0]);
 }
 
 
 std::string Problem::printEqnToString(const eqn *e, int test, int extra) const {
-  char buf[maxVars * 12 + 180]; // original buf[maxVars * 12 + 80]
-  sprintEqn(buf, e, test, extra);
-  return std::string(buf);
+  std::vector<char> buf((nVars + 1) * 12 + 180); // original buf[maxVars * 12 + 80]
+  sprintEqn(&buf[0], e, test, extra);
+  return std::string(&buf[0]);
 }
 
 
@@ -229,7 +229,7 @@ void Problem::sprintEqn(char *str, const eqn *e, int test, int extra) const {
 
 
 void Problem::printSubstitution(int s) const {
-  const eqn * eq = &(SUBs[s]);
+  const eqn * eq = &(ctx->SUBs[s]);
   assert(eq->key > 0);
   fprintf(outputFile, "%s := ", orgVariable(eq->key));
   printTerm(eq, 1);
@@ -307,7 +307,7 @@ void Problem::printProblem(int debug) const {
   for (e = 0; e < nMemories; e++) {
     int i;
     printHeader();
-    switch(redMemory[e].kind) {
+    switch(ctx->redMemory[e].kind) {
     case notRed:
       fprintf(outputFile,"notRed: ");
       break;
@@ -321,15 +321,15 @@ void Problem::printProblem(int debug) const {
       fprintf(outputFile,"Red: 0 == ");
       break;
     case redStride:
-      fprintf(outputFile,"Red stride " coef_fmt ": ", redMemory[e].stride);
+      fprintf(outputFile,"Red stride " coef_fmt ": ", ctx->redMemory[e].stride);
       break;
     }
-    fprintf(outputFile," " coef_fmt, redMemory[e].constantTerm);
-    for(i=0;i< redMemory[e].length; i++)
-      if(redMemory[e].coef[i] >= 0)
-        fprintf(outputFile,"+" coef_fmt "%s", redMemory[e].coef[i], orgVariable(redMemory[e].var[i]));
+    fprintf(outputFile," " coef_fmt, ctx->redMemory[e].constantTerm);
+    for(i=0;i< ctx->redMemory[e].length; i++)
+      if(ctx->redMemory[e].coef[i] >= 0)
+        fprintf(outputFile,"+" coef_fmt "%s", ctx->redMemory[e].coef[i], orgVariable(ctx->redMemory[e].var[i]));
       else
-        fprintf(outputFile,"-" coef_fmt "%s", -redMemory[e].coef[i], orgVariable(redMemory[e].var[i]));
+        fprintf(outputFile,"-" coef_fmt "%s", -ctx->redMemory[e].coef[i], orgVariable(ctx->redMemory[e].var[i]));
     fprintf(outputFile, "\n");
   }
   fflush(outputFile);
@@ -357,7 +357,7 @@ void Problem::printRedEquations() const {
     }
   }
   for (e = 0; e < nSUBs; e++) {
-    if (SUBs[e].color) {
+    if (ctx->SUBs[e].color) {
       printSubstitution(e);
       fprintf(outputFile, "\n");
     }
@@ -378,7 +378,7 @@ std::string Problem::prettyPrintProblemToString() const {
   std::string s="";
   int e;
   int v;
-  int live[maxmaxGEQs];
+  std::vector<int> live(nGEQs);
   int v1, v2, v3;
   int t, change;
   int stuffPrinted = 0;
@@ -388,13 +388,13 @@ std::string Problem::prettyPrintProblemToString() const {
     none, le, lt
   } partialOrderType;
 
-  partialOrderType po[maxVars][maxVars];
-  int poE[maxVars][maxVars];
-  int lastLinks[maxVars];
-  int firstLinks[maxVars];
-  int chainLength[maxVars];
-  int chain[maxVars];
-  int varCount[maxVars];
+  std::vector<std::vector<partialOrderType> > po(nVars + 1, std::vector<partialOrderType>(nVars + 1));
+  std::vector<std::vector<int> > poE(nVars + 1, std::vector<int>(nVars + 1));
+  std::vector<int> lastLinks(nVars + 1);
+  std::vector<int> firstLinks(nVars + 1);
+  std::vector<int> chainLength(nVars + 1);
+  std::vector<int> chain(nVars + 1);
+  std::vector<int> varCount(nGEQs);
   int i, m, multiprint;
 
 
@@ -622,7 +622,7 @@ std::string Problem::prettyPrintProblemToString() const {
       }
 
     for (e = 0; e < nSUBs; e++) {
-      const eqn * eq = &SUBs[e];
+      const eqn * eq = &ctx->SUBs[e];
       if (stuffPrinted)
         s += connector;
       stuffPrinted = 1;
@@ -671,7 +671,7 @@ int Problem::prettyPrintRedEquations() const {
     }
   }
   for (e = 0; e < nSUBs; e++) {
-    if (SUBs[e].color) {
+    if (ctx->SUBs[e].color) {
       if (stuffPrinted)
         fprintf(outputFile, "%s", connector);
       stuffPrinted = 1;
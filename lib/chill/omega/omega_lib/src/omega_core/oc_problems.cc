@@ -1,13 +1,14 @@
 #include <omega/omega_core/oc_i.h> 
 #include <basic/omega_error.h>
+#include <new>
 
 #include "../../../chill_io.hh"
 
 namespace omega {
 
 Problem::~Problem() {
-  delete[] EQs;
-  delete[] GEQs;
+  deleteEqns(EQs);
+  deleteEqns(GEQs);
 }
 
 
@@ -16,23 +17,6 @@ void check_number_EQs(int n) {
     debug_fprintf(stderr,"ERROR: nEQs < 0??\n");
     exit(1);
   }
-
-  if (n > maxmaxEQs) {
-    // clear global variables
-    inApproximateMode = 0;
-    outerColor = 0;
-
-    throw presburger_error("\nERROR:\n"
-                           "An attempt was made to set the number of available equality constraints to " + to_string(n) + ".\n"
-                           "The maximum number of equality constraints in a conjunction is " + to_string(maxmaxEQs) + ".\n"
-                           "This limit can be changed by redefining maxmaxEQs in oc.h and recompiling.\n\n");
-
-    // debug_fprintf(stderr, "\nERROR:\n");
-    // debug_fprintf(stderr, "An attempt was made to set the number of available equality constraints to %d.\n", n);
-    // debug_fprintf(stderr, "The maximum number of equality constraints in a conjunction is %d.\n", maxmaxEQs);
-    // debug_fprintf(stderr, "This limit can be changed by redefining maxmaxEQs in oc.h and recompiling.\n\n");
-    // exit(2);
-  }
 }
 
 void check_number_GEQs(int n) {
@@ -40,23 +24,6 @@ void check_number_GEQs(int n) {
     debug_fprintf(stderr,"ERROR: nGEQs < 0??\n");
     exit(1);
   }
-
-  if (n > maxmaxGEQs) {
-    // clear global variables
-    inApproximateMode = 0;
-    outerColor = 0;
-    
-    throw presburger_error("\nERROR:\n"
-                           "An attempt was made to set the number of available inequality constraints to " + to_string(n) +".\n"
-                           "The maximum number of inequality constraints in a conjunction is " + to_string(maxmaxGEQs) +".\n"
-                           "This limit can be changed by redefining maxmaxGEQs in oc.h and recompiling.\n\n");
-
-    // debug_fprintf(stderr, "\nERROR:\n");
-    // debug_fprintf(stderr, "An attempt was made to set the number of available inequality constraints to %d.\n", n);
-    // debug_fprintf(stderr, "The maximum number of inequality constraints in a conjunction is %d.\n", maxmaxGEQs);
-    // debug_fprintf(stderr, "This limit can be changed by redefining maxmaxGEQs in oc.h and recompiling.\n\n");
-    // exit(2);
-  }
 }
 
 
@@ -71,10 +38,13 @@ Problem::Problem(int in_eqs, int in_geqs) {
   allocEQs = padEQs(in_eqs);
   allocGEQs = padGEQs(in_geqs);
   assert(allocEQs > 0 && allocGEQs > 0);
-  EQs = new eqn[allocEQs];
-  GEQs = new eqn[allocGEQs];
+  allocVars = min_alloc_vars;
+  EQs = newEqns(allocEQs, allocVars);
+  GEQs = newEqns(allocGEQs, allocVars);
+  var.resize(allocVars + 2);
+  forwardingAddress.resize(allocVars + 2);
   nVars = 0;
-  hashVersion = omega::hashVersion;
+  hashVersion = ctx->hashVersion;
   variablesInitialized = 0;
   variablesFreed = 0;
   varsOfInterest = 0;
@@ -90,9 +60,10 @@ Problem::Problem(const Problem & p2) {
   allocEQs = padEQs(p2.nEQs); // Don't over-allocate; p2 might have too many!
   allocGEQs = padGEQs(p2.nGEQs);
   assert(allocEQs > 0 && allocGEQs > 0);
-  EQs = new eqn[allocEQs];
-  GEQs = new eqn[allocGEQs];
-  int e, i;
+  allocVars = p2.allocVars;
+  EQs = newEqns(allocEQs, allocVars);
+  GEQs = newEqns(allocGEQs, allocVars);
+  int e;
   nVars = p2.nVars;
   hashVersion = p2.hashVersion;
   variablesInitialized = p2.variablesInitialized;
@@ -101,34 +72,33 @@ Problem::Problem(const Problem & p2) {
   safeVars = p2.safeVars;
   nEQs = p2.nEQs;
   isTemporary = p2.isTemporary;
-  //nSUBs = 0;
+  nSUBs = 0;
   for (e = p2.nEQs - 1; e >= 0; e--)
     eqnncpy(&(EQs[e]), &(p2.EQs[e]), p2.nVars);
   nGEQs = p2.nGEQs;
   for (e = p2.nGEQs - 1; e >= 0; e--)
     eqnncpy(&(GEQs[e]), &(p2.GEQs[e]), p2.nVars);
-  for (i = 0; i <= p2.nVars; i++)
-    var[i] = p2.var[i];
-  for (i = 0; i <= maxVars; i++)
-    forwardingAddress[i] = p2.forwardingAddress[i];
-  //nMemories = 0;
+  var = p2.var;
+  forwardingAddress = p2.forwardingAddress;
+  nMemories = 0;
   get_var_name = p2.get_var_name;
   getVarNameArgs = p2.getVarNameArgs;
 }
 
 Problem & Problem::operator=(const Problem & p2) {
   if (this != &p2) {
-    if(allocEQs < p2.nEQs) {
-      delete[] EQs;
-      allocEQs = padEQs(p2.nEQs);
-      EQs = new eqn[allocEQs];
+    if(allocEQs < p2.nEQs || allocVars < p2.allocVars) {
+      deleteEqns(EQs);
+      allocEQs = max(allocEQs, padEQs(p2.nEQs));
+      EQs = newEqns(allocEQs, max(allocVars, p2.allocVars));
     }
-    if(allocGEQs < p2.nGEQs) {
-      delete[] GEQs;
-      allocGEQs = padGEQs(p2.nGEQs);
-      GEQs = new eqn[allocGEQs];
+    if(allocGEQs < p2.nGEQs || allocVars < p2.allocVars) {
+      deleteEqns(GEQs);
+      allocGEQs = max(allocGEQs, padGEQs(p2.nGEQs));
+      GEQs = newEqns(allocGEQs, max(allocVars, p2.allocVars));
     }
-    int e, i;
+    allocVars = max(allocVars, p2.allocVars);
+    int e;
     nVars = p2.nVars;
     hashVersion = p2.hashVersion;
     variablesInitialized = p2.variablesInitialized;
@@ -143,10 +113,10 @@ Problem & Problem::operator=(const Problem & p2) {
     nGEQs = p2.nGEQs;
     for (e = p2.nGEQs - 1; e >= 0; e--)
       eqnncpy(&(GEQs[e]), &(p2.GEQs[e]), p2.nVars);
-    for (i = 0; i <= p2.nVars; i++)
-      var[i] = p2.var[i];
-    for (i = 0; i <= maxVars; i++)
-      forwardingAddress[i] = p2.forwardingAddress[i];
+    var = p2.var;
+    var.resize(allocVars + 2);
+    forwardingAddress = p2.forwardingAddress;
+    forwardingAddress.resize(allocVars + 2);
     //nMemories = 0;
     get_var_name = p2.get_var_name;
     getVarNameArgs = p2.getVarNameArgs;
@@ -159,20 +129,56 @@ void Problem::zeroVariable(int i) {
   int e;
   for (e = nGEQs - 1; e >= 0; e--) GEQs[e].coef[i] = 0;
   for (e = nEQs - 1; e >= 0; e--) EQs[e].coef[i] = 0;
-  for (e = nSUBs - 1; e >= 0; e--) SUBs[e].coef[i] = 0;
+  for (e = nSUBs - 1; e >= 0; e--) ctx->SUBs[e].coef[i] = 0;
 }
  
 /* Functions for allocating EQ's and GEQ's */
 
+eqn *newEqns(int n, int nVars) {
+  // The rows, then coef[0..nVars] of each row.
+  char *block = new char[n * (sizeof(eqn) + (nVars + 1) * sizeof(coef_t))];
+  eqn *rows = reinterpret_cast<eqn *>(block);
+  coef_t *coefs = reinterpret_cast<coef_t *>(block + n * sizeof(eqn));
+  for (int e = 0; e < n; e++) {
+    new (&rows[e]) eqn;
+    rows[e].coef = coefs + e * (nVars + 1);
+  }
+  return rows;
+}
+
+void deleteEqns(eqn *rows) {
+  delete[] reinterpret_cast<char *>(rows);
+}
+
+void Problem::reserveVars(int n) {
+  if (n + 1 > allocVars) {
+    int oldAllocVars = allocVars;
+    allocVars = max(2 * allocVars, n + 1);
+    eqn *new_eqs = newEqns(allocEQs, allocVars);
+    for (int e = allocEQs - 1; e >= 0; e--)
+      eqnncpy(&(new_eqs[e]), &(EQs[e]), oldAllocVars);
+    deleteEqns(EQs);
+    EQs = new_eqs;
+    eqn *new_geqs = newEqns(allocGEQs, allocVars);
+    for (int e = allocGEQs - 1; e >= 0; e--)
+      eqnncpy(&(new_geqs[e]), &(GEQs[e]), oldAllocVars);
+    deleteEqns(GEQs);
+    GEQs = new_geqs;
+    var.resize(allocVars + 2);
+    forwardingAddress.resize(allocVars + 2);
+  }
+  ctx->reserveVars(allocVars);
+}
+
 int Problem::newGEQ() {
   if (++nGEQs > allocGEQs) {
     check_number_GEQs(nGEQs);
     allocGEQs = padGEQs(allocGEQs, nGEQs);
     assert(allocGEQs >= nGEQs);
-    eqn *new_geqs = new eqn[allocGEQs];
+    eqn *new_geqs = newEqns(allocGEQs, allocVars);
     for (int e = nGEQs - 2; e >= 0; e--)
       eqnncpy(&(new_geqs[e]), &(GEQs[e]), nVars);
-    delete[] GEQs; 
+    deleteEqns(GEQs);
     GEQs = new_geqs;
   }
 //    problem->GEQs[nGEQs-1].color = black;
@@ -185,10 +191,10 @@ int Problem::newEQ() {
     check_number_EQs(nEQs);
     allocEQs = padEQs(allocEQs, nEQs);
     assert(allocEQs >= nEQs);
-    eqn *new_eqs = new eqn[allocEQs];
+    eqn *new_eqs = newEqns(allocEQs, allocVars);
     for (int e = nEQs - 2; e >= 0; e--)
       eqnncpy(&(new_eqs[e]), &(EQs[e]), nVars);
-    delete[] EQs; 
+    deleteEqns(EQs);
     EQs = new_eqs;
   }
 // Could do this here, but some calls to newEQ do a copy instead of a zero;
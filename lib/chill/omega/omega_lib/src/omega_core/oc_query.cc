@@ -10,21 +10,22 @@ void Problem::unprotectVariable( int v) {
     i = -1 - i;
     nSUBs--;
     if (i < nSUBs) {
-      eqnncpy(&SUBs[i], &SUBs[nSUBs], nVars);
-      forwardingAddress[SUBs[i].key] = -i - 1;
+      eqnncpy(&ctx->SUBs[i], &ctx->SUBs[nSUBs], nVars);
+      forwardingAddress[ctx->SUBs[i].key] = -i - 1;
     }
   }
   else {
-    int bringToLife[maxVars];
+    std::vector<int> bringToLife(nSUBs);
     int comingBack = 0;
     int e2;
     for (e = nSUBs - 1; e >= 0; e--)
-      if ((bringToLife[e] = (SUBs[e].coef[i] != 0)))
+      if ((bringToLife[e] = (ctx->SUBs[e].coef[i] != 0)))
         comingBack++;
 
     for (e2 = nSUBs - 1; e2 >= 0; e2--)
       if (bringToLife[e2]) {
 
+        reserveVars(nVars + 1);
         nVars++;
         safeVars++;
         if (safeVars < nVars) {
@@ -37,8 +38,8 @@ void Problem::unprotectVariable( int v) {
             EQs[e].coef[safeVars] = 0;
           }
           for (e = nSUBs - 1; e >= 0; e--) {
-            SUBs[e].coef[nVars] = SUBs[e].coef[safeVars];
-            SUBs[e].coef[safeVars] = 0;
+            ctx->SUBs[e].coef[nVars] = ctx->SUBs[e].coef[safeVars];
+            ctx->SUBs[e].coef[safeVars] = 0;
           }
           var[nVars] = var[safeVars];
           forwardingAddress[var[nVars]] = nVars;
@@ -51,27 +52,27 @@ void Problem::unprotectVariable( int v) {
             EQs[e].coef[safeVars] = 0;
           }
           for (e = nSUBs - 1; e >= 0; e--) {
-            SUBs[e].coef[safeVars] = 0;
+            ctx->SUBs[e].coef[safeVars] = 0;
           }
         }
 
-        var[safeVars] = SUBs[e2].key;
-        forwardingAddress[SUBs[e2].key] = safeVars;
+        var[safeVars] = ctx->SUBs[e2].key;
+        forwardingAddress[ctx->SUBs[e2].key] = safeVars;
 
         int neweq = newEQ();
-        eqnncpy(&(EQs[neweq]), &(SUBs[e2]), nVars);
+        eqnncpy(&(EQs[neweq]), &(ctx->SUBs[e2]), nVars);
         EQs[neweq].coef[safeVars] = -1;
         if (e2 < nSUBs - 1)
-          eqnncpy(&(SUBs[e2]), &(SUBs[nSUBs - 1]), nVars);
+          eqnncpy(&(ctx->SUBs[e2]), &(ctx->SUBs[nSUBs - 1]), nVars);
         nSUBs--;
       }
 
     if (i < safeVars) {
       j = safeVars;
       for (e = nSUBs - 1; e >= 0; e--) {
-        t = SUBs[e].coef[j];
-        SUBs[e].coef[j] = SUBs[e].coef[i];
-        SUBs[e].coef[i] = t;
+        t = ctx->SUBs[e].coef[j];
+        ctx->SUBs[e].coef[j] = ctx->SUBs[e].coef[i];
+        ctx->SUBs[e].coef[i] = t;
       }
       for (e = nGEQs - 1; e >= 0; e--)
         if (GEQs[e].coef[j] != GEQs[e].coef[i]) {
@@ -109,7 +110,7 @@ void Problem::constrainVariableSign( int color, int i, int sign) {
 
     if (sign != 0) {
       e = newGEQ();
-      eqnncpy(&GEQs[e], &SUBs[k], nVars);
+      eqnncpy(&GEQs[e], &ctx->SUBs[k], nVars);
       for (j = 0; j <= nV; j++)
         GEQs[e].coef[j] *= sign;
       GEQs[e].coef[0]--;
@@ -118,7 +119,7 @@ void Problem::constrainVariableSign( int color, int i, int sign) {
     }
     else {
       e = newEQ();
-      eqnncpy(&EQs[e], &SUBs[k], nVars);
+      eqnncpy(&EQs[e], &ctx->SUBs[k], nVars);
       EQs[e].color = color;
     }
   }
@@ -150,7 +151,7 @@ void Problem::constrainVariableValue( int color, int i, int value) {
     k = -1 - k;
 
     e = newEQ();
-    eqnncpy(&EQs[e], &SUBs[k], nVars);
+    eqnncpy(&EQs[e], &ctx->SUBs[k], nVars);
     EQs[e].coef[0] -= value;
 
   }
@@ -190,7 +191,7 @@ void Problem:: query_difference(int v1, int v2, coef_t &lowerBound, coef_t &uppe
         if (e2 < 0)
           for(e2 = nGEQs-1; e2>=0;e2--) if (e != e2 && GEQs[e2].coef[i]) break;
         if (e2 < 0)
-          for(e2 = nSUBs-1; e2>=0;e2--) if (e != e2 && SUBs[e2].coef[i]) break;
+          for(e2 = nSUBs-1; e2>=0;e2--) if (e != e2 && ctx->SUBs[e2].coef[i]) break;
         if (e2 >= 0) guaranteed = false;
       }
       else guaranteed = false;
@@ -211,9 +212,8 @@ void Problem:: query_difference(int v1, int v2, coef_t &lowerBound, coef_t &uppe
     else guaranteed = false;
   }
 
-  bool isDead[maxmaxGEQs];
+  std::vector<bool> isDead(nGEQs, false);
 
-  for (e = nGEQs - 1; e >= 0; e--) isDead[e] = false;
   int tryAgain = 1;
   while (tryAgain) {
     tryAgain = 0;
@@ -237,7 +237,7 @@ void Problem:: query_difference(int v1, int v2, coef_t &lowerBound, coef_t &uppe
         if (e2 < 0) {
           int e3;
           for (e3 = nSUBs - 1; e3 >= 0; e3--)
-            if (SUBs[e3].coef[i])
+            if (ctx->SUBs[e3].coef[i])
               break;
           if (e3 >= 0)
             continue;
@@ -317,17 +317,17 @@ int Problem::queryVariable(int i, coef_t *lowerBound, coef_t *upperBound) {
     int easy = true;
     i = -i - 1;
     for (j = 1; j <= nV; j++)
-      if (SUBs[i].coef[j] != 0)
+      if (ctx->SUBs[i].coef[j] != 0)
         easy = false;
     if (easy) {
-      *upperBound = *lowerBound = SUBs[i].coef[0];
+      *upperBound = *lowerBound = ctx->SUBs[i].coef[0];
       return (false);
     }
     return (true);
   }
 
   for (e = nSUBs - 1; e >= 0; e--)
-    if (SUBs[e].coef[i] != 0)
+    if (ctx->SUBs[e].coef[i] != 0)
       coupled = true;
 
   for (e = nEQs - 1; e >= 0; e--)
@@ -389,7 +389,7 @@ void Problem::queryCoupledVariable(int i, coef_t *l, coef_t *u, int *couldBeZero
   }
 
   if (forwardingAddress[i] == -1) {
-    eqn = &SUBs[0];
+    eqn = &ctx->SUBs[0];
     sign = 1;
     v = 1;
   }
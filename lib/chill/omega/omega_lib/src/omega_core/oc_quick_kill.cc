@@ -15,7 +15,6 @@
 #include <omega/omega_core/oc_i.h>
 #include <vector>
 #include <algorithm>
-#include <basic/boolset.h>
 
 namespace omega {
 
@@ -50,7 +49,7 @@ int Problem::combineToTighten() {
           has_wildcard2 = true;
       }
         
-      coef_t c, c2;
+      coef_t c, c2 = 0;
       if ((has_wildcard && !has_wildcard2) || (!has_wildcard && has_wildcard2))
         c = 0;
       else
@@ -268,23 +267,24 @@ namespace {
   struct succListStruct {
     int    num;
     int    notEssential;
-    int    var[maxVars];
-    coef_t diff[maxVars];
-    int    eqn[maxVars];
+    std::vector<int>    var;
+    std::vector<coef_t> diff;
+    std::vector<int>    eqn;
+    explicit succListStruct(int n): num(0), notEssential(0), var(n), diff(n), eqn(n) {}
   };
 }
   
 
 int Problem::chainKill(int color, int onlyWildcards) {
   int v1,v2,e;
-  int essentialPred[maxVars];
-  int redundant[maxmaxGEQs];
-  int inChain[maxVars];
-  int goodStartingPoint[maxVars];
-  int tryToEliminate[maxmaxGEQs];
+  std::vector<int> essentialPred(nVars + 1);
+  std::vector<int> redundant(nGEQs);
+  std::vector<int> inChain(nVars + 1);
+  std::vector<int> goodStartingPoint(nVars + 1);
+  std::vector<int> tryToEliminate(nGEQs);
   int triedDoubleKill = 0;
 
-  succListStruct succ[maxVars];
+  std::vector<succListStruct> succ(nVars + 1, succListStruct(nVars + 1));
 
 restart:
 
@@ -407,8 +407,8 @@ restart:
   
   while (1) {
     int chainLength;
-    int chain[maxVars];
-    coef_t distance[maxVars];
+    std::vector<int> chain(nVars + 2);
+    std::vector<coef_t> distance(nVars + 2);
     // pick a place to start
     for(v1 = 0;v1<=nVars;v1++)
       if (essentialPred[v1] == 0 && succ[v1].num > succ[v1].notEssential)
@@ -496,6 +496,108 @@ restart:
 }
 
 
+eqnSignatures::eqnSignatures(int n, int nVars):
+  bits(3 * n * signatureWords(nVars)), sig(n) {
+  const int words = signatureWords(nVars);
+  for (int e = 0; e < n; e++) {
+    sig[e].pos = &bits[3 * e * words];
+    sig[e].neg = sig[e].pos + words;
+    sig[e].zero = sig[e].neg + words;
+  }
+}
+
+
+void eqnSignature::compute(const eqn &e, int nVars) {
+  for (int w = 0; w < signatureWords(nVars); w++)
+    pos[w] = neg[w] = zero[w] = 0;
+
+  coef_t g = 0;
+  int first = 0;
+  for (int i = 1; i <= nVars; i++) {
+    uint64_t bit = static_cast<uint64_t>(1) << ((i-1) % 64);
+    if (e.coef[i] > 0)
+      pos[(i-1)/64] |= bit;
+    else if (e.coef[i] < 0)
+      neg[(i-1)/64] |= bit;
+    else {
+      zero[(i-1)/64] |= bit;
+      continue;
+    }
+    g = gcd(g, abs(e.coef[i]));
+    if (first == 0)
+      first = i;
+  }
+
+  direction = 0;
+  if (first != 0) {
+    coef_t unit = (e.coef[first] > 0) ? g : -g;
+    for (int i = first; i <= nVars; i++)
+      if (e.coef[i] != 0) {
+        direction = (direction ^ static_cast<uint64_t>(i)) * 1099511628211ULL;
+        direction = (direction ^ static_cast<uint64_t>(e.coef[i]/unit)) * 1099511628211ULL;
+      }
+  }
+}
+
+
+int signatureVars(const uint64_t *bits, int words, int *vars) {
+  int n = 0;
+  for (int w = words - 1; w >= 0; w--)
+    for (uint64_t b = bits[w]; b != 0; ) {
+#if defined(__GNUC__)
+      int i = 63 - __builtin_clzll(b);
+#else
+      int i = 63;
+      while (!((b >> i) & 1))
+        i--;
+#endif
+      vars[n++] = w*64 + i + 1;
+      b &= ~(static_cast<uint64_t>(1) << i);
+    }
+  return n;
+}
+
+
+//
+// Find the first pair of variables p > q (in the order of a scan from
+// nVars down) whose 2x2 minor in e1 and e2 is nonzero.  Only variables
+// in either constraint's support can give a nonzero minor, and
+// parallel constraints, recognized by their direction, have none.
+// Returns false when there is no such pair.
+//
+static bool findMinor(const eqn &e1, const eqnSignature &s1, const eqn &e2, const eqnSignature &s2,
+                      int *vars, int nVars, int &p, int &q, coef_t &alpha) {
+  if (s1.direction == s2.direction && nVars > 0) {
+    bool parallel = true;
+    int p0 = vars[0];
+    try {
+      for (int k = 0; k < nVars && parallel; k++)
+        parallel = (check_mul(e1.coef[vars[k]], e2.coef[p0]) == check_mul(e2.coef[vars[k]], e1.coef[p0]));
+    }
+    catch (const std::overflow_error &) {
+      parallel = false;
+    }
+    if (parallel)
+      return false;
+  }
+
+  for (int a = 0; a < nVars; a++)
+    for (int b = a + 1; b < nVars; b++) {
+      p = vars[a];
+      q = vars[b];
+      try {
+        alpha = check_mul(e1.coef[p], e2.coef[q]) - check_mul(e2.coef[p], e1.coef[q]);
+      }
+      catch (const std::overflow_error &) {
+        continue;
+      }
+      if (alpha != 0)
+        return true;
+    }
+  return false;
+}
+
+
 namespace {
   struct varCountStruct {
     int e;
@@ -548,25 +650,23 @@ int Problem::quickKill(int onlyWildcards, bool desperate) {
 
   int isDead[nGEQs];
   std::vector<varCountStruct> killOrder;
-  std::vector<BoolSet<> > P(nGEQs, BoolSet<>(nVars)), Z(nGEQs, BoolSet<>(nVars)), N(nGEQs, BoolSet<>(nVars));
-  BoolSet<> PP, PZ, PN; // possible Positives, possible zeros & possible negatives
+  eqnSignatures sig(nGEQs, nVars);
+  const int words = signatureWords(nVars);
+  std::vector<uint64_t> PP(words), PZ(words), PN(words); // possible Positives, possible zeros & possible negatives
+  std::vector<uint64_t> support(words);
+  std::vector<int> vars(nVars + 1);
 
   for (int e = nGEQs - 1; e >= 0; e--) {
     isDead[e] = 0;
+    sig[e].compute(GEQs[e], nVars);
     int safeVarCount = 0;
     int wildVarCount = 0;
     for (int i = nVars; i >= 1; i--) {
-      if (GEQs[e].coef[i] == 0)
-        Z[e].set(i-1);
-      else {
+      if (GEQs[e].coef[i] != 0) {
         if (i > safeVars)
           wildVarCount++;
         else
           safeVarCount++;
-        if (GEQs[e].coef[i] < 0)
-          N[e].set(i-1);
-        else
-          P[e].set(i-1);
       }
     }
 
@@ -598,25 +698,21 @@ int Problem::quickKill(int onlyWildcards, bool desperate) {
       if (!isDead[e1])
         for (int e2 = e1+1; e2 < nGEQs; e2++)
           if (!isDead[e2]) {
+            const eqnSignature &s1 = sig[e1], &s2 = sig[e2];
+            for (int w = 0; w < words; w++)
+              support[w] = s1.pos[w] | s1.neg[w] | s2.pos[w] | s2.neg[w];
+            int nSupport = signatureVars(&support[0], words, &vars[0]);
+
             coef_t alpha = 0;
             int p, q;
-            for (p = nVars; p > 1; p--) 
-              for (q = p - 1; q > 0; q--) {
-                try {
-                  alpha = check_mul(GEQs[e1].coef[p], GEQs[e2].coef[q]) - check_mul(GEQs[e2].coef[p], GEQs[e1].coef[q]);
-                }
-                catch (std::overflow_error) {
-                  continue;
-                }
-                if (alpha != 0)
-                  goto foundPQ;
-              }
-            continue;
+            if (!findMinor(GEQs[e1], s1, GEQs[e2], s2, &vars[0], nSupport, p, q, alpha))
+              continue;
 
-          foundPQ:
-            PZ = (Z[e1] & Z[e2]) | (P[e1] & N[e2]) | (N[e1] & P[e2]);
-            PP = P[e1] | P[e2];
-            PN = N[e1] | N[e2];
+            for (int w = 0; w < words; w++) {
+              PZ[w] = (s1.zero[w] & s2.zero[w]) | (s1.pos[w] & s2.neg[w]) | (s1.neg[w] & s2.pos[w]);
+              PP[w] = s1.pos[w] | s2.pos[w];
+              PN[w] = s1.neg[w] | s2.neg[w];
+            }
             if (DEBUG) {
               fprintf(outputFile,"Considering combination of ");
               printGEQ(&(GEQs[e1]));
@@ -631,8 +727,10 @@ int Problem::quickKill(int onlyWildcards, bool desperate) {
                 try {
                   coef_t alpha1, alpha2, alpha3;
 
-                  if (!PZ.imply(Z[e3]))
-                    goto nextE3;
+                  const eqnSignature &s3 = sig[e3];
+                  for (int w = 0; w < words; w++)
+                    if (s3.zero[w] & ~PZ[w])
+                      goto nextE3;
 
                   alpha1 = check_mul(GEQs[e2].coef[q], GEQs[e3].coef[p]) - check_mul(GEQs[e2].coef[p], GEQs[e3].coef[q]);
                   alpha2 = -(check_mul(GEQs[e1].coef[q], GEQs[e3].coef[p]) - check_mul(GEQs[e1].coef[p], GEQs[e3].coef[q]));
@@ -663,12 +761,13 @@ int Problem::quickKill(int onlyWildcards, bool desperate) {
                     if (!GEQs[e3].color && (GEQs[e1].color || GEQs[e2].color)) {
                       goto nextE3;
                     }
-                    if (!PP.imply(P[e3]) | !PN.imply(N[e3]))
-                      goto nextE3;
+                    for (int w = 0; w < words; w++)
+                      if ((s3.pos[w] & ~PP[w]) | (s3.neg[w] & ~PN[w]))
+                        goto nextE3;
 
-                    // verify alpha1*v1+alpha2*v2 = alpha3*v3
-                    for (int k = nVars; k >= 1; k--)
-                      if (check_mul(alpha3,  GEQs[e3].coef[k]) != check_mul(alpha1, GEQs[e1].coef[k]) + check_mul(alpha2, GEQs[e2].coef[k]))
+                    // verify alpha1*v1+alpha2*v2 = alpha3*v3, all three are zero outside the support
+                    for (int k = 0; k < nSupport; k++)
+                      if (check_mul(alpha3,  GEQs[e3].coef[vars[k]]) != check_mul(alpha1, GEQs[e1].coef[vars[k]]) + check_mul(alpha2, GEQs[e2].coef[vars[k]]))
                         goto nextE3;
 
                     coef_t c = check_mul(alpha1, GEQs[e1].coef[0]) + check_mul(alpha2, GEQs[e2].coef[0]);
@@ -689,12 +788,13 @@ int Problem::quickKill(int onlyWildcards, bool desperate) {
                     }
                   } 
                   else { // trying to prove e3 <= 0 or e3 = 0
-                    if (!PN.imply(P[e3]) | !PP.imply(N[e3]))
-                      goto nextE3;
+                    for (int w = 0; w < words; w++)
+                      if ((s3.pos[w] & ~PN[w]) | (s3.neg[w] & ~PP[w]))
+                        goto nextE3;
 
-                    // verify alpha1*v1+alpha2*v2 = alpha3*v3
-                    for (int k = nVars; k >= 1; k--)
-                      if (check_mul(alpha3, GEQs[e3].coef[k]) != check_mul(alpha1, GEQs[e1].coef[k]) + check_mul(alpha2, GEQs[e2].coef[k]))
+                    // verify alpha1*v1+alpha2*v2 = alpha3*v3, all three are zero outside the support
+                    for (int k = 0; k < nSupport; k++)
+                      if (check_mul(alpha3, GEQs[e3].coef[vars[k]]) != check_mul(alpha1, GEQs[e1].coef[vars[k]]) + check_mul(alpha2, GEQs[e2].coef[vars[k]]))
                         goto nextE3;
 
                     if (DEBUG) {
@@ -37,18 +37,7 @@ int checkIfSingleVar(eqn* e, int i) {
 
 
 int singleVarGEQ(eqn* e) {
-  return  !e->touched && e->key != 0 && -maxVars <= e->key && e->key <= maxVars;
-}
-
-
-void checkVars(int nVars) {
-  if (nVars > maxVars) {
-    debug_fprintf(stderr, "\nERROR:\n");
-    debug_fprintf(stderr, "An attempt was made to create a conjunction with %d variables.\n", nVars);
-    debug_fprintf(stderr, "The current limit on variables in a single conjunction is %d.\n", maxVars);
-    debug_fprintf(stderr, "This limit can be changed by changing the #define of maxVars in oc.h.\n\n");
-    exit(2);
-  }
+  return  !e->touched && e->key != 0 && -keyBase < e->key && e->key < keyBase;
 }
 
 
@@ -121,7 +110,7 @@ int Problem::countRedEquations() const {
   for (int e = 0; e < nGEQs; e++)
     if (GEQs[e].color == EQ_RED) result+=1;
   for (int e = 0; e < nMemories; e++)
-    switch(redMemory[e].kind ) {
+    switch(ctx->redMemory[e].kind ) {
     case redEQ:
     case redStride:
       e++;
@@ -135,7 +124,7 @@ int Problem::countRedEquations() const {
 }
 
 void Problem::deleteBlack() {
-  int RedVar[maxVars];
+  std::vector<int> RedVar(nVars + 1);
   for(int i = safeVars+1;i <= nVars;i++) RedVar[i] = 0;
 
   assert(nSUBs == 0);
@@ -167,7 +156,7 @@ void Problem::deleteBlack() {
 
 
 void Problem::deleteRed() {
-  int BlackVar[maxVars];
+  std::vector<int> BlackVar(nVars + 1);
   for(int i = safeVars+1;i <= nVars;i++) BlackVar[i] = 0;
 
   assert(nSUBs == 0);
@@ -234,8 +223,8 @@ void Problem:: deleteVariable(int i) {
       EQs[e].coef[j] = EQs[e].coef[nVars];
     }
     for (int e = nSUBs - 1; e >= 0; e--) {
-      SUBs[e].coef[i] = SUBs[e].coef[j];
-      SUBs[e].coef[j] = SUBs[e].coef[nVars];
+      ctx->SUBs[e].coef[i] = ctx->SUBs[e].coef[j];
+      ctx->SUBs[e].coef[j] = ctx->SUBs[e].coef[nVars];
     }
     var[i] = var[j];
     var[j] = var[nVars];
@@ -249,7 +238,7 @@ void Problem:: deleteVariable(int i) {
     for (int e = nEQs - 1; e >= 0; e--)
       EQs[e].coef[i] = EQs[e].coef[nVars];
     for (int e = nSUBs - 1; e >= 0; e--)
-      SUBs[e].coef[i] = SUBs[e].coef[nVars];
+      ctx->SUBs[e].coef[i] = ctx->SUBs[e].coef[nVars];
     var[i] = var[nVars];
   }
   if (i <= safeVars)
@@ -264,12 +253,12 @@ void Problem::setInternals() {
   }
 
   var[0] = 0;
-  nextWildcard = 0;
+  ctx->nextWildcard = 0;
   for(int i = 1;i <= nVars;i++)
     if (var[i] < 0) 
-      var[i] = --nextWildcard;
+      var[i] = --ctx->nextWildcard;
   
-  assert(nextWildcard >= -maxWildcards);
+  assert(ctx->nextWildcard >= -maxWildcards);
 
   CHECK_FOR_DUPLICATE_VARIABLE_NAMES;
 
@@ -277,19 +266,19 @@ void Problem::setInternals() {
   for(int i = 1;i <= safeVars;i++) if (var[i] > 0) v++;
   varsOfInterest = v;
 
-  if (nextKey * 3 > maxKeys) {
-    omega::hashVersion++;
-    nextKey = maxVars + 1;
+  if ((ctx->nextKey - keyBase) * 3 > ctx->maxKeys) {
+    ctx->hashVersion = SolverContext::newHashVersion();
+    ctx->nextKey = keyBase + 1;
     for (int e = nGEQs - 1; e >= 0; e--)
       GEQs[e].touched = true;
-    for (int i = 0; i < hashTableSize; i++)
-      hashMaster[i].touched = -1;
-    hashVersion = omega::hashVersion;
+    for (int i = 0; i < ctx->hashTableSize; i++)
+      ctx->hashMaster[i].touched = -1;
+    hashVersion = ctx->hashVersion;
   }
-  else if (hashVersion != omega::hashVersion) {
+  else if (hashVersion != ctx->hashVersion) {
     for (int e = nGEQs - 1; e >= 0; e--)
       GEQs[e].touched = true;
-    hashVersion = omega::hashVersion;
+    hashVersion = ctx->hashVersion;
   }
 }
 
@@ -298,7 +287,7 @@ void Problem::setExternals() {
   for (int i = 1; i <= safeVars; i++)
     forwardingAddress[var[i]] = i;
   for (int i = 0; i < nSUBs; i++)
-    forwardingAddress[SUBs[i].key] = -i - 1;
+    forwardingAddress[ctx->SUBs[i].key] = -i - 1;
 }
 
 
@@ -329,11 +318,11 @@ void Problem::putVariablesInStandardOrder() {
 void Problem::nameWildcard(int i) {
   int j;
   do {
-    --nextWildcard;
-    if (nextWildcard < -maxWildcards)
-      nextWildcard = -1;
-    var[i] = nextWildcard;
-    for(j = nVars; j > 0;j--) if (i!=j && var[j] == nextWildcard) break;
+    --ctx->nextWildcard;
+    if (ctx->nextWildcard < -maxWildcards)
+      ctx->nextWildcard = -1;
+    var[i] = ctx->nextWildcard;
+    for(j = nVars; j > 0;j--) if (i!=j && var[j] == ctx->nextWildcard) break;
   } while (j != 0); 
 }
 
@@ -348,6 +337,7 @@ int Problem::protectWildcard(int i) {
 
 
 int Problem::addNewProtectedWildcard() {
+  reserveVars(nVars + 1);
   int i = ++safeVars;
   nVars++;
   if (nVars != i) {
@@ -360,7 +350,7 @@ int Problem::addNewProtectedWildcard() {
       EQs[e].coef[nVars] = EQs[e].coef[i];
     }
     for (int e = nSUBs - 1; e >= 0; e--) {
-      SUBs[e].coef[nVars] = SUBs[e].coef[i];
+      ctx->SUBs[e].coef[nVars] = ctx->SUBs[e].coef[i];
     }
     var[nVars] = var[i];
   }
@@ -369,17 +359,18 @@ int Problem::addNewProtectedWildcard() {
   for (int e = nEQs - 1; e >= 0; e--)
     EQs[e].coef[i] = 0;
   for (int e = nSUBs - 1; e >= 0; e--)
-    SUBs[e].coef[i] = 0;
+    ctx->SUBs[e].coef[i] = 0;
   nameWildcard(i);
   return (i);
 }
 
 
 int Problem::addNewUnprotectedWildcard() {
+  reserveVars(nVars + 1);
   int i = ++nVars;
   for (int e = nGEQs - 1; e >= 0; e--) GEQs[e].coef[i] = 0;
   for (int e = nEQs - 1; e >= 0; e--) EQs[e].coef[i] = 0;
-  for (int e = nSUBs - 1; e >= 0; e--) SUBs[e].coef[i] = 0;
+  for (int e = nSUBs - 1; e >= 0; e--) ctx->SUBs[e].coef[i] = 0;
   nameWildcard(i);
   return i;
 }
@@ -403,7 +394,7 @@ void Problem::cleanoutWildcards() {
             coef_t coef1 = (EQs[e2].coef[i]>0?1:-1) * k / c;
             coef_t coef2 = k / abs(EQs[e2].coef[i]);
             for (int j = nVars; j >= 0; j--)
-              EQs[e2].coef[j] = EQs[e2].coef[j] * coef2 - EQs[e].coef[j] * coef1;
+              EQs[e2].coef[j] = check_sub(check_mul(EQs[e2].coef[j], coef2), check_mul(EQs[e].coef[j], coef1));
             
             coef_t g = 0;
             for (int j = nVars; j >= 0; j--) {
@@ -421,30 +412,29 @@ void Problem::cleanoutWildcards() {
             coef_t k = lcm(a, abs(GEQs[e2].coef[i]));
             coef_t coef1 = (GEQs[e2].coef[i]>0?1:-1) * k / c;
             coef_t coef2 = k / abs(GEQs[e2].coef[i]);
-            for (int j = nVars; j >= 0; j--)
-              GEQs[e2].coef[j] = GEQs[e2].coef[j] * coef2 - EQs[e].coef[j] * coef1;
+            combineGEQ(&GEQs[e2], &GEQs[e2], coef2, &EQs[e], -coef1, nVars);
             
             GEQs[e2].touched = 1;
             renormalize = true;
           }
         
         for (int e2 = nSUBs-1; e2 >= 0; e2--)
-          if (SUBs[e2].coef[i] != 0 && SUBs[e2].color >= EQs[e].color) {
-            coef_t k = lcm(a, abs(SUBs[e2].coef[i]));
-            coef_t coef1 = (SUBs[e2].coef[i]>0?1:-1) * k / c;
-            coef_t coef2 = k / abs(SUBs[e2].coef[i]);
+          if (ctx->SUBs[e2].coef[i] != 0 && ctx->SUBs[e2].color >= EQs[e].color) {
+            coef_t k = lcm(a, abs(ctx->SUBs[e2].coef[i]));
+            coef_t coef1 = (ctx->SUBs[e2].coef[i]>0?1:-1) * k / c;
+            coef_t coef2 = k / abs(ctx->SUBs[e2].coef[i]);
             for (int j = nVars; j >= 0; j--)
-              SUBs[e2].coef[j] = SUBs[e2].coef[j] * coef2 - EQs[e].coef[j] * coef1;
+              ctx->SUBs[e2].coef[j] = check_sub(check_mul(ctx->SUBs[e2].coef[j], coef2), check_mul(EQs[e].coef[j], coef1));
             
             coef_t g = 0;
             for (int j = nVars; j >= 0; j--) {
-              g = gcd(abs(SUBs[e2].coef[j]), g);
+              g = gcd(abs(ctx->SUBs[e2].coef[j]), g);
               if (g == 1)
                 break;
             }
             if (g != 0 && g != 1)
               for (int j = nVars; j >= 0; j--)
-                SUBs[e2].coef[j] /= g;            
+                ctx->SUBs[e2].coef[j] /= g;            
           }
 
         // remove redundent wildcard equality
@@ -460,7 +450,7 @@ void Problem::cleanoutWildcards() {
   }
 
   // remove multi-wildcard equality in approximation mode
-  if (inApproximateMode)
+  if (ctx->inApproximateMode)
     for (int e = nEQs-1; e >= 0; e--)
       for (int i = nVars; i >= safeVars+1; i--)
         if (EQs[e].coef[i] != 0) {
@@ -486,11 +476,11 @@ void Problem::cleanoutWildcards() {
 void Problem:: check() const {
 #ifndef NDEBUG
   int v = nSUBs;
-  checkVars(nVars+1);
+  assert(nVars < allocVars);
   for(int i = 1; i <= safeVars; i++) if (var[i] > 0) v++;
   assert(v == varsOfInterest);
   for(int e = 0; e < nGEQs; e++) assert(GEQs[e].touched || GEQs[e].key != 0);
-  if(!mayBeRed) {
+  if(!ctx->mayBeRed) {
     for(int e = 0; e < nEQs; e++) assert(!EQs[e].color);
     for(int e = 0; e < nGEQs; e++) assert(!GEQs[e].color);
   }
@@ -519,9 +509,9 @@ void Problem:: check() const {
 
 void Problem::rememberRedConstraint(eqn *e, redType type, coef_t stride) {
   // Check if this is really a stride constraint
-  if (type == redEQ && newVar == nVars && e->coef[newVar]) {
+  if (type == redEQ && ctx->newVar == nVars && e->coef[ctx->newVar]) {
     type = redStride;
-    stride = e->coef[newVar];
+    stride = e->coef[ctx->newVar];
   }
   //   else for(int i = safeVars+1; i <= nVars; i++) assert(!e->coef[i]); // outdated -- by chun 10/30/2008
 
@@ -549,9 +539,9 @@ void Problem::rememberRedConstraint(eqn *e, redType type, coef_t stride) {
   }
 
   // Convert redLEQ to redGEQ
-  eqn mem;
-  eqnncpy(&mem,e, nVars);
-  e = &mem;
+  EqnBuffer mem(1, nVars);
+  eqnncpy(&mem[0],e, nVars);
+  e = &mem[0];
   if (type == redLEQ) {
     for(int i = 0; i <= safeVars; i++)
       e->coef[i] = -e->coef[i];
@@ -560,8 +550,8 @@ void Problem::rememberRedConstraint(eqn *e, redType type, coef_t stride) {
 
   // Prepare coefficient array for red constraint
   bool has_wildcard = false;
-  coef_t coef[varsOfInterest-nextWildcard+1];
-  for (int i = 0; i <= varsOfInterest-nextWildcard; i++)
+  coef_t coef[varsOfInterest-ctx->nextWildcard+1];
+  for (int i = 0; i <= varsOfInterest-ctx->nextWildcard; i++)
     coef[i] = 0;
   for (int i = 0; i <= safeVars; i++) {
     if (var[i] < 0) {
@@ -584,25 +574,25 @@ void Problem::rememberRedConstraint(eqn *e, redType type, coef_t stride) {
     for (int i = 0; i < nSUBs; i++) {
       int t = 0;
       for (int j = 1; j <= safeVars; j++) {
-        if (var[j] < 0 && SUBs[i].coef[j] != 0)
+        if (var[j] < 0 && ctx->SUBs[i].coef[j] != 0)
           t++;
       }
       if (t > 0) {
-        repl_subs[num_repl_subs] = new coef_t[varsOfInterest-nextWildcard+1];
-        for (int j = 0; j <= varsOfInterest-nextWildcard; j++)
+        repl_subs[num_repl_subs] = new coef_t[varsOfInterest-ctx->nextWildcard+1];
+        for (int j = 0; j <= varsOfInterest-ctx->nextWildcard; j++)
           repl_subs[num_repl_subs][j] = 0;
       
         for (int k = 0; k <= safeVars; k++)
-          repl_subs[num_repl_subs][(var[k]<0)?varsOfInterest-var[k]:var[k]] = SUBs[i].coef[k];
-        repl_subs[num_repl_subs][SUBs[i].key] = -1;
+          repl_subs[num_repl_subs][(var[k]<0)?varsOfInterest-var[k]:var[k]] = ctx->SUBs[i].coef[k];
+        repl_subs[num_repl_subs][ctx->SUBs[i].key] = -1;
         num_wild_in_repl_subs[num_repl_subs] = t;
         num_repl_subs++;
       }
     }
 
-    int wild_solved[-nextWildcard+1];
+    int wild_solved[-ctx->nextWildcard+1];
     bool has_unsolved = false;
-    for (int i = 1; i <= -nextWildcard; i++) {
+    for (int i = 1; i <= -ctx->nextWildcard; i++) {
       int minimum_wild = 0;
       int pos;
       for (int j = 0; j < num_repl_subs; j++)
@@ -632,21 +622,21 @@ void Problem::rememberRedConstraint(eqn *e, redType type, coef_t stride) {
     while (has_unsolved) {
       for (int i = 0; i < num_repl_subs; i++)
         if (num_wild_in_repl_subs[i] > 1) {
-          for (int j = 1; j <= -nextWildcard; j++) {
+          for (int j = 1; j <= -ctx->nextWildcard; j++) {
             if (repl_subs[i][varsOfInterest+j] != 0 && wild_solved[j] >= 0) {
               int s = wild_solved[j];
               coef_t l = lcm(abs(repl_subs[i][varsOfInterest+j]), abs(repl_subs[s][varsOfInterest+j]));
               coef_t scale_1 = l/abs(repl_subs[i][varsOfInterest+j]);
               coef_t scale_2 = l/abs(repl_subs[s][varsOfInterest+j]);
               int sign = ((repl_subs[i][varsOfInterest+j]>0)?1:-1) * ((repl_subs[s][varsOfInterest+j]>0)?1:-1);
-              for (int k = 0; k <= varsOfInterest-nextWildcard; k++)
+              for (int k = 0; k <= varsOfInterest-ctx->nextWildcard; k++)
                 repl_subs[i][k] = scale_1*repl_subs[i][k] - sign*scale_2*repl_subs[s][k];
               num_wild_in_repl_subs[i]--;
             }
           }
 
           if (num_wild_in_repl_subs[i] == 1) {
-            for (int j = 1; j <= -nextWildcard; j++)
+            for (int j = 1; j <= -ctx->nextWildcard; j++)
               if (repl_subs[i][varsOfInterest+j] != 0) {
                 assert(wild_solved[j]==-1);
                 wild_solved[j] = i;
@@ -655,7 +645,7 @@ void Problem::rememberRedConstraint(eqn *e, redType type, coef_t stride) {
           }
           else if (num_wild_in_repl_subs[i] > 1) {
             int pos = 0;
-            for (int j = 1; j <= -nextWildcard; j++)
+            for (int j = 1; j <= -ctx->nextWildcard; j++)
               if (repl_subs[i][varsOfInterest+j] != 0) {
                 pos = j;
                 break;
@@ -668,12 +658,12 @@ void Problem::rememberRedConstraint(eqn *e, redType type, coef_t stride) {
                 coef_t scale_1 = l/abs(repl_subs[i][varsOfInterest+pos]);
                 coef_t scale_2 = l/abs(repl_subs[j][varsOfInterest+pos]);
                 int sign = ((repl_subs[i][varsOfInterest+pos]>0)?1:-1) * ((repl_subs[j][varsOfInterest+pos]>0)?1:-1);
-                for (int k = 0; k <= varsOfInterest-nextWildcard; k++)
+                for (int k = 0; k <= varsOfInterest-ctx->nextWildcard; k++)
                   repl_subs[j][k] = scale_2*repl_subs[j][k] - sign*scale_1*repl_subs[i][k];
 
                 num_wild_in_repl_subs[j] = 0;
                 int first_wild = 0;
-                for (int k = 1; k <= -nextWildcard; k++)
+                for (int k = 1; k <= -ctx->nextWildcard; k++)
                   if (repl_subs[j][varsOfInterest+k] != 0) {
                     num_wild_in_repl_subs[j]++;
                     first_wild = k;
@@ -688,7 +678,7 @@ void Problem::rememberRedConstraint(eqn *e, redType type, coef_t stride) {
         }
       
       has_unsolved = false;
-      for (int i = 1; i <= -nextWildcard; i++)
+      for (int i = 1; i <= -ctx->nextWildcard; i++)
         if (coef[varsOfInterest+i] != 0 && wild_solved[i] < 0) {
           has_unsolved = true;
           break;
@@ -696,7 +686,7 @@ void Problem::rememberRedConstraint(eqn *e, redType type, coef_t stride) {
     }          
               
     // Substitute all widecards in the red constraint
-    for (int i = 1; i <= -nextWildcard; i++) {
+    for (int i = 1; i <= -ctx->nextWildcard; i++) {
       if (coef[varsOfInterest+i] != 0) {
         int s = wild_solved[i];
         assert(s >= 0);
@@ -705,7 +695,7 @@ void Problem::rememberRedConstraint(eqn *e, redType type, coef_t stride) {
         coef_t scale_1 = l/abs(coef[varsOfInterest+i]);
         coef_t scale_2 = l/abs(repl_subs[s][varsOfInterest+i]);
         int sign = ((coef[varsOfInterest+i]>0)?1:-1) * ((repl_subs[s][varsOfInterest+i]>0)?1:-1);
-        for (int j = 0; j <= varsOfInterest-nextWildcard; j++)
+        for (int j = 0; j <= varsOfInterest-ctx->nextWildcard; j++)
           coef[j] = scale_1*coef[j] - sign*scale_2*repl_subs[s][j];
 
         if (scale_1 != 1)
@@ -719,16 +709,18 @@ void Problem::rememberRedConstraint(eqn *e, redType type, coef_t stride) {
   
   // Ready to insert into redMemory
   int m = nMemories++;
-  redMemory[m].length = 0;
-  redMemory[m].kind = type;
-  redMemory[m].constantTerm = coef[0];
+  ctx->redMemory[m].coef.resize(varsOfInterest + 1);
+  ctx->redMemory[m].var.resize(varsOfInterest + 1);
+  ctx->redMemory[m].length = 0;
+  ctx->redMemory[m].kind = type;
+  ctx->redMemory[m].constantTerm = coef[0];
   for(int i = 1; i <= varsOfInterest; i++)
     if (coef[i]) {
-      int j = redMemory[m].length++;
-      redMemory[m].coef[j] = coef[i];
-      redMemory[m].var[j] = i;
+      int j = ctx->redMemory[m].length++;
+      ctx->redMemory[m].coef[j] = coef[i];
+      ctx->redMemory[m].var[j] = i;
     }
-  if (type == redStride) redMemory[m].stride = stride;
+  if (type == redStride) ctx->redMemory[m].stride = stride;
   if (DBUG) {
     fprintf(outputFile,"Red constraint remembered\n");
     printProblem();
@@ -744,7 +736,7 @@ void Problem::recallRedMemories() {
 
     eqn* e = 0;
     for(int m = 0; m < nMemories; m++) {
-      switch(redMemory[m].kind) {
+      switch(ctx->redMemory[m].kind) {
       case redGEQ:
       {
         int temporary_eqn = newGEQ();
@@ -766,18 +758,18 @@ void Problem::recallRedMemories() {
         e = &EQs[temporary_eqn];
         eqnnzero(e, nVars);
         int i = addNewUnprotectedWildcard();
-        e->coef[i] = -redMemory[m].stride;
+        e->coef[i] = -ctx->redMemory[m].stride;
         break;
       }
       default:
         assert(0);
       }
       e->color = EQ_RED;
-      e->coef[0] = redMemory[m].constantTerm;
-      for(int i = 0; i < redMemory[m].length; i++) {
-        int v = redMemory[m].var[i];
+      e->coef[0] = ctx->redMemory[m].constantTerm;
+      for(int i = 0; i < ctx->redMemory[m].length; i++) {
+        int v = ctx->redMemory[m].var[i];
         assert(var[forwardingAddress[v]] == v);
-        e->coef[forwardingAddress[v]] = redMemory[m].coef[i];
+        e->coef[forwardingAddress[v]] = ctx->redMemory[m].coef[i];
       }
     }
         
@@ -811,10 +803,10 @@ void Problem::swapVars(int i, int j) {
       EQs[e].coef[j] = t;
     }
   for (int e = nSUBs - 1; e >= 0; e--)
-    if (SUBs[e].coef[i] != SUBs[e].coef[j]) {
-      coef_t t = SUBs[e].coef[i];
-      SUBs[e].coef[i] = SUBs[e].coef[j];
-      SUBs[e].coef[j] = t;
+    if (ctx->SUBs[e].coef[i] != ctx->SUBs[e].coef[j]) {
+      coef_t t = ctx->SUBs[e].coef[i];
+      ctx->SUBs[e].coef[i] = ctx->SUBs[e].coef[j];
+      ctx->SUBs[e].coef[j] = t;
     }
   if (DEBUG) {
     use_ugly_names++;
@@ -826,30 +818,30 @@ void Problem::swapVars(int i, int j) {
 }
 
 void Problem::addingEqualityConstraint(int e) {
-  if (addingOuterEqualities && originalProblem != noProblem &&
-      originalProblem != this && !conservative) {
-    int e2 = originalProblem->newEQ();
+  if (ctx->addingOuterEqualities && ctx->originalProblem != noProblem &&
+      ctx->originalProblem != this && !ctx->conservative) {
+    int e2 = ctx->originalProblem->newEQ();
     if (TRACE)
       fprintf(outputFile, "adding equality constraint %d to outer problem\n", e2);
-    eqnnzero(&originalProblem->EQs[e2], originalProblem->nVars);
+    eqnnzero(&ctx->originalProblem->EQs[e2], ctx->originalProblem->nVars);
     for (int i = nVars; i >= 1; i--) {
       int j;
-      for (j = originalProblem->nVars; j >= 1; j--)
-        if (originalProblem->var[j] == var[i])
+      for (j = ctx->originalProblem->nVars; j >= 1; j--)
+        if (ctx->originalProblem->var[j] == var[i])
           break;
-      if (j <= 0 || (outerColor && j > originalProblem->safeVars)) {
+      if (j <= 0 || (ctx->outerColor && j > ctx->originalProblem->safeVars)) {
         if (DBUG)
           fprintf(outputFile, "retracting\n");
-        originalProblem->nEQs--;
+        ctx->originalProblem->nEQs--;
         return;
       }
-      originalProblem->EQs[e2].coef[j] = EQs[e].coef[i];
+      ctx->originalProblem->EQs[e2].coef[j] = EQs[e].coef[i];
     }
-    originalProblem->EQs[e2].coef[0] = EQs[e].coef[0];
+    ctx->originalProblem->EQs[e2].coef[0] = EQs[e].coef[0];
  
-    originalProblem->EQs[e2].color = outerColor;
+    ctx->originalProblem->EQs[e2].color = ctx->outerColor;
     if (DBUG)
-      originalProblem->printProblem();
+      ctx->originalProblem->printProblem();
   }
 }
 
@@ -873,6 +865,7 @@ normalizeReturnType Problem::normalize() {
   bool coupledSubscripts = false;
 
   check();
+  ctx->reserveVars(allocVars);
 
   for (int e = 0; e < nGEQs; e++) {
     if (!GEQs[e].touched) {
@@ -886,12 +879,12 @@ normalizeReturnType Problem::normalize() {
       coef_t hashCode;
 
       {
-        int *p = &packing[0];
+        int *p = &ctx->packing[0];
         for (int k = 1; k <= nVars; k++)
           if (GEQs[e].coef[k]) {
             *(p++) = k;
           }
-        topVar = (p - &packing[0]) - 1;
+        topVar = (p - &ctx->packing[0]) - 1;
       }
 
       if (topVar == -1) {
@@ -904,7 +897,7 @@ normalizeReturnType Problem::normalize() {
         continue;
       }
       else if (topVar == 0) {
-        int singleVar = packing[0];
+        int singleVar = ctx->packing[0];
         g = GEQs[e].coef[singleVar];
         if (g > 0) {
           GEQs[e].coef[singleVar] = 1;
@@ -921,14 +914,14 @@ normalizeReturnType Problem::normalize() {
       else {
         coupledSubscripts = true;
         i0 = topVar;
-        i = packing[i0--];
+        i = ctx->packing[i0--];
         g = GEQs[e].coef[i];
         hashCode = g * (i + 3);
         if (g < 0)
           g = -g;
         for (; i0 >= 0; i0--) {
           coef_t x;
-          i = packing[i0];
+          i = ctx->packing[i0];
           x = GEQs[e].coef[i];
           hashCode = hashCode * keyMult * (i + 3) + x;
           if (x < 0)
@@ -943,18 +936,18 @@ normalizeReturnType Problem::normalize() {
         }
         for (; i0 >= 0; i0--) {
           coef_t x;
-          i = packing[i0];
+          i = ctx->packing[i0];
           x = GEQs[e].coef[i];
           hashCode = hashCode * keyMult * (i + 3) + x;
         }
         if (g > 1) {
           GEQs[e].coef[0] = int_div(GEQs[e].coef[0], g);
           i0 = topVar;
-          i = packing[i0--];
+          i = ctx->packing[i0--];
           GEQs[e].coef[i] = GEQs[e].coef[i] / g;
           hashCode = GEQs[e].coef[i] * (i + 3);
           for (; i0 >= 0; i0--) {
-            i = packing[i0];
+            i = ctx->packing[i0];
             GEQs[e].coef[i] = GEQs[e].coef[i] / g;
             hashCode = hashCode * keyMult * (i + 3) + GEQs[e].coef[i];
           }
@@ -962,21 +955,21 @@ normalizeReturnType Problem::normalize() {
 
         {
           coef_t g2 = abs(hashCode);  // get e's hash code
-          j = static_cast<int>(g2 % static_cast<coef_t>(hashTableSize));
-          assert (g2 % (coef_t) hashTableSize == j);
+          j = static_cast<int>(g2 % static_cast<coef_t>(ctx->hashTableSize));
+          assert (g2 % (coef_t) ctx->hashTableSize == j);
           while (1) {
-            eqn *proto = &(hashMaster[j]);
+            eqn *proto = &(ctx->hashMaster[j]);
             if (proto->touched == g2) {
               if (proto->coef[0] == topVar) {
                 if (hashCode >= 0)
                   for (i0 = topVar; i0 >= 0; i0--) {
-                    i = packing[i0];
+                    i = ctx->packing[i0];
                     if (GEQs[e].coef[i] != proto->coef[i])
                       break;
                   }
                 else
                   for (i0 = topVar; i0 >= 0; i0--) {
-                    i = packing[i0];
+                    i = ctx->packing[i0];
                     if (GEQs[e].coef[i] != -proto->coef[i])
                       break;
                   }
@@ -994,30 +987,29 @@ normalizeReturnType Problem::normalize() {
               eqnnzero(proto, nVars);
               if (hashCode >= 0)
                 for (i0 = topVar; i0 >= 0; i0--) {
-                  i = packing[i0];
+                  i = ctx->packing[i0];
                   proto->coef[i] = GEQs[e].coef[i];
                 }
               else
                 for (i0 = topVar; i0 >= 0; i0--) {
-                  i = packing[i0];
+                  i = ctx->packing[i0];
                   proto->coef[i] = -GEQs[e].coef[i];
                 }
               proto->coef[0] = topVar;
               proto->touched = g2;
-              proto->key = nextKey++;
+              int key = proto->key = ctx->nextKey++;
 
-              if (proto->key > maxKeys) {
-                fprintf(outputFile, "too many hash keys generated \n");
-                fflush(outputFile);
-                exit(2);
-              }
+              // Keep the table at most half full; this moves proto.
+              if (key - keyBase >= ctx->maxKeys ||
+                  2 * (ctx->nextKey - keyBase - 1) > ctx->hashTableSize)
+                ctx->growHashTable();
               if (hashCode >= 0)
-                GEQs[e].key = proto->key;
+                GEQs[e].key = key;
               else
-                GEQs[e].key = -proto->key;
+                GEQs[e].key = -key;
               break;
             }
-            j = (j + 1) % hashTableSize;
+            j = (j + 1) % ctx->hashTableSize;
           }
         }
       }
@@ -1029,7 +1021,7 @@ normalizeReturnType Problem::normalize() {
       int eKey = GEQs[e].key;
       int e2;
       if (e > 0) {
-        e2 = fastLookup[maxKeys - eKey];
+        e2 = ctx->lookup(-eKey);
         if (e2 >= 0 && e2 < e && GEQs[e2].key == -eKey) {
           // confirm it is indeed a match  -- by chun 10/29/2008
           int k;
@@ -1052,7 +1044,7 @@ normalizeReturnType Problem::normalize() {
           }
         }
 
-        e2 = fastLookup[maxKeys + eKey];
+        e2 = ctx->lookup(eKey);
         if (e2 >= 0 && e2 < e && GEQs[e2].key == eKey) {
           // confirm it is indeed a match  -- by chun 10/29/2008
           int k;
@@ -1079,12 +1071,12 @@ normalizeReturnType Problem::normalize() {
           }
         }
       }
-      fastLookup[maxKeys + eKey] = e;
+      ctx->lookup(eKey) = e;
     }
   }
 
   // bypass entended normalization for temporary problem
-  if (!isTemporary && !inApproximateMode)
+  if (!isTemporary && !ctx->inApproximateMode)
     normalize_ext();
     
   return coupledSubscripts ? normalize_coupled : normalize_uncoupled;
@@ -1324,15 +1316,38 @@ void Problem::normalize_ext() {
 }
 
 
-void initializeOmega(void) {
-  if (omegaInitialized)
-    return;
+SolverContext::SolverContext() {
+  newVar = -1;
+  findingImplicitEqualities = 0;
+  firstCheckForRedundantEquations = 0;
+  doItAgain = 0;
+  conservative = 0;
+  trace = 1;
+  depth = 0;
+  solveDepth = 0;
+  inApproximateMode = 0;
+  inStridesAllowedMode = 0;
+  addingOuterEqualities = 0;
+  outerColor = 0;
+  pleaseNoEqualitiesInSimplifiedProblems = 0;
+  mayBeRed = 0;
+  originalProblem = noProblem;
+  hashVersion = newHashVersion();
 
 //   assert(sizeof(eqn)==sizeof(int)*(headerWords)+sizeof(coef_t)*(1+maxVars));
   nextWildcard = 0;
-  nextKey = maxVars + 1;
+  nextKey = keyBase + 1;
+  nVars = Problem::min_alloc_vars;
+  SUBs = newEqns(nVars + 1, nVars);
+  redMemory.resize(nVars + 1);
+  packing.resize(nVars + 1);
+  hashTableSize = 5*maxmaxGEQs;
+  maxKeys = 8*maxmaxGEQs;
+  hashMaster = newEqns(hashTableSize, nVars);
   for (int i = 0; i < hashTableSize; i++)
     hashMaster[i].touched = -1;
+  fastLookup.assign(maxKeys*2, -1);
+  varLookup.assign(nVars*2 + 1, -1);
 
   sprintf(wildName[1], "__alpha");
   sprintf(wildName[2], "__beta");
@@ -1353,7 +1368,72 @@ void initializeOmega(void) {
   sprintf(wildName[17], "__Chi");
   sprintf(wildName[18], "__Omega");
   sprintf(wildName[19], "__Pi");
+}
+
+
+
+SolverContext::~SolverContext() {
+  deleteEqns(SUBs);
+  deleteEqns(hashMaster);
+}
 
+
+void SolverContext::reserveVars(int n) {
+  if (n <= nVars)
+    return;
+  int oldVars = nVars;
+  nVars = max(2 * nVars, n);
+
+  eqn *oldSUBs = SUBs;
+  SUBs = newEqns(nVars + 1, nVars);
+  for (int e = oldVars; e >= 0; e--)
+    eqnncpy(&SUBs[e], &oldSUBs[e], oldVars);
+  deleteEqns(oldSUBs);
+  redMemory.resize(nVars + 1);
+  packing.resize(nVars + 1);
+
+  eqn *oldMaster = hashMaster;
+  hashMaster = newEqns(hashTableSize, nVars);
+  for (int i = 0; i < hashTableSize; i++)
+    eqnncpy(&hashMaster[i], &oldMaster[i], oldVars);
+  deleteEqns(oldMaster);
+
+  std::vector<int> oldLookup;
+  oldLookup.swap(varLookup);
+  varLookup.assign(nVars*2 + 1, -1);
+  for (int k = -oldVars; k <= oldVars; k++)
+    varLookup[nVars + k] = oldLookup[oldVars + k];
+}
+
+
+void SolverContext::growHashTable() {
+  eqn *oldMaster = hashMaster;
+  int oldSize = hashTableSize;
+  std::vector<int> oldLookup;
+  oldLookup.swap(fastLookup);
+  int oldMaxKeys = maxKeys;
+
+  hashTableSize *= 2;
+  maxKeys *= 2;
+  hashMaster = newEqns(hashTableSize, nVars);
+  for (int i = 0; i < hashTableSize; i++)
+    hashMaster[i].touched = -1;
+  for (int i = 0; i < oldSize; i++)
+    if (oldMaster[i].touched >= 0) {
+      int j = static_cast<int>(oldMaster[i].touched % static_cast<coef_t>(hashTableSize));
+      while (hashMaster[j].touched >= 0)
+        j = (j + 1) % hashTableSize;
+      eqnncpy(&hashMaster[j], &oldMaster[i], nVars);
+    }
+  deleteEqns(oldMaster);
+
+  fastLookup.assign(maxKeys*2, -1);
+  for (int k = -oldMaxKeys; k < oldMaxKeys; k++)
+    fastLookup[maxKeys + k] = oldLookup[oldMaxKeys + k];
+}
+
+void initializeOmega(void) {
+  // Every SolverContext sets up its own hash table and wildcard names.
   omegaInitialized = 1;
 }
 
@@ -15,34 +15,31 @@
 
 namespace omega {
 
-static int solveDepth = 0;
-#define maxDead maxmaxGEQs
-
 int Problem::solve(int desiredResult) {
   assert(omegaInitialized);
   int result;
 
-  checkVars(nVars+1);
+  reserveVars(nVars);
   assert(nVars >= safeVars);
   if (desiredResult != OC_SOLVE_SIMPLIFY)
     safeVars = 0;
   
-  solveDepth++;
-  if (solveDepth > 50) {
-    fprintf(outputFile, "Solve depth = %d, inApprox = %d, aborting\n", solveDepth, inApproximateMode);
+  ctx->solveDepth++;
+  if (ctx->solveDepth > 50) {
+    fprintf(outputFile, "Solve depth = %d, inApprox = %d, aborting\n", ctx->solveDepth, ctx->inApproximateMode);
     printProblem();
     fflush(outputFile);
 
-    if (solveDepth > 60)
+    if (ctx->solveDepth > 60)
       exit(2);
   }
 
   check();
   do {
-    doItAgain = 0;
+    ctx->doItAgain = 0;
     check();
     if (solveEQ() == false) {
-      solveDepth--;
+      ctx->solveDepth--;
       return (false);
     }
     check();
@@ -55,8 +52,8 @@ int Problem::solve(int desiredResult) {
       result = solveGEQ(desiredResult);
     check();
   }
-  while (doItAgain && desiredResult == OC_SOLVE_SIMPLIFY);
-  solveDepth--;
+  while (ctx->doItAgain && desiredResult == OC_SOLVE_SIMPLIFY);
+  ctx->solveDepth--;
 
   return (result);
 }
@@ -195,13 +192,13 @@ void Problem::analyzeElimination(
           grey = (Lc - 1) * (Uc - 1);
 
           for (int j = nVars; j >= 1; j--) {
-            coef_t diff = check_mul(Lc, GEQs[e].coef[j]) + check_mul(Uc, GEQs[e2].coef[j]);
+            coef_t diff = check_add(check_mul(Lc, GEQs[e].coef[j]), check_mul(Uc, GEQs[e2].coef[j]));
             if (diff < 0) diff = -diff;
             g = gcd(g, diff);
             if (g == 1)
               break;
           }
-          diff = check_mul(Lc, GEQs[e].coef[0]) + check_mul(Uc, GEQs[e2].coef[0]);
+          diff = check_add(check_mul(Lc, GEQs[e].coef[0]), check_mul(Uc, GEQs[e2].coef[0]));
           if (g == 0) {
             if (diff < 0) {
               /* Real shadow must be true */
@@ -291,10 +288,9 @@ void Problem::partialElimination() {
     fv = safeVars;
   bool somethingHappened = false;
   for (int i = nVars; i > fv; i--) {
-    bool isDead[maxmaxGEQs];
+    std::vector<bool> isDead(nGEQs, false);
     int e;
-    for (e = nGEQs-1; e >= 0; e--) isDead[e] = false;
-    int deadEqns[maxDead];
+    std::vector<int> deadEqns(nGEQs);
     int numDead = 0;
     for (int e1 = nGEQs-1; e1 >= 0; e1--)
       if (abs(GEQs[e1].coef[i]) == 1) {
@@ -316,6 +312,7 @@ void Problem::partialElimination() {
                 int new_eqn;
                 if (numDead == 0) {
                   new_eqn = newGEQ();
+                  isDead.resize(nGEQs, false);
                 }
                 else {
                   new_eqn = deadEqns[--numDead];
@@ -330,8 +327,7 @@ void Problem::partialElimination() {
                   fprintf(outputFile, "\n");
                 }
 
-                for (int k = nVars; k >= 0; k--)
-                  GEQs[new_eqn].coef[k] = GEQs[e2].coef[k] + check_mul(GEQs[e1].coef[k], Uc);
+                combineGEQ(&GEQs[new_eqn], &GEQs[e2], 1, &GEQs[e1], Uc, nVars);
                 GEQs[new_eqn].touched = true;
                 GEQs[new_eqn].color = GEQs[e2].color | GEQs[e1].color;
                 if (DBUG) {
@@ -383,7 +379,7 @@ solveGEQstart:
     check_number_GEQs(nGEQs);
 
     if (DEBUG) {
-      fprintf(outputFile, "\nSolveGEQ(%d,%d):\n", desiredResult, pleaseNoEqualitiesInSimplifiedProblems);
+      fprintf(outputFile, "\nSolveGEQ(%d,%d):\n", desiredResult, ctx->pleaseNoEqualitiesInSimplifiedProblems);
       printProblem();
       fprintf(outputFile, "\n");
     }
@@ -391,7 +387,7 @@ solveGEQstart:
 #ifndef NDEBUG
     for(e=0;e<nSUBs;e++)
       for(i=safeVars+1;i<=nVars;i++)
-        assert(!SUBs[e].coef[i]);
+        assert(!ctx->SUBs[e].coef[i]);
 #endif
 
     check();
@@ -473,7 +469,7 @@ solveGEQstart:
           nVars = 0;
         return (true);
       }
-      if (originalProblem != noProblem && !lColor && !uColor && !conservative && lowerBound == upperBound) {
+      if (ctx->originalProblem != noProblem && !lColor && !uColor && !ctx->conservative && lowerBound == upperBound) {
         int e = newEQ();
         assert(e == 0);
         EQs[e].coef[0] = -lowerBound;
@@ -617,7 +613,7 @@ solveGEQstart:
           else splinters = parallelSplinters;
           if (disjointSplinters == 1) splinters = 1;
           exact = splinters == 1;
-          if (inApproximateMode) exact = 1;
+          if (ctx->inApproximateMode) exact = 1;
         }
         catch (std::overflow_error) {
           int result = quickKill(0, true);
@@ -752,8 +748,8 @@ solveGEQstart:
                   if (GEQs[Ue].coef[i] < 0) {
                     if (GEQs[Le].key != -GEQs[Ue].key) {
                       coef_t Uc = -GEQs[Ue].coef[i];
-                      coefficient = check_mul(GEQs[Ue].coef[1], Lc) + check_mul(GEQs[Le].coef[1], Uc);
-                      constantTerm = check_mul(GEQs[Ue].coef[0], Lc) + check_mul(GEQs[Le].coef[0], Uc);
+                      coefficient = check_add(check_mul(GEQs[Ue].coef[1], Lc), check_mul(GEQs[Le].coef[1], Uc));
+                      constantTerm = check_add(check_mul(GEQs[Ue].coef[0], Lc), check_mul(GEQs[Le].coef[0], Uc));
                       if (DEBUG) {
                         printGEQextra(&(GEQs[Ue]));
                         fprintf(outputFile, "\n");
@@ -833,7 +829,7 @@ solveGEQstart:
           eliminateAgain = 1;
 
           {
-            int deadEqns[maxDead];
+            std::vector<int> deadEqns(nGEQs);
             int numDead = 0;
             int topEqn = nGEQs - 1;
             int lowerBoundCount = 0;
@@ -882,10 +878,8 @@ solveGEQstart:
                       coef_t Lc_over_g = Lc/g;
                       coef_t Uc_over_g = Uc/g;
 
-                      for (k = nVars; k >= 0; k--)
-                        GEQs[e2].coef[k] =
-                          check_mul(GEQs[Ue].coef[k], Lc_over_g) + check_mul(GEQs[Le].coef[k], Uc_over_g);
-                                 
+                      combineGEQ(&GEQs[e2], &GEQs[Ue], Lc_over_g, &GEQs[Le], Uc_over_g, nVars);
+
                       GEQs[e2].coef[nVars + 1] = 0;
                       GEQs[e2].touched = true;
                       GEQs[e2].color = GEQs[Ue].color | GEQs[Le].color;
@@ -908,9 +902,7 @@ solveGEQstart:
               }
 
             {
-              int isDead[maxmaxGEQs];
-              for (e = nGEQs - 1; e >= 0; e--)
-                isDead[e] = false;
+              std::vector<bool> isDead(nGEQs, false);
               while (numDead > 0) {
                 e = deadEqns[--numDead];
                 isDead[e] = true;
@@ -931,6 +923,8 @@ solveGEQstart:
           rS = new Problem;
           iS = new Problem;
 
+          rS->reserveVars(nVars + 1);
+          iS->reserveVars(nVars + 1);
           iS->nVars = rS->nVars = nVars; // do this immed.; in case of reallocation, we
           // need to know how much to copy
           rS->get_var_name = get_var_name;
@@ -976,18 +970,10 @@ solveGEQstart:
                       fprintf(outputFile, "\n");
                     }
 
-                    if (Uc == Lc) {
-                      for (k = nVars; k >= 0; k--)
-                        iS->GEQs[ie2].coef[k] = rS->GEQs[re2].coef[k] =
-                          GEQs[Ue].coef[k] + GEQs[Le].coef[k];
-                      iS->GEQs[ie2].coef[0] -= (Uc - 1);
-                    }
-                    else {
-                      for (k = nVars; k >= 0; k--)
-                        iS->GEQs[ie2].coef[k] = rS->GEQs[re2].coef[k] =
-                          check_mul(GEQs[Ue].coef[k], Lc_over_g) + check_mul(GEQs[Le].coef[k], Uc_over_g);
-                      iS->GEQs[ie2].coef[0] -= check_mul(Uc_over_g-1, Lc_over_g-1);
-                    }
+                    // The dark shadow is the real shadow tightened by this much
+                    coef_t dark = Uc == Lc ? Uc - 1 : check_mul(Uc_over_g-1, Lc_over_g-1);
+                    combineGEQ(&rS->GEQs[re2], &GEQs[Ue], Lc_over_g, &GEQs[Le], Uc_over_g, nVars);
+                    combineGEQ(&iS->GEQs[ie2], &GEQs[Ue], Lc_over_g, &GEQs[Le], Uc_over_g, nVars, -dark);
 
                     iS->GEQs[ie2].color = rS->GEQs[re2].color
                       = GEQs[Ue].color || GEQs[Le].color;
@@ -1014,20 +1000,20 @@ solveGEQstart:
             iS->var[t] = var[t];
           nVars++;
           if (desiredResult != true) {
-            int t = trace;
+            int t = ctx->trace;
             if (TRACE)
-              fprintf(outputFile, "\nreal solution(%d):\n", depth);
-            depth++;
-            trace = 0;
-            if (originalProblem == noProblem) {
-              originalProblem = this;
+              fprintf(outputFile, "\nreal solution(%d):\n", ctx->depth);
+            ctx->depth++;
+            ctx->trace = 0;
+            if (ctx->originalProblem == noProblem) {
+              ctx->originalProblem = this;
               result = rS->solveGEQ(false);
-              originalProblem = noProblem;
+              ctx->originalProblem = noProblem;
             }
             else
               result = rS->solveGEQ(false);
-            trace = t;
-            depth--;
+            ctx->trace = t;
+            ctx->depth--;
             if (result == false) {
               delete rS;
               delete iS;
@@ -1044,12 +1030,12 @@ solveGEQstart:
           if (desiredResult != false) {
             if (darkShadowFeasible) {
               if (TRACE)
-                fprintf(outputFile, "\ninteger solution(%d):\n", depth);
-              depth++;
-              conservative++;
+                fprintf(outputFile, "\ninteger solution(%d):\n", ctx->depth);
+              ctx->depth++;
+              ctx->conservative++;
               result = iS->solveGEQ(desiredResult);
-              conservative--;
-              depth--;
+              ctx->conservative--;
+              ctx->depth--;
               if (result != false) {
                 delete rS;
                 delete iS;
@@ -1062,10 +1048,10 @@ solveGEQstart:
             {
               coef_t worstLowerBoundConstant=1;
               int lowerBounds = 0;
-              int lowerBound[maxmaxGEQs];
+              std::vector<int> lowerBound(nGEQs);
               int smallest;
               int t;
-              conservative++;
+              ctx->conservative++;
               for (e = 0; e < nGEQs; e++)
                 if (GEQs[e].coef[i] < -1) {
                   set_max(worstLowerBoundConstant,
@@ -1106,7 +1092,7 @@ solveGEQstart:
                 }
                 if (maxIncr > 50) {
                   if (!smoothed && smoothWeirdEquations()) {
-                    conservative--;
+                    ctx->conservative--;
                     delete rS;
                     delete iS;
                     smoothed = 1;
@@ -1135,7 +1121,7 @@ solveGEQstart:
                   if (result == true) {
                     delete rS;
                     delete iS;
-                    conservative--;
+                    ctx->conservative--;
                     return (true);
                   }
                   EQs[0].coef[0]--;
@@ -1158,7 +1144,7 @@ solveGEQstart:
               delete rS;
               delete iS;
 
-              conservative--;
+              ctx->conservative--;
               return (false);
             }
           }
@@ -1214,14 +1200,14 @@ int Problem::verifyProblem() {
   tmpProblem.nMemories = 0;
   tmpProblem.isTemporary = true;
   areRed = 0;
-  if (mayBeRed) {
+  if (ctx->mayBeRed) {
     for(e=0; e<nEQs;  e++) if (EQs[e].color) areRed = 1;
     for(e=0; e<nGEQs; e++) if (GEQs[e].color) areRed = 1;
     if (areRed) tmpProblem.turnRedBlack();
   }
-  originalProblem = this;
-  assert(!outerColor);
-  outerColor = areRed;
+  ctx->originalProblem = this;
+  assert(!ctx->outerColor);
+  ctx->outerColor = areRed;
   if (TRACE) {
     fprintf(outputFile, "verifying problem: [\n");
     printProblem();
@@ -1229,8 +1215,8 @@ int Problem::verifyProblem() {
   tmpProblem.check();
   tmpProblem.freeEliminations(0);
   result = tmpProblem.solve(OC_SOLVE_UNKNOWN);
-  originalProblem = noProblem;
-  outerColor = 0;
+  ctx->originalProblem = noProblem;
+  ctx->outerColor = 0;
   if (TRACE) {
     if (result)
       fprintf(outputFile, "] verified problem\n");
@@ -1267,7 +1253,7 @@ void Problem:: freeEliminations(int fv) {
       if (e2 < 0) {
         int e3;
         for (e3 = nSUBs - 1; e3 >= 0; e3--)
-          if (SUBs[e3].coef[i])
+          if (ctx->SUBs[e3].coef[i])
             break;
         if (e3 >= 0)
           continue;
@@ -1302,15 +1288,14 @@ void Problem:: freeEliminations(int fv) {
 void Problem::freeRedEliminations() {
   int tryAgain = 1;
   int i, e, e2;
-  int isRedVar[maxVars];
-  int isDeadVar[maxVars];
-  int isDeadGEQ[maxmaxGEQs];
+  std::vector<int> isRedVar(nVars + 1);
+  std::vector<int> isDeadVar(nVars + 1);
+  std::vector<int> isDeadGEQ(nGEQs, 0);
   for (i = nVars; i > 0; i--) {
     isRedVar[i] = 0;
     isDeadVar[i] = 0;
   }
   for (e = nGEQs - 1; e >= 0; e--) {
-    isDeadGEQ[e] = 0;
     if (GEQs[e].color)
       for (i = nVars; i > 0; i--)
         if (GEQs[e].coef[i] != 0)
@@ -1339,7 +1324,7 @@ void Problem::freeRedEliminations() {
         if (e2 < 0) {
           int e3;
           for (e3 = nSUBs - 1; e3 >= 0; e3--)
-            if (SUBs[e3].coef[i])
+            if (ctx->SUBs[e3].coef[i])
               break;
           if (e3 >= 0)
             continue;
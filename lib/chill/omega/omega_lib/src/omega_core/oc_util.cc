@@ -15,8 +15,52 @@
 
 namespace omega {
 
+void combineGEQ(eqn *dest, const eqn *e1, coef_t c1, const eqn *e2, coef_t c2,
+                int nVars, coef_t extra) {
+  // dest may be e1 or e2, so the row is built aside first
+  static thread_local std::vector<coef_t> row;
+  if (static_cast<int>(row.size()) <= nVars)
+    row.resize(nVars + 1);
+  int k;
+  try {
+    for (k = nVars; k >= 0; k--)
+      row[k] = check_add(check_mul(e1->coef[k], c1), check_mul(e2->coef[k], c2));
+    row[0] = check_add(row[0], extra);
+  }
+  catch (const std::overflow_error &) {
+#if defined HAVE_WIDE_COEF
+    std::vector<wide_coef_t> wide(nVars + 1);
+    wide_coef_t g = 0;
+    for (k = nVars; k >= 0; k--)
+      wide[k] = static_cast<wide_coef_t>(e1->coef[k]) * c1 + static_cast<wide_coef_t>(e2->coef[k]) * c2;
+    wide[0] += extra;
+    for (k = nVars; k >= 1 && g != 1; k--)
+      g = gcd(g, abs(wide[k]));
+    if (g == 0)
+      // Only whether the constant is negative matters
+      wide[0] = wide[0] >= 0 ? 0 : -1;
+    else if (g > 1) {
+      for (k = nVars; k >= 1; k--)
+        wide[k] /= g;
+      wide[0] = int_div(wide[0], g);
+    }
+    for (k = nVars; k >= 0; k--) {
+      row[k] = static_cast<coef_t>(wide[k]);
+      if (row[k] != wide[k])
+        throw std::overflow_error("coefficient overflow in combined inequality");
+    }
+    if (DBUG)
+      fprintf(outputFile, "combineGEQ: reduced an overflowing row by " coef_fmt "\n",
+              static_cast<coef_t>(g));
+#else
+    throw;
+#endif
+  }
+  memcpy(dest->coef, &row[0], (nVars + 1) * sizeof(coef_t));
+}
+
 void Problem:: problem_merge(Problem &p2) {
-  int newLocation[maxVars];
+  std::vector<int> newLocation(p2.nVars + 1);
   int i,e2;
 
   resurrectSubs();
@@ -35,6 +79,7 @@ void Problem:: problem_merge(Problem &p2) {
     assert(p2.var[i] > 0) ;
     newLocation[i] = forwardingAddress[p2.var[i]];
   }
+  reserveVars(nVars + p2.nVars - p2.safeVars);
   for(; i<= p2.nVars; i++) {
     int j = ++(nVars);
     newLocation[i] = j;
@@ -69,12 +114,12 @@ void Problem:: problem_merge(Problem &p2) {
 
 void Problem::chainUnprotect() {
   int i, e;
-  int unprotect[maxVars];
+  std::vector<int> unprotect(safeVars + 1);
   int any = 0;
   for (i = 1; i <= safeVars; i++) {
     unprotect[i] = (var[i] < 0);
     for (e = nSUBs - 1; e >= 0; e--)
-      if (SUBs[e].coef[i])
+      if (ctx->SUBs[e].coef[i])
         unprotect[i] = 0;
   }
   for (i = 1; i <= safeVars; i++) if (unprotect[i]) any=1;
@@ -100,7 +145,7 @@ void Problem::chainUnprotect() {
         for (e = nEQs - 1; e >= 0; e--)
           std::swap(EQs[e].coef[i], EQs[e].coef[j]);
         for (e = nSUBs - 1; e >= 0; e--)
-          std::swap(SUBs[e].coef[i], SUBs[e].coef[j]);
+          std::swap(ctx->SUBs[e].coef[i], ctx->SUBs[e].coef[j]);
         std::swap(unprotect[i], unprotect[j]);
         i--;
       }
@@ -113,18 +158,18 @@ void Problem::chainUnprotect() {
 }
 
 void Problem::resurrectSubs() {
-  if (nSUBs > 0 && !pleaseNoEqualitiesInSimplifiedProblems) {
+  if (nSUBs > 0 && !ctx->pleaseNoEqualitiesInSimplifiedProblems) {
     int i, e, n, m,mbr;
     mbr = 0;
     for (e = nGEQs - 1; e >= 0; e--) if (GEQs[e].color) mbr=1;
     for (e = nEQs - 1; e >= 0; e--) if (EQs[e].color) mbr=1;
     if (nMemories) mbr = 1;
 
-    assert(!mbr || mayBeRed);
+    assert(!mbr || ctx->mayBeRed);
     
     if (DBUG) {
       fprintf(outputFile, "problem reduced, bringing variables back to life\n");
-      if(mbr && !mayBeRed) fprintf(outputFile, "Red equations we don't expect\n");
+      if(mbr && !ctx->mayBeRed) fprintf(outputFile, "Red equations we don't expect\n");
       printProblem();
     }
     if (DBUG && nEQs > 0)
@@ -143,7 +188,7 @@ void Problem::resurrectSubs() {
           for (e = nEQs - 1; e >= 0; e--)
             std::swap(EQs[e].coef[i], EQs[e].coef[j]);
           for (e = nSUBs - 1; e >= 0; e--)
-            std::swap(SUBs[e].coef[i], SUBs[e].coef[j]);
+            std::swap(ctx->SUBs[e].coef[i], ctx->SUBs[e].coef[j]);
           i--;
         }
         safeVars--;
@@ -153,6 +198,7 @@ void Problem::resurrectSubs() {
     n = nVars;
     if (n < safeVars + m)
       n = safeVars + m;
+    reserveVars(nVars + m);
     for (e = nGEQs - 1; e >= 0; e--) {
       if (singleVarGEQ(&GEQs[e])) {
         i = abs(GEQs[e].key);
@@ -171,17 +217,17 @@ void Problem::resurrectSubs() {
       for (e = nEQs - 1; e >= 0; e--)
         EQs[e].coef[i + m] = EQs[e].coef[i];
       for (e = nSUBs - 1; e >= 0; e--)
-        SUBs[e].coef[i + m] = SUBs[e].coef[i];
+        ctx->SUBs[e].coef[i + m] = ctx->SUBs[e].coef[i];
     }
     for (i = safeVars + m; i >= safeVars + 1; i--) {
       for (e = nGEQs - 1; e >= 0; e--) GEQs[e].coef[i] = 0;
       for (e = nEQs - 1; e >= 0; e--) EQs[e].coef[i] = 0;
-      for (e = nSUBs - 1; e >= 0; e--) SUBs[e].coef[i] = 0;
+      for (e = nSUBs - 1; e >= 0; e--) ctx->SUBs[e].coef[i] = 0;
     }
     nVars += m;
     safeVars += m;
     for (e = nSUBs - 1; e >= 0; e--)  
-      var[safeVars -m + 1 + e] = SUBs[e].key;
+      var[safeVars -m + 1 + e] = ctx->SUBs[e].key;
     for (i = 1; i <= safeVars; i++)
       forwardingAddress[var[i]] = i;
     if (DBUG) {
@@ -190,7 +236,7 @@ void Problem::resurrectSubs() {
     }
     for (e = nSUBs - 1; e >= 0; e--) {
       int neweq = newEQ();
-      eqnncpy(&(EQs[neweq]), &(SUBs[e]), nVars);
+      eqnncpy(&(EQs[neweq]), &(ctx->SUBs[e]), nVars);
       EQs[neweq].coef[safeVars -m + 1 + e] = -1;
       EQs[neweq].color = EQ_BLACK;
       if (DBUG) {
@@ -231,22 +277,21 @@ void Problem::reverseProtectedVariables() {
       GEQs[e].touched = 1;
     }
     for(e=0;e<nSUBs;e++) {
-      t = SUBs[e].coef[v1];
-      SUBs[e].coef[v1] = SUBs[e].coef[v2];
-      SUBs[e].coef[v2] = t;
+      t = ctx->SUBs[e].coef[v1];
+      ctx->SUBs[e].coef[v1] = ctx->SUBs[e].coef[v2];
+      ctx->SUBs[e].coef[v2] = t;
     }
   }
 
   for (i = 1; i <= safeVars; i++)
     forwardingAddress[var[i]] = i;
   for (i = 0; i < nSUBs; i++)
-    forwardingAddress[SUBs[i].key] = -i - 1;
+    forwardingAddress[ctx->SUBs[i].key] = -i - 1;
 }
 
 void Problem::ordered_elimination(int symbolic) {
   int i,j,e;
-  int isDead[maxmaxGEQs];
-  for(e=0;e<nEQs;e++) isDead[e] = 0;
+  std::vector<int> isDead(nEQs, 0);
 
   if (!variablesInitialized) {
     initializeVariables();
@@ -272,7 +317,7 @@ void Problem::ordered_elimination(int symbolic) {
   for (i = 1; i <= safeVars; i++)
     forwardingAddress[var[i]] = i;
   for (i = 0; i < nSUBs; i++)
-    forwardingAddress[SUBs[i].key] = -i - 1;
+    forwardingAddress[ctx->SUBs[i].key] = -i - 1;
 }
 
 
@@ -290,7 +335,7 @@ coef_t Problem::checkSum() const {
 
 void Problem::coalesce() {
   int e, e2, colors;
-  int isDead[maxmaxGEQs];
+  std::vector<int> isDead(nGEQs);
   int foundSomething = 0;
 
 
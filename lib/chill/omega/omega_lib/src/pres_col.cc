@@ -12,7 +12,7 @@ namespace omega {
 void copy_column(Problem *tp,  int to_col,
                  Problem *fp,  int fr_col,
                  int start_EQ, int start_GEQ) {
-  checkVars(to_col);
+  tp->reserveVars(to_col);
   assert(start_EQ + fp->nEQs  <= tp->allocEQs);
   assert(start_GEQ + fp->nGEQs  <= tp->allocGEQs);
 
@@ -33,6 +33,7 @@ void copy_column(Problem *tp,  int to_col,
 void zero_column(Problem *tp,  int to_col,
                  int start_EQ, int start_GEQ,
                  int no_EQs,   int no_GEQs) {
+  tp->reserveVars(to_col);
   assert(start_EQ + no_EQs <= tp->allocEQs);
   assert(start_GEQ + no_GEQs <= tp->allocGEQs);
 
@@ -92,7 +93,7 @@ int Conjunct::map_to_column(Variable_ID D) {
           && "Attempt to update global var without a local variable ID"));
 
   cols_ordered = false; // extremely important
-  checkVars(problem->nVars+2);
+  problem->reserveVars(problem->nVars+1);
   int col = ++problem->nVars;
   mappedVars.append(D);
   problem->forwardingAddress[col] = col;
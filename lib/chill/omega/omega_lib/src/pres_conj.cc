@@ -252,11 +252,12 @@ void copy_conj_header(Conjunct* to, Conjunct* fr) {
 
   Problem *fp = fr->problem;
   Problem *tp = to->problem;
+  tp->reserveVars(fp->allocVars - 1);
   tp->nVars = fp->nVars;
   tp->safeVars = fp->safeVars;
   tp->variablesInitialized = fp->variablesInitialized;
   tp->variablesFreed = fp->variablesFreed;
-  for(int i=1; i<=maxVars; i++) {  // only need nVars of var
+  for(int i=1; i<(int)fp->var.size(); i++) {  // only need nVars of var
     tp->forwardingAddress[i] = fp->forwardingAddress[i];
     tp->var[i] = fp->var[i];
   }
@@ -992,7 +993,6 @@ Conjunct* _merge_conjs(Conjunct* conj1, Conjunct* conj2,
 	}
  
   p3->nVars = new_col-1;
-  checkVars(p3->nVars);
   p3->variablesInitialized = 1;
   for(i=1; i<=p3->nVars; i++)
     p3->var[i] = p3->forwardingAddress[i] = i;
@@ -1259,7 +1259,11 @@ bool Conjunct::query_variable_used(Variable_ID v) {
 
 int Conjunct::simplifyProblem(int verify, int subs, int redundantElimination) {
   if (verified) verify = 0;
-  int result = problem->simplifyProblem(verify, subs, redundantElimination);
+  int result;
+  {
+    Presburger_Unlock unlock;
+    result = problem->simplifyProblem(verify, subs, redundantElimination);
+  }
   if (result == false && !exact)
     exact=true;
   assert(!(verified && verify && result == false));
@@ -1271,7 +1275,11 @@ int Conjunct::simplifyProblem(int verify, int subs, int redundantElimination) {
 
 // not as confident about this one as the previous:
 int Conjunct::redSimplifyProblem(int effort, int computeGist) {
-  redCheck result = problem->redSimplifyProblem(effort, computeGist);
+  redCheck result;
+  {
+    Presburger_Unlock unlock;
+    result = problem->redSimplifyProblem(effort, computeGist);
+  }
   if (result == redFalse && !exact)
     exact=true;
   return result;
@@ -1366,6 +1374,7 @@ Problem *Comp_Problem::UncompressProblem() {
   Problem *p = new Problem(eqs.n_constraints(), geqs.n_constraints());
   p->get_var_name     = get_var_name;
   p->getVarNameArgs = _getVarNameArgs;
+  p->reserveVars(_nVars);
   p->nVars          = _nVars;
   p->safeVars       = _safeVars;
   for(int i=1; i<=p->nVars; i++) {
@@ -1377,7 +1386,7 @@ Problem *Comp_Problem::UncompressProblem() {
   return p;
 }
 
-void Comp_Constraints::UncompressConstr(eqn *constrs, short &pn_constrs) {
+void Comp_Constraints::UncompressConstr(eqn *constrs, int &pn_constrs) {
   int e, v;
   for(e=0; e<n_constrs; e++) {
     eqnnzero(&constrs[e], 0);
@@ -1,4 +1,5 @@
 #include <omega/pres_gen.h>
+#include <mutex>
 
 namespace omega {
 
@@ -10,6 +11,35 @@ FILE *DebugFile=stderr;  // This is the default; it's best to set it yourself.
 
 negation_control pres_legal_negations = any_negation;
 
+namespace {
+  std::mutex presburger_mutex;
+  thread_local int presburger_depth = 0;
+}
+
+Presburger_Lock::Presburger_Lock() {
+  if (presburger_depth++ == 0)
+    presburger_mutex.lock();
+}
+
+Presburger_Lock::~Presburger_Lock() {
+  if (--presburger_depth == 0)
+    presburger_mutex.unlock();
+}
+
+Presburger_Unlock::Presburger_Unlock(): depth(presburger_depth) {
+  if (depth > 0) {
+    presburger_depth = 0;
+    presburger_mutex.unlock();
+  }
+}
+
+Presburger_Unlock::~Presburger_Unlock() {
+  if (depth > 0) {
+    presburger_mutex.lock();
+    presburger_depth = depth;
+  }
+}
+
 //
 // I/O utility functions.
 //
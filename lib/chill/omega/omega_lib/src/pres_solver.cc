@@ -0,0 +1,306 @@
+/*****************************************************************************
+ Copyright (C) 1994-2000 the Omega Project Team
+ Copyright (C) 2005-2011 Chun Chen
+ All Rights Reserved.
+
+ Purpose:
+   incremental satisfiability queries against a fixed relation.
+
+ Notes:
+   Each conjunct is kept as a bare omega core problem whose protected
+   columns are the relation's variables that the conjunct constrains.
+   A scope starts from a copy of its parent's reduced problems, so
+   wildcards the parent already projected away are never seen again.
+
+ History:
+*****************************************************************************/
+
+#include <omega.h>
+#include <omega/pres_solver.h>
+#include <omega/omega_core/oc_i.h>
+#include <stdio.h>
+#include <deque>
+#include <string>
+
+namespace omega {
+
+namespace {
+
+// Solver problems have no Conjunct to name their columns after, and the
+// omega core wants distinct names when it checks or prints a problem.
+// A deque, so that names already handed out stay put as it grows, and one
+// per thread, since solves run on whichever thread asks.
+const char *solver_var_name(unsigned int col, void *) {
+  thread_local std::deque<std::string> names;
+  char buf[16];
+  while (names.size() <= col) {
+    sprintf(buf, "c%d", (int)names.size());
+    names.push_back(buf);
+  }
+  return names[col].c_str();
+}
+
+// Appends a protected column for solver column k, moving the first
+// wildcard out of the way.
+void add_column(Problem *p, std::vector<int> &columns, int k) {
+  p->reserveVars(p->nVars + 1);
+  int col = ++p->nVars;
+  for (int e = 0; e < p->nGEQs; e++)
+    p->GEQs[e].coef[col] = 0;
+  for (int e = 0; e < p->nEQs; e++)
+    p->EQs[e].coef[col] = 0;
+  int safe = ++p->safeVars;
+  if (safe != col)
+    p->swapVars(safe, col);
+  p->var[safe] = p->forwardingAddress[safe] = safe;
+  p->var[col] = p->forwardingAddress[col] = col;
+  if ((int)columns.size() <= k)
+    columns.resize(k + 1, 0);
+  columns[k] = safe;
+}
+
+// Simplifies and verifies p and renumbers columns to follow the
+// protected variables to where the omega core left them.
+bool reduce(Problem *p, std::vector<int> &columns) {
+  for (int e = 0; e < p->nGEQs; e++)
+    p->GEQs[e].touched = 1;
+  if (!p->simplifyProblem(1, 0, 0))
+    return false;
+  assert(p->nSUBs == 0);
+
+  // what is now in column i used to be in column p->var[i]
+  std::vector<int> moved(p->var.size(), 0);
+  for (int i = 1; i <= p->safeVars; i++)
+    moved[p->var[i]] = i;
+  for (size_t k = 0; k < columns.size(); k++)
+    if (columns[k] > 0)
+      columns[k] = moved[columns[k]];
+
+  for (int i = 0; i <= p->nVars; i++)
+    p->var[i] = p->forwardingAddress[i] = i;
+  p->variablesInitialized = 1;
+  return true;
+}
+
+} // namespace
+
+
+Relation_Solver::Relation_Solver(NOT_CONST Relation &R) {
+  Relation r = R;
+  n_in = r.is_set() ? r.n_set() : r.n_inp();
+  n_io = r.is_set() ? n_in : n_in + r.n_out();
+  if (r.is_compressed())
+    r.uncompress();
+  r.simplify();
+
+  levels.resize(2);
+  Level &base = levels[0];
+  for (DNF_Iterator di(r.query_DNF()); di; di++) {
+    Conjunct *conj = *di;
+    Problem *cp = conj->problem;
+    assert(cp->nSUBs == 0);
+
+    // Protected columns first, in the conjunct's order, then wildcards.
+    std::vector<int> from(cp->nVars + 1, 0);
+    std::vector<int> columns;
+    int n_vars = 0;
+    for (int pass = 0; pass < 2; pass++)
+      for (int i = 1; i <= conj->mappedVars.size(); i++) {
+        Variable_ID v = conj->mappedVars[i];
+        if ((v->kind() == Wildcard_Var) != (pass == 1))
+          continue;
+        int col = conj->find_column(v);
+        if (col <= 0)
+          continue;
+        from[col] = ++n_vars;
+        if (pass == 0) {
+          int k = column_of(v);
+          if ((int)columns.size() <= k)
+            columns.resize(k + 1, 0);
+          columns[k] = n_vars;
+        }
+      }
+
+    Problem *p = new Problem(cp->nEQs, cp->nGEQs);
+    p->get_var_name = solver_var_name;
+    p->getVarNameArgs = NULL;
+    p->reserveVars(n_vars);
+    p->nVars = n_vars;
+    p->safeVars = 0;
+    for (size_t k = 0; k < columns.size(); k++)
+      if (columns[k] > 0)
+        p->safeVars++;
+    for (int pass = 0; pass < 2; pass++) {
+      int n = pass == 0 ? cp->nEQs : cp->nGEQs;
+      for (int e = 0; e < n; e++) {
+        eqn &fr = pass == 0 ? cp->EQs[e] : cp->GEQs[e];
+        int i = pass == 0 ? p->newEQ() : p->newGEQ();
+        eqn &to = pass == 0 ? p->EQs[i] : p->GEQs[i];
+        eqnnzero(&to, n_vars);
+        to.coef[0] = fr.coef[0];
+        for (int col = 1; col <= cp->nVars; col++)
+          if (from[col] > 0)
+            to.coef[from[col]] = fr.coef[col];
+        to.touched = 1;
+        to.color = fr.color;
+      }
+    }
+
+    if (!reduce(p, columns)) {
+      delete p;
+      p = NULL;
+    }
+    base.problems.push_back(p);
+    base.columns.push_back(columns);
+    exact.push_back(conj->is_exact());
+  }
+  base.solved = true;
+}
+
+Relation_Solver::~Relation_Solver() {
+  for (size_t l = 0; l < levels.size(); l++)
+    clear(levels[l]);
+}
+
+void Relation_Solver::clear(Level &level) {
+  for (size_t c = 0; c < level.problems.size(); c++)
+    delete level.problems[c];
+  level.problems.clear();
+  level.columns.clear();
+  level.applied = 0;
+  level.solved = false;
+}
+
+void Relation_Solver::push() {
+  levels.push_back(Level());
+}
+
+void Relation_Solver::pop() {
+  assert(levels.size() > 2 && "Relation_Solver::pop without push");
+  clear(levels.back());
+  levels.pop_back();
+}
+
+int Relation_Solver::column_of(Variable_ID v) {
+  switch (v->kind()) {
+  case Input_Var:
+    assert(v->get_position() <= n_in);
+    return v->get_position();
+  case Output_Var:
+    assert(n_in + v->get_position() <= n_io);
+    return n_in + v->get_position();
+  case Global_Var: {
+    Global_Var_ID g = v->get_global_var();
+    // Matches Global_Var_Decl::get_local: symbolic constants and input
+    // functions share one local.
+    Argument_Tuple of = g->arity() == 0 || v->function_of() == Input_Tuple
+      ? Input_Tuple : Output_Tuple;
+    for (size_t i = 0; i < globals.size(); i++)
+      if (globals[i].first == g && globals[i].second == of)
+        return n_io + i + 1;
+    globals.push_back(std::make_pair(g, of));
+    return n_io + globals.size();
+  }
+  default:
+    assert(0 && "Relation_Solver only takes input, output and global variables");
+    return 0;
+  }
+}
+
+void Relation_Solver::add_row(bool is_eq, const Terms &terms, coef_t constant) {
+  Row row;
+  row.is_eq = is_eq;
+  row.coef.push_back(constant);
+  for (size_t t = 0; t < terms.size(); t++) {
+    int k = column_of(terms[t].first);
+    if ((int)row.coef.size() <= k)
+      row.coef.resize(k + 1, 0);
+    row.coef[k] += terms[t].second;
+  }
+  levels.back().rows.push_back(row);
+}
+
+void Relation_Solver::add_GEQ(const Terms &terms, coef_t constant) {
+  add_row(false, terms, constant);
+}
+
+void Relation_Solver::add_EQ(const Terms &terms, coef_t constant) {
+  add_row(true, terms, constant);
+}
+
+//
+// Brings level l's problems up to date with its rows, starting from its
+// parent's problems the first time and from its own afterwards.
+//
+void Relation_Solver::solve(int l) {
+  Level &level = levels[l];
+  if (level.solved && level.applied == (int)level.rows.size())
+    return;
+
+  if (!level.solved) {
+    solve(l - 1);
+    Level &parent = levels[l - 1];
+    level.problems.assign(parent.problems.size(), NULL);
+    level.columns.assign(parent.columns.size(), std::vector<int>());
+    for (size_t c = 0; c < parent.problems.size(); c++)
+      if (parent.problems[c] != NULL) {
+        level.problems[c] = new Problem(*parent.problems[c]);
+        level.columns[c] = parent.columns[c];
+      }
+    level.applied = 0;
+    level.solved = true;
+  }
+
+  for (size_t c = 0; c < level.problems.size(); c++) {
+    Problem *p = level.problems[c];
+    if (p == NULL)
+      continue;
+    std::vector<int> &columns = level.columns[c];
+    for (size_t r = level.applied; r < level.rows.size(); r++) {
+      const Row &row = level.rows[r];
+      for (size_t k = 1; k < row.coef.size(); k++)
+        if (row.coef[k] != 0 && (k >= columns.size() || columns[k] == 0))
+          add_column(p, columns, k);
+      int i = row.is_eq ? p->newEQ() : p->newGEQ();
+      eqn &e = row.is_eq ? p->EQs[i] : p->GEQs[i];
+      eqnnzero(&e, p->nVars);
+      e.coef[0] = row.coef[0];
+      for (size_t k = 1; k < row.coef.size(); k++)
+        if (row.coef[k] != 0)
+          e.coef[columns[k]] = row.coef[k];
+      e.touched = 1;
+      e.color = EQ_BLACK;
+    }
+    if (!reduce(p, columns)) {
+      delete p;
+      level.problems[c] = NULL;
+    }
+  }
+  level.applied = level.rows.size();
+}
+
+bool Relation_Solver::is_upper_bound_satisfiable() {
+  solve(levels.size() - 1);
+  const Level &top = levels.back();
+  for (size_t c = 0; c < top.problems.size(); c++)
+    if (top.problems[c] != NULL)
+      return true;
+  return false;
+}
+
+// Interpret UNKNOWN as false, as Rel_Body::is_lower_bound_satisfiable does.
+bool Relation_Solver::is_lower_bound_satisfiable() {
+  solve(levels.size() - 1);
+  const Level &top = levels.back();
+  for (size_t c = 0; c < top.problems.size(); c++)
+    if (top.problems[c] != NULL && exact[c])
+      return true;
+  return false;
+}
+
+bool Relation_Solver::is_satisfiable() {
+  assert(is_lower_bound_satisfiable() == is_upper_bound_satisfiable());
+  return is_upper_bound_satisfiable();
+}
+
+} // namespace
@@ -11,7 +11,7 @@ Substitutions::Substitutions(Relation &input_R, Conjunct *input_c) {
   int num_subs = c->problem->nSUBs; 
   subs = new eqn[num_subs];
   for(i = 0; i < num_subs; i++)
-    subs[i] = SUBs[i];
+    subs[i] = c->problem->ctx->SUBs[i];
   subbed_vars.reallocate(num_subs);
   /* Go through and categorize variables as:
      1) substituted, 2) not substituted, 3) wildcard
@@ -147,6 +147,9 @@ namespace {
 }
 
 std::map<std::string, Relation *> relationMap;
+#ifdef BUILD_CODEGEN
+CodeGenMemo codegenMemo;  // keyed by relation text, so it carries over between runs
+#endif
 int argCount = 0;
 int tuplePos = 0;
 Argument_Tuple currentTuple = Input_Tuple;
@@ -2118,13 +2121,9 @@ yyreduce:
             flushScanBuffer();
 #ifdef BUILD_CODEGEN
             try {
-              CodeGen cg((yyvsp[-2].REL_TUPLE_PAIR)->first, (yyvsp[-2].REL_TUPLE_PAIR)->second, *(yyvsp[-1].RELATION));
-              CG_result *cgr = cg.buildAST();
-              if (cgr != NULL) {
-                std::string s = cgr->printString();
+              std::string s;
+              if (codegenMemo.printString((yyvsp[-2].REL_TUPLE_PAIR)->first, (yyvsp[-2].REL_TUPLE_PAIR)->second, *(yyvsp[-1].RELATION), 1, s))
                 std::cout << s << std::endl;
-                delete cgr;
-              }
               else
                 std::cout << "/* empty */" << std::endl;
             }
@@ -2146,13 +2145,9 @@ yyreduce:
             flushScanBuffer();
 #ifdef BUILD_CODEGEN
             try {
-              CodeGen cg((yyvsp[-2].REL_TUPLE_PAIR)->first, (yyvsp[-2].REL_TUPLE_PAIR)->second, *(yyvsp[-1].RELATION));
-              CG_result *cgr = cg.buildAST((yyvsp[-3].INT_VALUE));
-              if (cgr != NULL) {
-                std::string s = cgr->printString();
+              std::string s;
+              if (codegenMemo.printString((yyvsp[-2].REL_TUPLE_PAIR)->first, (yyvsp[-2].REL_TUPLE_PAIR)->second, *(yyvsp[-1].RELATION), (yyvsp[-3].INT_VALUE), s))
                 std::cout << s << std::endl;
-                delete cgr;
-              }
               else
                 std::cout << "/* empty */" << std::endl;
             }
@@ -4332,6 +4327,10 @@ int omega_run(std::istream *is, std::ostream *os) {
     auto cout_buff = std::cout.rdbuf();
     std::cout.rdbuf(os->rdbuf());
 
+    // A solver of its own, so the run does not depend on what was solved before
+    SolverContext ctx;
+    SolverContext::Scope scope(ctx);
+
     //yydebug = 1;
     is_interactive = false;
     need_coef = false;
@@ -96,6 +96,9 @@ namespace {
 }
 
 std::map<std::string, Relation *> relationMap;
+#ifdef BUILD_CODEGEN
+CodeGenMemo codegenMemo;  // keyed by relation text, so it carries over between runs
+#endif
 int argCount = 0;
 int tuplePos = 0;
 Argument_Tuple currentTuple = Input_Tuple;
@@ -431,13 +434,9 @@ inputItem : ';' /*empty*/
             flushScanBuffer();
 #ifdef BUILD_CODEGEN
             try {
-              CodeGen cg($2->first, $2->second, *$3);
-              CG_result *cgr = cg.buildAST();
-              if (cgr != NULL) {
-                std::string s = cgr->printString();
+              std::string s;
+              if (codegenMemo.printString($2->first, $2->second, *$3, 1, s))
                 std::cout << s << std::endl;
-                delete cgr;
-              }
               else
                 std::cout << "/* empty */" << std::endl;
             }
@@ -454,13 +453,9 @@ inputItem : ';' /*empty*/
             flushScanBuffer();
 #ifdef BUILD_CODEGEN
             try {
-              CodeGen cg($3->first, $3->second, *$4);
-              CG_result *cgr = cg.buildAST($2);
-              if (cgr != NULL) {
-                std::string s = cgr->printString();
+              std::string s;
+              if (codegenMemo.printString($3->first, $3->second, *$4, $2, s))
                 std::cout << s << std::endl;
-                delete cgr;
-              }
               else
                 std::cout << "/* empty */" << std::endl;
             }
@@ -1849,6 +1844,10 @@ int omega_run(std::istream *is, std::ostream *os) {
     auto cout_buff = std::cout.rdbuf();
     std::cout.rdbuf(os->rdbuf());
 
+    // A solver of its own, so the run does not depend on what was solved before
+    SolverContext ctx;
+    SolverContext::Scope scope(ctx);
+
     //yydebug = 1;
     is_interactive = false;
     need_coef = false;
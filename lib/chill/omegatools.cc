@@ -1976,47 +1976,45 @@ std::pair<std::vector<DependenceVector>, std::vector<DependenceVector> > relatio
         //debug_fprintf(stderr, "else messy\n"); 
         // For messy bounds, further test to see if the dependence distance
         // can be reduced to positive/negative.  This is an omega hack.
-        if (lbound == negInfinity && ubound == posInfinity) {
-          {
-            Relation t = dep.r;
-            F_And *f_root = t.and_with_and();
-            GEQ_Handle h = f_root->add_GEQ();
-            h.update_coef(t.input_var(level), 1);
-            h.update_coef(t.output_var(level), -1);
-            h.update_const(-1);
-            
-            if (!t.is_satisfiable()) {
+        if ((lbound == negInfinity && ubound == posInfinity) ||
+            lbound == 0 || ubound == 0) {
+          // Every probe adds a single constraint to dep.r, so simplify it
+          // once and try each constraint in a scope of its own.
+          Relation_Solver solver(dep.r);
+          Relation_Solver::Terms forward, backward;  // in - out, out - in
+          forward.push_back(std::make_pair(dep.r.input_var(level), static_cast<coef_t>(1)));
+          forward.push_back(std::make_pair(dep.r.output_var(level), static_cast<coef_t>(-1)));
+          backward.push_back(std::make_pair(dep.r.input_var(level), static_cast<coef_t>(-1)));
+          backward.push_back(std::make_pair(dep.r.output_var(level), static_cast<coef_t>(1)));
+
+          if (lbound == negInfinity && ubound == posInfinity) {
+            solver.push();
+            solver.add_GEQ(forward, -1);
+            if (!solver.is_satisfiable()) {
               lbound = 0;
             }
-          }
-          {
-            Relation t = dep.r;
-            F_And *f_root = t.and_with_and();
-            GEQ_Handle h = f_root->add_GEQ();
-            h.update_coef(t.input_var(level), -1);
-            h.update_coef(t.output_var(level), 1);
-            h.update_const(-1);
-            
-            if (!t.is_satisfiable()) {
+            solver.pop();
+
+            solver.push();
+            solver.add_GEQ(backward, -1);
+            if (!solver.is_satisfiable()) {
               ubound = 0;
             }
+            solver.pop();
           }
-        }
-        
-        // Same thing as above, test to see if zero dependence
-        // distance possible.
-        if (lbound == 0 || ubound == 0) {
-          Relation t = dep.r;
-          F_And *f_root = t.and_with_and();
-          EQ_Handle h = f_root->add_EQ();
-          h.update_coef(t.input_var(level), 1);
-          h.update_coef(t.output_var(level), -1);
-          
-          if (!t.is_satisfiable()) {
-            if (lbound == 0)
-              lbound = 1;
-            if (ubound == 0)
-              ubound = -1;
+
+          // Same thing as above, test to see if zero dependence
+          // distance possible.
+          if (lbound == 0 || ubound == 0) {
+            solver.push();
+            solver.add_EQ(forward);
+            if (!solver.is_satisfiable()) {
+              if (lbound == 0)
+                lbound = 1;
+              if (ubound == 0)
+                ubound = -1;
+            }
+            solver.pop();
           }
         }
         
@@ -21,6 +21,7 @@
 #include <util/util.h>
 #include <set_relation/expression.h>
 #include <set_relation/set_relation.h>
+#include <set_relation/serialization.h>
 #include <parser/parser.h>
 #include <set_relation/UninterpFunc.h>
 #include <set_relation/TupleDecl.h>
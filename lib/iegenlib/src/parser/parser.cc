@@ -1,248 +1,696 @@
 /*!
  * \file parser.cc
  *
- * \brief Implementations to methods declared in parser.h
+ * \brief Hand-written recursive-descent parser for sets, relations, and
+ *        environments, implementing parse_set, parse_relation, and
+ *        parse_env from parser.h.
  *
- * \date Started: 5/17/2010
- * # $Revision:: 622                $: last committed revision
- * # $Date:: 2013-01-18 13:11:32 -0#$: date of last committed revision
- * # $Author:: cathie               $: author of last committed revision
+ * It accepts the language described by parser.l and parser.y and builds
+ * the same Sets and Relations that the bison parser builds.  The scanner
+ * works in place on the input string, tokens only point into it, and all
+ * of the parser's state lives in a Parser on the caller's stack, so any
+ * number of threads can parse at the same time.  Tuple elements, function
+ * arguments, and conjunctions are collected in scratch vectors that are
+ * reused throughout a parse, constraints are added to their Conjunction as
+ * soon as they are parsed, and no std::string is made for a token unless
+ * it names something in the result.
  *
- * \authors Michelle Strout, Alan LaMielle, Nicholas Jeanette
- *
- * Copyright (c) 2009, 2010, 2011, 2012, Colorado State University <br>
- * All rights reserved. <br>
  * See ../../COPYING for details. <br>
 */
 
 #include <parser/parser.h>
-
-
-// The yyparse() routine will be defined in the c++ file generated by flex.
-// gen_parser.cc
-//extern int yyparse();
-extern int zzparse();
-#define yyparse zzparse
-
-using namespace std;
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <sstream>
+#include <vector>
 
 namespace iegenlib{ namespace parser{
 
-   /*! a string of input buffer */
-   string input_buffer;
-
-   /*! the integer of our input position */
-   unsigned int input_pos;
+namespace {
+
+   //! The tokens parser.l hands to the bison grammar.
+   enum TokenKind {
+      TOK_END, TOK_LBRACE, TOK_RBRACE, TOK_LBRACKET, TOK_RBRACKET,
+      TOK_LPAREN, TOK_RPAREN, TOK_COMMA, TOK_COLON, TOK_SEMI,
+      TOK_EQ, TOK_LT, TOK_LTE, TOK_GT, TOK_GTE, TOK_ARROW,
+      TOK_PLUS, TOK_DASH, TOK_STAR, TOK_AND,
+      TOK_UNION, TOK_OR, TOK_EXISTS, TOK_INVERSE,
+      TOK_ID, TOK_INT
+   };
+
+   //! A token refers to its text in the input instead of copying it.
+   struct Token {
+      TokenKind kind;
+      const char* text;
+      unsigned int length;
+      int value;              //!< of a TOK_INT
+      unsigned int line;
+      unsigned int column;
+   };
+
+   /*!
+    * \class Parser
+    *
+    * \brief Scanner and parser state for parsing one string.
+    *
+    * Grammar, where [] is optional, * repeats, and | separates choices:
+    *
+    *    start       : ID '(' ')' '=' inverse ID '(' ')'
+    *                | [ '[' ID (',' ID)* ']' '->' ] body
+    *    body        : '{' conjunct '}' ( union '{' conjunct '}' )*
+    *                | '{' conjunct ( ';' conjunct )+ '}'
+    *    conjunct    : tuple [ '->' tuple ] [ ':' [ constraint
+    *                                             ( ('&&' | and) constraint )* ] ]
+    *    tuple       : [ '[' [ (ID | INT) ( ',' (ID | INT) )* ] ']' ]
+    *    constraint  : expression ('=' | '<' | '<=' | '>' | '>=') expression
+    *                | expression ('<' | '<=') expression ('<' | '<=') expression
+    *    expression  : unary ( ('+' | '-') unary )*
+    *    unary       : '-' unary | term
+    *    term        : INT [ ['*'] simple ] | simple [ '*' INT ]
+    *    simple      : ID [ '(' expression (',' expression)* ')' [ '[' INT ']' ] ]
+    *                | '(' expression (',' expression)* ')'
+    *
+    * All conjuncts of a body are either set or relation conjuncts.
+    */
+   class Parser {
+   public:
+      explicit Parser(const std::string& input);
+      ~Parser();
+
+      //! Parses the whole input.  On return exactly one of env, set, and
+      //! relation is set, the others are left NULL.
+      void parseStart(Environment*& env, Set*& set, Relation*& relation);
+
+   private:
+      Parser(const Parser&);
+      Parser& operator=(const Parser&);
+
+      // Scanner
+      void advance();
+      void scanWord();
+      void scanInt();
+
+      bool at(TokenKind kind) const { return mTok.kind == kind; }
+      bool accept(TokenKind kind);
+      void expect(TokenKind kind);
+      void error(const std::string& message) const;
+      void errorExpected(const std::string& expected) const;
+      std::string tokenString() const
+         { return std::string(mTok.text, mTok.length); }
+
+      // Grammar
+      Environment* parseEnvironment();
+      void parseSymbolic();
+      void parseBody(int& isRelation);
+      Conjunction* parseConjunct(int& isRelation);
+      TupleDecl parseTuple();
+      void parseConstraint(Conjunction* conj);
+      Exp* parseExpression();
+      Exp* parseUnary();
+      Exp* parseTerm();
+      Exp* parseSimple();
+      unsigned int parseExpressionList();
+
+      const char* mPos;
+      const char* mEnd;
+      const char* mLineStart;
+      unsigned int mLine;
+      Token mTok;
+
+      //! Elements of the tuple being parsed.
+      std::vector<Token> mTupleElems;
+      //! Arguments and tuple elements of the calls and tuples being parsed,
+      //! innermost last.  Owned until they are handed to their term.
+      std::vector<Exp*> mExpStack;
+      //! Conjuncts of the body, owned until added to the result.
+      std::vector<Conjunction*> mConjunctions;
+   };
+
+   static const char* tokenName(TokenKind kind) {
+      switch (kind) {
+         case TOK_END:      return "end of input";
+         case TOK_LBRACE:   return "'{'";
+         case TOK_RBRACE:   return "'}'";
+         case TOK_LBRACKET: return "'['";
+         case TOK_RBRACKET: return "']'";
+         case TOK_LPAREN:   return "'('";
+         case TOK_RPAREN:   return "')'";
+         case TOK_COMMA:    return "','";
+         case TOK_COLON:    return "':'";
+         case TOK_SEMI:     return "';'";
+         case TOK_EQ:       return "'='";
+         case TOK_LT:       return "'<'";
+         case TOK_LTE:      return "'<='";
+         case TOK_GT:       return "'>'";
+         case TOK_GTE:      return "'>='";
+         case TOK_ARROW:    return "'->'";
+         case TOK_PLUS:     return "'+'";
+         case TOK_DASH:     return "'-'";
+         case TOK_STAR:     return "'*'";
+         case TOK_AND:      return "'&&'";
+         case TOK_UNION:    return "'union'";
+         case TOK_OR:       return "'or'";
+         case TOK_EXISTS:   return "'exists'";
+         case TOK_INVERSE:  return "'inverse'";
+         case TOK_ID:       return "identifier";
+         case TOK_INT:      return "integer";
+      }
+      return "token";
+   }
 
-   /*! boolean flag set when an error occurs in the parser */
-   bool parse_error;
+   //! Characters that may appear in an identifier after its start.
+   static inline bool isWordChar(char c) {
+      return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+          || (c >= '0' && c <= '9') || c == '_' || c == '\'' || c == '$';
+   }
 
-   /// error message for when an error occurs in the parser
-   string error_message;
-   /*! This is used for the actual parsing of the string we pass in we return
-   each char of the string
-   @return int the value of each char of our string */
-   int string_get_next_char() {
-      int retchar = 0;
+   //! Characters that may start an identifier (after an optional '_').
+   static inline bool isIdentStart(char c) {
+      return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+          || c == '\'' || c == '$';
+   }
 
-      //If we are not at the end of the input string buffer
-      if (input_pos<input_buffer.length() && !parse_error) {
-         //Return the next char in the string
-         retchar = input_buffer[input_pos];
-         input_pos += 1;
-      } else {
-         //Otherwise return EOF
-         retchar = EOF;
+   static inline bool wordIs(const Token& tok, const char* word) {
+      unsigned int i = 0;
+      for (; i < tok.length; i++) {
+         if (word[i] != tok.text[i]) { return false; }
       }
-
-      return retchar;
+      return word[i] == '\0';
    }
 
-   /*! Environment pointer parse_env_result. */
-   Environment* parse_env_result;
+   Parser::Parser(const std::string& input)
+      : mPos(input.data()), mEnd(input.data() + input.size()),
+        mLineStart(input.data()), mLine(1) {
+      advance();
+   }
 
-   /*! Relation pointer parse_relation_result. */
-   Relation* parse_relation_result;
+   Parser::~Parser() {
+      for (size_t i = 0; i < mExpStack.size(); i++) {
+         delete mExpStack[i];
+      }
+      for (size_t i = 0; i < mConjunctions.size(); i++) {
+         delete mConjunctions[i];
+      }
+   }
 
-   /*! Set pointer parse_set_result. */
-   Set* parse_set_result;
-   
-   /*! parser_env passes a string representation of an environment 
-   to the parser and an Environment gets created.
-   @param string env string that is to be parsed
-   @return Null pointer if error occurs or an environment is returned
-   @return Environment pointer when parsing is successful
-   */
-   Environment* parse_env(std::string env_string) {
-      //reset all fields
-      parser::parse_env_result=NULL;
-      parser::parse_relation_result=NULL;
-      parser::parse_set_result=NULL;
-      parse_error = false;
-      input_buffer.clear();
+   /*! Scans the next token into mTok. */
+   void Parser::advance() {
+      while (mPos < mEnd && (*mPos == ' ' || *mPos == '\t' || *mPos == '\n'
+                             || *mPos == '\r')) {
+         if (*mPos == '\n') {
+            mLine += 1;
+            mLineStart = mPos + 1;
+         }
+         mPos += 1;
+      }
 
-      //Set the input buffer to the given env string
-      input_buffer=env_string;
+      mTok.text = mPos;
+      mTok.length = 1;
+      mTok.value = 0;
+      mTok.line = mLine;
+      mTok.column = mPos - mLineStart + 1;
+      if (mPos == mEnd) {
+         mTok.kind = TOK_END;
+         mTok.length = 0;
+         return;
+      }
 
-      //Set the starting position at the first character
-      input_pos=0;
+      char next = (mPos + 1 < mEnd) ? mPos[1] : '\0';
+      switch (*mPos) {
+         case '{': mTok.kind = TOK_LBRACE; break;
+         case '}': mTok.kind = TOK_RBRACE; break;
+         case '[': mTok.kind = TOK_LBRACKET; break;
+         case ']': mTok.kind = TOK_RBRACKET; break;
+         case '(': mTok.kind = TOK_LPAREN; break;
+         case ')': mTok.kind = TOK_RPAREN; break;
+         case ',': mTok.kind = TOK_COMMA; break;
+         case ':': mTok.kind = TOK_COLON; break;
+         case ';': mTok.kind = TOK_SEMI; break;
+         case '=': mTok.kind = TOK_EQ; break;
+         case '+': mTok.kind = TOK_PLUS; break;
+         case '*': mTok.kind = TOK_STAR; break;
+         case '<':
+            mTok.kind = (next == '=') ? TOK_LTE : TOK_LT;
+            mTok.length = (next == '=') ? 2 : 1;
+            break;
+         case '>':
+            mTok.kind = (next == '=') ? TOK_GTE : TOK_GT;
+            mTok.length = (next == '=') ? 2 : 1;
+            break;
+         case '-':
+            mTok.kind = (next == '>') ? TOK_ARROW : TOK_DASH;
+            mTok.length = (next == '>') ? 2 : 1;
+            break;
+         case '&':
+            if (next != '&') {
+               mPos += 1;
+               advance();
+               return;
+            }
+            mTok.kind = TOK_AND;
+            mTok.length = 2;
+            break;
+         default:
+            if (*mPos >= '0' && *mPos <= '9') {
+               scanInt();
+            } else if (isWordChar(*mPos)) {
+               scanWord();
+            } else {
+               // The flex scanner drops characters that match no rule
+               // (e.g. the '!' of "i != j"), so do the same here.
+               mPos += 1;
+               advance();
+               return;
+            }
+      }
+      mPos += mTok.length;
+   }
 
-      //Run the parser
-      yyparse();
+   /*! Scans an integer constant. */
+   void Parser::scanInt() {
+      const char* end = mPos;
+      long long value = 0;
+      while (end < mEnd && *end >= '0' && *end <= '9') {
+         value = value * 10 + (*end - '0');
+         if (value > INT_MAX) {
+            error("integer constant out of range");
+         }
+         end += 1;
+      }
+      mTok.kind = TOK_INT;
+      mTok.value = (int)value;
+      mTok.length = end - mPos;
+   }
 
-      //if the error flag is set throw an exception
-      if(parse_error==true){
-         throw parse_exception(error_message);
+   /*! Scans an identifier or keyword.  Like parser.l, an identifier may
+   start with one '_', but not with "__", which is reserved for the tuple
+   variables iegenlib makes up. */
+   void Parser::scanWord() {
+      const char* end = mPos;
+      while (end < mEnd && isWordChar(*end)) {
+         end += 1;
       }
+      mTok.length = end - mPos;
 
-      //if a relation is returned from yyparse return null
-      if(parse_env_result == NULL){
-         return NULL;
+      if (!(isIdentStart(mPos[0])
+            || (mPos[0] == '_' && mTok.length > 1 && isIdentStart(mPos[1])))) {
+         error("invalid identifier '" + tokenString() + "'");
       }
 
-      return parse_env_result;
+      mTok.kind = TOK_ID;
+      if (mTok.length == 3 && (mPos[0] | 0x20) == 'a'
+          && (mPos[1] | 0x20) == 'n' && (mPos[2] | 0x20) == 'd') {
+         mTok.kind = TOK_AND;
+      } else if (wordIs(mTok, "union") || wordIs(mTok, "UNION")) {
+         mTok.kind = TOK_UNION;
+      } else if (wordIs(mTok, "or") || wordIs(mTok, "OR")) {
+         mTok.kind = TOK_OR;
+      } else if (wordIs(mTok, "exists")) {
+         mTok.kind = TOK_EXISTS;
+      } else if (wordIs(mTok, "inverse") || wordIs(mTok, "INVERSE")) {
+         mTok.kind = TOK_INVERSE;
+      }
    }
 
-   /*! getter for the parse_env_result
-   @return Environment* parse_env_result */
-   // FIXME: not sure why the other getters do copies.
-   // Should change them to be consistent with this one.
-   // NOT sure this is even used.
-   Environment* get_parse_env_result() {
-      return (parse_env_result);
+   bool Parser::accept(TokenKind kind) {
+      if (mTok.kind != kind) { return false; }
+      advance();
+      return true;
    }
 
-   /*! setter for the parse_env_result
-   @param Environment parse_env_result */
-   void set_parse_env_result(Environment* e) {
-      parser::parse_env_result=e;
-   }   
-   
-
-   /*!parser_set passes a string representation of a set to the parser and a
-   ParseSet gets created.
-   @param string set string that is to be parsed
-   @return Null pointer if error occurs or a relation is returned
-   @return Set pointer when parsing is successful
-   */
-   Set* parse_set(string set_string)  {
-      //reset all fields
-      parser::parse_env_result=NULL;
-      parser::parse_relation_result=NULL;
-      parser::parse_set_result=NULL;
-      parse_error = false;
-      input_buffer.clear();
-
-      //Set the input buffer to the given set string
-      input_buffer=set_string;
+   void Parser::expect(TokenKind kind) {
+      if (mTok.kind != kind) { errorExpected(tokenName(kind)); }
+      advance();
+   }
 
-      //Set the starting position at the first character
-      input_pos=0;
+   /*! Throws a parse_exception locating the current token. */
+   void Parser::error(const std::string& message) const {
+      std::stringstream ss;
+      ss << "syntax error at line " << mTok.line << ", column "
+         << mTok.column << ": " << message;
+      throw parse_exception(ss.str());
+   }
 
-      //Run the parser
-      yyparse();
+   void Parser::errorExpected(const std::string& expected) const {
+      if (mTok.kind == TOK_END) {
+         error("expected " + expected + " but found end of input");
+      }
+      error("expected " + expected + " but found '" + tokenString() + "'");
+   }
 
-      //if the error flag is set throw an exception
-      if(parse_error==true){
-         throw parse_exception(error_message);
+   /*! start: environment, or an optional symbolic list and a body. */
+   void Parser::parseStart(Environment*& env, Set*& set,
+                           Relation*& relation) {
+      if (at(TOK_ID)) {
+         std::unique_ptr<Environment> result(parseEnvironment());
+         expect(TOK_END);
+         env = result.release();
+         return;
       }
 
-      //if a relation is returned from yyparse return null
-      if(parse_set_result == NULL){
-         return NULL;
+      if (at(TOK_LBRACKET)) { parseSymbolic(); }
+      int isRelation = -1;
+      parseBody(isRelation);
+      expect(TOK_END);
+
+      const Conjunction* first = mConjunctions.front();
+      SparseConstraints* result;
+      if (isRelation) {
+         int inarity = first->inarity();
+         relation = new Relation(inarity, first->arity() - inarity);
+         result = relation;
+      } else {
+         set = new Set(first->arity());
+         result = set;
       }
+      for (size_t i = 0; i < mConjunctions.size(); i++) {
+         Conjunction* conj = mConjunctions[i];
+         mConjunctions[i] = NULL;
+         result->addConjunction(conj);
+      }
+      mConjunctions.clear();
+   }
 
-      return parse_set_result;
+   /*! environment: f() = inverse g() */
+   Environment* Parser::parseEnvironment() {
+      std::string funcName = tokenString();
+      advance();
+      expect(TOK_LPAREN);
+      expect(TOK_RPAREN);
+      expect(TOK_EQ);
+      expect(TOK_INVERSE);
+      if (!at(TOK_ID)) { errorExpected("function name"); }
+      std::string inverseName = tokenString();
+      advance();
+      expect(TOK_LPAREN);
+      expect(TOK_RPAREN);
+
+      Environment* env = new Environment();
+      env->setInverse(funcName, inverseName);
+      return env;
    }
 
-   /*! getter for the parse_set_result
-   @return Set parse_set_result */
-   Set get_parse_set_result() {
-      return (*parse_set_result);
+   /*! Symbolic constants declared ahead of a body, [N, M] ->, are not
+   needed to build the result and are skipped. */
+   void Parser::parseSymbolic() {
+      expect(TOK_LBRACKET);
+      do {
+         if (!at(TOK_ID)) { errorExpected(tokenName(TOK_ID)); }
+         advance();
+      } while (accept(TOK_COMMA));
+      expect(TOK_RBRACKET);
+      expect(TOK_ARROW);
    }
 
-   /*! setter for the parse_set_result
-   @param Set parse_set_result */
-   void set_parse_set_result(Set* s) {
-      parser::parse_set_result=s;
+   /*! body: Omega style conjuncts joined by union, or isl style conjuncts
+   separated by ';' in one pair of braces. */
+   void Parser::parseBody(int& isRelation) {
+      expect(TOK_LBRACE);
+      mConjunctions.push_back(parseConjunct(isRelation));
+      if (accept(TOK_SEMI)) {
+         do {
+            mConjunctions.push_back(parseConjunct(isRelation));
+         } while (accept(TOK_SEMI));
+         expect(TOK_RBRACE);
+         // parser.y collects the conjuncts after the first one in reverse,
+         // keep its order since addConjunction depends on it.
+         std::reverse(mConjunctions.begin() + 1, mConjunctions.end());
+         return;
+      }
+      expect(TOK_RBRACE);
+      while (accept(TOK_UNION)) {
+         expect(TOK_LBRACE);
+         mConjunctions.push_back(parseConjunct(isRelation));
+         expect(TOK_RBRACE);
+      }
    }
 
+   /*! conjunct: tuple declaration(s) and optional constraints.  The first
+   conjunct decides whether this is a set or a relation (isRelation is -1
+   until then), the others have to agree. */
+   Conjunction* Parser::parseConjunct(int& isRelation) {
+      TupleDecl tdecl = parseTuple();
+      if (isRelation == -1) { isRelation = at(TOK_ARROW); }
+
+      std::unique_ptr<Conjunction> conj;
+      if (isRelation) {
+         expect(TOK_ARROW);
+         TupleDecl outdecl = parseTuple();
+         conj.reset(new Conjunction(tdecl.size() + outdecl.size(),
+                                    tdecl.size()));
+         conj->setTupleDecl(tdecl, outdecl);
+      } else {
+         conj.reset(new Conjunction(tdecl.size()));
+         conj->setTupleDecl(tdecl);
+      }
 
-   /*! passes a relation string into the parser and creates the Relation
-   @param string relation string that is to be parsed
-   @return Null pointer if error occurs or a set is returned
-   @return Relation pointer when parsing is successful */
-   Relation* parse_relation(string relation_string) {
-      //reset all fields
-      parser::parse_env_result=NULL;
-      parser::parse_relation_result=NULL;
-      parser::parse_set_result=NULL;
-      parse_error = false;
-      input_buffer.clear();
+      if (accept(TOK_COLON) && !at(TOK_RBRACE) && !at(TOK_SEMI)) {
+         do {
+            parseConstraint(conj.get());
+         } while (accept(TOK_AND));
+      }
 
-      //Set the input buffer to the given relation string
-      input_buffer = relation_string;
+      conj->substituteTupleDecl();
+      return conj.release();
+   }
 
-      //Set the starting position at the first character
-      input_pos=0;
+   /*! tuple: [ '[' elements ']' ], where an element is a variable or an
+   integer constant.  A missing tuple is an empty one. */
+   TupleDecl Parser::parseTuple() {
+      if (!accept(TOK_LBRACKET)) { return TupleDecl(); }
+
+      mTupleElems.clear();
+      if (!at(TOK_RBRACKET)) {
+         do {
+            if (!at(TOK_ID) && !at(TOK_INT)) {
+               errorExpected("tuple variable or constant");
+            }
+            mTupleElems.push_back(mTok);
+            advance();
+         } while (accept(TOK_COMMA));
+      }
+      expect(TOK_RBRACKET);
+
+      if (mTupleElems.empty()) { return TupleDecl(); }
+      TupleDecl tdecl(mTupleElems.size());
+      for (unsigned int i = 0; i < mTupleElems.size(); i++) {
+         const Token& elem = mTupleElems[i];
+         if (elem.kind == TOK_INT) {
+            tdecl.setTupleElem(i, elem.value);
+         } else {
+            tdecl.setTupleElem(i, std::string(elem.text, elem.length));
+         }
+      }
+      return tdecl;
+   }
 
-      //Run the parser
-      yyparse();
+   /*! Turns a < b (strict) or a <= b into the inequality b - a [- 1] >= 0,
+   with the same steps parser.y takes.  Adopts both expressions. */
+   static Exp* lessThan(Exp* a, Exp* b, bool strict) {
+      b->setInequality();
+      if (strict) { a->addTerm(new Term(1)); }
+      a->multiplyBy(-1);
+      b->addExp(a);
+      return b;
+   }
 
-      //if error flag is set then throw an exception
-      if(parse_error==true){
-        throw parse_exception(error_message);
+   static void addConstraint(Conjunction* conj, Exp* constraint) {
+      if (constraint->isEquality()) {
+         conj->addEquality(constraint);
+      } else if (constraint->isInequality()) {
+         conj->addInequality(constraint);
+      } else {
+         delete constraint;
       }
+   }
 
-      //if a set is returned from yyparse return null
-      if(parse_relation_result==NULL){
-         return NULL;
+   /*! constraint: a comparison, or a range lo (<|<=) mid (<|<=) hi which
+   adds two inequalities. */
+   void Parser::parseConstraint(Conjunction* conj) {
+      std::unique_ptr<Exp> lhs(parseExpression());
+      TokenKind op = mTok.kind;
+      if (op != TOK_EQ && op != TOK_LT && op != TOK_LTE && op != TOK_GT
+          && op != TOK_GTE) {
+         errorExpected("comparison operator");
+      }
+      advance();
+      std::unique_ptr<Exp> rhs(parseExpression());
+
+      if ((op == TOK_LT || op == TOK_LTE) && (at(TOK_LT) || at(TOK_LTE))) {
+         bool strict = at(TOK_LT);
+         advance();
+         std::unique_ptr<Exp> upper(parseExpression());
+         Exp* mid = rhs->clone();
+         addConstraint(conj, lessThan(lhs.release(), rhs.release(),
+                                      op == TOK_LT));
+         addConstraint(conj, lessThan(mid, upper.release(), strict));
+         return;
       }
 
-      return parse_relation_result;
+      switch (op) {
+         case TOK_EQ:
+            lhs->setEquality();
+            rhs->multiplyBy(-1);
+            lhs->addExp(rhs.release());
+            addConstraint(conj, lhs.release());
+            break;
+         case TOK_LT:
+         case TOK_LTE:
+            addConstraint(conj, lessThan(lhs.release(), rhs.release(),
+                                         op == TOK_LT));
+            break;
+         default:
+            addConstraint(conj, lessThan(rhs.release(), lhs.release(),
+                                         op == TOK_GT));
+            break;
+      }
    }
 
-   /*! getter for the parse_relation_result
-    * the getter can only be called a single time
-    * the code that calls it gets a copy of the object
-    * and we delete our copy
-   @return Relation parse_relation_result */
-   Relation get_parse_relation_result() {
-      Relation retval = (*parse_relation_result);
-      delete parse_relation_result;
-      return retval;
+   /*! expression: unary terms joined by '+' and '-'. */
+   Exp* Parser::parseExpression() {
+      std::unique_ptr<Exp> exp(parseUnary());
+      while (at(TOK_PLUS) || at(TOK_DASH)) {
+         bool minus = at(TOK_DASH);
+         advance();
+         Exp* rhs = parseUnary();
+         if (minus) { rhs->multiplyBy(-1); }
+         exp->addExp(rhs);
+      }
+      return exp.release();
    }
 
-   /*! setter for the parse_relation_result
-   @param Relation parse_relation_result */
-   void set_parse_relation_result(Relation* s) {
-      parser::parse_relation_result=s;
+   /*! unary: negation binds tighter than '+' and '-'. */
+   Exp* Parser::parseUnary() {
+      if (accept(TOK_DASH)) {
+         Exp* exp = parseUnary();
+         exp->multiplyBy(-1);
+         return exp;
+      }
+      return parseTerm();
    }
 
-   /*! sets the parse_error flag to true */
-   void set_parse_error(string error){
-      parse_error = true;
-      error_message = error;
-   }
+   /*! term: an integer, optionally multiplying a simple expression
+   (2i, 2*i, 2(i+1)), or a simple expression optionally multiplied by an
+   integer (i*2). */
+   Exp* Parser::parseTerm() {
+      if (at(TOK_INT)) {
+         int coeff = mTok.value;
+         advance();
+         if (accept(TOK_STAR) || at(TOK_ID) || at(TOK_LPAREN)) {
+            Exp* exp = parseSimple();
+            exp->multiplyBy(coeff);
+            return exp;
+         }
+         Exp* exp = new Exp();
+         exp->addTerm(new Term(coeff));
+         return exp;
+      }
 
-   /*! getter for the parse_error flag
-   @return bool parse_error */
-   bool get_parse_error(){
-      return parse_error;
+      std::unique_ptr<Exp> exp(parseSimple());
+      if (accept(TOK_STAR)) {
+         if (!at(TOK_INT)) { errorExpected(tokenName(TOK_INT)); }
+         exp->multiplyBy(mTok.value);
+         advance();
+      }
+      return exp.release();
    }
 
-   /*! clearAll frees (if needed) and resets the parse_relation_result and the
-   parse_set_result so no data is left in those variables*/
-   void clearAll(){
-      if(parse_relation_result!=NULL){
-         delete parse_relation_result;
+   /*! simple: a variable, a function call (optionally indexed into the
+   tuple it returns), or a parenthesized expression or tuple. */
+   Exp* Parser::parseSimple() {
+      if (accept(TOK_LPAREN)) {
+         unsigned int count = parseExpressionList();
+         expect(TOK_RPAREN);
+         Exp* exp;
+         if (count == 1) {
+            exp = mExpStack.back();
+            mExpStack.pop_back();
+         } else {
+            size_t base = mExpStack.size() - count;
+            TupleExpTerm* tuple = new TupleExpTerm(count);
+            for (unsigned int i = 0; i < count; i++) {
+               tuple->setExpElem(i, mExpStack[base + i]);
+            }
+            mExpStack.resize(base);
+            exp = new Exp();
+            exp->addTerm(tuple);
+         }
+         return exp;
+      }
+
+      if (!at(TOK_ID)) { errorExpected("expression"); }
+      std::string name = tokenString();
+      advance();
+      if (!accept(TOK_LPAREN)) {
+         Exp* exp = new Exp();
+         exp->addTerm(new VarTerm(name));
+         return exp;
+      }
+
+      unsigned int count = parseExpressionList();
+      expect(TOK_RPAREN);
+      int index = -1;
+      if (accept(TOK_LBRACKET)) {
+         if (!at(TOK_INT)) { errorExpected(tokenName(TOK_INT)); }
+         index = mTok.value;
+         advance();
+         expect(TOK_RBRACKET);
       }
-      if(parse_set_result!=NULL){
-         delete parse_set_result;
+
+      size_t base = mExpStack.size() - count;
+      UFCallTerm* call = new UFCallTerm(name, count, index);
+      for (unsigned int i = 0; i < count; i++) {
+         call->setParamExp(i, mExpStack[base + i]);
       }
-      parser::parse_relation_result=NULL;
-      parser::parse_set_result=NULL;
-      input_buffer.clear();
+      mExpStack.resize(base);
+      Exp* exp = new Exp();
+      exp->addTerm(call);
+      return exp;
    }
 
+   /*! Pushes one or more comma separated expressions onto mExpStack and
+   returns how many. */
+   unsigned int Parser::parseExpressionList() {
+      unsigned int count = 0;
+      do {
+         Exp* exp = parseExpression();
+         mExpStack.push_back(exp);
+         count += 1;
+      } while (accept(TOK_COMMA));
+      return count;
+   }
+
+} // end anonymous namespace
+
+Environment* parse_env(std::string env_string) {
+   Environment* env = NULL;
+   Set* set = NULL;
+   Relation* relation = NULL;
+   Parser(env_string).parseStart(env, set, relation);
+   delete set;
+   delete relation;
+   return env;
+}
+
+Set* parse_set(std::string set_string) {
+   Environment* env = NULL;
+   Set* set = NULL;
+   Relation* relation = NULL;
+   Parser(set_string).parseStart(env, set, relation);
+   delete env;
+   delete relation;
+   return set;
+}
+
+Relation* parse_relation(std::string relation_string) {
+   Environment* env = NULL;
+   Set* set = NULL;
+   Relation* relation = NULL;
+   Parser(relation_string).parseStart(env, set, relation);
+   delete env;
+   delete set;
+   return relation;
+}
+
 }}//end namespace iegenlib::parser
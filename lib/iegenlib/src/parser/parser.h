@@ -33,9 +33,6 @@
     functions and associated global variables.
 */
 namespace iegenlib { namespace parser{
-   //! Used by lexer to obtain each character of input string being parsed.
-   int string_get_next_char();
-
    /*!parser_env passes a string representation of an environment 
    to the parser and an Environment gets created.
    @param string env string that is to be parsed
@@ -44,10 +41,6 @@ namespace iegenlib { namespace parser{
    */
    Environment* parse_env(std::string env_string);
 
-   /*! setter for the parse_env_result
-   @param Environment parse_env_result */
-   void set_parse_env_result(Environment* env);
-
    /*!parser_set passes a string representation of a set to the parser and a
    Set gets created.
    @param string set string that is to be parsed
@@ -56,16 +49,36 @@ namespace iegenlib { namespace parser{
    */
    Set* parse_set(std::string set_string);
 
-   /*! setter for the parse_set_result
-   @param Set parse_set_result */
-   void set_parse_set_result(Set* s);
-
    /*! passes a relation string into the parser and creates the Relation
    @param string relation string that is to be parsed
    @return Null pointer if error occurs or a set is returned
    @return Relation pointer when parsing is successful */
    Relation* parse_relation(std::string relation_string);
 
+   //! The three functions above are implemented by a hand-written
+   //! recursive-descent parser (parser.cc), which is reentrant and throws
+   //! parse_exception with the line and column of the first error.
+   //! The flex/bison parser it replaced accepts the same language and is
+   //! kept in this namespace for comparison.
+   namespace bison {
+      Environment* parse_env(std::string env_string);
+      Set* parse_set(std::string set_string);
+      Relation* parse_relation(std::string relation_string);
+   }
+
+   // The rest is used by the generated bison parser and flex scanner.
+
+   //! Used by lexer to obtain each character of input string being parsed.
+   int string_get_next_char();
+
+   /*! setter for the parse_env_result
+   @param Environment parse_env_result */
+   void set_parse_env_result(Environment* env);
+
+   /*! setter for the parse_set_result
+   @param Set parse_set_result */
+   void set_parse_set_result(Set* s);
+
    /*! setter for the parse_relation_result
    @param Relation parse_relation_result */
    void set_parse_relation_result(Relation* s);
@@ -0,0 +1,177 @@
+/*! \file parser_bench.cc
+ *
+ * \brief Compares the recursive-descent parser with the bison parser it
+ *        replaced on every set and relation string in set_relation_test.cc.
+ *
+ * Not part of the unit tests.  Build it with the library and run it as
+ *
+ *    parser_bench [path/to/set_relation_test.cc]
+ *
+ * where the path defaults to $IEGEN_HOME/src/set_relation/set_relation_test.cc.
+ * It exits with a non-zero status if the two parsers disagree on any string.
+ *
+ * See ../../COPYING for details. <br>
+*/
+
+#include <parser/parser.h>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace iegenlib;
+
+// Collects the string arguments of the Set and Relation constructors in a
+// source file, e.g. new Set("{[i]:0<=i<N}") or Relation r("{[i]->[j]}"),
+// joining adjacent literals.  isRelation[k] tells which one corpus[k] is for.
+static void readCorpus(const std::string& path,
+                       std::vector<std::string>& corpus,
+                       std::vector<bool>& isRelation) {
+   std::ifstream in(path.c_str());
+   std::stringstream buffer;
+   buffer << in.rdbuf();
+   const std::string src = buffer.str();
+
+   const char* names[] = {"Set", "Relation"};
+   for (size_t pos = 0; pos < src.size(); pos++) {
+      for (int n = 0; n < 2; n++) {
+         std::string name = names[n];
+         if (src.compare(pos, name.size(), name) != 0) { continue; }
+         if (pos > 0 && (isalnum(src[pos-1]) || src[pos-1] == '_')) {
+            continue;
+         }
+         size_t p = pos + name.size();
+         while (p < src.size() && isspace(src[p])) { p++; }
+         while (p < src.size() && (isalnum(src[p]) || src[p] == '_')) { p++; }
+         while (p < src.size() && isspace(src[p])) { p++; }
+         if (p >= src.size() || src[p] != '(') { continue; }
+         p++;
+
+         std::string literal;
+         bool found = false;
+         while (true) {
+            while (p < src.size() && isspace(src[p])) { p++; }
+            if (p >= src.size() || src[p] != '"') { break; }
+            for (p++; p < src.size() && src[p] != '"'; p++) {
+               if (src[p] == '\\') { p++; }
+               literal += src[p];
+            }
+            p++;
+            found = true;
+         }
+         if (found) {
+            corpus.push_back(literal);
+            isRelation.push_back(n == 1);
+         }
+      }
+   }
+}
+
+// What parsing str gives: the result's string, NULL, or a parse error.
+static std::string parseOutcome(const std::string& str, bool isRelation,
+                                bool bison) {
+   try {
+      if (isRelation) {
+         Relation* r = bison ? parser::bison::parse_relation(str)
+                             : parser::parse_relation(str);
+         std::string out = r ? r->toString() : "NULL";
+         delete r;
+         return out;
+      }
+      Set* s = bison ? parser::bison::parse_set(str) : parser::parse_set(str);
+      std::string out = s ? s->toString() : "NULL";
+      delete s;
+      return out;
+   } catch (parse_exception&) {
+      return "parse error";
+   }
+}
+
+// Seconds for one pass over the corpus, best of a few.
+static double timeCorpus(const std::vector<std::string>& corpus,
+                         const std::vector<bool>& isRelation, bool bison,
+                         int passes) {
+   double best = 0.0;
+   for (int rep = 0; rep < 5; rep++) {
+      std::chrono::steady_clock::time_point start
+         = std::chrono::steady_clock::now();
+      for (int pass = 0; pass < passes; pass++) {
+         for (size_t k = 0; k < corpus.size(); k++) {
+            if (isRelation[k]) {
+               delete (bison ? parser::bison::parse_relation(corpus[k])
+                             : parser::parse_relation(corpus[k]));
+            } else {
+               delete (bison ? parser::bison::parse_set(corpus[k])
+                             : parser::parse_set(corpus[k]));
+            }
+         }
+      }
+      double secs = std::chrono::duration<double>(
+         std::chrono::steady_clock::now() - start).count() / passes;
+      if (rep == 0 || secs < best) { best = secs; }
+   }
+   return best;
+}
+
+int main(int argc, char** argv) {
+   std::string path;
+   if (argc > 1) {
+      path = argv[1];
+   } else {
+      char* root = getenv("IEGEN_HOME");
+      if (root == NULL) {
+         std::cerr << "usage: " << argv[0] << " [set_relation_test.cc], or "
+                   << "set IEGEN_HOME to the distribution root directory"
+                   << std::endl;
+         return 2;
+      }
+      path = std::string(root) + "/src/set_relation/set_relation_test.cc";
+   }
+
+   std::vector<std::string> all;
+   std::vector<bool> allIsRelation;
+   readCorpus(path, all, allIsRelation);
+   if (all.empty()) {
+      std::cerr << "no set or relation strings found in " << path
+                << std::endl;
+      return 2;
+   }
+
+   // Both parsers have to agree on everything, including what they reject,
+   // only the inputs that parse are timed.
+   std::vector<std::string> corpus;
+   std::vector<bool> isRelation;
+   size_t bytes = 0;
+   int mismatches = 0;
+   for (size_t k = 0; k < all.size(); k++) {
+      std::string expected = parseOutcome(all[k], allIsRelation[k], true);
+      std::string actual = parseOutcome(all[k], allIsRelation[k], false);
+      if (expected != actual) {
+         std::cerr << "parsing \"" << all[k] << "\": bison gives \""
+                   << expected << "\", recursive descent gives \""
+                   << actual << "\"" << std::endl;
+         mismatches++;
+      }
+      if (expected != "parse error" && expected != "NULL") {
+         corpus.push_back(all[k]);
+         isRelation.push_back(allIsRelation[k]);
+         bytes += all[k].size();
+      }
+   }
+
+   const int passes = 20;
+   double bisonTime = timeCorpus(corpus, isRelation, true, passes);
+   double rdTime = timeCorpus(corpus, isRelation, false, passes);
+   std::cout << "[ PARSER ] " << corpus.size() << " strings, " << bytes
+             << " bytes per pass" << std::endl;
+   std::cout << "[ PARSER ] bison:            " << corpus.size() / bisonTime
+             << " strings/s, " << bytes / bisonTime * 1E-6 << " MB/s"
+             << std::endl;
+   std::cout << "[ PARSER ] recursive descent: " << corpus.size() / rdTime
+             << " strings/s, " << bytes / rdTime * 1E-6 << " MB/s ("
+             << bisonTime / rdTime << "x)" << std::endl;
+   return mismatches ? 1 : 0;
+}
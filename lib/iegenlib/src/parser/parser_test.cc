@@ -18,6 +18,8 @@
 #include <string>
 #include <parser/parser.h>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 using namespace iegenlib;
 
@@ -489,3 +491,110 @@ TEST(Parser, ConstraintRange) {
    delete s1;
 }
 
+
+// Syntax errors report where they are.
+TEST(Parser, ErrorLocation) {
+   try {
+      parser::parse_set("{[i,j] : 0 <= i < n &&\n  j > f(i }");
+      FAIL() << "expected a parse_exception";
+   } catch (parse_exception& e) {
+      EXPECT_EQ("syntax error at line 2, column 11: expected ')' but found '}'",
+                std::string(e.what()));
+   }
+
+   try {
+      parser::parse_relation("{[i] -> [j] : i = j");
+      FAIL() << "expected a parse_exception";
+   } catch (parse_exception& e) {
+      EXPECT_EQ("syntax error at line 1, column 20: expected '}' but found "
+                "end of input", std::string(e.what()));
+   }
+
+   EXPECT_THROW(parser::parse_set("{[i] : i >= 0 or i < -5}"),
+                parse_exception);
+   EXPECT_THROW(parser::parse_set("{[i] : i & 1 = 0}"), parse_exception);
+   EXPECT_THROW(parser::parse_set("{[i] : 2*i*3 = 0}"), parse_exception);
+   EXPECT_THROW(parser::parse_set("{[i] : f() = 0}"), parse_exception);
+   EXPECT_THROW(parser::parse_set("{[i] : i = 1} {[j]}"), parse_exception);
+   EXPECT_THROW(parser::parse_set("{[i] : i = 1; [i] -> [j]}"),
+                parse_exception);
+}
+
+// Sets and relations given as strings parse the same from several threads.
+TEST(Parser, ConcurrentParses) {
+   const std::string str = "[n] -> {[i,j] : 0 <= i < n && i < j <= f(i)}";
+   const std::string expected = parser::parse_set(str)->toString();
+
+   std::vector<std::string> results(4);
+   std::vector<std::thread> threads;
+   for (size_t t = 0; t < results.size(); t++) {
+      threads.push_back(std::thread([&str, &results, t]() {
+         for (int i = 0; i < 200; i++) {
+            Set* s = parser::parse_set(str);
+            results[t] = s->toString();
+            delete s;
+         }
+      }));
+   }
+   for (size_t t = 0; t < threads.size(); t++) {
+      threads[t].join();
+   }
+   for (size_t t = 0; t < results.size(); t++) {
+      EXPECT_EQ(expected, results[t]);
+   }
+}
+
+// What parsing str gives: the result's string, NULL, or a parse error.
+static std::string parseOutcome(const std::string& str, bool isRelation,
+                                bool bison) {
+   try {
+      if (isRelation) {
+         Relation* r = bison ? parser::bison::parse_relation(str)
+                             : parser::parse_relation(str);
+         std::string out = r ? r->toString() : "NULL";
+         delete r;
+         return out;
+      }
+      Set* s = bison ? parser::bison::parse_set(str) : parser::parse_set(str);
+      std::string out = s ? s->toString() : "NULL";
+      delete s;
+      return out;
+   } catch (parse_exception&) {
+      return "parse error";
+   }
+}
+
+// The recursive-descent parser and the bison parser agree on what they
+// build from a sample of sets and relations, and on what they reject.
+// parser_bench.cc compares them on every string in set_relation_test.cc.
+TEST(Parser, MatchesBison) {
+   const char* sets[] = {
+      "{[i,j] : 0 <= i < N && 0 <= j < M}",
+      "[N] -> {[i] : 0 <= i && i < N}",
+      "{[i] : i = 2j + 1 and 0 <= j < 10}",
+      "{[i,k] : exists(j : k = col(j) && index(i) <= j < index(i+1))}",
+      "{[i] : 0 <= i < 5} union {[i] : 10 <= i < 15}",
+      "{[i,j] : 0 < i <= n and 0 <= j < n}",
+      "{[i] : -i + 2 >= 0 && 3(i+1) <= 2*N}",
+      "{[i,j] : sigma(left(i))[0] = j}",
+      "{[i] : i >= 0 or i < -5}",
+      "{[i] : f() = 0}",
+   };
+   const char* relations[] = {
+      "{[i,j] -> [i,k] : 0 <= i < N && k = col(j)}",
+      "[N] -> { [i] -> [j] : i < j < N }",
+      "{[i] -> [j] : i = j - 1} union {[i] -> [j] : i = j + 1}",
+      "{[i] -> [i'] : i' = f(i) && 0 <= i}",
+      "{[i] -> [j] : i = j",
+   };
+   for (size_t k = 0; k < sizeof(sets) / sizeof(sets[0]); k++) {
+      EXPECT_EQ(parseOutcome(sets[k], false, true),
+                parseOutcome(sets[k], false, false))
+         << "parsing \"" << sets[k] << "\"";
+   }
+   for (size_t k = 0; k < sizeof(relations) / sizeof(relations[0]); k++) {
+      EXPECT_EQ(parseOutcome(relations[k], true, true),
+                parseOutcome(relations[k], true, false))
+         << "parsing \"" << relations[k] << "\"";
+   }
+}
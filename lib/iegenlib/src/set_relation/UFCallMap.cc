@@ -15,6 +15,7 @@
 #include "UFCallMap.h"
 #include "set_relation.h"
 #include <util/util.h>
+#include <algorithm>
 #include <iostream>
 
 namespace iegenlib{
@@ -35,27 +36,23 @@ UFCallMap& UFCallMap::operator=( const UFCallMap& other) {
 // ConsSymbol:  row_col_tv2P1_M2_
 string UFCallMap::symUFC( std::string ufcName )
 {
-    int len = ufcName.length();
-    std::stringstream ss;
-
-    for (int i = 0 ; i < len ; i++){
-        char c = ufcName[i];
-        if( c != ' ' && c != ','){
-            if( c == '(' || c == ')'){
-                ss <<'_';
-            } else if( c == '[' || c == ']'){
-                ss <<'B';
-            } else if( c == '+' ){
-                ss <<'P';
-            } else if( c == '-' ){
-                ss <<'M';
-            } else{
-                ss <<c;
-            }
+    std::string sym;
+    sym.reserve(ufcName.length());
+
+    for (std::string::const_iterator it = ufcName.begin();
+            it != ufcName.end(); it++){
+        char c = *it;
+        switch (c) {
+            case ' ': case ',': break;
+            case '(': case ')': sym.push_back('_'); break;
+            case '[': case ']': sym.push_back('B'); break;
+            case '+': sym.push_back('P'); break;
+            case '-': sym.push_back('M'); break;
+            default:  sym.push_back(c);
         }
     }
 
-    return (ss.str());
+    return sym;
 }
 
 /*! Use this to insert a UFCallTerm to map.
@@ -69,25 +66,39 @@ string UFCallMap::symUFC( std::string ufcName )
 */
 VarTerm UFCallMap::insert( UFCallTerm *ufc )
 {
-    UFCallTerm* ufcterm = new UFCallTerm (*ufc);
-    ufcterm->setCoefficient(1);
-    std::string symCons = ufcterm->toString();
+    UFC2VarMap::iterator it = mUFC2VarParam.find(*ufc);
+    if (it != mUFC2VarParam.end()){
+        return it->second;
+    }
 
-    symCons = UFCallMap::symUFC(symCons);
-    VarTerm vt( 1 , symCons );
+    UFCallTerm ufcterm(*ufc);
+    ufcterm.setCoefficient(1);
+    VarTerm vt( 1 , UFCallMap::symUFC(ufcterm.toString()) );
 
-    if( find(&vt) ){
+    if( mVarParam2UFC.find(vt.symbol()) != mVarParam2UFC.end() ){
         return vt;
     }
 
-    mUFC2VarParam.insert ( std::pair<UFCallTerm,VarTerm>(*ufcterm,vt) );
-    mVarParam2UFC.insert ( std::pair<VarTerm,UFCallTerm>(vt,*ufcterm) );
-
-    delete ufcterm;
+    mUFC2VarParam.insert ( std::make_pair(ufcterm,vt) );
+    mVarParam2UFC.insert ( std::make_pair(vt.symbol(),ufcterm) );
 
     return vt;
 }
 
+//! Adds the UFCs of other, and their VarTerms, that are not in this map.
+void UFCallMap::merge( const UFCallMap& other )
+{
+    for (UFC2VarMap::const_iterator it = other.mUFC2VarParam.begin();
+            it != other.mUFC2VarParam.end(); it++){
+        if( mVarParam2UFC.find(it->second.symbol()) == mVarParam2UFC.end()
+            && mUFC2VarParam.find(it->first) == mUFC2VarParam.end() ){
+            mUFC2VarParam.insert( *it );
+            mVarParam2UFC.insert( std::make_pair(it->second.symbol(),
+                                                 it->first) );
+        }
+    }
+}
+
 /*! Searches for ufcterm in the map. If ufcterm exists, it returns a pointer 
 **  to equ. VarTerm, otherwise it adds the ufcterm to the map, then returns
 **  the equ. VarTerm. The class does not own the object pointed by ufcterm,
@@ -98,20 +109,11 @@ VarTerm UFCallMap::insert( UFCallTerm *ufc )
 */
 VarTerm* UFCallMap::find( UFCallTerm* ufc )
 {
-    VarTerm* result;
-    UFCallTerm* ufcterm = new UFCallTerm(*ufc);
-    ufcterm->setCoefficient(1);
-    std::map<UFCallTerm,VarTerm>::iterator it;
-    
-    it = mUFC2VarParam.find(*ufcterm);
+    UFC2VarMap::iterator it = mUFC2VarParam.find(*ufc);
     if (it == mUFC2VarParam.end()){
-        result = new VarTerm(  (insert(ufcterm)).symbol() );
-    } else {
-        result = new VarTerm(it->second);
+        return new VarTerm( insert(ufc) );
     }
-
-    delete ufcterm;
-    return result;
+    return new VarTerm(it->second);
 }
 
 /*! Searches for a VarTerm in the map. If VarTerm exists in the map,
@@ -124,18 +126,32 @@ VarTerm* UFCallMap::find( UFCallTerm* ufc )
 */
 UFCallTerm* UFCallMap::find( VarTerm* vt )
 {
-    VarTerm* sym = new VarTerm(*vt);
-    sym->setCoefficient(1);
-    std::map<VarTerm,UFCallTerm>::iterator it;
-
-    it = mVarParam2UFC.find(*sym);
+    std::unordered_map<std::string,UFCallTerm>::iterator it =
+        mVarParam2UFC.find(vt->symbol());
     if (it == mVarParam2UFC.end()){
         return NULL;
     }
-    delete sym;
 
-    UFCallTerm* result = new UFCallTerm(it->second) ;
-    return result;
+    return new UFCallTerm(it->second);
+}
+
+// The entries in the order of the UFCallTerms, which is the order
+// UFCallMap has always printed them in.
+std::vector<const UFCallMap::UFC2VarMap::value_type*>
+UFCallMap::sortedEntries() const
+{
+    std::vector<const UFC2VarMap::value_type*> entries;
+    entries.reserve(mUFC2VarParam.size());
+    for (UFC2VarMap::const_iterator it = mUFC2VarParam.begin();
+            it != mUFC2VarParam.end(); it++){
+        entries.push_back(&(*it));
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const UFC2VarMap::value_type* a,
+                 const UFC2VarMap::value_type* b){
+                  return a->first < b->first;
+              });
+    return entries;
 }
 
 // prints the content of the map into a string, and returns it
@@ -143,10 +159,10 @@ std::string UFCallMap::toString()
 {
     std::stringstream ss;
     ss << "UFCallMap:" << std::endl;
-    std::map<UFCallTerm,VarTerm>::iterator it;
-    for (it=mUFC2VarParam.begin(); it!=mUFC2VarParam.end(); it++) {
-        ss << "\tUFC = " << it->first.toString() 
-           << "  ,  sym = " << it->second.toString() << std::endl;
+    std::vector<const UFC2VarMap::value_type*> entries = sortedEntries();
+    for (size_t i = 0; i < entries.size(); i++) {
+        ss << "\tUFC = " << entries[i]->first.toString() 
+           << "  ,  sym = " << entries[i]->second.toString() << std::endl;
     }
     return ss.str();
 }
@@ -157,10 +173,10 @@ std::string UFCallMap::toString()
 std::string UFCallMap::varTermStrList()
 {
     std::stringstream ss;
-    std::map<UFCallTerm,VarTerm>::iterator it;
-    for (it=mUFC2VarParam.begin(); it!=mUFC2VarParam.end(); it++) {
-        if( it != mUFC2VarParam.begin() ) ss << ", ";
-        ss << it->second.toString();
+    std::vector<const UFC2VarMap::value_type*> entries = sortedEntries();
+    for (size_t i = 0; i < entries.size(); i++) {
+        if( i > 0 ) ss << ", ";
+        ss << entries[i]->second.toString();
     }
     return ss.str();
 }
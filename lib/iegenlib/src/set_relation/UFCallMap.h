@@ -19,6 +19,9 @@
 #include "TupleDecl.h"
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace iegenlib{
 
@@ -63,6 +66,9 @@ public:
     */
     VarTerm insert( UFCallTerm *ufc);
 
+    //! Adds the UFCs of other, and their VarTerms, that are not in this map.
+    void merge( const UFCallMap& other );
+
     /*! Searches for ufcterm in the map. If ufcterm exists, it returns
     **  a pointer to equ. VarTerm, otherwise returns NULL.
     **  The class does not own the object pointed by ufcterm,
@@ -91,8 +97,25 @@ public:
     std::string varTermStrList();
 
 private:
-    std::map<UFCallTerm,VarTerm> mUFC2VarParam;
-    std::map<VarTerm,UFCallTerm> mVarParam2UFC;
+    //! Hashes UFCallTerms consistently with factorMatches, so a call is
+    //! found whatever its coefficient.
+    struct UFCallHash {
+        size_t operator()(const UFCallTerm& ufc) const
+            { return ufc.factorHash(); }
+    };
+    struct UFCallEqual {
+        bool operator()(const UFCallTerm& a, const UFCallTerm& b) const
+            { return a.factorMatches(b); }
+    };
+    typedef std::unordered_map<UFCallTerm,VarTerm,UFCallHash,UFCallEqual>
+        UFC2VarMap;
+
+    //! The (UFC, VarTerm) pairs in UFCallTerm order, for printing.
+    std::vector<const UFC2VarMap::value_type*> sortedEntries() const;
+
+    UFC2VarMap mUFC2VarParam;
+    //! UFCs keyed by the symbol of their VarTerm.
+    std::unordered_map<std::string,UFCallTerm> mVarParam2UFC;
 };
 
 }
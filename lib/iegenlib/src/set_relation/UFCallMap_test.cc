@@ -82,3 +82,56 @@ TEST(UFCallMapTest, UFCallMap) {
     delete r_ufcall;
     delete symCons;
 }
+
+
+#pragma mark UFCallMapLookup
+// UFCallMap finds calls whatever their coefficient, and maps symbols back
+TEST(UFCallMapTest, UFCallMapLookup) {
+
+    iegenlib::UFCallMap map;
+
+    // col(idx(__tv0 + 1) - 2)
+    UFCallTerm *inner = new UFCallTerm("idx", 1);
+    Exp *innerArg = new Exp();
+    innerArg->addTerm(new TupleVarTerm(0));
+    innerArg->addTerm(new Term(1));
+    inner->setParamExp(0, innerArg);
+    UFCallTerm *outer = new UFCallTerm(3, "col", 1);
+    Exp *outerArg = new Exp();
+    outerArg->addTerm(inner);
+    outerArg->addTerm(new Term(-2));
+    outer->setParamExp(0, outerArg);
+
+    VarTerm vt = map.insert(outer);
+    EXPECT_EQ("col_idx___tv0P1_M2_", vt.symbol());
+    EXPECT_EQ(1, vt.coefficient());
+
+    UFCallTerm *neg = new UFCallTerm(*outer);
+    neg->setCoefficient(-5);
+    VarTerm *found = map.find(neg);
+    EXPECT_EQ(vt.symbol(), found->symbol());
+    EXPECT_EQ(outer->factorHash(), neg->factorHash());
+    delete found;
+
+    UFCallTerm *back = map.find(&vt);
+    ASSERT_TRUE(back != NULL);
+    EXPECT_EQ("col(idx(__tv0 + 1) - 2)", back->toString());
+    delete back;
+
+    // find inserts calls it does not know yet
+    UFCallTerm *other = new UFCallTerm("idx", 1);
+    Exp *otherArg = new Exp();
+    otherArg->addTerm(new TupleVarTerm(2));
+    other->setParamExp(0, otherArg);
+    found = map.find(other);
+    EXPECT_EQ("idx___tv2_", found->symbol());
+    delete found;
+    EXPECT_EQ("col_idx___tv0P1_M2_, idx___tv2_", map.varTermStrList());
+
+    VarTerm unknown(1, "row___tv1_");
+    EXPECT_TRUE(map.find(&unknown) == NULL);
+
+    delete outer;
+    delete neg;
+    delete other;
+}
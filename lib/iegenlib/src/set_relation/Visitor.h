@@ -29,6 +29,11 @@ class Visitor {
   public:
     Visitor() {}
     virtual ~Visitor() {}
+
+    //! Return false when the visit only reads the terms it is given.
+    //! UFCallTerm arguments are shared between copies, and a call
+    //! privatizes them before handing them to a visitor that may change them.
+    virtual bool mutatesTerms() const { return true; }
   
     // Classes in expression.h
     virtual void preVisitTerm(iegenlib::Term * t) {}
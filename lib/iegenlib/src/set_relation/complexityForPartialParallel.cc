@@ -17,6 +17,7 @@
 #include "Visitor.h"
 #include <stack>
 #include <map>
+#include <algorithm>
 #include <assert.h>
 
 namespace iegenlib{
@@ -73,6 +74,7 @@ class VisitorCalculateComplexity : public Visitor {
         nestedness = 0;
     }
     virtual ~VisitorCalculateComplexity(){}
+    bool mutatesTerms() const { return false; }
     void postVisitUFCallTerm(UFCallTerm * t){
       if( nestedness ) return;
       if( ufcUB ){
@@ -281,4 +283,224 @@ std::string SparseConstraints::
   return result;
 }
 
+
+/*****************************************************************************/
+#pragma mark -
+/*************** CostModel *****************************/
+
+// Returns the top level term of exp for tuple variable loc, or NULL.
+static TupleVarTerm* tupleVarTermAt(const Exp* exp, int loc){
+  std::list<Term*> terms = exp->getTermList();
+  for (std::list<Term*>::iterator it = terms.begin(); it != terms.end(); it++){
+    TupleVarTerm* tv = dynamic_cast<TupleVarTerm*>(*it);
+    if( tv && tv->tvloc() == loc ){ return tv; }
+  }
+  return NULL;
+}
+
+// Largest location of a tuple variable used in exp, UF arguments
+// included, ignoring the term skip.  Returns -1 if there is none.
+static int maxTupleVar(const Exp* exp, const Term* skip = NULL){
+  int result = -1;
+  std::list<Term*> terms = exp->getTermList();
+  for (std::list<Term*>::iterator it = terms.begin(); it != terms.end(); it++){
+    if( *it == skip ){ continue; }
+    TupleVarTerm* tv = dynamic_cast<TupleVarTerm*>(*it);
+    const UFCallTerm* ufc = dynamic_cast<const UFCallTerm*>(*it);
+    if( tv ){
+      result = std::max(result, tv->tvloc());
+    } else if( ufc ){
+      for (unsigned int i = 0; i < ufc->numArgs(); i++){
+        result = std::max(result, maxTupleVar(ufc->getParamExp(i)));
+      }
+    }
+  }
+  return result;
+}
+
+// Gathers the distinct UF calls in exp, nested ones included.
+static void gatherUFCalls(const Exp* exp, 
+                          std::map<std::string, const UFCallTerm*>& calls){
+  std::list<Term*> terms = exp->getTermList();
+  for (std::list<Term*>::iterator it = terms.begin(); it != terms.end(); it++){
+    const UFCallTerm* ufc = dynamic_cast<const UFCallTerm*>(*it);
+    if( !ufc ){ continue; }
+    UFCallTerm factor(*ufc);
+    factor.setCoefficient(1);
+    calls.insert(std::make_pair(factor.toString(), ufc));
+    for (unsigned int i = 0; i < ufc->numArgs(); i++){
+      gatherUFCalls(ufc->getParamExp(i), calls);
+    }
+  }
+}
+
+void CostModel::setSymbolic(const std::string& name, double value){
+  mSymbolics[name] = value;
+}
+
+void CostModel::setUF(const std::string& name, double entries, double range,
+                      double bytesPerEntry){
+  UFSize& size = mUFs[name];
+  size.entries = entries;
+  size.range = range;
+  size.bytes = bytesPerEntry;
+}
+
+// Size of a UF given with setUF, or else from its domain and range in the
+// current environment.  Unknown UFs get one entry and one value.
+CostModel::UFSize CostModel::ufSize(const std::string& name) const{
+  std::map<std::string, UFSize>::const_iterator it = mUFs.find(name);
+  if( it != mUFs.end() ){ return it->second; }
+
+  UFSize size;
+  size.entries = 1;
+  size.range = 1;
+  size.bytes = sizeof(int);
+  Set* domain = Context::current().env().funcDomain(name);
+  Set* range = Context::current().env().funcRange(name);
+  if( domain ){ size.entries = std::max(estimate(domain).iterations, 1.0); }
+  if( range ){ size.range = estimate(range).iterations; }
+  delete domain;
+  delete range;
+  return size;
+}
+
+// Average value of exp, without the term skip, given the mean values of
+// the tuple variables.
+double CostModel::value(const Exp* exp, const std::vector<double>& means,
+                        const Term* skip) const{
+  double result = 0;
+  std::list<Term*> terms = exp->getTermList();
+  for (std::list<Term*>::iterator it = terms.begin(); it != terms.end(); it++){
+    Term* term = *it;
+    if( term == skip ){ continue; }
+    TupleVarTerm* tv = dynamic_cast<TupleVarTerm*>(term);
+    const VarTerm* var = dynamic_cast<const VarTerm*>(term);
+    const UFCallTerm* ufc = dynamic_cast<const UFCallTerm*>(term);
+    if( tv ){
+      if( tv->tvloc() < (int)means.size() ){
+        result += term->coefficient() * means[tv->tvloc()];
+      }
+    } else if( var ){
+      std::map<std::string, double>::const_iterator sym =
+          mSymbolics.find(var->symbol());
+      if( sym == mSymbolics.end() ){
+        throw assert_exception("CostModel: no value for symbolic constant "
+                               + var->symbol());
+      }
+      result += term->coefficient() * sym->second;
+    } else if( ufc ){
+      // A UF maps its domain linearly onto its range
+      UFSize size = ufSize(ufc->name());
+      double ufValue = size.range / 2;
+      if( ufc->numArgs() == 1 ){
+        ufValue = value(ufc->getParamExp(0), means) * size.range / size.entries;
+      }
+      result += term->coefficient() * ufValue;
+    } else if( term->isConst() ){
+      result += term->coefficient();
+    }
+  }
+  return result;
+}
+
+CostEstimate CostModel::estimate(const Conjunction* conj) const{
+  CostEstimate est;
+  TupleDecl tdecl = conj->getTupleDecl();
+  int arity = conj->arity();
+  std::vector<double> means(arity, 0.0);
+  est.tripCounts.assign(arity, 1.0);
+
+  for (int t = 0; t < arity; t++){
+    if( tdecl.elemIsConst(t) ){
+      means[t] = tdecl.elemConstVal(t);
+      continue;
+    }
+
+    // An equality that gives t from outer tuple variables needs no loop
+    bool defined = false;
+    for (std::vector<Exp*>::const_iterator it = conj->equalities().begin();
+         it != conj->equalities().end() && !defined; it++){
+      TupleVarTerm* tv = tupleVarTermAt(*it, t);
+      if( tv && std::abs(tv->coefficient()) == 1 && maxTupleVar(*it, tv) < t ){
+        means[t] = -value(*it, means, tv) / tv->coefficient();
+        defined = true;
+      }
+    }
+    if( defined ){ continue; }
+
+    // Otherwise loop from the tightest lower to the tightest upper bound
+    bool hasLower = false, hasUpper = false;
+    double lower = 0, upper = 0;
+    for (std::vector<Exp*>::const_iterator it = conj->inequalities().begin();
+         it != conj->inequalities().end(); it++){
+      TupleVarTerm* tv = tupleVarTermAt(*it, t);
+      if( !tv || maxTupleVar(*it, tv) >= t ){ continue; }
+      double bound = -value(*it, means, tv) / tv->coefficient();
+      if( tv->coefficient() > 0 ){
+        lower = hasLower ? std::max(lower, bound) : bound;
+        hasLower = true;
+      } else {
+        upper = hasUpper ? std::min(upper, bound) : bound;
+        hasUpper = true;
+      }
+    }
+    if( hasLower && hasUpper ){
+      est.tripCounts[t] = std::max(upper - lower + 1, 0.0);
+      means[t] = lower + std::max(upper - lower, 0.0) / 2;
+    } else {
+      est.bounded = false;
+      means[t] = hasLower ? lower : upper;
+    }
+  }
+
+  est.iterations = 1;
+  for (int t = 0; t < arity; t++){ est.iterations *= est.tripCounts[t]; }
+
+  // Each distinct UF call is read once per iteration of the innermost
+  // loop its arguments depend on
+  std::map<std::string, const UFCallTerm*> calls;
+  for (std::vector<Exp*>::const_iterator it = conj->equalities().begin();
+       it != conj->equalities().end(); it++){
+    gatherUFCalls(*it, calls);
+  }
+  for (std::vector<Exp*>::const_iterator it = conj->inequalities().begin();
+       it != conj->inequalities().end(); it++){
+    gatherUFCalls(*it, calls);
+  }
+  for (std::map<std::string, const UFCallTerm*>::iterator it = calls.begin();
+       it != calls.end(); it++){
+    const UFCallTerm* ufc = it->second;
+    int level = -1;
+    for (unsigned int i = 0; i < ufc->numArgs(); i++){
+      level = std::max(level, maxTupleVar(ufc->getParamExp(i)));
+    }
+    double reads = 1;
+    for (int t = 0; t <= level && t < arity; t++){ reads *= est.tripCounts[t]; }
+    est.ufReads += reads;
+    est.bytes += reads * ufSize(ufc->name()).bytes;
+  }
+
+  return est;
+}
+
+CostEstimate CostModel::estimate(SparseConstraints* sc) const{
+  CostEstimate est;
+  for (std::list<Conjunction*>::const_iterator it = sc->conjunctionBegin();
+       it != sc->conjunctionEnd(); it++){
+    CostEstimate conjEst = estimate(*it);
+    est.iterations += conjEst.iterations;
+    est.ufReads += conjEst.ufReads;
+    est.bytes += conjEst.bytes;
+    est.bounded = est.bounded && conjEst.bounded;
+    if( est.tripCounts.size() < conjEst.tripCounts.size() ){
+      est.tripCounts.resize(conjEst.tripCounts.size(), 0.0);
+    }
+    for (size_t t = 0; t < conjEst.tripCounts.size(); t++){
+      est.tripCounts[t] = std::max(est.tripCounts[t], conjEst.tripCounts[t]);
+    }
+  }
+  return est;
+}
+
 }//end namespace iegenlib
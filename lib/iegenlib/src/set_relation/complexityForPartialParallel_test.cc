@@ -176,3 +176,66 @@ TEST(complexityTest, complexityForPartialParallelTEST){
 
 }
 
+
+#pragma mark costModelTEST
+TEST(complexityTest, costModelTEST){
+
+  iegenlib::setCurrEnv();
+  iegenlib::appendCurrEnv("col",
+      new Set("{[k]:0<=k &&k<nnz}"), 
+      new Set("{[j]:0<=j &&j<n}"), false, iegenlib::Monotonic_NONE);
+  iegenlib::appendCurrEnv("rowptr",
+      new Set("{[i]:0<=i &&i<n}"), 
+      new Set("{[k]:0<=k &&k<nnz}"), false, iegenlib::Monotonic_Increasing);
+
+  iegenlib::CostModel model;
+  model.setSymbolic("n", 1000);
+  model.setSymbolic("nnz", 10000);
+
+  // CSR traversal: rowptr(i+1) - rowptr(i) averages nnz/n
+  Set *csr = new Set("{[i,k]: 0 <= i && i < n"
+                     " && rowptr(i) <= k && k < rowptr(i+1)}");
+  iegenlib::CostEstimate est = model.estimate(csr);
+  EXPECT_TRUE(est.bounded);
+  ASSERT_EQ(2u, est.tripCounts.size());
+  EXPECT_DOUBLE_EQ(1000, est.tripCounts[0]);
+  EXPECT_DOUBLE_EQ(10, est.tripCounts[1]);
+  EXPECT_DOUBLE_EQ(10000, est.iterations);
+  // rowptr(i) and rowptr(i+1) once per row
+  EXPECT_DOUBLE_EQ(2000, est.ufReads);
+  EXPECT_DOUBLE_EQ(2000 * sizeof(int), est.bytes);
+
+  // j is computed from col(k), which is read once per nonzero
+  Set *spmv = new Set("{[i,k,j]: 0 <= i && i < n && j = col(k)"
+                      " && rowptr(i) <= k && k < rowptr(i+1)}");
+  est = model.estimate(spmv);
+  EXPECT_DOUBLE_EQ(1, est.tripCounts[2]);
+  EXPECT_DOUBLE_EQ(10000, est.iterations);
+  EXPECT_DOUBLE_EQ(12000, est.ufReads);
+
+  // Sizes given explicitly take precedence over the environment
+  model.setUF("col", 10000, 1000, 8);
+  est = model.estimate(spmv);
+  EXPECT_DOUBLE_EQ(2000 * sizeof(int) + 10000 * 8, est.bytes);
+
+  // A dense loop over the same rows and columns costs n^2
+  Relation *dense = new Relation("{[i]->[j]: 0 <= i && i < n"
+                                 " && 0 <= j && j < n}");
+  est = model.estimate(dense);
+  EXPECT_DOUBLE_EQ(1000000, est.iterations);
+  EXPECT_DOUBLE_EQ(0, est.ufReads);
+
+  // Unbounded tuple variables are reported
+  Set *open = new Set("{[i]: 0 <= i}");
+  EXPECT_FALSE(model.estimate(open).bounded);
+
+  // Symbolic constants need a value
+  Set *unknown = new Set("{[i]: 0 <= i && i < m}");
+  EXPECT_THROW(model.estimate(unknown), iegenlib::assert_exception);
+
+  delete csr;
+  delete spmv;
+  delete dense;
+  delete open;
+  delete unknown;
+}
@@ -205,3 +205,102 @@ TEST(detectUnsatOrFindEqualitiesTest, detectUnsatOrFindEqualitiesTEST){
   }
 }
 
+
+#pragma mark satCacheTEST
+TEST(detectUnsatOrFindEqualitiesTest, satCacheTEST){
+
+  iegenlib::setCurrEnv();
+  iegenlib::appendCurrEnv("rowptr",
+        new Set("{[i]:0<=i &&i<m}"), 
+        new Set("{[j]:0<=j &&j<nnz}"), false, iegenlib::Monotonic_Increasing);
+  iegenlib::SatCache& cache = currentEnv.satCache();
+  unsigned hits = cache.hits(), misses = cache.misses();
+
+  // Unsat, since rowptr(i) < rowptr(i+1) by monotonicity
+  Set *unsat = new Set("{[i,k]: 0 <= i && i < m"
+                       " && rowptr(i+1) <= k && k < rowptr(i)}");
+  EXPECT_EQ(NULL, unsat->detectUnsatOrFindEqualities());
+  EXPECT_EQ(misses + 1, cache.misses());
+  EXPECT_EQ(NULL, unsat->detectUnsatOrFindEqualities());
+  EXPECT_EQ(hits + 1, cache.hits());
+
+  // Cached results are copies of what was computed
+  Set *maySat = new Set("{[i,k]: 0 <= i && i < m"
+                        " && rowptr(i) <= k && k < rowptr(i+1)}");
+  Set *first = maySat->detectUnsatOrFindEqualities();
+  Set *second = maySat->detectUnsatOrFindEqualities();
+  ASSERT_TRUE(first != NULL);
+  ASSERT_TRUE(second != NULL);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(first->prettyPrintString(), second->prettyPrintString());
+  EXPECT_EQ(hits + 2, cache.hits());
+
+  // Relations get the same treatment
+  Relation *rel = new Relation("{[i]->[k]: 0 <= i && i < m"
+                               " && rowptr(i+1) <= k && k < rowptr(i)}");
+  EXPECT_EQ(NULL, rel->detectUnsatOrFindEqualities());
+  EXPECT_EQ(NULL, rel->detectUnsatOrFindEqualities());
+  EXPECT_EQ(hits + 3, cache.hits());
+
+  // Changing the environment drops cached results
+  currentEnv.addUniQuantRule( new UniQuantRule(std::string("TheOthers"),
+            std::string("[e1,e2]"), std::string("e1 = e2"),
+            std::string("rowptr(e1) = rowptr(e2)")) );
+  misses = cache.misses();
+  EXPECT_EQ(NULL, unsat->detectUnsatOrFindEqualities());
+  EXPECT_EQ(misses + 1, cache.misses());
+
+  delete unsat;
+  delete maySat;
+  delete first;
+  delete second;
+  delete rel;
+}
+
+#pragma mark batchDetectUnsatOrFindEqualitiesTEST
+TEST(detectUnsatOrFindEqualitiesTest, batchDetectUnsatOrFindEqualitiesTEST){
+
+  iegenlib::setCurrEnv();
+  iegenlib::appendCurrEnv("rowptr",
+        new Set("{[i]:0<=i &&i<m}"), 
+        new Set("{[j]:0<=j &&j<nnz}"), false, iegenlib::Monotonic_Increasing);
+  iegenlib::appendCurrEnv("colidx",
+        new Set("{[i]:0<=i &&i<nnz}"), 
+        new Set("{[j]:0<=j &&j<m}"), false, iegenlib::Monotonic_NONE);
+
+  std::vector<Relation*> rels;
+  rels.push_back(new Relation("{[i,k]->[ip,kp]: i < ip && 0 <= i && ip < m"
+                     " && rowptr(ip) <= k && k < rowptr(ip+1)"
+                     " && rowptr(i) <= kp && kp < rowptr(i+1) && k = kp}"));
+  rels.push_back(new Relation("{[i]->[k]: 0 <= i && i < m"
+                              " && rowptr(i+1) <= k && k < rowptr(i)}"));
+  rels.push_back(new Relation("{[i,k]->[ip,kp]: i < ip && 0 <= i && ip < m"
+                     " && rowptr(i) <= k && k < rowptr(i+1)"
+                     " && rowptr(ip) <= kp && kp < rowptr(ip+1)"
+                     " && colidx(k) = colidx(kp)}"));
+  // Duplicates of the first two
+  rels.push_back(new Relation(*rels[0]));
+  rels.push_back(new Relation(*rels[1]));
+
+  std::vector<Relation*> results =
+      iegenlib::batchDetectUnsatOrFindEqualities(rels, NULL, 3);
+  ASSERT_EQ(rels.size(), results.size());
+  for (size_t i = 0; i < rels.size(); i++) {
+    Relation *expected = rels[i]->detectUnsatOrFindEqualities();
+    if (expected == NULL || results[i] == NULL) {
+      EXPECT_EQ(expected, results[i]) << "relation " << i;
+    } else {
+      EXPECT_EQ(expected->prettyPrintString(), 
+                results[i]->prettyPrintString()) << "relation " << i;
+    }
+    delete expected;
+  }
+  EXPECT_TRUE(results[0] == NULL);
+  EXPECT_TRUE(results[1] == NULL);
+  EXPECT_TRUE(results[2] != NULL);
+
+  for (size_t i = 0; i < rels.size(); i++) {
+    delete rels[i];
+    delete results[i];
+  }
+}
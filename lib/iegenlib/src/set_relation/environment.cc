@@ -17,21 +17,75 @@
 
 #include "environment.h"
 #include "set_relation.h"
+#include "UFCallMap.h"
 
 namespace iegenlib{
 
 Environment currentEnv;
 
+// Context selected by a Context::Scope on this thread, NULL for the default.
+static thread_local Context* threadContext = NULL;
+
+namespace {
+// Owns the isl context the default Context hands out on one thread.
+struct IslCtxHolder {
+    isl_ctx *ctx;
+    IslCtxHolder() : ctx(isl_ctx_alloc()) {}
+    ~IslCtxHolder() { isl_ctx_free(ctx); }
+};
+}
+
+Context::Context() : mEnv(new Environment()), mOwnsEnv(true), mIslCtx(NULL) {}
+
+Context::Context(const Environment& env) : mEnv(new Environment(env)),
+                                           mOwnsEnv(true), mIslCtx(NULL) {}
+
+Context::Context(Environment* env) : mEnv(env), mOwnsEnv(false),
+                                     mIslCtx(NULL) {}
+
+Context::~Context() {
+    if (mOwnsEnv) { delete mEnv; }
+    if (mIslCtx) { isl_ctx_free(mIslCtx); }
+}
+
+//! isl contexts are not thread safe, so the default context, which all
+//! threads without a Scope share, keeps one per thread.
+isl_ctx* Context::isl() {
+    if (!mOwnsEnv) {
+        static thread_local IslCtxHolder holder;
+        return holder.ctx;
+    }
+    if (mIslCtx == NULL) { mIslCtx = isl_ctx_alloc(); }
+    return mIslCtx;
+}
+
+Context& Context::current() {
+    return threadContext ? *threadContext : global();
+}
+
+Context& Context::global() {
+    static Context instance(&currentEnv);
+    return instance;
+}
+
+Context::Scope::Scope(Context& ctx) : mPrevious(threadContext) {
+    threadContext = &ctx;
+}
+
+Context::Scope::~Scope() {
+    threadContext = mPrevious;
+}
+
 //! Resets the current environment to empty.
 void setCurrEnv() {
-    currentEnv.reset();
+    Context::current().env().reset();
 }
 
 //! Resets the current environment to empty and then accepts new UninterpFunc
 //! declaration into new environment.
 void setCurrEnv(std::string funcName, Set* domain, Set* range,
                 bool bijective, MonotonicType monoType) {
-    currentEnv.reset();
+    Context::current().env().reset();
     appendCurrEnv(funcName, domain, range, bijective, monoType);
 }
 
@@ -57,8 +111,8 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
   UninterpFunc* ufunc = new UninterpFunc(funcName, domain, range, 
                                            bijective, monoType);
   // create new environment
-  Environment* env = new Environment(ufunc);
-  currentEnv.append(env);
+  Environment& curr = Context::current().env();
+  curr.append(new Environment(ufunc));
 
 /* Adding quantified rules for functional consistency and monotonicity */
   if( domain->getArity() == 1 && range->getArity() == 1 ){
@@ -73,7 +127,7 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
     leftSide = ( "e1 = e2" );
     rightSide = ( funcName + "(e1) = " + funcName + "(e2)" );
     uqRule = new UniQuantRule(type, tupleDecl, leftSide, rightSide);
-    currentEnv.addUniQuantRule( uqRule );
+    curr.addUniQuantRule( uqRule );
 */
     // 3.1.2 Adding Monotonicity rules based on:
     //   If UF monotonically strictly increasing then:
@@ -85,7 +139,7 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
       leftSide = ( "e1 < e2" );
       rightSide = ( funcName + "(e1) < " + funcName + "(e2)" );
       uqRule = new UniQuantRule(type, tupleDecl, leftSide, rightSide);
-      currentEnv.addUniQuantRule( uqRule );
+      curr.addUniQuantRule( uqRule );
 /*
       // forall e1, e2 : UF(e1) = UF(e2) => e1 = e2
       type = ("Monotonicity");
@@ -93,7 +147,7 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
       leftSide = ( funcName + "(e1) = " + funcName + "(e2)" );
       rightSide = ( "e1 = e2" );
       uqRule = new UniQuantRule(type, tupleDecl, leftSide, rightSide);
-      currentEnv.addUniQuantRule( uqRule );
+      curr.addUniQuantRule( uqRule );
 */
       // forall e1, e2 : UF(e1) < UF(e2) => e1 < e2
       type = ("Monotonicity");
@@ -101,7 +155,7 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
       leftSide = ( funcName + "(e1) < " + funcName + "(e2)" );
       rightSide = ( "e1 < e2" );
       uqRule = new UniQuantRule(type, tupleDecl, leftSide, rightSide);
-      currentEnv.addUniQuantRule( uqRule );
+      curr.addUniQuantRule( uqRule );
 /*
       // forall e1, e2 : UF(e1) <= UF(e2) => e1 <= e2
       type = ("Monotonicity");
@@ -109,7 +163,7 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
       leftSide = ( funcName + "(e1) <= " + funcName + "(e2)" );
       rightSide = ( "e1 <= e2" );
       uqRule = new UniQuantRule(type, tupleDecl, leftSide, rightSide);
-      currentEnv.addUniQuantRule( uqRule );
+      curr.addUniQuantRule( uqRule );
 */
     //   If UF monotonically increasing then:
     } else  if ( Monotonic_Nondecreasing == monoType ){
@@ -120,7 +174,7 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
       leftSide = ( "e1 < e2" );
       rightSide = ( funcName + "(e1) <= " + funcName + "(e2)" );
       uqRule = new UniQuantRule(type, tupleDecl, leftSide, rightSide);
-      currentEnv.addUniQuantRule( uqRule );
+      curr.addUniQuantRule( uqRule );
   
     // If UF monotonically strictly decreasing then
     } else if ( Monotonic_Decreasing == monoType ){
@@ -131,7 +185,7 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
       leftSide = ( "e1 < e2" );
       rightSide = ( funcName + "(e1) > " + funcName + "(e2)" );
       uqRule = new UniQuantRule(type, tupleDecl, leftSide, rightSide);
-      currentEnv.addUniQuantRule( uqRule );
+      curr.addUniQuantRule( uqRule );
 /*
       // forall e1, e2 : UF(e1) = UF(e2) => e1 = e2
       type = ("Monotonicity");
@@ -139,7 +193,7 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
       leftSide = ( funcName + "(e1) = " + funcName + "(e2)" );
       rightSide = ( "e1 = e2" ); 
       uqRule = new UniQuantRule(type, tupleDecl, leftSide, rightSide);
-      currentEnv.addUniQuantRule( uqRule );
+      curr.addUniQuantRule( uqRule );
 */
       // forall e1, e2 : UF(e1) < UF(e2) => e1 > e2
       type = ("Monotonicity");
@@ -147,7 +201,7 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
       leftSide = ( funcName + "(e1) < " + funcName + "(e2)" );
       rightSide = ( "e1 > e2" );
       uqRule = new UniQuantRule(type, tupleDecl, leftSide, rightSide);
-      currentEnv.addUniQuantRule( uqRule );
+      curr.addUniQuantRule( uqRule );
 /*
       // forall e1, e2 : UF(e1) <= UF(e2) => e1 >= e2
       type = ("Monotonicity");
@@ -155,7 +209,7 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
       leftSide = ( funcName + "(e1) <= " + funcName + "(e2)" );
       rightSide = ( "e1 >= e2" );
       uqRule = new UniQuantRule(type, tupleDecl, leftSide, rightSide);
-      currentEnv.addUniQuantRule( uqRule );
+      curr.addUniQuantRule( uqRule );
 */
       // If UF monotonically decreasing then:
     } else  if ( Monotonic_Nonincreasing == monoType ){
@@ -166,7 +220,7 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
       leftSide = ( "e1 < e2" );
       rightSide = ( funcName + "(e1) >= " + funcName + "(e2)" );
       uqRule = new UniQuantRule(type, tupleDecl, leftSide, rightSide);
-      currentEnv.addUniQuantRule( uqRule );
+      curr.addUniQuantRule( uqRule );
     }
   }
 /////////////////////////////////////////////////////////////////
@@ -175,18 +229,18 @@ void appendCurrEnv(std::string funcName, Set* domain, Set* range,
 void appendCurrEnv(std::string str) {
     // parse the environment
     Environment* env = parser::parse_env(str);
-    currentEnv.append(env);
+    Context::current().env().append(env);
 }
 */
 
 std::string queryInverseCurrEnv(const std::string funcName){
-    return currentEnv.funcInverse(funcName);
+    return Context::current().env().funcInverse(funcName);
 }
 
 //! search this environment for a function domain
 //! returned Set is a clone
 Set* queryDomainCurrEnv(const std::string funcName) {
-    Set* retval = currentEnv.funcDomain(funcName);
+    Set* retval = Context::current().env().funcDomain(funcName);
     if (retval==NULL) {
         std::stringstream ss;
         ss << "queryDomainCurrEnv: the function " << funcName;
@@ -199,7 +253,7 @@ Set* queryDomainCurrEnv(const std::string funcName) {
 //! search this environment for a function range
 //! returned Set is a clone
 Set* queryRangeCurrEnv(const std::string funcName) {
-    Set* retval = currentEnv.funcRange(funcName);
+    Set* retval = Context::current().env().funcRange(funcName);
     if (retval==NULL) {
         std::stringstream ss;
         ss << "queryRangeCurrEnv: the function " << funcName;
@@ -211,7 +265,7 @@ Set* queryRangeCurrEnv(const std::string funcName) {
 
 //! search this environment for a function monotonicity type
 MonotonicType queryMonoTypeEnv(const std::string funcName) {
-    return currentEnv.funcMonoType(funcName);
+    return Context::current().env().funcMonoType(funcName);
 }
 
 
@@ -227,21 +281,124 @@ unsigned int queryRangeArityCurrEnv(const std::string funcName) {
 
 //! add an universially quantified Rule to environment
 void addUniQuantRule(UniQuantRule *uqRule){
-    currentEnv.addUniQuantRule(uqRule);
+    Context::current().env().addUniQuantRule(uqRule);
 }
 
 // Return the number of available universially quantified Rules
 int queryNoUniQuantRules(){
-  return currentEnv.getNoUniQuantRules();
+  return Context::current().env().getNoUniQuantRules();
 }
 
 // Returns the universially quantified Rule No. idx stored in the enviroment
 //! The environment still owns returned object (user should not delete it)
 UniQuantRule* queryUniQuantRuleEnv(int idx){
-  return currentEnv.getUniQuantRule(idx);
+  return Context::current().env().getUniQuantRule(idx);
+}
+
+SatCache::~SatCache() {
+    clear();
+}
+
+bool SatCache::findSet(const std::string& key, Set*& result) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::map<std::string, Set*>::iterator it = mSets.find(key);
+    if (it == mSets.end()) {
+        mMisses++;
+        return false;
+    }
+    mHits++;
+    result = it->second ? new Set(*(it->second)) : NULL;
+    return true;
+}
+
+bool SatCache::findRelation(const std::string& key, Relation*& result) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::map<std::string, Relation*>::iterator it = mRelations.find(key);
+    if (it == mRelations.end()) {
+        mMisses++;
+        return false;
+    }
+    mHits++;
+    result = it->second ? new Relation(*(it->second)) : NULL;
+    return true;
+}
+
+void SatCache::addSet(const std::string& key, const Set* result) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mSets.find(key) != mSets.end()) { return; }
+    if (mSets.size() >= maxEntries) {
+        for (std::map<std::string, Set*>::iterator it = mSets.begin();
+                it != mSets.end(); it++) {
+            delete it->second;
+        }
+        mSets.clear();
+    }
+    mSets[key] = result ? new Set(*result) : NULL;
+}
+
+void SatCache::addRelation(const std::string& key, const Relation* result) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mRelations.find(key) != mRelations.end()) { return; }
+    if (mRelations.size() >= maxEntries) {
+        for (std::map<std::string, Relation*>::iterator it =
+                mRelations.begin(); it != mRelations.end(); it++) {
+            delete it->second;
+        }
+        mRelations.clear();
+    }
+    mRelations[key] = result ? new Relation(*result) : NULL;
+}
+
+bool SatCache::findInstantiation(const std::string& key,
+                                 std::pair<std::string,std::string>& inst,
+                                 UFCallMap* ufcmap) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::map<std::string, Instantiation>::iterator it =
+        mInstantiations.find(key);
+    if (it == mInstantiations.end()) { return false; }
+    inst = it->second.inst;
+    ufcmap->merge(*(it->second.ufcalls));
+    return true;
+}
+
+void SatCache::addInstantiation(const std::string& key,
+                                const std::pair<std::string,std::string>& inst,
+                                const UFCallMap& ufcalls) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mInstantiations.find(key) != mInstantiations.end()) { return; }
+    if (mInstantiations.size() >= maxEntries) {
+        for (std::map<std::string, Instantiation>::iterator it =
+                mInstantiations.begin(); it != mInstantiations.end(); it++) {
+            delete it->second.ufcalls;
+        }
+        mInstantiations.clear();
+    }
+    Instantiation& entry = mInstantiations[key];
+    entry.inst = inst;
+    entry.ufcalls = new UFCallMap(ufcalls);
+}
+
+void SatCache::clear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (std::map<std::string, Set*>::iterator it = mSets.begin();
+            it != mSets.end(); it++) {
+        delete it->second;
+    }
+    mSets.clear();
+    for (std::map<std::string, Relation*>::iterator it = mRelations.begin();
+            it != mRelations.end(); it++) {
+        delete it->second;
+    }
+    mRelations.clear();
+    for (std::map<std::string, Instantiation>::iterator it =
+            mInstantiations.begin(); it != mInstantiations.end(); it++) {
+        delete it->second.ufcalls;
+    }
+    mInstantiations.clear();
 }
 
 void Environment::append(Environment *other){
+    mSatCache.clear();
     mInverseMap.insert(other->mInverseMap.begin(),other->mInverseMap.end());
     // Need to do a deep copy of the UninterpFunc objects
     for (std::map<std::string, UninterpFunc*>::iterator     
@@ -287,11 +444,24 @@ Environment::Environment(UninterpFunc* symfunc){
     }
 }
 
-//! Assignment operator for Environment.
+//! Assignment operator for Environment.  Performs a deep copy of the
+//! functions and rules, the SatCache is not copied.
 Environment& Environment::operator=(const Environment& other) {
-    for (std::map<std::string, std::string>::const_iterator     
-            it=other.mInverseMap.begin(); it!=other.mInverseMap.end(); it++) {
-        mInverseMap[it->first] = it->second;
+    if (this == &other) { return *this; }
+    reset();
+    for (size_t i = 0; i < uniQuantRules.size(); i++) {
+        delete uniQuantRules[i];
+    }
+    uniQuantRules.clear();
+
+    mInverseMap = other.mInverseMap;
+    for (std::map<std::string, UninterpFunc*>::const_iterator     
+            it=other.mUninterpFuncMap.begin(); 
+            it!=other.mUninterpFuncMap.end(); it++) {
+        mUninterpFuncMap[it->first] = new UninterpFunc(*(it->second));
+    }
+    for (size_t i = 0; i < other.uniQuantRules.size(); i++) {
+        uniQuantRules.push_back(new UniQuantRule(*(other.uniQuantRules[i])));
     }
     return *this;
 }
@@ -305,10 +475,16 @@ Environment::~Environment() {
     mUninterpFuncMap.clear();
     // delete all UninterpFunc declarations
     mInverseMap.clear();
+    // the environment owns its universially quantified rules
+    for (size_t i = 0; i < uniQuantRules.size(); i++) {
+        delete uniQuantRules[i];
+    }
+    uniQuantRules.clear();
 }
 
 // Reset the Environment to empty
 void Environment::reset(){
+    mSatCache.clear();
     // delete all UninterpFunc declarations
     for (std::map<std::string, UninterpFunc*>::iterator     
             it=mUninterpFuncMap.begin(); it!=mUninterpFuncMap.end(); it++) {
@@ -321,6 +497,7 @@ void Environment::reset(){
 
 // Define the inverse for the given function.
 void Environment::setInverse(std::string funcName, std::string inverseName) {
+    mSatCache.clear();
     mInverseMap[funcName] = inverseName;
     mInverseMap[inverseName] = funcName;
 }
@@ -378,6 +555,7 @@ std::string Environment::toString() const {
 
 //! Add an universially quantified Rule to the environment
 void Environment::addUniQuantRule(UniQuantRule *uqRule){
+    mSatCache.clear();
     uniQuantRules.push_back (uqRule);
 }
 
@@ -413,6 +591,10 @@ UniQuantRule::UniQuantRule(string type, string tupleDecl,
     else                               mUniQuantRuleType = TheOthers;
 }
 
+UniQuantRule::UniQuantRule(UniQuantRuleType type, Set* leftSide,
+                           Set* rightSide)
+    : mUniQuantRuleType(type), mLeftSide(leftSide), mRightSide(rightSide) {}
+
 //! Copy constructor.  Performs a deep copy.
 UniQuantRule::UniQuantRule(const UniQuantRule& other) {
 
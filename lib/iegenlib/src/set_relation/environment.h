@@ -26,14 +26,20 @@
 #include <vector>
 #include <sstream>
 #include <iostream>
+#include <mutex>
+#include <utility>
 
 #include "UninterpFunc.h"
 #include <util/util.h>
 
+struct isl_ctx;
+
 namespace iegenlib{
 
 class UniQuantRule;
 class Environment;
+class Relation;
+class UFCallMap;
 
 /*  FIXME: Might want to resurrect this to parse Symbolic declarations
     of uninterpreted functions.
@@ -87,6 +93,71 @@ int queryNoUniQuantRules();
 //! The environment still owns returned object (user should not delete it)
 UniQuantRule* queryUniQuantRuleEnv(int idx);
 
+/*!
+ * \class SatCache
+ *
+ * \brief Memoizes the work done by detectUnsatOrFindEqualities.
+ *
+ * Keeps the results of Set and Relation::detectUnsatOrFindEqualities keyed
+ * by the canonical string of the input, and the rule instantiations built
+ * for it, so closely related dependence relations only instantiate the
+ * rules for expressions that have not been seen before.  Every Environment
+ * owns one and empties it whenever its functions or rules change.  Each
+ * cache keeps at most maxEntries entries per kind and is emptied when it
+ * would grow past that.
+ */
+class SatCache {
+public:
+    SatCache() : mHits(0), mMisses(0) {}
+    ~SatCache();
+
+    //! Sets result to a copy of the result cached under key, which is
+    //! NULL when the input was unsatisfiable.  Returns false on a miss.
+    bool findSet(const std::string& key, Set*& result);
+    bool findRelation(const std::string& key, Relation*& result);
+
+    //! Caches a copy of result (NULL for unsatisfiable) under key.
+    void addSet(const std::string& key, const Set* result);
+    void addRelation(const std::string& key, const Relation* result);
+
+    //! Sets inst to the rule instantiation cached under key and adds the
+    //! UF calls it replaced with symbolic constants to ufcmap.
+    //! Returns false on a miss.
+    bool findInstantiation(const std::string& key,
+                           std::pair<std::string,std::string>& inst,
+                           UFCallMap* ufcmap);
+
+    //! Caches a rule instantiation and the UF calls it replaced.
+    void addInstantiation(const std::string& key,
+                          const std::pair<std::string,std::string>& inst,
+                          const UFCallMap& ufcalls);
+
+    //! Drops all cached results and instantiations.
+    void clear();
+
+    //! Number of result lookups that hit and missed, for testing.
+    unsigned hits() const { return mHits; }
+    unsigned misses() const { return mMisses; }
+
+    static const size_t maxEntries = 4096;
+
+private:
+    struct Instantiation {
+        std::pair<std::string,std::string> inst;
+        UFCallMap* ufcalls;
+    };
+
+    SatCache(const SatCache&);
+    SatCache& operator=(const SatCache&);
+
+    std::mutex mMutex;
+    std::map<std::string, Set*> mSets;
+    std::map<std::string, Relation*> mRelations;
+    std::map<std::string, Instantiation> mInstantiations;
+    unsigned mHits;
+    unsigned mMisses;
+};
+
 class Environment {
 public:
 
@@ -101,7 +172,8 @@ public:
     Environment(const Environment& other)
         { *this = other; }
     
-    //! Assignment operator for Environment.
+    //! Assignment operator for Environment, deep copies the functions,
+    //! inverses, and rules.
     Environment& operator=(const Environment& other);
     
     //! destructor
@@ -146,14 +218,89 @@ public:
     // the environment
     UniQuantRule* getUniQuantRule(int idx);
 
+    //! Results of detectUnsatOrFindEqualities under this environment.
+    SatCache& satCache() { return mSatCache; }
+
 private:
+    friend class BinaryWriter;
+    friend class BinaryReader;
+
     std::map<std::string, UninterpFunc*> mUninterpFuncMap;
     std::map<std::string, std::string> mInverseMap;
     std::vector<UniQuantRule*>  uniQuantRules;
+    SatCache mSatCache;
 };
 
+//! Environment of the default Context, see Context::global().
 extern Environment currentEnv;
 
+/*!
+ * \class Context
+ *
+ * \brief Owns the state that Set and Relation operations use implicitly:
+ * the uninterpreted function environment, its universally quantified
+ * rules, and the isl context.
+ *
+ * Every thread works in its current context, which is the default context
+ * (whose environment is currentEnv) until a Context::Scope selects another
+ * one on that thread.  The *CurrEnv functions and islCtx() all go through
+ * Context::current(), so analyses that each run in their own Context can
+ * run on different threads at the same time.  A Context itself must only
+ * be used by one thread at a time, and Sets and Relations must not be
+ * shared between threads that use different contexts.
+ */
+class Context {
+public:
+    //! Constructs a context with an empty environment.
+    Context();
+    //! Constructs a context with a copy of env, e.g. to run work on
+    //! another thread under the calling thread's environment.
+    explicit Context(const Environment& env);
+
+    //! Frees the environment, its rules, and the isl context.
+    ~Context();
+
+    //! The uninterpreted function environment of this context.
+    Environment& env() { return *mEnv; }
+
+    //! The isl context of this context, allocated on first use.
+    //! The default context gives each thread an isl context of its own.
+    isl_ctx* isl();
+
+    //! The context of the calling thread.
+    static Context& current();
+
+    //! The default context, shared by all threads without a Scope.
+    static Context& global();
+
+    /*!
+     * \class Scope
+     *
+     * \brief Makes a Context current on the calling thread for the
+     * lifetime of the Scope, then restores the previous one.
+     */
+    class Scope {
+    public:
+        explicit Scope(Context& ctx);
+        ~Scope();
+    private:
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+        Context* mPrevious;
+    };
+
+private:
+    //! Used for the default context, which does not own currentEnv.
+    explicit Context(Environment* env);
+
+    Context(const Context&);
+    Context& operator=(const Context&);
+
+    Environment* mEnv;
+    bool mOwnsEnv;
+    isl_ctx* mIslCtx;
+};
+
 // Monotonicity should always be the first and TheOthers the last type
 // This convention is used inside drivers 
 typedef enum {Monotonicity, CoMonotonicity, Triangularity, 
@@ -172,6 +319,8 @@ typedef enum {Monotonicity, CoMonotonicity, Triangularity,
 class UniQuantRule {
 public:
   UniQuantRule(string type, string tupleDecl, string leftSide, string rightSide);
+  //! Constructs a rule from already built sides, which are adopted.
+  UniQuantRule(UniQuantRuleType type, Set* leftSide, Set* rightSide);
   ~UniQuantRule();
   //! Copy constructor.
   UniQuantRule( const UniQuantRule& other );//{ *this = other; }
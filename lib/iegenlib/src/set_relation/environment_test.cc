@@ -23,7 +23,9 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <thread>
 
+using iegenlib::Context;
 using iegenlib::Environment;
 using iegenlib::UninterpFunc;
 using iegenlib::Set;
@@ -131,4 +133,61 @@ TEST_F(EnvironmentTest, EnvAppend) {
 */
 
 
+// Declares ctx_f with the given range in a Context of its own, then parses,
+// queries, and round trips a Set through isl within that context.
+static void analyzeInContext(const std::string& range, unsigned int* arity,
+                             int* rules, std::string* inverse,
+                             std::string* isl) {
+    Context ctx;
+    Context::Scope scope(ctx);
+    EXPECT_EQ(&ctx, &Context::current());
+
+    iegenlib::appendCurrEnv("ctx_f", new Set("{[i]:0<=i<n}"), new Set(range),
+                            true, iegenlib::Monotonic_Increasing);
+    *arity = iegenlib::queryRangeArityCurrEnv("ctx_f");
+    *inverse = iegenlib::queryInverseCurrEnv("ctx_f");
+    *rules = iegenlib::queryNoUniQuantRules();
+
+    Set* s = new Set("{[i,j] : 0 <= i < n && 0 <= j < ctx_f(i)}");
+    Set* t = new Set("{[i,j] : j < ctx_f(i)}");
+    Set* u = s->Intersect(t);
+    Set* affine = new Set("{[i,j] : 0 <= i < n && 0 <= j < m}");
+    Set* result = iegenlib::passSetThruISL(affine);
+    *isl = result->prettyPrintString();
+    delete affine;
+    delete result;
+    EXPECT_EQ(s->prettyPrintString(), u->prettyPrintString());
+    delete s;
+    delete t;
+    delete u;
+}
+
+// Two analyses that declare the same UF differently run concurrently, each
+// in its own Context, without seeing each other or the default context.
+TEST_F(EnvironmentTest, ContextPerThread) {
+    unsigned int arity[2] = {0, 0};
+    int rules[2] = {0, 0};
+    std::string inverse[2], isl[2];
+
+    std::thread first(analyzeInContext, "{[k]:0<=k<m}",
+                      &arity[0], &rules[0], &inverse[0], &isl[0]);
+    std::thread second(analyzeInContext, "{[k,l]:0<=k<m && 0<=l<m}",
+                       &arity[1], &rules[1], &inverse[1], &isl[1]);
+    first.join();
+    second.join();
+
+    EXPECT_EQ(1u, arity[0]);
+    EXPECT_EQ(2u, arity[1]);
+    // Monotonicity rules are only generated for scalar UFs.
+    EXPECT_EQ(2, rules[0]);
+    EXPECT_EQ(0, rules[1]);
+    EXPECT_EQ("ctx_f_inv", inverse[0]);
+    EXPECT_EQ("ctx_f_inv", inverse[1]);
+    EXPECT_EQ(isl[0], isl[1]);
+
+    EXPECT_EQ(&Context::global(), &Context::current());
+    EXPECT_EQ("", iegenlib::queryInverseCurrEnv("ctx_f"));
+}
+
+
 /******************************************/
@@ -15,6 +15,7 @@
 #include "TupleDecl.h"
 #include "set_relation.h"
 #include "Visitor.h"
+#include <algorithm>
 
 
 namespace iegenlib{
@@ -155,12 +156,10 @@ Exp* Term::collapseNestedInvertibleFunctions() const {
 UFCallTerm::UFCallTerm(int coeff, std::string funcName, unsigned int num_args,
                        int tuple_index)
 : Term(coeff), mFuncName(funcName), mNumArgs(num_args),
-  mTupleIndex(tuple_index) 
+  mTupleIndex(tuple_index), mArgsHash(0), mArgsKeyValid(false)
 {
     // Initialize all ptrs in vector to NULL.
-    for (unsigned int i=0; i<num_args; i++) {
-        mArgs.push_back(NULL);
-    }
+    mArgs.resize(num_args);
     setTermType(UFCall);
     
 }
@@ -168,12 +167,10 @@ UFCallTerm::UFCallTerm(int coeff, std::string funcName, unsigned int num_args,
 UFCallTerm::UFCallTerm(std::string funcName, unsigned int num_args,
                        int tuple_index)
 : Term(1), mFuncName(funcName), mNumArgs(num_args),
-  mTupleIndex(tuple_index)
+  mTupleIndex(tuple_index), mArgsHash(0), mArgsKeyValid(false)
 {
     // Initialize all ptrs in vector to NULL.
-    for (unsigned int i=0; i<num_args; i++) {
-        mArgs.push_back(NULL);
-    }
+    mArgs.resize(num_args);
     setTermType(UFCall);
 }
 
@@ -182,10 +179,9 @@ UFCallTerm::UFCallTerm(const UFCallTerm& other) : Term(other) {
 }
 
 void UFCallTerm::reset() {
-    for (unsigned int i=0; i<mArgs.size(); i++) {
-        if (mArgs[i]) { delete mArgs[i]; }
-    }
+    // Arguments are deleted along with their last owner.
     mArgs.clear();
+    mArgsKeyValid = false;
 }
 
 //! Copy assignment
@@ -202,7 +198,13 @@ UFCallTerm& UFCallTerm::operator=(const UFCallTerm& other) {
             throw assert_exception("UFCallTerm::operator=: other missing"
                     " a parameter expression");
         }
-        mArgs.push_back( other.mArgs[i]->clone() );
+        // Share the argument, it is copied once either call changes it.
+        mArgs.push_back( other.mArgs[i] );
+    }
+    if (other.mArgsKeyValid.load(std::memory_order_acquire)) {
+        mArgsKey = other.mArgsKey;
+        mArgsHash = other.mArgsHash;
+        mArgsKeyValid = true;
     }
 
     return *this;
@@ -235,16 +237,9 @@ bool UFCallTerm::operator<(const Term& other) const {
     { return false; }
 
     // Now compare the argument list (as one big string).
-    std::stringstream ss1;
-    argsToStream(ss1);
-    std::string args = ss1.str();
-
-    std::stringstream ss2;
-    ((UFCallTerm&)other).argsToStream(ss2);
-    std::string otherArgs = ss2.str();
-    
-    if (args < otherArgs) { return true; }
-    if (args > otherArgs) { return false; }
+    int argsComparison = argsKey().compare(((UFCallTerm&)other).argsKey());
+    if (argsComparison < 0) { return true; }
+    if (argsComparison > 0) { return false; }
     
     // If everything else matches, let the superclass compare by coefficient.
     return Term::operator<(other);
@@ -258,7 +253,7 @@ Term* UFCallTerm::clone() const {
 //! Helper method for toString and operator<.
 void UFCallTerm::argsToStream(std::stringstream& ss) const {
     bool firstArg = true;
-    for (std::vector<Exp*>::const_iterator i=mArgs.begin(); 
+    for (std::vector<std::shared_ptr<Exp> >::const_iterator i=mArgs.begin(); 
             i != mArgs.end(); ++i) {
         if (not firstArg) { ss << ", "; }
         if (*i) { ss << (*i)->toString(); }
@@ -266,12 +261,27 @@ void UFCallTerm::argsToStream(std::stringstream& ss) const {
     }
 }
 
+//! Returns the argument list as a string, computing it on first use.
+const std::string& UFCallTerm::argsKey() const {
+    if (not mArgsKeyValid.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(mArgsKeyMutex);
+        if (not mArgsKeyValid.load(std::memory_order_relaxed)) {
+            std::stringstream ss;
+            argsToStream(ss);
+            mArgsKey = ss.str();
+            mArgsHash = std::hash<std::string>()(mArgsKey);
+            mArgsKeyValid.store(true, std::memory_order_release);
+        }
+    }
+    return mArgsKey;
+}
+
 //! Emits our argument list, as strings, to the given stream (pretty printed).
 //! Helper method for prettyPrintString.
 void UFCallTerm::argsToStreamPrettyPrint(
         const TupleDecl & aTupleDecl, std::stringstream& ss) const {
     bool firstArg = true;
-    for (std::vector<Exp*>::const_iterator i=mArgs.begin(); 
+    for (std::vector<std::shared_ptr<Exp> >::const_iterator i=mArgs.begin(); 
             i != mArgs.end(); ++i) {
         if (not firstArg) { ss << ", "; }
         if (*i) { ss << (*i)->prettyPrintString(aTupleDecl); }
@@ -283,9 +293,7 @@ void UFCallTerm::argsToStreamPrettyPrint(
 std::string UFCallTerm::toString(bool absValue) const {
     std::stringstream ss;
     coeffToStream(ss, absValue);
-    ss << mFuncName << '(';
-    argsToStream(ss);
-    ss << ')';
+    ss << mFuncName << '(' << argsKey() << ')';
     if (isIndexed()) {
         ss << '[' << tupleIndex() << ']';
     }
@@ -336,11 +344,29 @@ void UFCallTerm::setParamExp(unsigned int i, Exp* param_exp) {
         throw assert_exception("UFCallTerm::setParamExp: param exp being set "
                                 "twice");
     }
-    mArgs[i] = param_exp;
+    mArgs[i].reset(param_exp);
+    mArgsKeyValid = false;
+}
+
+//! Returns a pointer to the ith parameter expression, which the caller
+//! may modify.  A shared expression is copied first.
+Exp* UFCallTerm::getParamExp(unsigned int i) {
+    if (i>=mNumArgs) {
+        throw assert_exception("UFCallTerm::setParamExp: i is out of bounds");
+    }
+    if (mArgs[i]==NULL) {
+        throw assert_exception("UFCallTerm::setParamExp: requested parameter "
+                                "hasn't been set");
+    }
+    if (not mArgs[i].unique()) {
+        mArgs[i].reset(mArgs[i]->clone());
+    }
+    mArgsKeyValid = false;
+    return mArgs[i].get();
 }
 
 //! Returns a pointer to the ith parameter expression.
-Exp* UFCallTerm::getParamExp(unsigned int i) const {
+const Exp* UFCallTerm::getParamExp(unsigned int i) const {
     if (i>=mNumArgs) {
         throw assert_exception("UFCallTerm::setParamExp: i is out of bounds");
     }
@@ -348,7 +374,7 @@ Exp* UFCallTerm::getParamExp(unsigned int i) const {
         throw assert_exception("UFCallTerm::setParamExp: requested parameter "
                                 "hasn't been set");
     }
-    return mArgs[i];
+    return mArgs[i].get();
 }
 
 //! Returns a UFCallTerm that is identical except it is
@@ -405,12 +431,21 @@ bool UFCallTerm::factorMatches(const Term& other) const {
     // check that the tuple location matches
     if (tupleIndex() != ufo.tupleIndex()) { return false; }
 
-    // check that the argument lists match
-    std::stringstream ss1;
-    argsToStream(ss1);
-    std::stringstream ss2;
-    ufo.argsToStream(ss2);
-    return (ss1.str() == ss2.str());    
+    // check that the argument lists match, comparing hashes first
+    const std::string& args = argsKey();
+    const std::string& otherArgs = ufo.argsKey();
+    if (mArgsHash != ufo.mArgsHash) { return false; }
+    return (args == otherArgs);
+}
+
+
+size_t UFCallTerm::factorHash() const {
+    argsKey();
+    size_t seed = std::hash<std::string>()(mFuncName);
+    seed ^= mArgsHash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<int>()(tupleIndex()) + 0x9e3779b9 + (seed << 6)
+            + (seed >> 2);
+    return seed;
 }
 
 
@@ -433,9 +468,9 @@ Exp* UFCallTerm::collapseNestedInvertibleFunctions() const {
     Exp* saved_arg = NULL;
     int arg_index = 0;
     bool can_collapse_self = true;
-    for (std::vector<Exp*>::const_iterator i=mArgs.begin(); 
+    for (std::vector<std::shared_ptr<Exp> >::const_iterator i=mArgs.begin(); 
             i != mArgs.end(); ++i) {
-        Exp* arg = *i;
+        Exp* arg = i->get();
         
         // Get the first term to the argument expression.  
         // Should only have one term. 
@@ -466,7 +501,7 @@ Exp* UFCallTerm::collapseNestedInvertibleFunctions() const {
                 }
 
                 // Save off the nested arg to the zeroth nested function call.
-                Exp* nestedParam = ufcallterm->mArgs.front();
+                Exp* nestedParam = ufcallterm->mArgs.front().get();
                 if (arg_index==0) {
                     saved_arg = nestedParam;
                 }
@@ -503,7 +538,7 @@ Exp* UFCallTerm::collapseNestedInvertibleFunctions() const {
                          this->mFuncName, mArgs.size(), 
                          this->mTupleIndex);
         unsigned int count = 0;
-        for (std::vector<Exp*>::const_iterator i=mArgs.begin(); 
+        for (std::vector<std::shared_ptr<Exp> >::const_iterator i=mArgs.begin(); 
                 i != mArgs.end(); ++i) {
             uf_call->setParamExp(count++,     
                 (*i)->collapseNestedInvertibleFunctions());
@@ -899,19 +934,22 @@ Exp::Exp(const Exp& other) {
 }
 
 void Exp::reset() {
-    for (std::list<Term*>::iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
+    for (std::vector<Term*>::iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
         delete (*i);
     }
     mTerms.clear();
+    mSorted = true;
 }
 
 //! Copy assignment
 Exp& Exp::operator=(const Exp& other) {
     reset();
-    for (std::list<Term*>::const_iterator i=other.mTerms.begin(); 
+    mTerms.reserve(other.mTerms.size());
+    for (std::vector<Term*>::const_iterator i=other.mTerms.begin(); 
                 i != other.mTerms.end(); ++i) {
         mTerms.push_back((*i)->clone());
     }
+    mSorted = other.mSorted;
     mExpType = other.mExpType;
 
     return *this;
@@ -934,7 +972,7 @@ std::string Exp::toString() const {
     // FIXME does the line just below go in other
     // toString() or prettyPrintString methods?
     if(mTerms.size() == 0) return "0";
-    for (std::list<Term*>::const_iterator i=mTerms.begin(); 
+    for (std::vector<Term*>::const_iterator i=mTerms.begin(); 
             i != mTerms.end(); ++i) {
         bool absValue = false;
         if (not firstTerm) {
@@ -957,7 +995,7 @@ Exp::prettyPrintString(const TupleDecl & aTupleDecl) const
 {
     std::string result;
     bool firstTerm = true;
-    for (std::list<Term*>::const_iterator i=mTerms.begin(); 
+    for (std::vector<Term*>::const_iterator i=mTerms.begin(); 
             i != mTerms.end(); ++i) {
         bool absValue = false;
         if (not firstTerm) {
@@ -976,7 +1014,7 @@ Exp::prettyPrintString(const TupleDecl & aTupleDecl) const
     std::string result_left, result_right, result;
     result_left = result_right = std::string("0");
     bool firstTerm_left = true,firstTerm_right = true;
-    for (std::list<Term*>::const_iterator i=mTerms.begin(); 
+    for (std::vector<Term*>::const_iterator i=mTerms.begin(); 
             i != mTerms.end(); ++i) {
         if ((*i)->coefficient() < 0) {
             if (firstTerm_left) result_left = (*i)->prettyPrintString(aTupleDecl, true);
@@ -997,6 +1035,11 @@ Exp::prettyPrintString(const TupleDecl & aTupleDecl) const
 */
 }
 
+//! Strict weak ordering on Term pointers, used to keep mTerms sorted.
+static bool termPtrLess(const Term* a, const Term* b) {
+    return *a < *b;
+}
+
 //! Add a term to this expression
 void Exp::addTerm(Term *term) {
 
@@ -1004,49 +1047,63 @@ void Exp::addTerm(Term *term) {
     if(term->coefficient() == 0){ delete term; return; }
 
     // Approach:
-    // Iterate over our existing items (which are already sorted).
-    // If we find one we can combine with the given term, combine them.
-    // If we find one that comes after the given term, insert it.
-    // Otherwise, append to the end.
-    for (std::list<Term*>::iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
-        Term *t = *i;
-        if (t->combine(term->clone())) {
-            delete term;
-            // We've successfully combined this term with an existing one,
-            // but it's possible that the resulting term has a coefficient
-            // of zero, in which case it should be removed.
-            if (0 == t->coefficient()) {
-                mTerms.erase(i);
-                delete t;
-            }
-            return;
+    // Our terms are sorted and no two of them share a factor, so binary
+    // search for where the given term belongs.  Terms with the same factor
+    // only differ by coefficient, so a match sorts right before or right
+    // after that position.  Combine with it if there is one, otherwise
+    // insert the term there.  If the terms are out of order, look for a
+    // match among all of them and otherwise insert before the first one
+    // that sorts after the given term.
+    std::vector<Term*>::iterator pos, match = mTerms.end();
+    if (mSorted) {
+        pos = std::lower_bound(mTerms.begin(), mTerms.end(), term,
+                               termPtrLess);
+        if (pos != mTerms.end() && (*pos)->factorMatches(*term)) {
+            match = pos;
+        } else if (pos != mTerms.begin() &&
+                   (*(pos-1))->factorMatches(*term)) {
+            match = pos-1;
         }
-        if (*term < *t) {
-            // We've found a term that belongs after the new one,
-            // so insert the new term here, and we're done.
-            mTerms.insert(i, term);
-            return;
+    } else {
+        pos = mTerms.end();
+        for (std::vector<Term*>::iterator i=mTerms.begin();
+                    i != mTerms.end(); ++i) {
+            if ((*i)->factorMatches(*term)) { match = i; break; }
+            if (pos == mTerms.end() && *term < **i) { pos = i; }
         }
     }
-    
-    // We could neither combine this term with an existing one, nor
-    // find a term that comes after it in the sort order.  So, just
-    // append it to the end of the list.
-    mTerms.push_back(term);
+
+    if (match == mTerms.end()) {
+        mTerms.insert(pos, term);
+        return;
+    }
+
+    Term *t = *match;
+    t->combine(term);
+    // We've successfully combined this term with an existing one,
+    // but it's possible that the resulting term has a coefficient
+    // of zero, in which case it should be removed.
+    if (0 == t->coefficient()) {
+        mTerms.erase(match);
+        delete t;
+    }
 }
 
 //! Add another expression to this one
 void Exp::addExp(Exp *exp) {
-    for (std::list<Term*>::const_iterator i=exp->mTerms.begin(); 
-                i != exp->mTerms.end(); ++i) {
-        addTerm((*i)->clone());
-    }
+    // exp is deleted anyway, so its terms are moved rather than cloned
+    std::vector<Term*> terms;
+    terms.swap(exp->mTerms);
     delete exp;
+    for (std::vector<Term*>::const_iterator i=terms.begin(); 
+                i != terms.end(); ++i) {
+        addTerm(*i);
+    }
 }
 
 //! Multiply all terms in this expression by a constant
 void Exp::multiplyBy(int constant) {
-    for (std::list<Term*>::iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
+    for (std::vector<Term*>::iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
         (*i)->multiplyBy(constant);
     }   
 }
@@ -1054,7 +1111,7 @@ void Exp::multiplyBy(int constant) {
 //! Return whether all coefficients in this expression are
 //! evenly divisible by the given integer.
 bool Exp::isDivisible(int divisor) const {
-    for (std::list<Term*>::const_iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
+    for (std::vector<Term*>::const_iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
         Term* t = *i;
         if (t->coefficient() % divisor != 0) { return false; }
     }
@@ -1062,7 +1119,7 @@ bool Exp::isDivisible(int divisor) const {
 }
 
 void Exp::divideBy(int divisor) {
-    for (std::list<Term*>::iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
+    for (std::vector<Term*>::iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
         Term* t = *i;
         t->divideBy(divisor);
     }
@@ -1082,7 +1139,7 @@ Term* Exp::findMatchingFactor(const Term & factor) const {
     }
     
     Term* matchingFactor = NULL;
-    for (std::list<Term*>::const_iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
+    for (std::vector<Term*>::const_iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
         const Term* t = *i;
         if (t->factorMatches(factor) and isDivisible(t->coefficient()) ) {
             // found a simple match for this factor
@@ -1169,7 +1226,7 @@ Exp* Exp::invertFuncToExposeFactor(Term * factor_ptr) const {
     
     // Search through terms in this expression.
     std::string inverseFuncName = "";
-    for (std::list<Term*>::const_iterator i=mTerms.begin();
+    for (std::vector<Term*>::const_iterator i=mTerms.begin();
                 i != mTerms.end(); ++i) {
         Term* t = (*i);
     
@@ -1227,9 +1284,9 @@ Exp* Exp::invertFuncToExposeFactor(Term * factor_ptr) const {
         // the factor we are looking for
         unsigned int arg_count = 0;
         int arg_index = 0;
-        Exp* relevant_arg;
+        const Exp* relevant_arg;
         for (; arg_count<foundUFC->numArgs(); arg_count++) {
-            Exp* arg = foundUFC->getParamExp( arg_count );
+            const Exp* arg = ((const UFCallTerm*)foundUFC)->getParamExp( arg_count );
             if (arg->dependsOn(*factor_ptr)) {
                 arg_index = arg_count;
                 relevant_arg = arg;
@@ -1270,7 +1327,7 @@ Exp* Exp::invertFuncToExposeFactor(Term * factor_ptr) const {
 //! part of a term), which is its key.
 void Exp::substitute(SubMap& searchTermToSubExp) {
     Exp *addedTerms = new Exp();
-    std::list<Term*>::iterator i=mTerms.begin();
+    std::vector<Term*>::iterator i=mTerms.begin();
     while (i != mTerms.end()) {
         Term *t = *i;
         
@@ -1282,9 +1339,6 @@ void Exp::substitute(SubMap& searchTermToSubExp) {
             // Note the coefficient for this term and then remove 
             // it from the list for the expression.
             int foundCoefficient = t->coefficient();
-            // Note that we don't increment i here; it already points
-            // to the item after the one just erased.
-            i = mTerms.erase(i);
             delete t;
             // Put substituted expression in and multiple by coeff of term.
             Exp *product = sub->clone();
@@ -1292,10 +1346,8 @@ void Exp::substitute(SubMap& searchTermToSubExp) {
             addedTerms->addExp(product);
             
         } else { 
-            // clone term and remove from original expression
-            Term* term_clone = t->clone();
-            i = mTerms.erase(i);  // removing term from current exp
-            delete t;
+            // move term out of the original expression, no need to copy
+            Term* term_clone = t;
 
             // If we have a UFCallTerm
             // below here change term_clone to callTerm
@@ -1321,7 +1373,11 @@ void Exp::substitute(SubMap& searchTermToSubExp) {
             // params substituted or term that doesn't match factor) back in
             addedTerms->addTerm(term_clone);
         }
+        i++;
     }
+    // Every term has been moved into addedTerms or substituted.
+    mTerms.clear();
+    mSorted = true;
 
     // put all the modifications into this Exp
     addExp(addedTerms);
@@ -1339,7 +1395,7 @@ void Exp::normalizeForEquality() {
     Term *lastTerm = mTerms.back();
     if(lastTerm->coefficient() == 0){
         delete lastTerm;
-        mTerms.remove(lastTerm);
+        mTerms.pop_back();
     }
 }
 
@@ -1348,7 +1404,7 @@ void Exp::normalizeForEquality() {
 //! g(g_inv(x)[0], g_inv(x)[1]) changed to x
 Exp* Exp::collapseNestedInvertibleFunctions() const {
     Exp* retval = new Exp();
-    for (std::list<Term*>::const_iterator i=mTerms.begin();
+    for (std::vector<Term*>::const_iterator i=mTerms.begin();
                 i != mTerms.end(); i++) {
         retval->addExp( (*i)->collapseNestedInvertibleFunctions() );
     }   
@@ -1359,7 +1415,7 @@ Exp* Exp::collapseNestedInvertibleFunctions() const {
 **  (including within UFCallTerm arguments, recursively).
 */
 bool Exp::dependsOn(const Term& factor) const {
-    for (std::list<Term*>::const_iterator i=mTerms.begin();
+    for (std::vector<Term*>::const_iterator i=mTerms.begin();
                 i != mTerms.end(); i++) {
         if ((*i)->factorMatches(factor)) {
             // We found the matching term.
@@ -1368,11 +1424,11 @@ bool Exp::dependsOn(const Term& factor) const {
             // This term doesn't match, but maybe it contains other
             // expressions that we need to search recursively.
             if ((*i)->isUFCall()) {
-                UFCallTerm *callTerm = dynamic_cast<UFCallTerm*>((*i));
+                const UFCallTerm *callTerm = dynamic_cast<UFCallTerm*>((*i));
                 // This term doesn't match, but maybe it contains other
                 // expressions that we need to search recursively.
                 for (unsigned int count=0; count<callTerm->numArgs(); count++) {
-                    Exp* arg = callTerm->getParamExp(count);
+                    const Exp* arg = callTerm->getParamExp(count);
                     if (arg->dependsOn(factor)) { return true; }
                 }
             }
@@ -1395,7 +1451,7 @@ bool Exp::dependsOn(const Term& factor) const {
 **  that is being indexed.
 */
 bool Exp::hasIndexedUFCall() const {
-    for (std::list<Term*>::const_iterator i=mTerms.begin();
+    for (std::vector<Term*>::const_iterator i=mTerms.begin();
                 i != mTerms.end(); i++) {
         if ( (*i)->isUFCall() ) {
             UFCallTerm* ufcallptr = dynamic_cast<UFCallTerm*>(*i);
@@ -1414,7 +1470,7 @@ UFCallTerm* Exp::cloneIndexedUFCallTerm() const {
             "no indexed UFCallTerm");
     }
     UFCallTerm* retval = NULL;
-    for (std::list<Term*>::const_iterator i=mTerms.begin();
+    for (std::vector<Term*>::const_iterator i=mTerms.begin();
                 i != mTerms.end(); i++) {
         if ( (*i)->isUFCall() ) {
             UFCallTerm* ufcallptr = dynamic_cast<UFCallTerm*>(*i);
@@ -1467,8 +1523,8 @@ bool Exp::operator<( const Exp& other) const {
     if (mTerms.size() < other.mTerms.size()) { return true; }
     if (other.mTerms.size() < mTerms.size()) { return false; }
     // then compare our elements
-    std::list<Term*>::const_iterator otherIter = other.mTerms.begin();
-    std::list<Term*>::const_iterator myIter = mTerms.begin(); 
+    std::vector<Term*>::const_iterator otherIter = other.mTerms.begin();
+    std::vector<Term*>::const_iterator myIter = mTerms.begin(); 
     while ( myIter != mTerms.end() ) {
         //compare values
         if (**myIter < **otherIter) { return true; }
@@ -1526,7 +1582,7 @@ void Exp::remapTupleVars(const std::vector<int>& oldToNewLocs) {
     // themselves to a new location as specified.
     // Since we only do one pass we don't have __tv0 mapping to __tv3 and
     // then __tv3 mapping to something else later.
-    for (std::list<Term*>::iterator i=mTerms.begin();
+    for (std::vector<Term*>::iterator i=mTerms.begin();
                 i != mTerms.end(); i++) {
         TupleVarTerm *tupleVarTerm = dynamic_cast<TupleVarTerm*>(*i);
         if (tupleVarTerm) {
@@ -1555,6 +1611,9 @@ void Exp::remapTupleVars(const std::vector<int>& oldToNewLocs) {
 
         }
     }
+    // Locations changed in place, which may break the sort order.
+    mSorted = mSorted &&
+              std::is_sorted(mTerms.begin(), mTerms.end(), termPtrLess);
 }
 
 //! Returns true if only have a constant term
@@ -1593,7 +1652,7 @@ Term* Exp::getTerm() const {
 //! Otherwise return NULL.
 //! This expression still owns the Term.
 Term* Exp::getConstTerm() const {
-    for (std::list<Term*>::const_iterator i=mTerms.begin(); 
+    for (std::vector<Term*>::const_iterator i=mTerms.begin(); 
             i != mTerms.end(); i++) {
         Term* t = (*i);
         if (t->isConst()) {
@@ -1618,7 +1677,7 @@ std::string Exp::toDotString(int & next_id) const {
 
     // Printing out children here and calling recursively
     // on grandchildren due to a function call.
-    for (std::list<Term*>::const_iterator i=mTerms.begin();
+    for (std::vector<Term*>::const_iterator i=mTerms.begin();
                 i != mTerms.end(); i++) {
         int term_id = next_id++;
         // Connect self to term child
@@ -1629,11 +1688,11 @@ std::string Exp::toDotString(int & next_id) const {
 
         // Create grandchildren if needed and recurse
         if ((*i)->isUFCall()) {
-            UFCallTerm *callTerm = dynamic_cast<UFCallTerm*>((*i));
+            const UFCallTerm *callTerm = dynamic_cast<UFCallTerm*>((*i));
             // This term doesn't match, but maybe it contains other
             // expressions that we need to search recursively.
             for (unsigned int count=0; count<callTerm->numArgs(); count++) {
-                Exp* arg = callTerm->getParamExp(count);
+                const Exp* arg = callTerm->getParamExp(count);
                 result << arg->toDotString(term_id,next_id);
             }
         }
@@ -1675,7 +1734,7 @@ StringIterator* Exp::getSymbolIterator() const {
 
     std::set<std::string> symbolSet;
 
-    for (std::list<Term*>::const_iterator i=mTerms.begin();
+    for (std::vector<Term*>::const_iterator i=mTerms.begin();
                 i != mTerms.end(); i++) {
 
         VarTerm *varTerm = dynamic_cast<VarTerm*>(*i);
@@ -1688,11 +1747,11 @@ StringIterator* Exp::getSymbolIterator() const {
         
             // Recurse if needed.
             if ((*i)->isUFCall()) {
-                UFCallTerm *callTerm = dynamic_cast<UFCallTerm*>(*i);
+                const UFCallTerm *callTerm = dynamic_cast<UFCallTerm*>(*i);
                 // This term doesn't match, but maybe it contains other
                 // expressions that we need to search recursively.
                 for (unsigned int count=0; count<callTerm->numArgs(); count++) {
-                    Exp* arg = callTerm->getParamExp(count);
+                    const Exp* arg = callTerm->getParamExp(count);
                     StringIterator* subSymIter = arg->getSymbolIterator();
                     while (subSymIter->hasNext()) {
                         symbolSet.insert( subSymIter->next() );
@@ -1738,9 +1797,18 @@ void Term::acceptVisitor(Visitor *v) {
 void UFCallTerm::acceptVisitor(Visitor *v) {
     v->preVisitUFCallTerm(this);
 
-    // Iterate over parameters passed to UF.
-    for (std::vector<Exp*>::iterator i=mArgs.begin(); i != mArgs.end(); ++i) {
-        (*i)->acceptVisitor(v);
+    // Iterate over parameters passed to UF.  Visitors may modify them,
+    // so those get private copies; read-only ones see the shared ones.
+    if (v->mutatesTerms()) {
+        for (unsigned int i=0; i<mNumArgs; i++) {
+            getParamExp(i)->acceptVisitor(v);
+        }
+        mArgsKeyValid = false;
+    } else {
+        for (unsigned int i=0; i<mNumArgs; i++) {
+            const_cast<Exp*>(((const UFCallTerm*)this)->getParamExp(i))
+                ->acceptVisitor(v);
+        }
     }
 
     v->postVisitUFCallTerm(this);
@@ -1763,7 +1831,7 @@ void TupleExpTerm::acceptVisitor(Visitor *v) {
 
 void Exp::acceptVisitor(Visitor *v) {
     v->preVisitExp(this);
-    for (std::list<Term*>::iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
+    for (std::vector<Term*>::iterator i=mTerms.begin(); i != mTerms.end(); ++i) {
         (*i)->acceptVisitor(v);
     }
     v->postVisitExp(this);
@@ -1775,7 +1843,7 @@ void Exp::acceptVisitor(Visitor *v) {
 //! Get a list of pointers to the terms in this expression.
 //! All pointers in this list will be owned by caller.
 std::list<Term*> Exp::getTermList() const {
-    return mTerms;
+    return std::list<Term*>(mTerms.begin(), mTerms.end());
 }
 
 
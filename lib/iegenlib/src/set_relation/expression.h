@@ -22,6 +22,9 @@
 #include <string>
 #include <list>
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include <sstream>
 #include <stdlib.h>
 #include <iostream>
@@ -233,8 +236,13 @@ public:
     void setParamExp(unsigned int i, Exp* param_exp);
     
     //! Returns a pointer to the ith parameter expression.
-    //! This UFCallTerm still owns the pointer.
-    Exp* getParamExp(unsigned int i) const;
+    //! This UFCallTerm still owns the pointer.  Copies of a call share
+    //! their parameter expressions, so this first makes a private copy
+    //! of a shared one and drops the cached argument key.  Make changes
+    //! before this call is compared or printed again, or fetch the pointer
+    //! again after them.  Use the const version to only read it.
+    Exp* getParamExp(unsigned int i);
+    const Exp* getParamExp(unsigned int i) const;
 
     //! Indicate if the function return value is being
     //! indexed.
@@ -273,6 +281,10 @@ public:
 
     //! Returns true if this term can be combined with the given term.
     bool factorMatches(const Term& other) const;
+
+    //! Hash of the function name, tuple index, and arguments, so calls
+    //! that factorMatches hash the same whatever their coefficients.
+    size_t factorHash() const;
     
     //! Visitor design pattern, see Visitor.h for usage
     void acceptVisitor(Visitor *v);
@@ -283,10 +295,22 @@ private:
     void argsToStreamPrettyPrint(const TupleDecl & aTupleDecl,
         std::stringstream& ss) const;
 
+    //! Argument list as a string, computed once and used to order and
+    //! match calls.  Cleared whenever an argument may change.  Calls
+    //! sharing arguments can be read from several threads, so the key
+    //! is filled under mArgsKeyMutex.
+    const std::string& argsKey() const;
+
     std::string mFuncName;
     unsigned int mNumArgs;
-    std::vector<Exp*> mArgs;
+    //! Parameter expressions, shared copy-on-write between copies.
+    std::vector<std::shared_ptr<Exp> > mArgs;
     int mTupleIndex;
+
+    mutable std::string mArgsKey;
+    mutable size_t mArgsHash;
+    mutable std::atomic<bool> mArgsKeyValid;
+    mutable std::mutex mArgsKeyMutex;
 };
 
 /*!
@@ -529,7 +553,7 @@ private:
 class Exp {
 public:
     //! Default constructor
-    inline Exp() {setExpression();}
+    inline Exp() : mSorted(true) {setExpression();}
 
     //! Copy constructor.  Performs a deep copy.
     Exp(const Exp& other);
@@ -709,7 +733,10 @@ private:
     */
     Term* findMatchingFactor(const Term & factor) const;        
 
-    std::list<Term*> mTerms;
+    //! Sorted by Term::operator<, no two terms share a factor.
+    std::vector<Term*> mTerms;
+    //! False once remapTupleVars has left mTerms out of order.
+    bool mSorted;
     exptype mExpType; 
 
 };
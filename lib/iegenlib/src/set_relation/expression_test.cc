@@ -18,11 +18,13 @@
 #include "set_relation.h"
 #include "SubMap.h"
 #include "../util/util.h"
+#include "Visitor.h"
 
 #include <gtest/gtest.h>
 #include <utility>
 #include <iostream>
 #include <fstream>
+#include <thread>
 using std::cout;
 using std::endl;
 
@@ -574,7 +576,117 @@ TEST_F(ExpTest, ExpRemapLocs) {
     EXPECT_EQ("12 __tv4 + 7 __tv2 + 5 N + g(__tv0) + 42", e1.toString());  
 }
 
-#pragma mark ExpIsConst
+#pragma mark ExpAddTermAfterRemap
+// Test that terms still combine once remapping has left them out of order,
+// and that a sorted expression combines terms regardless of insert order.
+TEST_F(ExpTest, ExpAddTermAfterRemap) {
+    Exp e1;
+    e1.addTerm(new TupleVarTerm(7, 3));
+    e1.addTerm(new TupleVarTerm(12, 0));
+    std::vector<int> map(4);
+    map[0] = 4;
+    map[1] = 1;
+    map[2] = 0;
+    map[3] = 2;
+    e1.remapTupleVars(map);
+    EXPECT_EQ("12 __tv4 + 7 __tv2", e1.toString());
+    e1.addTerm(new TupleVarTerm(-7, 2));
+    EXPECT_EQ("12 __tv4", e1.toString());
+
+    Exp e2, e3;
+    for (int i = 0; i < 20; i++) {
+        e2.addTerm(new TupleVarTerm(i + 1, i));
+        e3.addTerm(new TupleVarTerm(i + 1, 19 - i));
+    }
+    for (int i = 0; i < 20; i++) {
+        e2.addTerm(new TupleVarTerm(-(i + 1), i));
+        e3.addTerm(new TupleVarTerm(-(20 - i), i));
+    }
+    EXPECT_TRUE( e2.equalsZero() );
+    EXPECT_TRUE( e3.equalsZero() );
+}
+
+#pragma mark UFCallTermSharedArgs
+// Test that copies of a call share their arguments until one of them
+// changes an argument.
+TEST_F(ExpTest, UFCallTermSharedArgs) {
+    UFCallTerm* f = new UFCallTerm("f", 1);
+    Exp* arg = new Exp();
+    arg->addTerm(new TupleVarTerm(0));
+    arg->addTerm(new Term(1));
+    f->setParamExp(0, arg);
+
+    UFCallTerm* g = dynamic_cast<UFCallTerm*>(f->clone());
+    const UFCallTerm* cf = f;
+    const UFCallTerm* cg = g;
+    EXPECT_EQ( cf->getParamExp(0) , cg->getParamExp(0) );
+    EXPECT_TRUE( f->factorMatches(*g) );
+
+    // Changing the argument of the copy leaves the original alone.
+    g->getParamExp(0)->addTerm(new Term(1));
+    EXPECT_NE( cf->getParamExp(0) , cg->getParamExp(0) );
+    EXPECT_EQ( "f(__tv0 + 1)", f->toString() );
+    EXPECT_EQ( "f(__tv0 + 2)", g->toString() );
+    EXPECT_FALSE( f->factorMatches(*g) );
+    EXPECT_TRUE( *f < *g );
+
+    delete f;
+    delete g;
+}
+
+#pragma mark UFCallTermVisitSharedArgs
+class VisitorCountTupleVars : public Visitor {
+  public:
+    VisitorCountTupleVars(bool mutates) : mMutates(mutates), mCount(0) {}
+    bool mutatesTerms() const { return mMutates; }
+    void preVisitTupleVarTerm(iegenlib::TupleVarTerm * t) { mCount++; }
+    int count() const { return mCount; }
+  private:
+    bool mMutates;
+    int mCount;
+};
+
+// Test that only a visitor that may change terms detaches the shared
+// arguments of a call, and that shared keys can be read concurrently.
+TEST_F(ExpTest, UFCallTermVisitSharedArgs) {
+    UFCallTerm* inner = new UFCallTerm("g", 1);
+    Exp* innerArg = new Exp();
+    innerArg->addTerm(new TupleVarTerm(0));
+    inner->setParamExp(0, innerArg);
+    UFCallTerm* f = new UFCallTerm("f", 1);
+    Exp* arg = new Exp();
+    arg->addTerm(inner);
+    arg->addTerm(new TupleVarTerm(1));
+    f->setParamExp(0, arg);
+
+    UFCallTerm* g = dynamic_cast<UFCallTerm*>(f->clone());
+    const UFCallTerm* cf = f;
+    const UFCallTerm* cg = g;
+
+    VisitorCountTupleVars reader(false);
+    g->acceptVisitor(&reader);
+    EXPECT_EQ( 2, reader.count() );
+    EXPECT_EQ( cf->getParamExp(0) , cg->getParamExp(0) );
+
+    // Both copies print the nested call through the same argument.
+    std::string s1, s2;
+    std::thread t1([&]() { for (int i=0; i<200; i++) s1 = f->toString(); });
+    std::thread t2([&]() { for (int i=0; i<200; i++) s2 = g->toString(); });
+    t1.join();
+    t2.join();
+    EXPECT_EQ( "f(__tv1 + g(__tv0))", s1 );
+    EXPECT_EQ( s1, s2 );
+
+    VisitorCountTupleVars writer(true);
+    g->acceptVisitor(&writer);
+    EXPECT_EQ( 2, writer.count() );
+    EXPECT_NE( cf->getParamExp(0) , cg->getParamExp(0) );
+    EXPECT_TRUE( f->factorMatches(*g) );
+
+    delete f;
+    delete g;
+}
+
 // Test that even an expression with the value of zero is considered const.
 TEST_F(ExpTest, ExpIsConst) {
     Exp* e1 = new Exp();
@@ -0,0 +1,547 @@
+/*!
+ * \file serialization.cc
+ *
+ * \brief Implementation of the BinaryWriter and BinaryReader classes.
+ *
+ * \date Started: 2026-10-19
+ *
+ * Copyright (c) 2026, University of Arizona <br>
+ * All rights reserved. <br>
+ * See ../../COPYING for details. <br>
+ */
+
+#include "serialization.h"
+#include "environment.h"
+#include "expression.h"
+#include "set_relation.h"
+#include <util/util.h>
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace iegenlib{
+
+static const char sMagic[4] = {'I', 'E', 'G', 'B'};
+
+// Term tags.
+enum { TagConst, TagTupleVar, TagVar, TagUFCall, TagTupleExp };
+
+/*****************************************************************************/
+#pragma mark -
+/*************** BinaryWriter *****************************/
+
+void BinaryWriter::writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+        mBody.push_back(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    mBody.push_back(char(value));
+}
+
+void BinaryWriter::writeSigned(int64_t value) {
+    writeVarint((uint64_t(value) << 1) ^ uint64_t(value >> 63));
+}
+
+void BinaryWriter::writeSymbol(const std::string& name) {
+    std::map<std::string, unsigned>::iterator it = mSymbolIds.find(name);
+    if (it == mSymbolIds.end()) {
+        it = mSymbolIds.insert(std::make_pair(name, mSymbols.size())).first;
+        mSymbols.push_back(name);
+    }
+    writeVarint(it->second);
+}
+
+void BinaryWriter::writeTerm(Term* term) {
+    if (term->isConst()) {
+        mBody.push_back(TagConst);
+        writeSigned(term->coefficient());
+    } else if (TupleVarTerm* tv = dynamic_cast<TupleVarTerm*>(term)) {
+        mBody.push_back(TagTupleVar);
+        writeSigned(tv->coefficient());
+        writeVarint(tv->tvloc());
+    } else if (VarTerm* var = dynamic_cast<VarTerm*>(term)) {
+        mBody.push_back(TagVar);
+        writeSigned(var->coefficient());
+        writeSymbol(var->symbol());
+    } else if (UFCallTerm* uf = dynamic_cast<UFCallTerm*>(term)) {
+        const UFCallTerm* cuf = uf;
+        mBody.push_back(TagUFCall);
+        writeSigned(uf->coefficient());
+        writeSymbol(uf->name());
+        writeSigned(uf->isIndexed() ? uf->tupleIndex() : -1);
+        writeVarint(uf->numArgs());
+        for (unsigned int i = 0; i < uf->numArgs(); i++) {
+            writeExp(*cuf->getParamExp(i));
+        }
+    } else if (TupleExpTerm* te = dynamic_cast<TupleExpTerm*>(term)) {
+        mBody.push_back(TagTupleExp);
+        writeSigned(te->coefficient());
+        writeVarint(te->size());
+        for (unsigned int i = 0; i < te->size(); i++) {
+            writeExp(*te->getExpElem(i));
+        }
+    } else {
+        throw assert_exception("BinaryWriter: unknown Term type "
+                               + term->type());
+    }
+}
+
+void BinaryWriter::writeExp(const Exp& exp) {
+    std::list<Term*> terms = exp.getTermList();
+    writeVarint(terms.size());
+    for (std::list<Term*>::const_iterator i = terms.begin();
+            i != terms.end(); i++) {
+        writeTerm(*i);
+    }
+}
+
+void BinaryWriter::writeConjunction(Conjunction& conj) {
+    TupleDecl tdecl = conj.getTupleDecl();
+    writeVarint(tdecl.size());
+    for (unsigned int i = 0; i < tdecl.size(); i++) {
+        if (tdecl.elemIsConst(i)) {
+            mBody.push_back(1);
+            writeSigned(tdecl.elemConstVal(i));
+        } else {
+            mBody.push_back(0);
+            writeSymbol(tdecl.elemVarString(i));
+        }
+    }
+    writeVarint(conj.inarity());
+    mBody.push_back(conj.isUnsat() ? 1 : 0);
+
+    writeVarint(conj.equalities().size());
+    for (size_t i = 0; i < conj.equalities().size(); i++) {
+        writeExp(*conj.equalities()[i]);
+    }
+    writeVarint(conj.inequalities().size());
+    for (size_t i = 0; i < conj.inequalities().size(); i++) {
+        writeExp(*conj.inequalities()[i]);
+    }
+}
+
+void BinaryWriter::writeConjunctions(const SparseConstraints& sc) {
+    size_t count = 0;
+    for (std::list<Conjunction*>::const_iterator i = sc.conjunctionBegin();
+            i != sc.conjunctionEnd(); i++) {
+        count++;
+    }
+    writeVarint(count);
+    for (std::list<Conjunction*>::const_iterator i = sc.conjunctionBegin();
+            i != sc.conjunctionEnd(); i++) {
+        writeConjunction(**i);
+    }
+}
+
+void BinaryWriter::writeSetBody(const Set& set) {
+    writeVarint(set.arity());
+    writeConjunctions(set);
+}
+
+void BinaryWriter::write(const Set& set) {
+    mBody.push_back('S');
+    writeSetBody(set);
+}
+
+void BinaryWriter::write(const Relation& rel) {
+    mBody.push_back('R');
+    writeVarint(rel.inArity());
+    writeVarint(rel.outArity());
+    writeConjunctions(rel);
+}
+
+void BinaryWriter::write(const Environment& env) {
+    mBody.push_back('E');
+
+    writeVarint(env.mUninterpFuncMap.size());
+    for (std::map<std::string, UninterpFunc*>::const_iterator
+            it = env.mUninterpFuncMap.begin();
+            it != env.mUninterpFuncMap.end(); it++) {
+        UninterpFunc* uf = it->second;
+        writeSymbol(it->first);
+        writeSetBody(*uf->getDomain());
+        writeSetBody(*uf->getRange());
+        mBody.push_back(uf->isBijective() ? 1 : 0);
+        writeVarint(uf->getMonoType());
+    }
+
+    writeVarint(env.mInverseMap.size());
+    for (std::map<std::string, std::string>::const_iterator
+            it = env.mInverseMap.begin(); it != env.mInverseMap.end(); it++) {
+        writeSymbol(it->first);
+        writeSymbol(it->second);
+    }
+
+    writeVarint(env.uniQuantRules.size());
+    for (size_t i = 0; i < env.uniQuantRules.size(); i++) {
+        UniQuantRule* rule = env.uniQuantRules[i];
+        writeVarint(rule->getType());
+        writeSetBody(*rule->getLeftSide());
+        writeSetBody(*rule->getRightSide());
+    }
+}
+
+std::string BinaryWriter::str() const {
+    BinaryWriter header;
+    header.mBody.append(sMagic, sizeof(sMagic));
+    header.writeVarint(version);
+    header.writeVarint(mSymbols.size());
+    for (size_t i = 0; i < mSymbols.size(); i++) {
+        header.writeVarint(mSymbols[i].size());
+        header.mBody.append(mSymbols[i]);
+    }
+    return header.mBody + mBody;
+}
+
+void BinaryWriter::save(const std::string& path) const {
+    std::ofstream out(path.c_str(), std::ios::out | std::ios::binary);
+    std::string data = str();
+    out.write(data.data(), data.size());
+    if (!out) {
+        throw parse_exception("BinaryWriter::save: unable to write " + path);
+    }
+}
+
+/*****************************************************************************/
+#pragma mark -
+/*************** BinaryReader *****************************/
+
+BinaryReader::BinaryReader(const char* data, size_t size)
+    : mData(data), mSize(size), mPos(0), mMapped(NULL), mMappedSize(0) {
+    readHeader();
+}
+
+BinaryReader::BinaryReader(const std::string& path)
+    : mData(NULL), mSize(0), mPos(0), mMapped(NULL), mMappedSize(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw parse_exception("BinaryReader: unable to open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw parse_exception("BinaryReader: unable to stat " + path);
+    }
+    mMappedSize = st.st_size;
+    if (mMappedSize > 0) {
+        mMapped = mmap(NULL, mMappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mMapped == MAP_FAILED) {
+        mMapped = NULL;
+        throw parse_exception("BinaryReader: unable to map " + path);
+    }
+    mData = static_cast<const char*>(mMapped);
+    mSize = mMappedSize;
+    try {
+        readHeader();
+    } catch (...) {
+        if (mMapped) { munmap(mMapped, mMappedSize); }
+        throw;
+    }
+}
+
+BinaryReader::~BinaryReader() {
+    if (mMapped) { munmap(mMapped, mMappedSize); }
+}
+
+void BinaryReader::readHeader() {
+    if (mSize < sizeof(sMagic) || memcmp(mData, sMagic, sizeof(sMagic))) {
+        throw parse_exception("BinaryReader: not an iegenlib binary encoding");
+    }
+    mPos = sizeof(sMagic);
+    uint64_t version = readVarint();
+    if (version == 0 || version > BinaryWriter::version) {
+        std::stringstream ss;
+        ss << "BinaryReader: unsupported version " << version;
+        throw parse_exception(ss.str());
+    }
+    uint64_t count = readVarint();
+    if (count > mSize - mPos) {
+        throw parse_exception("BinaryReader: truncated symbol table");
+    }
+    mSymbols.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t length = readVarint();
+        if (length > mSize - mPos) {
+            throw parse_exception("BinaryReader: truncated symbol table");
+        }
+        mSymbols.push_back(std::make_pair(mPos, size_t(length)));
+        mPos += length;
+    }
+}
+
+unsigned char BinaryReader::readByte() {
+    if (mPos >= mSize) {
+        throw parse_exception("BinaryReader: unexpected end of input");
+    }
+    return (unsigned char)mData[mPos++];
+}
+
+uint64_t BinaryReader::readVarint() {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        unsigned char byte = readByte();
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) { return value; }
+    }
+    throw parse_exception("BinaryReader: malformed varint");
+}
+
+int64_t BinaryReader::readSigned() {
+    uint64_t value = readVarint();
+    return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+int BinaryReader::readInt() {
+    int64_t value = readSigned();
+    if (value != int64_t(int(value))) {
+        throw parse_exception("BinaryReader: integer out of range");
+    }
+    return int(value);
+}
+
+std::string BinaryReader::readSymbol() {
+    uint64_t id = readVarint();
+    if (id >= mSymbols.size()) {
+        throw parse_exception("BinaryReader: bad symbol index");
+    }
+    return std::string(mData + mSymbols[id].first, mSymbols[id].second);
+}
+
+char BinaryReader::nextKind() const {
+    if (mPos >= mSize) {
+        throw parse_exception("BinaryReader: no more objects");
+    }
+    return mData[mPos];
+}
+
+void BinaryReader::expectKind(char kind) {
+    if (nextKind() != kind) {
+        std::stringstream ss;
+        ss << "BinaryReader: expected '" << kind << "' but found '"
+           << nextKind() << "'";
+        throw parse_exception(ss.str());
+    }
+    mPos++;
+}
+
+Term* BinaryReader::readTerm() {
+    unsigned char tag = readByte();
+    int coeff = readInt();
+    switch (tag) {
+    case TagConst:
+        return new Term(coeff);
+    case TagTupleVar:
+        return new TupleVarTerm(coeff, int(readVarint()));
+    case TagVar:
+        return new VarTerm(coeff, readSymbol());
+    case TagUFCall: {
+        std::string name = readSymbol();
+        int index = readInt();
+        uint64_t numArgs = readVarint();
+        if (numArgs > mSize - mPos) {
+            throw parse_exception("BinaryReader: bad argument count");
+        }
+        UFCallTerm* uf = new UFCallTerm(coeff, name, numArgs, index);
+        try {
+            for (unsigned int i = 0; i < numArgs; i++) {
+                uf->setParamExp(i, readExp());
+            }
+        } catch (...) {
+            delete uf;
+            throw;
+        }
+        return uf;
+    }
+    case TagTupleExp: {
+        uint64_t size = readVarint();
+        if (size > mSize - mPos) {
+            throw parse_exception("BinaryReader: bad tuple size");
+        }
+        TupleExpTerm* te = new TupleExpTerm(coeff, size);
+        try {
+            for (unsigned int i = 0; i < size; i++) {
+                te->setExpElem(i, readExp());
+            }
+        } catch (...) {
+            delete te;
+            throw;
+        }
+        return te;
+    }
+    default:
+        throw parse_exception("BinaryReader: unknown term tag");
+    }
+}
+
+Exp* BinaryReader::readExp() {
+    uint64_t count = readVarint();
+    if (count > mSize - mPos) {
+        throw parse_exception("BinaryReader: bad term count");
+    }
+    Exp* exp = new Exp();
+    try {
+        for (uint64_t i = 0; i < count; i++) {
+            exp->addTerm(readTerm());
+        }
+    } catch (...) {
+        delete exp;
+        throw;
+    }
+    return exp;
+}
+
+Conjunction* BinaryReader::readConjunction(int arity) {
+    uint64_t size = readVarint();
+    if (size != uint64_t(arity)) {
+        throw parse_exception("BinaryReader: conjunction arity mismatch");
+    }
+    TupleDecl tdecl(arity);
+    for (int i = 0; i < arity; i++) {
+        if (readByte()) {
+            tdecl.setTupleElem(i, readInt());
+        } else {
+            tdecl.setTupleElem(i, readSymbol());
+        }
+    }
+    Conjunction* conj = new Conjunction(tdecl);
+    try {
+        uint64_t inarity = readVarint();
+        if (inarity > uint64_t(arity)) {
+            throw parse_exception("BinaryReader: bad in arity");
+        }
+        conj->setInArity(int(inarity));
+        if (readByte()) { conj->setUnsat(); }
+
+        uint64_t count = readVarint();
+        for (uint64_t i = 0; i < count; i++) {
+            conj->addEquality(readExp());
+        }
+        count = readVarint();
+        for (uint64_t i = 0; i < count; i++) {
+            conj->addInequality(readExp());
+        }
+    } catch (...) {
+        delete conj;
+        throw;
+    }
+    return conj;
+}
+
+void BinaryReader::readConjunctions(SparseConstraints* sc, int arity,
+                                    int inArity) {
+    uint64_t count = readVarint();
+    for (uint64_t i = 0; i < count; i++) {
+        Conjunction* conj = readConjunction(arity);
+        if (conj->inarity() != inArity) {
+            delete conj;
+            throw parse_exception("BinaryReader: bad in arity");
+        }
+        sc->addConjunction(conj);
+    }
+}
+
+Set* BinaryReader::readSetBody() {
+    uint64_t arity = readVarint();
+    if (arity > mSize - mPos) {
+        throw parse_exception("BinaryReader: bad arity");
+    }
+    Set* set = new Set(int(arity));
+    set->reset();
+    try {
+        readConjunctions(set, int(arity), 0);
+    } catch (...) {
+        delete set;
+        throw;
+    }
+    return set;
+}
+
+Set* BinaryReader::readSet() {
+    expectKind('S');
+    return readSetBody();
+}
+
+Relation* BinaryReader::readRelation() {
+    expectKind('R');
+    uint64_t inArity = readVarint();
+    uint64_t outArity = readVarint();
+    if (inArity + outArity > mSize - mPos) {
+        throw parse_exception("BinaryReader: bad arity");
+    }
+    Relation* rel = new Relation(int(inArity), int(outArity));
+    try {
+        readConjunctions(rel, int(inArity + outArity), int(inArity));
+    } catch (...) {
+        delete rel;
+        throw;
+    }
+    return rel;
+}
+
+Environment* BinaryReader::readEnvironment() {
+    expectKind('E');
+    Environment* env = new Environment();
+    try {
+        uint64_t count = readVarint();
+        for (uint64_t i = 0; i < count; i++) {
+            std::string name = readSymbol();
+            Set* domain = readSetBody();
+            Set* range = NULL;
+            try {
+                range = readSetBody();
+                bool bijective = readByte();
+                uint64_t mono = readVarint();
+                if (mono > Monotonic_Decreasing) {
+                    throw parse_exception("BinaryReader: bad monotonicity");
+                }
+                if (env->mUninterpFuncMap.count(name)) {
+                    throw parse_exception("BinaryReader: duplicate function "
+                                          + name);
+                }
+                env->mUninterpFuncMap[name] = new UninterpFunc(name, domain,
+                    range, bijective, MonotonicType(mono));
+            } catch (...) {
+                delete domain;
+                delete range;
+                throw;
+            }
+        }
+
+        count = readVarint();
+        for (uint64_t i = 0; i < count; i++) {
+            std::string func = readSymbol();
+            env->mInverseMap[func] = readSymbol();
+        }
+
+        count = readVarint();
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t type = readVarint();
+            if (type > TheOthers) {
+                throw parse_exception("BinaryReader: bad rule type");
+            }
+            Set* left = readSetBody();
+            Set* right = NULL;
+            try {
+                right = readSetBody();
+            } catch (...) {
+                delete left;
+                throw;
+            }
+            env->uniQuantRules.push_back(
+                new UniQuantRule(UniQuantRuleType(type), left, right));
+        }
+    } catch (...) {
+        delete env;
+        throw;
+    }
+    return env;
+}
+
+}//end namespace iegenlib
@@ -0,0 +1,150 @@
+/*!
+ * \file serialization.h
+ *
+ * \brief Compact binary encoding of Sets, Relations, and Environments.
+ *
+ * The string syntax round-trips through the parser, which dominates the
+ * time it takes to reload large dependence relations or UF environments.
+ * The binary format stores the already parsed objects instead:
+ *
+ *   file        := "IEGB" version:varint symtab object*
+ *   symtab      := count:varint (length:varint bytes)*
+ *   object      := 'S' arity:varint conjunctions
+ *                | 'R' inArity:varint outArity:varint conjunctions
+ *                | 'E' environment
+ *   conjunctions:= count:varint conjunction*
+ *   conjunction := tupledecl inarity:varint unsat:byte
+ *                  count:varint exp*  count:varint exp*
+ *   tupledecl   := size:varint (0 symbol:varint | 1 const:zigzag)*
+ *   exp         := count:varint term*
+ *   term        := 0 coeff | 1 coeff location | 2 coeff symbol
+ *                | 3 coeff symbol index:zigzag nargs exp*
+ *                | 4 coeff size exp*
+ *   environment := count:varint (symbol set set bijective:byte mono:varint)*
+ *                  count:varint (symbol symbol)*
+ *                  count:varint (type:varint set set)*
+ *
+ * Integers are LEB128 varints (signed ones zigzag encoded) and every name
+ * is an index into the symbol table, so each string is stored once.  The
+ * reader works directly on a memory buffer or an mmapped file: symbol
+ * names are not copied out of the buffer until a Term needs one.
+ *
+ * \date Started: 2026-10-19
+ *
+ * Copyright (c) 2026, University of Arizona <br>
+ * All rights reserved. <br>
+ * See ../../COPYING for details. <br>
+ */
+
+#ifndef SERIALIZATION_H_
+#define SERIALIZATION_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace iegenlib{
+
+class Conjunction;
+class Environment;
+class Exp;
+class Relation;
+class Set;
+class SparseConstraints;
+class Term;
+class TupleDecl;
+
+/*!
+ * \class BinaryWriter
+ *
+ * \brief Accumulates Sets, Relations, and Environments in the binary
+ * format.  Objects are read back in the order they were written.
+ */
+class BinaryWriter {
+public:
+    //! Version written into the header, readers reject newer versions.
+    static const unsigned version = 1;
+
+    BinaryWriter() {}
+
+    void write(const Set& set);
+    void write(const Relation& rel);
+    void write(const Environment& env);
+
+    //! The complete encoding of everything written so far.
+    std::string str() const;
+
+    //! Writes str() to the given file, throws parse_exception on failure.
+    void save(const std::string& path) const;
+
+private:
+    void writeVarint(uint64_t value);
+    void writeSigned(int64_t value);
+    void writeSymbol(const std::string& name);
+    void writeConjunctions(const SparseConstraints& sc);
+    void writeConjunction(Conjunction& conj);
+    void writeExp(const Exp& exp);
+    void writeTerm(Term* term);
+    void writeSetBody(const Set& set);
+
+    std::string mBody;
+    std::map<std::string, unsigned> mSymbolIds;
+    std::vector<std::string> mSymbols;
+};
+
+/*!
+ * \class BinaryReader
+ *
+ * \brief Decodes objects written by BinaryWriter.  Corrupt or truncated
+ * input throws parse_exception.  All returned objects belong to the caller.
+ */
+class BinaryReader {
+public:
+    //! Reads from the given buffer, which must outlive the reader.
+    BinaryReader(const char* data, size_t size);
+
+    //! Maps the given file and reads from the mapping.
+    explicit BinaryReader(const std::string& path);
+
+    ~BinaryReader();
+
+    //! True when all objects have been read.
+    bool atEnd() const { return mPos == mSize; }
+
+    //! Kind of the next object: 'S', 'R', or 'E'.
+    char nextKind() const;
+
+    Set* readSet();
+    Relation* readRelation();
+    Environment* readEnvironment();
+
+private:
+    BinaryReader(const BinaryReader&);
+    BinaryReader& operator=(const BinaryReader&);
+
+    void readHeader();
+    void expectKind(char kind);
+    unsigned char readByte();
+    uint64_t readVarint();
+    int64_t readSigned();
+    int readInt();
+    std::string readSymbol();
+    void readConjunctions(SparseConstraints* sc, int arity, int inArity);
+    Conjunction* readConjunction(int arity);
+    Exp* readExp();
+    Term* readTerm();
+    Set* readSetBody();
+
+    const char* mData;
+    size_t mSize;
+    size_t mPos;
+    void* mMapped;
+    size_t mMappedSize;
+    //! Offset and length of every symbol within the buffer.
+    std::vector<std::pair<size_t, size_t> > mSymbols;
+};
+
+}//end namespace iegenlib
+
+#endif /* SERIALIZATION_H_ */
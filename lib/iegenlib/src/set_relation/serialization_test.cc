@@ -0,0 +1,142 @@
+/*!
+ * \file serialization_test.cc
+ *
+ * \brief Tests for the BinaryWriter and BinaryReader classes.
+ *
+ * \date Started: 2026-10-19
+ *
+ * Copyright (c) 2026, University of Arizona <br>
+ * All rights reserved. <br>
+ * See ../../COPYING for details. <br>
+ */
+
+#include "serialization.h"
+#include "environment.h"
+#include "set_relation.h"
+#include <util/util.h>
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+
+using iegenlib::BinaryReader;
+using iegenlib::BinaryWriter;
+using iegenlib::Environment;
+using iegenlib::Relation;
+using iegenlib::Set;
+using iegenlib::UniQuantRule;
+using iegenlib::parse_exception;
+
+#pragma mark SetRelationRoundTrip
+TEST(SerializationTest, SetRelationRoundTrip) {
+
+    Set s1("{[i,j]: 0 <= i && i < N && rowptr(i) <= j && j < rowptr(i+1)}");
+    Set s2("{[i,3,k]: i = k+2} union {[i,3,k]: i > N}");
+    Set s3("{[x]: x = -123456789 && sigma(left(x))[1] = x}");
+    Relation r1("{[i,j]->[k]: k = col(j) && 0 <= i && i < N"
+                " && rowptr(i) <= j && j < rowptr(i+1)}");
+    Relation r2("[N] -> {[i]->[0,ip]: i < ip && ip < N}");
+
+    BinaryWriter writer;
+    writer.write(s1);
+    writer.write(r1);
+    writer.write(s2);
+    writer.write(r2);
+    writer.write(s3);
+    std::string data = writer.str();
+
+    BinaryReader reader(data.data(), data.size());
+    EXPECT_EQ('S', reader.nextKind());
+    Set* s1b = reader.readSet();
+    EXPECT_EQ(s1.prettyPrintString(), s1b->prettyPrintString());
+    EXPECT_EQ(s1.toString(), s1b->toString());
+    EXPECT_TRUE(s1 == *s1b);
+
+    EXPECT_EQ('R', reader.nextKind());
+    Relation* r1b = reader.readRelation();
+    EXPECT_EQ(r1.prettyPrintString(), r1b->prettyPrintString());
+    EXPECT_TRUE(r1 == *r1b);
+
+    Set* s2b = reader.readSet();
+    EXPECT_EQ(s2.prettyPrintString(), s2b->prettyPrintString());
+    EXPECT_EQ(2, s2b->getNumConjuncts());
+
+    Relation* r2b = reader.readRelation();
+    EXPECT_EQ(r2.prettyPrintString(), r2b->prettyPrintString());
+    EXPECT_EQ(1, r2b->inArity());
+    EXPECT_EQ(2, r2b->outArity());
+
+    Set* s3b = reader.readSet();
+    EXPECT_EQ(s3.prettyPrintString(), s3b->prettyPrintString());
+    EXPECT_TRUE(reader.atEnd());
+
+    // Each name is stored once, so the encoding is smaller than the strings.
+    EXPECT_LT(data.size(), s1.toString().size() + r1.toString().size()
+        + s2.toString().size() + r2.toString().size() + s3.toString().size());
+
+    delete s1b;
+    delete r1b;
+    delete s2b;
+    delete r2b;
+    delete s3b;
+}
+
+#pragma mark EnvironmentRoundTrip
+TEST(SerializationTest, EnvironmentRoundTrip) {
+
+    Environment env;
+    env.append(new Environment(new iegenlib::UninterpFunc("rowptr",
+        new Set("{[i]: 0 <= i && i <= N}"),
+        new Set("{[j]: 0 <= j && j <= NNZ}"),
+        false, iegenlib::Monotonic_Nondecreasing)));
+    env.append(new Environment(new iegenlib::UninterpFunc("sigma",
+        new Set("{[i]: 0 <= i && i < N}"),
+        new Set("{[j]: 0 <= j && j < N}"),
+        true, iegenlib::Monotonic_NONE)));
+    env.addUniQuantRule(new UniQuantRule("Monotonicity", "[e1,e2]",
+                                         "e1 < e2", "rowptr(e1) <= rowptr(e2)"));
+
+    BinaryWriter writer;
+    writer.write(env);
+    std::string path = "serialization_test.iegb";
+    writer.save(path);
+
+    BinaryReader reader(path);
+    Environment* envb = reader.readEnvironment();
+    EXPECT_TRUE(reader.atEnd());
+    EXPECT_EQ(env.toString(), envb->toString());
+    EXPECT_EQ("sigma_inv", envb->funcInverse("sigma"));
+    EXPECT_EQ(iegenlib::Monotonic_Nondecreasing,
+              envb->funcMonoType("rowptr"));
+    ASSERT_EQ(1, envb->getNoUniQuantRules());
+    EXPECT_EQ(env.getUniQuantRule(0)->toString(),
+              envb->getUniQuantRule(0)->toString());
+    EXPECT_EQ(iegenlib::Monotonicity, envb->getUniQuantRule(0)->getType());
+
+    delete envb;
+    std::remove(path.c_str());
+}
+
+#pragma mark CorruptInput
+TEST(SerializationTest, CorruptInput) {
+
+    EXPECT_THROW(BinaryReader("nope", 4), parse_exception);
+
+    BinaryWriter writer;
+    writer.write(Set("{[i,j]: 0 <= i && i < j && j < f(N)}"));
+    std::string data = writer.str();
+
+    // Every truncation is either detected or leaves nothing to read.
+    for (size_t len = 0; len < data.size(); len++) {
+        try {
+            BinaryReader reader(data.data(), len);
+            Set* s = reader.readSet();
+            delete s;
+            ADD_FAILURE() << "truncated to " << len << " bytes was accepted";
+        } catch (parse_exception&) {
+        }
+    }
+
+    BinaryReader reader(data.data(), data.size());
+    EXPECT_THROW(reader.readRelation(), parse_exception);
+}
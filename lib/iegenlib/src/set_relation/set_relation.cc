@@ -18,19 +18,281 @@
 #include "Visitor.h"
 #include <stack>
 #include <map>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <thread>
 #include <assert.h>
+#include <isl/constraint.h>
+#include <isl/local_space.h>
+#include <isl/space.h>
+#include <isl/val.h>
 
 namespace iegenlib{
 
 /************************ ISL helper routines ****************************/
 
+//! Long-lived isl context of the calling thread's Context, allocated on
+//  first use, see Context::isl().
+isl_ctx* islCtx(){
+  return Context::current().isl();
+}
+
+// Collects the symbolic constants used by sc into params, and checks that
+// every term can be represented in isl as is: constants, tuple variables and
+// symbolic constants over a tuple declaration without constants or repeated
+// names (the parser turns those into equalities of its own).
+static bool islAffineParams(const SparseConstraints* sc,
+                            std::vector<std::string>& params){
+  std::set<std::string> symbols;
+  for (std::list<Conjunction*>::const_iterator ci=sc->conjunctionBegin();
+       ci != sc->conjunctionEnd(); ci++){
+    TupleDecl tdecl = (*ci)->getTupleDecl();
+    std::set<std::string> names;
+    for (unsigned i = 0; i < tdecl.size(); i++){
+      if (tdecl.elemIsConst(i)) { return false; }
+      if (!names.insert(tdecl.elemVarString(i)).second) { return false; }
+    }
+    const std::vector<Exp*>* lists[2] = {&(*ci)->equalities(),
+                                       &(*ci)->inequalities()};
+    for (int l = 0; l < 2; l++){
+      for (std::vector<Exp*>::const_iterator ei=lists[l]->begin();
+           ei != lists[l]->end(); ei++){
+        std::list<Term*> terms = (*ei)->getTermList();
+        for (std::list<Term*>::const_iterator ti=terms.begin();
+             ti != terms.end(); ti++){
+          if ((*ti)->isUFCall() || (*ti)->isTupleExp()) { return false; }
+          VarTerm* var = dynamic_cast<VarTerm*>(*ti);
+          if (var) { symbols.insert(var->symbol()); }
+        }
+      }
+    }
+  }
+  params.assign(symbols.begin(), symbols.end());
+  return true;
+}
+
+// Sets the coefficients of one iegenlib constraint on an isl constraint.
+static isl_constraint* islSetTerms(isl_constraint* c, const Exp* exp,
+                           const std::map<std::string, int>& paramPos,
+                           int inArity){
+  std::list<Term*> terms = exp->getTermList();
+  for (std::list<Term*>::const_iterator ti=terms.begin();
+       ti != terms.end(); ti++){
+    Term* term = *ti;
+    if (term->isConst()){
+      c = isl_constraint_set_constant_si(c, term->coefficient());
+    } else if (TupleVarTerm* tv = dynamic_cast<TupleVarTerm*>(term)){
+      int loc = tv->tvloc();
+      if (loc < inArity){
+        c = isl_constraint_set_coefficient_si(c, isl_dim_in, loc,
+                                              term->coefficient());
+      } else {
+        c = isl_constraint_set_coefficient_si(c, isl_dim_out, loc - inArity,
+                                              term->coefficient());
+      }
+    } else if (VarTerm* var = dynamic_cast<VarTerm*>(term)){
+      c = isl_constraint_set_coefficient_si(c, isl_dim_param,
+                   paramPos.find(var->symbol())->second, term->coefficient());
+    }
+  }
+  return c;
+}
+
+/*! Translates an affine Set or Relation into an isl_map without going through
+**  strings. Sets become maps with an empty domain. Returns NULL if sc has
+**  terms isl cannot represent directly (UF calls, tuple expressions, or
+**  constants or repeated names in the tuple declaration).
+*/
+isl_map* islMapFromConstraints(const SparseConstraints* sc, int inArity,
+                               int outArity, isl_ctx* ctx){
+  std::vector<std::string> params;
+  if (!islAffineParams(sc, params)) { return NULL; }
+
+  isl_space* space = isl_space_alloc(ctx, params.size(), inArity, outArity);
+  std::map<std::string, int> paramPos;
+  for (unsigned i = 0; i < params.size(); i++){
+    space = isl_space_set_dim_name(space, isl_dim_param, i, params[i].c_str());
+    paramPos[params[i]] = i;
+  }
+
+  isl_map* map = isl_map_empty(isl_space_copy(space));
+  for (std::list<Conjunction*>::const_iterator ci=sc->conjunctionBegin();
+       ci != sc->conjunctionEnd(); ci++){
+    isl_basic_map* bmap = isl_basic_map_universe(isl_space_copy(space));
+    isl_local_space* ls = isl_local_space_from_space(isl_space_copy(space));
+    for (std::vector<Exp*>::const_iterator ei=(*ci)->equalities().begin();
+         ei != (*ci)->equalities().end(); ei++){
+      isl_constraint* c =
+          isl_constraint_alloc_equality(isl_local_space_copy(ls));
+      c = islSetTerms(c, *ei, paramPos, inArity);
+      bmap = isl_basic_map_add_constraint(bmap, c);
+    }
+    for (std::vector<Exp*>::const_iterator ei=(*ci)->inequalities().begin();
+         ei != (*ci)->inequalities().end(); ei++){
+      isl_constraint* c =
+          isl_constraint_alloc_inequality(isl_local_space_copy(ls));
+      c = islSetTerms(c, *ei, paramPos, inArity);
+      bmap = isl_basic_map_add_constraint(bmap, c);
+    }
+    isl_local_space_free(ls);
+    map = isl_map_union(map, isl_map_from_basic_map(bmap));
+  }
+  isl_space_free(space);
+
+  return map;
+}
+
+namespace {
+// State for translating the constraints of one isl_basic_map.
+struct IslConstraintReader {
+  Conjunction* conj;
+  int inArity;
+  bool ok;
+};
+
+// Reads an isl coefficient into an int, failing on rationals and overflow.
+bool islValToInt(isl_val* v, int& out){
+  bool ok = isl_val_is_int(v) && isl_val_get_den_si(v) == 1;
+  if (ok){
+    long num = isl_val_get_num_si(v);
+    ok = (num >= INT_MIN && num <= INT_MAX);
+    out = (int) num;
+  }
+  isl_val_free(v);
+  return ok;
+}
+
+isl_stat islReadConstraint(isl_constraint* c, void* user){
+  IslConstraintReader* reader = (IslConstraintReader*) user;
+  Exp* exp = new Exp();
+  int coeff;
+  enum isl_dim_type types[3] = {isl_dim_param, isl_dim_in, isl_dim_out};
+  for (int t = 0; t < 3 && reader->ok; t++){
+    int ndims = isl_constraint_dim(c, types[t]);
+    for (int i = 0; i < ndims && reader->ok; i++){
+      reader->ok = islValToInt(
+          isl_constraint_get_coefficient_val(c, types[t], i), coeff);
+      if (reader->ok && coeff != 0){
+        if (types[t] == isl_dim_param){
+          exp->addTerm(new VarTerm(coeff,
+              isl_constraint_get_dim_name(c, isl_dim_param, i)));
+        } else if (types[t] == isl_dim_in){
+          exp->addTerm(new TupleVarTerm(coeff, i));
+        } else {
+          exp->addTerm(new TupleVarTerm(coeff, reader->inArity + i));
+        }
+      }
+    }
+  }
+  if (reader->ok){
+    reader->ok = islValToInt(isl_constraint_get_constant_val(c), coeff);
+    if (reader->ok && coeff != 0) { exp->addTerm(new Term(coeff)); }
+  }
+
+  if (reader->ok && isl_constraint_is_equality(c)){
+    reader->conj->addEquality(exp);
+  } else if (reader->ok){
+    reader->conj->addInequality(exp);
+  } else {
+    delete exp;
+  }
+  isl_constraint_free(c);
+  return reader->ok ? isl_stat_ok : isl_stat_error;
+}
+
+// State for translating the basic maps of one isl_map.
+struct IslMapReader {
+  std::list<Conjunction*> conjs;
+  TupleDecl tdecl;
+  int inArity;
+  bool ok;
+};
+
+isl_stat islReadBasicMap(isl_basic_map* bmap, void* user){
+  IslMapReader* reader = (IslMapReader*) user;
+  // Local (div) variables have no iegenlib equivalent.
+  if (isl_basic_map_dim(bmap, isl_dim_div) > 0){
+    reader->ok = false;
+    isl_basic_map_free(bmap);
+    return isl_stat_error;
+  }
+  IslConstraintReader creader;
+  creader.conj = new Conjunction(reader->tdecl);
+  creader.conj->setInArity(reader->inArity);
+  creader.inArity = reader->inArity;
+  creader.ok = true;
+  isl_basic_map_foreach_constraint(bmap, islReadConstraint, &creader);
+  isl_basic_map_free(bmap);
+  reader->conjs.push_back(creader.conj);
+  reader->ok = creader.ok;
+  return creader.ok ? isl_stat_ok : isl_stat_error;
+}
+
+// Translates an isl_map back into conjunctions over tdecl (takes the map).
+bool islMapToConjunctions(isl_map* map, const TupleDecl& tdecl,
+                          int inArity, std::list<Conjunction*>& conjs){
+  IslMapReader reader;
+  reader.tdecl = tdecl;
+  reader.inArity = inArity;
+  reader.ok = true;
+  isl_map_foreach_basic_map(map, islReadBasicMap, &reader);
+  isl_map_free(map);
+  if (!reader.ok || reader.conjs.empty()){
+    for (std::list<Conjunction*>::iterator ci=reader.conjs.begin();
+         ci != reader.conjs.end(); ci++){
+      delete *ci;
+    }
+    return false;
+  }
+  conjs = reader.conjs;
+  return true;
+}
+}
+
+/*! Translates an isl_set back into a Set over the given tuple declaration
+**  (takes ownership of iset). Returns NULL if iset has local variables,
+**  non-integer or out of range coefficients, or is empty.
+*/
+Set* islSetToSet(isl_set* iset, const TupleDecl& tdecl){
+  std::list<Conjunction*> conjs;
+  if (!islMapToConjunctions(isl_map_from_range(iset), tdecl, 0, conjs)){
+    return NULL;
+  }
+  Set* result = new Set(tdecl.size());
+  for (std::list<Conjunction*>::iterator ci=conjs.begin();
+       ci != conjs.end(); ci++){
+    result->addConjunction(*ci);
+  }
+  result->cleanUp();
+  return result;
+}
+
+//! Same as islSetToSet for an isl_map and a Relation.
+Relation* islMapToRelation(isl_map* imap, const TupleDecl& tdecl,
+                           int inArity, int outArity){
+  std::list<Conjunction*> conjs;
+  if (!islMapToConjunctions(imap, tdecl, inArity, conjs)){
+    return NULL;
+  }
+  Relation* result = new Relation(inArity, outArity);
+  for (std::list<Conjunction*>::iterator ci=conjs.begin();
+       ci != conjs.end(); ci++){
+    result->addConjunction(*ci);
+  }
+  result->cleanUp();
+  return result;
+}
+
 //! Runs an Affine Set (string) through ISL and returns the resulting set
 //  as a string
 string passSetStrThruISL(string sstr){
 
-  isl_ctx *ctx = isl_ctx_alloc();
+  isl_ctx *ctx = islCtx();
   string islStr =  islSetToString ( islStringToSet(sstr,ctx), ctx );
-  isl_ctx_free(ctx);
 
   return islStr;
 }
@@ -41,9 +303,8 @@ string passSetStrThruISL(string sstr){
 //    (may have different tuple declaration)
 string passUnionSetStrThruISL(string sstr){
 
-  isl_ctx *ctx = isl_ctx_alloc();
+  isl_ctx *ctx = islCtx();
   string islStr =  islUnionSetToString ( islStringToUnionSet(sstr,ctx), ctx );
-  isl_ctx_free(ctx);
 
   return islStr;
 }
@@ -51,9 +312,8 @@ string passUnionSetStrThruISL(string sstr){
 //! Runs an Affine Relation through ISL and returns the normalized result
 string passRelationStrThruISL(string rstr){
 
-  isl_ctx *ctx = isl_ctx_alloc();
+  isl_ctx *ctx = islCtx();
   string islStr =  islMapToString ( islStringToMap(rstr,ctx), ctx );
-  isl_ctx_free(ctx);
 
   return islStr;
 }
@@ -61,9 +321,8 @@ string passRelationStrThruISL(string rstr){
 //! Runs an Affine Union Relation through ISL and returns the normalized result
 string passUnionRelationStrThruISL(string rstr){
 
-  isl_ctx *ctx = isl_ctx_alloc();
+  isl_ctx *ctx = islCtx();
   string islStr =  islUnionMapToString ( islStringToUnionMap(rstr,ctx), ctx );
-  isl_ctx_free(ctx);
 
   return islStr;
 }
@@ -71,11 +330,18 @@ string passUnionRelationStrThruISL(string rstr){
 //! Runs an Affine Set through ISL and returns the resulting normalized set
 Set* passSetThruISL(Set* s){
 
-  string sstr = s->toISLString();
+  // Translate directly when possible, this keeps the original tuple
+  // declaration so no correction is needed.
+  isl_ctx *ctx = islCtx();
+  isl_map* imap = islMapFromConstraints(s, 0, s->arity(), ctx);
+  if (imap){
+    isl_set* iset = isl_set_coalesce(isl_map_range(imap));
+    Set* result = islSetToSet(iset, s->getTupleDecl());
+    if (result) { return result; }
+  }
 
-  isl_ctx *ctx = isl_ctx_alloc();
+  string sstr = s->toISLString();
   string islStr =  islSetToString ( islStringToSet(sstr,ctx), ctx );
-  isl_ctx_free(ctx);
 
   // We need to revert changes that isl applies to Tuple Declaration because of 
   // equality constrains. We do this purely using string manipulation.
@@ -94,11 +360,17 @@ Set* passSetThruISL(Set* s){
 //! Runs an Affine Relation through ISL and returns the normalized result
 Relation* passRelationThruISL(Relation* r){
 
-  string rstr = r->toISLString();
+  // Same as passSetThruISL
+  isl_ctx *ctx = islCtx();
+  isl_map* imap = islMapFromConstraints(r, r->inArity(), r->outArity(), ctx);
+  if (imap){
+    Relation* result = islMapToRelation(isl_map_coalesce(imap),
+                          r->getTupleDecl(), r->inArity(), r->outArity());
+    if (result) { return result; }
+  }
 
-  isl_ctx *ctx = isl_ctx_alloc();
+  string rstr = r->toISLString();
   string islStr =  islMapToString ( islStringToMap(rstr,ctx), ctx );
-  isl_ctx_free(ctx);
 
   // Same as passSetThruISL
   int inArity = r->inArity(), outArity = r->outArity();
@@ -115,12 +387,11 @@ Set* islSetProjectOut(Set* s, unsigned pos) {
     string sstr = s->toISLString();
 
     // Using isl to project out tuple variable #pos
-    isl_ctx *ctx = isl_ctx_alloc();
+    isl_ctx *ctx = islCtx();
     string islStr = islSetToString ( 
                  isl_set_project_out(islStringToSet(sstr,ctx), 
                                      isl_dim_out, pos, 1), ctx 
                  );
-    isl_ctx_free(ctx);
 
     // We need to revert changes that isl applies to Tuple Declaration similar
     // to passSetThruISL. However, this is different from passSetThruISL.
@@ -143,17 +414,17 @@ Set* islSetProjectOut(Set* s, unsigned pos) {
 #pragma mark -
 /****************************** Conjunction *********************************/
 
-Conjunction::Conjunction(int arity) : mTupleDecl(arity), mInArity(0),
-                                      unsat(false){
+Conjunction::Conjunction(int arity) : mSorted(true), mTupleDecl(arity),
+                                      mInArity(0), unsat(false){
 }
 
-Conjunction::Conjunction(TupleDecl tdecl) : mTupleDecl(tdecl), mInArity(0),
-                                      unsat(false){
+Conjunction::Conjunction(TupleDecl tdecl) : mSorted(true), mTupleDecl(tdecl),
+                                      mInArity(0), unsat(false){
 }
 
 
 Conjunction::Conjunction(int arity, int inarity)
-    : mTupleDecl(arity), mInArity(inarity), unsat(false){
+    : mSorted(true), mTupleDecl(arity), mInArity(inarity), unsat(false){
 }
 
 Conjunction::Conjunction(const Conjunction& other) {
@@ -163,16 +434,17 @@ Conjunction::Conjunction(const Conjunction& other) {
 Conjunction& Conjunction::operator=(const Conjunction& other) {
     reset();
 
-    for (std::list<Exp*>::const_iterator i=other.mEqualities.begin();
+    for (std::vector<Exp*>::const_iterator i=other.mEqualities.begin();
                 i != other.mEqualities.end(); i++) {
         mEqualities.push_back((*i)->clone());
     }
 
-    for (std::list<Exp*>::const_iterator i=other.mInequalities.begin();
+    for (std::vector<Exp*>::const_iterator i=other.mInequalities.begin();
                 i != other.mInequalities.end(); i++) {
         mInequalities.push_back((*i)->clone());
     }
 
+    mSorted = other.mSorted;
     mTupleDecl = other.mTupleDecl;
     mInArity = other.mInArity;
     unsat = other.unsat;
@@ -180,17 +452,18 @@ Conjunction& Conjunction::operator=(const Conjunction& other) {
 }
 
 void Conjunction::reset() {
-    for (std::list<Exp*>::iterator i=mEqualities.begin();
+    for (std::vector<Exp*>::iterator i=mEqualities.begin();
                 i != mEqualities.end(); i++) {
         delete (*i);
     }
     mEqualities.clear();
 
-    for (std::list<Exp*>::iterator i=mInequalities.begin();
+    for (std::vector<Exp*>::iterator i=mInequalities.begin();
                 i != mInequalities.end(); i++) {
         delete (*i);
     }
     mInequalities.clear();
+    mSorted = true;
 }
 
 Conjunction::~Conjunction() {
@@ -228,8 +501,8 @@ bool Conjunction::operator<( const Conjunction& other) const {
     if (other.mInequalities.size() < mInequalities.size()) { return false; }
 
     // 4. compare sorted equalities lists
-    std::list<Exp*>::const_iterator thisIter;
-    std::list<Exp*>::const_iterator otherIter;
+    std::vector<Exp*>::const_iterator thisIter;
+    std::vector<Exp*>::const_iterator otherIter;
     otherIter = other.mEqualities.begin();
     thisIter = mEqualities.begin();
     while (thisIter != mEqualities.end()) {
@@ -314,13 +587,36 @@ void Conjunction::setTupleDecl( TupleDecl tuple_decl_in,
 }
 
 
+//! Strict weak ordering on Exp pointers, used to keep constraints sorted.
+static bool expPtrLess(const Exp* a, const Exp* b) {
+    return *a < *b;
+}
+
+/*! Inserts exp into the sorted constraint list unless an equal
+**  constraint is already there, in which case exp is deleted.
+**  Binary searches while the list is known to be sorted, otherwise
+**  walks it up to the first constraint that sorts after exp.
+*/
+static void insertConstraint(std::vector<Exp*>& list, Exp* exp, bool sorted) {
+    std::vector<Exp*>::iterator pos;
+    if (sorted) {
+        pos = std::lower_bound(list.begin(), list.end(), exp, expPtrLess);
+    } else {
+        for (pos = list.begin(); pos != list.end(); pos++) {
+            if (*exp == **pos || *exp < **pos) { break; }
+        }
+    }
+    if (pos != list.end() && *exp == **pos) {
+        delete exp;
+        return;
+    }
+    list.insert(pos, exp);
+}
+
 /*! addEquality -- add the given expression, interpreted as an
 ** equality (Exp = 0), to our list of equalities.
-** Maintains a sorted order on the constraints.
-**
-** FIXME: the check for duplicate equalities is done in O(n) time here,
-** but with a different strategy could be reduced to O(log n) time.
-**
+** Maintains a sorted order on the constraints, duplicates are found
+** in O(log n) time.
 */
 void Conjunction::addEquality(Exp* equality) {
     equality->normalizeForEquality();
@@ -332,30 +628,13 @@ void Conjunction::addEquality(Exp* equality) {
     // Setting the type of expression
     equality->setEquality();
 
-    for (std::list<Exp*>::iterator i=mEqualities.begin();
-                i != mEqualities.end(); i++) {
-        Exp* e = *i;
-
-        if(*equality == *e){
-            delete equality;
-            return;
-        }
-        if (*equality < *e) {
-            // We've found a term that belongs after the new one,
-            // so insert the new term here, and we're done.
-            mEqualities.insert(i, equality);
-            return;
-        }
-    }
-
-    mEqualities.push_back(equality);
+    insertConstraint(mEqualities, equality, mSorted);
 }
 
 /*! addInequality -- add the given expression, interpreted as an
 ** inequality (Exp >= 0), to our list of inequalities.
-**
-** FIXME: the check for duplicate inequalities is done in O(n) time here,
-** but with a different strategy could be reduced to O(log n) time.
+** Maintains a sorted order on the constraints, duplicates are found
+** in O(log n) time.
 */
 void Conjunction::addInequality(Exp* inequality) {
     if(inequality->equalsZero()){
@@ -366,22 +645,7 @@ void Conjunction::addInequality(Exp* inequality) {
     // Setting the type of expression
     inequality->setInequality();
 
-    for (std::list<Exp*>::iterator i=mInequalities.begin();
-                i != mInequalities.end(); i++) {
-        Exp* e = *i;
-
-        if(*inequality == *e){
-            delete inequality;
-            return;
-        }
-        if (*inequality < *e) {
-            // We've found a term that belongs after the new one,
-            // so insert the new exp here, and we're done.
-            mInequalities.insert(i, inequality);
-            return;
-        }
-    }
-    mInequalities.push_back(inequality);
+    insertConstraint(mInequalities, inequality, mSorted);
 }
 
 void Conjunction::substituteTupleDecl() {
@@ -415,11 +679,11 @@ void Conjunction::substituteTupleDecl() {
     }
 
     // perform the substitution on all our constraints
-    for (std::list<Exp*>::iterator expIter=mEqualities.begin();
+    for (std::vector<Exp*>::iterator expIter=mEqualities.begin();
                 expIter != mEqualities.end(); expIter++) {
         (*expIter)->substitute(var2TupleVar);
     }
-    for (std::list<Exp*>::iterator expIter=mInequalities.begin();
+    for (std::vector<Exp*>::iterator expIter=mInequalities.begin();
                 expIter != mInequalities.end(); expIter++) {
         (*expIter)->substitute(var2TupleVar);
     }
@@ -434,11 +698,13 @@ void Conjunction::substituteTupleDecl() {
 **  from source, and add them to our own constraints.
 */
 void Conjunction::copyConstraintsFrom(const Conjunction *source) {
-    for (std::list<Exp*>::const_iterator expIter=source->mEqualities.begin();
+    // Appending may break the sort order until the next cleanUp.
+    mSorted = false;
+    for (std::vector<Exp*>::const_iterator expIter=source->mEqualities.begin();
                 expIter != source->mEqualities.end(); expIter++) {
         mEqualities.push_back((*expIter)->clone());
     }
-    for (std::list<Exp*>::const_iterator expIter=source->mInequalities.begin();
+    for (std::vector<Exp*>::const_iterator expIter=source->mInequalities.begin();
                 expIter != source->mInequalities.end(); expIter++) {
         mInequalities.push_back((*expIter)->clone());
     }
@@ -453,7 +719,7 @@ void Conjunction::copyConstraintsFrom(const Conjunction *source) {
 void Conjunction::substituteInConstraints(SubMap& searchTermToSubExp) {
 
     // straight-forward substitution into equalities
-    std::list<Exp*>::iterator expIter=mEqualities.begin();
+    std::vector<Exp*>::iterator expIter=mEqualities.begin();
     while (expIter != mEqualities.end()) {
         (*expIter)->substitute(searchTermToSubExp);
         expIter++;
@@ -475,14 +741,14 @@ std::string Conjunction::toString() const {
     ss << "{ " << mTupleDecl.toString(true,mInArity);
 
     bool first = true;
-    for (std::list<Exp*>::const_iterator i=mEqualities.begin();
+    for (std::vector<Exp*>::const_iterator i=mEqualities.begin();
                 i != mEqualities.end(); i++) {
         if (not first) { ss << " && "; }
         else { ss << " : ";  first = false; }
         ss << (*i)->toString() << " = 0";
     }
 
-    for (std::list<Exp*>::const_iterator i=mInequalities.begin();
+    for (std::vector<Exp*>::const_iterator i=mInequalities.begin();
                 i != mInequalities.end(); i++) {
         if (not first) { ss << " && "; }
         else { ss << " : ";  first = false; }
@@ -508,11 +774,11 @@ std::string Conjunction::prettyPrintString() const {
         TupleVarTerm *tv = new TupleVarTerm(i);
 
         // perform the substitution on all our constraints
-        for (std::list<Exp*>::const_iterator expIter=dup->mEqualities.begin();
+        for (std::vector<Exp*>::const_iterator expIter=dup->mEqualities.begin();
                 expIter != dup->mEqualities.end(); expIter++) {
             (*expIter)->substitute(varExp->clone(), *tv);
         }
-        for (std::list<Exp*>::const_iterator expIter=dup->mInequalities.begin();
+        for (std::vector<Exp*>::const_iterator expIter=dup->mInequalities.begin();
                 expIter != dup->mInequalities.end(); expIter++) {
             (*expIter)->substitute(varExp->clone(), *tv);
         }
@@ -522,14 +788,14 @@ std::string Conjunction::prettyPrintString() const {
 */
 
     dup->cleanUp();
-    for (std::list<Exp*>::const_iterator i = dup->mEqualities.begin();
+    for (std::vector<Exp*>::const_iterator i = dup->mEqualities.begin();
                 i != dup->mEqualities.end(); i++) {
         if (not first) { ss << " && "; }
         else { ss << " : ";  first = false; }
         ss << (*i)->prettyPrintString(mTupleDecl)<< " = 0";
     }
 
-    for (std::list<Exp*>::const_iterator i = dup->mInequalities.begin();
+    for (std::vector<Exp*>::const_iterator i = dup->mInequalities.begin();
                 i != dup->mInequalities.end(); i++) {
         if (not first) { ss << " && "; }
         else { ss << " : ";  first = false; }
@@ -563,7 +829,7 @@ std::string Conjunction::toDotString(int & next_id) const
         int eq_node = next_id++;
         result << self_id << "->" << eq_node << ";\n";
         result << eq_node << " [label = \"Equalities\\n... = 0\"];\n";
-        for (std::list<Exp*>::const_iterator i=mEqualities.begin();
+        for (std::vector<Exp*>::const_iterator i=mEqualities.begin();
                 i != mEqualities.end(); i++) {
             // recursively call on expressions
             result << (*i)->toDotString(eq_node,next_id);
@@ -575,7 +841,7 @@ std::string Conjunction::toDotString(int & next_id) const
         int ineq_node = next_id++;
         result << self_id << "->" << ineq_node << ";\n";
         result << ineq_node << " [label = \"Inequalities\\n... >= 0\"];\n";
-        for (std::list<Exp*>::const_iterator i=mInequalities.begin();
+        for (std::vector<Exp*>::const_iterator i=mInequalities.begin();
                 i != mInequalities.end(); i++) {
             // recursively call on expressions
             result << (*i)->toDotString(ineq_node,next_id);
@@ -619,7 +885,7 @@ StringIterator* Conjunction::getSymbolIterator() const {
     std::set<std::string> symbolSet;
 
     // Collect symbols from equalities
-    for (std::list<Exp*>::const_iterator i=mEqualities.begin();
+    for (std::vector<Exp*>::const_iterator i=mEqualities.begin();
             i != mEqualities.end(); i++) {
         // recursively call on expressions
         StringIterator* subSymIter = (*i)->getSymbolIterator();
@@ -630,7 +896,7 @@ StringIterator* Conjunction::getSymbolIterator() const {
     }
 
     // Collect symbols from inequalities
-    for (std::list<Exp*>::const_iterator i=mInequalities.begin();
+    for (std::vector<Exp*>::const_iterator i=mInequalities.begin();
             i != mInequalities.end(); i++) {
         // recursively call on expressions
         StringIterator* subSymIter = (*i)->getSymbolIterator();
@@ -867,7 +1133,7 @@ void Conjunction::pushConstConstraintsToTupleDecl() {
 
     // loop through own equality constraints to find
     // when tuple vars are equal to constants.
-    for (std::list<Exp*>::const_iterator iter=mEqualities.begin();
+    for (std::vector<Exp*>::const_iterator iter=mEqualities.begin();
                 iter != mEqualities.end(); iter++ ) {
         Exp* e = *iter;
         
@@ -903,7 +1169,7 @@ void Conjunction::pushConstConstraintsToTupleDecl() {
     }
     
     // Finally remove all those constant equality expressions.
-    for (std::list<Exp*>::iterator iter=mEqualities.begin();
+    for (std::vector<Exp*>::iterator iter=mEqualities.begin();
                 iter != mEqualities.end(); ) {
         Exp* e = *iter;
         if (equalitiesToRemove.find(*e)!=equalitiesToRemove.end()) {
@@ -1043,7 +1309,7 @@ Exp *Conjunction::findFunction(int tupleLocToFind, int startTupleRange,
 
     // Otherwise, search all our equalities for one that can
     // be solved for this tuple element.
-    for (std::list<Exp*>::const_iterator i=mEqualities.begin();
+    for (std::vector<Exp*>::const_iterator i=mEqualities.begin();
                 i != mEqualities.end(); i++) {
         TupleVarTerm *factor = new TupleVarTerm(tupleLocToFind);
         Exp *solution = (*i)->solveForFactor(factor);
@@ -1096,7 +1362,7 @@ Exp *Conjunction::findAndRemoveFunction(int tupleLocToFind,
 
     // Otherwise, search all our equalities for one that can
     // be solved for this tuple element.
-    for (std::list<Exp*>::iterator i=mEqualities.begin();
+    for (std::vector<Exp*>::iterator i=mEqualities.begin();
                 i != mEqualities.end(); i++) {
         TupleVarTerm *factor = new TupleVarTerm(tupleLocToFind);
         Exp *solution = (*i)->solveForFactor(factor);
@@ -1138,15 +1404,19 @@ Exp *Conjunction::findAndRemoveFunction(int tupleLocToFind,
 **  of -1 means that old location goes away entirely.
 */
 void Conjunction::remapTupleVars(const std::vector<int>& oldToNewLocs) {
+    // Remapping changes the constraints in place, so they may be out of
+    // order until the next cleanUp.
+    mSorted = false;
+
     // Remap tuple variables in our equalities.
-    for (std::list<Exp*>::iterator i=mEqualities.begin();
+    for (std::vector<Exp*>::iterator i=mEqualities.begin();
                 i != mEqualities.end(); i++) {
         (*i)->remapTupleVars(oldToNewLocs);
         (*i)->normalizeForEquality();
     }
 
     // Remap tuple variables in our inequalities.
-    for (std::list<Exp*>::iterator i=mInequalities.begin();
+    for (std::vector<Exp*>::iterator i=mInequalities.begin();
                 i != mInequalities.end(); i++) {
         (*i)->remapTupleVars(oldToNewLocs);
     }
@@ -1206,11 +1476,11 @@ Conjunction* Conjunction::Intersect(const Conjunction* rhs) const {
     Conjunction* retval = new Conjunction(*this);
 
     // then get equalities and equalities from rhs
-    for (std::list<Exp*>::const_iterator i=rhs->mEqualities.begin();
+    for (std::vector<Exp*>::const_iterator i=rhs->mEqualities.begin();
             i != rhs->mEqualities.end(); i++) {
         retval->addEquality((*i)->clone());
     }
-    for (std::list<Exp*>::const_iterator i=rhs->mInequalities.begin();
+    for (std::vector<Exp*>::const_iterator i=rhs->mInequalities.begin();
             i != rhs->mInequalities.end(); i++ ) {
         retval->addInequality((*i)->clone());
     }
@@ -1265,7 +1535,7 @@ Conjunction* Conjunction::boundTupleExp(const TupleExpTerm& tuple_exp) const {
 // not satisfiable.  For now just checking for constant equalities.
 bool Conjunction::satisfiable() const {
 
-    for (std::list<Exp*>::const_iterator i=mEqualities.begin();
+    for (std::vector<Exp*>::const_iterator i=mEqualities.begin();
             i != mEqualities.end(); i++) {
         if ( (*i)->isContradiction() ) {
             return false;
@@ -1282,9 +1552,14 @@ bool Conjunction::satisfiable() const {
 
 void Conjunction::cleanUp() {
 
-    // Remove zero equalities, normalize, and remove nested inverse funcs
-    for (std::list<Exp*>::iterator i=mEqualities.begin();
-            i != mEqualities.end(); ) {
+    // Normalize, remove nested inverse funcs, and then add the equalities
+    // back so they are added in order and duplicates are eliminated.
+    // addEquality drops the ones that are equal to zero.
+    std::vector<Exp*> equalityListCopy;
+    equalityListCopy.swap(mEqualities);
+    mSorted = true;
+    for (std::vector<Exp*>::iterator i=equalityListCopy.begin();
+            i != equalityListCopy.end(); i++) {
 
         // make first term positive
         (*i)->normalizeForEquality();
@@ -1294,47 +1569,20 @@ void Conjunction::cleanUp() {
         (*i) = temp->collapseNestedInvertibleFunctions();
         delete temp;
 
-        // remove zero expressions
-        if((*i)->equalsZero()){
-            std::list<Exp*>::iterator old = i;
-            i++;
-            delete *old;
-            mEqualities.erase(old);
-        } else { i++; }
-    }
-
-    // copy the current list of equalities and then add then
-    // so they are added in order and duplicates are eliminated
-    std::list<Exp*> equalityListCopy = mEqualities;
-    mEqualities.clear();
-    for (std::list<Exp*>::iterator i=equalityListCopy.begin();
-            i != equalityListCopy.end(); i++) {
         this->addEquality(*i);
     }
 
-    // Remove zero inequalities
-    for (std::list<Exp*>::iterator i=mInequalities.begin();
-            i != mInequalities.end(); ) {
+    // Same for the inequalities.
+    std::vector<Exp*> inequalityListCopy;
+    inequalityListCopy.swap(mInequalities);
+    for (std::vector<Exp*>::iterator i=inequalityListCopy.begin();
+            i != inequalityListCopy.end(); i++) {
 
          // get rid of nested inverse funcs like f( f_inv( i ) )
         Exp* temp = (*i);
         (*i) = temp->collapseNestedInvertibleFunctions();
         delete temp;
 
-        if((*i)->equalsZero()){
-            std::list<Exp*>::iterator old = i;
-            i++;
-            delete *old;
-            mInequalities.erase(old);
-        } else { i++; }
-    }
-
-    // copy the current list of inequalities and then add then
-    // so they are added in order and duplicates are eliminated
-    std::list<Exp*> inequalityListCopy = mInequalities;
-    mInequalities.clear();
-    for (std::list<Exp*>::iterator i=inequalityListCopy.begin();
-            i != inequalityListCopy.end(); i++) {
         this->addInequality(*i);
     }
 
@@ -1349,7 +1597,7 @@ void Conjunction::groupIndexedUFCalls() {
     // loop over all equalities in conjunction and gather up
     // all indexed UFCall return expressions (i.e. what they are equal to)
     std::map<UFCallTerm,std::map<int,Exp*> > ufcallAndIndex2Exp;
-    for (std::list<Exp*>::iterator i=mEqualities.begin();
+    for (std::vector<Exp*>::iterator i=mEqualities.begin();
                 i != mEqualities.end(); ) {
         Exp* e = (*i);
 
@@ -1452,6 +1700,17 @@ SparseConstraints::operator=(const SparseConstraints& other) {
     return *this;
 }
 
+void SparseConstraints::adoptConjunctions(SparseConstraints& other) {
+    reset();
+    std::list<Conjunction*> adopted;
+    adopted.swap(other.mConjunctions);
+    for (std::list<Conjunction*>::iterator i=adopted.begin();
+                i != adopted.end(); i++) {
+        this->addConjunction(*i);
+    }
+    this->cleanUp();
+}
+
 /*! Less than operator.
 **      Compare two SparseConstraints in the following order:
 **          1. by number of conjunctions: number of Conjunctions in mConjunctions
@@ -1764,15 +2023,15 @@ std::set<Exp> SparseConstraints::constraintsDifference(SparseConstraints* A){
 
   std::set<Exp> diffSet;
 
-  const std::list<Exp*> eqB = conjB->equalities();
-  const std::list<Exp*> ineqB = conjB->inequalities();
-  const std::list<Exp*> eqA = conjA->equalities();
-  const std::list<Exp*> ineqA = conjA->inequalities();
+  const std::vector<Exp*> eqB = conjB->equalities();
+  const std::vector<Exp*> ineqB = conjB->inequalities();
+  const std::vector<Exp*> eqA = conjA->equalities();
+  const std::vector<Exp*> ineqA = conjA->inequalities();
 
   int found = 0;
-  for (std::list<Exp*>::const_iterator it=eqB.begin(); it != eqB.end(); it++){
+  for (std::vector<Exp*>::const_iterator it=eqB.begin(); it != eqB.end(); it++){
     found = 0;
-    for (std::list<Exp*>::const_iterator jt=eqA.begin(); jt != eqA.end(); jt++){
+    for (std::vector<Exp*>::const_iterator jt=eqA.begin(); jt != eqA.end(); jt++){
       if( (*(*it)) == (*(*jt)) ){ 
         found = 1;
         break;
@@ -1783,9 +2042,9 @@ std::set<Exp> SparseConstraints::constraintsDifference(SparseConstraints* A){
     }  
   }
 
-  for (std::list<Exp*>::const_iterator it=ineqB.begin(); it != ineqB.end(); it++){
+  for (std::vector<Exp*>::const_iterator it=ineqB.begin(); it != ineqB.end(); it++){
     found = 0;
-    for (std::list<Exp*>::const_iterator jt=ineqA.begin(); jt != ineqA.end(); jt++){
+    for (std::vector<Exp*>::const_iterator jt=ineqA.begin(); jt != ineqA.end(); jt++){
       if( (*(*it)) == (*(*jt)) ){ 
         found = 1;
         break;
@@ -1807,7 +2066,8 @@ std::set<Exp> SparseConstraints::constraintsDifference(SparseConstraints* A){
 /********************************** Set ***************************************/
 Set::Set(std::string str) {
     Set* s = parser::parse_set(str); // parse string
-    *this = *s; // copy created Set
+    mArity = s->mArity;
+    adoptConjunctions(*s); // take over created Set's conjunctions
     delete s;
 }
 
@@ -2000,7 +2260,9 @@ void Set::normalize() {
 /******************************** Relation ************************************/
 Relation::Relation(std::string str) {
     Relation* r = parser::parse_relation(str); // parse relation
-    *this = *r; // copy created Relation
+    mInArity = r->mInArity;
+    mOutArity = r->mOutArity;
+    adoptConjunctions(*r); // take over created Relation's conjunctions
     delete r;
 }
 
@@ -2348,9 +2610,11 @@ void Relation::normalize() {
 
 //! Visitor design pattern, see Visitor.h for usage
 void Conjunction::acceptVisitor(Visitor *v) {
+    // Visitors may modify the constraints in place.
+    mSorted = false;
     v->preVisitConjunction(this);
     
-    std::list<Exp*>::iterator expIter = mEqualities.begin();
+    std::vector<Exp*>::iterator expIter = mEqualities.begin();
     while (expIter != mEqualities.end()) {
         (*expIter)->acceptVisitor(v);
         expIter++;
@@ -2449,6 +2713,7 @@ class VisitorIsUFCallParam : public Visitor {
     bool prevSeen;
 
   public:
+    bool mutatesTerms() const { return false; }
     VisitorIsUFCallParam(int tupleID) : mResult(false),
                  mTupleID(tupleID), mSeenTupleVar(false), prevSeen(false) {}
 
@@ -2529,7 +2794,8 @@ void VisitorBoundDomainRange::preVisitUFCallTerm(UFCallTerm * t){
     // Create a TupleExpTerm from the parameter expressions.
     TupleExpTerm tuple_exp(uf_call->numArgs());
     for (unsigned int count=0; count<uf_call->numArgs(); count++) {
-        tuple_exp.setExpElem(count, uf_call->getParamExp(count)->clone());
+        tuple_exp.setExpElem(count,
+            ((const UFCallTerm*)uf_call)->getParamExp(count)->clone());
     }
 
     // look up bound for uninterpreted function
@@ -2659,6 +2925,7 @@ class VisitorSuperAffineSet : public Visitor {
          int ufcDepth;     // Helps us to recognize nested UFCs,
                            // since we do not want to iterate inside UFC arguments
   public:
+         bool mutatesTerms() const { return false; }
          VisitorSuperAffineSet(UFCallMap* imap){ufcmap = imap;}
          // We do not change any type of Term except for UFCallTerm
          void preVisitTerm(Term * t) {
@@ -2710,13 +2977,13 @@ class VisitorSuperAffineSet : public Visitor {
                  ufcDepth--;   // Consider the fact that UFCs can be nested
                  return;
              }
-             Exp* CaffineExp = affineExp->clone();
+             // The conjunction takes over affineExp
              if( e->isInequality() ){
-                 affineConj->addInequality( CaffineExp );
+                 affineConj->addInequality( affineExp );
              }else{
-                 affineConj->addEquality( CaffineExp );
+                 affineConj->addEquality( affineExp );
              }
-             delete affineExp;
+             affineExp = NULL;
          }
          //! Initializes an affineConj
          void preVisitConjunction(iegenlib::Conjunction * c){
@@ -2832,6 +3099,7 @@ class VisitorReverseAffineSubstitution : public Visitor {
          Exp* nonAffineExp;
          bool visit;       // helps to know which Exp is UFC argument
   public:
+         bool mutatesTerms() const { return false; }
          VisitorReverseAffineSubstitution(UFCallMap* imap){ufcmap = imap;}
 
          /*! We iterate over terms in Exp, if the term is not a VarTerm
@@ -2970,6 +3238,7 @@ class VisitorProjectOut : public Visitor {
     Relation* newRelation;
     std::list<Conjunction*> mNewConj;
   public:
+    bool mutatesTerms() const { return false; }
     VisitorProjectOut(int itvar, int ia=0){
         tvar = itvar;
         // Adjust inArity for after projection
@@ -3151,6 +3420,7 @@ class VisitorNumUFCallConstsMustRemove : public Visitor {
     int count;
 
   public:
+    bool mutatesTerms() const { return false; }
     VisitorNumUFCallConstsMustRemove(int tupleID, std::set<Exp>& iignore)
                   : mTupleID(tupleID), ignore(iignore),   
                   seenTupleVar(false), UFCLevel(0), count(0){}
@@ -3218,6 +3488,7 @@ class VisitorRemoveUFCallConsts : public Visitor {
     std::list<Conjunction*> mRedConj;
 
   public:
+    bool mutatesTerms() const { return false; }
     VisitorRemoveUFCallConsts(int tupleID)
                   : mTupleID(tupleID), seenTupleVar(false), UFCLevel(0){}
 
@@ -3419,11 +3690,12 @@ class VisitorGatherAllParameters : public Visitor {
     std::set<Exp> instExps; 
 
   public:
+    bool mutatesTerms() const { return false; }
     VisitorGatherAllParameters(){}
     virtual ~VisitorGatherAllParameters(){}
 
     void preVisitUFCallTerm(UFCallTerm * t){
-        instExps.insert( *(t->getParamExp(0)) );
+        instExps.insert( *(((const UFCallTerm*)t)->getParamExp(0)) );
     }
 
     std::set<Exp> getExps() { 
@@ -3484,6 +3756,8 @@ std::pair <std::string,std::string> instantiate(
   srParts subLeftSideParts, subRightSideParts;
   subLeftSideParts = getPartsFromStr(supAffLeft->prettyPrintString());
   subRightSideParts = getPartsFromStr(supAffRight->prettyPrintString());
+  delete supAffLeft;
+  delete supAffRight;
   subLeftSideParts.constraints = trim(subLeftSideParts.constraints);
   subRightSideParts.constraints = trim(subRightSideParts.constraints);
   std::string leftStr = "false", rightStr = "false";
@@ -3548,22 +3822,30 @@ isl_set* instantiationSet( srParts supSetParts,
   // there might be some unusual example, we put a cap (up to 2 times), so
   // we would never end up looping many times even in rare occasions. 
   isl_set* set = isl_set_read_from_str(ctx, origRel.c_str() );
+
+  // Each side of each instantiation is read once, and copied for every
+  // use in the passes below.
+  std::vector<isl_set*> antecedents, consequents;
+  for (std::set<std::pair <std::string,std::string>>::iterator 
+        it=instantiations.begin(); it!=instantiations.end(); it++){ 
+    string antecedentStr = syms + "{" + supSetParts.tupDecl + 
+                           " : " + (*it).first + "}";
+    string consequentStr = syms + "{" + supSetParts.tupDecl + 
+                           " : " + (*it).second + "}";
+    antecedents.push_back(isl_set_read_from_str(ctx, antecedentStr.c_str()));
+    consequents.push_back(isl_set_read_from_str(ctx, consequentStr.c_str()));
+  }
+
   isl_set* old_set = isl_set_copy(set);
   for (int i = 0; i < 2; i++) {
-    for (std::set<std::pair <std::string,std::string>>::iterator 
-          it=instantiations.begin(); it!=instantiations.end(); it++){ 
-      string antecedentStr = syms + "{" + supSetParts.tupDecl + 
-                             " : " + (*it).first + "}";
-      string consequentStr = syms + "{" + supSetParts.tupDecl + 
-                             " : " + (*it).second + "}";
+    for (size_t j = 0; j < antecedents.size(); j++){ 
       // If antecedent is true add the consequent of the instantiation
       int added = 0;
       {
-        isl_set* ant_set = isl_set_read_from_str(ctx, antecedentStr.c_str());
+        isl_set* ant_set = isl_set_copy(antecedents[j]);
         ant_set = isl_set_gist(ant_set, isl_set_copy(set));
         if (isl_set_plain_is_universe(ant_set)) {
-          isl_set* con_set = isl_set_read_from_str(ctx, consequentStr.c_str());
-          set = isl_set_intersect(set, con_set);
+          set = isl_set_intersect(set, isl_set_copy(consequents[j]));
           set = isl_set_coalesce(set);
           added = 1;
         }
@@ -3571,12 +3853,10 @@ isl_set* instantiationSet( srParts supSetParts,
       }
       // If complement of consequent is true add the complement of antecedent 
       if (!added) {
-        isl_set* con_set = isl_set_read_from_str(ctx, consequentStr.c_str());
-        con_set = isl_set_complement(con_set);
+        isl_set* con_set = isl_set_complement(isl_set_copy(consequents[j]));
         con_set = isl_set_gist(con_set, isl_set_copy(set));
         if (isl_set_plain_is_universe(con_set)) {
-          isl_set* ant_set = isl_set_read_from_str(ctx, antecedentStr.c_str());
-          ant_set = isl_set_complement(ant_set);
+          isl_set* ant_set = isl_set_complement(isl_set_copy(antecedents[j]));
           set = isl_set_intersect(set, ant_set);
           set = isl_set_coalesce(set);
           added = 1;
@@ -3591,6 +3871,11 @@ isl_set* instantiationSet( srParts supSetParts,
       old_set = isl_set_copy(set);
     }
   }
+  isl_set_free(old_set);
+  for (size_t j = 0; j < antecedents.size(); j++){ 
+    isl_set_free(antecedents[j]);
+    isl_set_free(consequents[j]);
+  }
 
   return set;
 }
@@ -3602,26 +3887,41 @@ Set* checkIslSet(isl_set* set, isl_ctx* ctx,
                       UFCallMap *ufcmap, Set *origSet ){
   Set *result = NULL;
   if( isl_set_is_empty(set) ){
+    isl_set_free(set);
     result = NULL;
   } else {
     isl_basic_set *bset = isl_set_affine_hull(set);
-    // Get an isl printer and associate to an isl context
-    isl_printer * ip = isl_printer_to_str(ctx);
-    // get string back from ISL set
-    isl_printer_set_output_format(ip , ISL_FORMAT_ISL);
-    isl_printer_print_basic_set(ip ,bset);
-    char *i_str = isl_printer_get_str(ip);
-    // clean-up
-    isl_printer_flush(ip);
-    isl_printer_free(ip);
+    // The isl set was built over the original tuple, so its dimensions
+    // can be read back directly unless the tuple has constants.
+    Set* affineEqs = NULL;
+    TupleDecl tdecl = origSet->getTupleDecl();
+    bool hasConst = false;
+    for (unsigned i = 0; i < tdecl.size(); i++){
+      hasConst = hasConst || tdecl.elemIsConst(i);
+    }
+    if (!hasConst){
+      affineEqs = islSetToSet(
+                    isl_set_from_basic_set(isl_basic_set_copy(bset)), tdecl);
+    }
+    if (!affineEqs){
+      // Get an isl printer and associate to an isl context
+      isl_printer * ip = isl_printer_to_str(ctx);
+      // get string back from ISL set
+      isl_printer_set_output_format(ip , ISL_FORMAT_ISL);
+      isl_printer_print_basic_set(ip ,bset);
+      char *i_str = isl_printer_get_str(ip);
+      // clean-up
+      isl_printer_flush(ip);
+      isl_printer_free(ip);
+      affineEqs = new Set(i_str);
+      free(i_str);
+    }
     isl_basic_set_free(bset);
     // Puting the newly found equalities into original constraint set.
-    Set* affineEqs = new Set(i_str);
     Set* eQs = affineEqs->reverseAffineSubstitution(ufcmap);
     result = origSet->Intersect(eQs);
     delete affineEqs;
     delete eQs;
-    //free(i_str);
   }
   return result;
 }
@@ -3641,27 +3941,42 @@ std::set<std::pair <std::string,std::string>> ruleInstantiation
   int noAvalRules = queryNoUniQuantRules();
   UniQuantRule* uqRule;
   std::set<std::pair <std::string,std::string>> instantiations;
-  // If no rules are explicitly specified, we instantiate all of them  
-  if (!useRule){
-    useRule = new bool[ TheOthers ];
-    for(int i = 0 ; i < TheOthers ; i++ ){ useRule[i] = 1; } 
+  // Instantiations already built under the current environment are
+  // reused, only new (rule, e1, e2) candidates are instantiated.
+  SatCache& cache = Context::current().env().satCache();
+  std::string tupleKey = origTupleDecl.toString();
+  std::vector<std::string> expKeys;
+  for (std::set<Exp>::iterator it=instExps.begin(); 
+           it!=instExps.end(); it++){
+    expKeys.push_back(it->toString());
   }
-  // Instantiating the universially quantified rules available 
-  // in the environment one by one, for the ones we want to check
   for(int i = 0 ; i < noAvalRules ; i++ ){
 
     // Query rule No. i from environment
     uqRule = queryUniQuantRuleEnv(i);
-    // If we do not want to instantiate this rule move on to next one
-    if( !(useRule[uqRule->getType()]) ) continue;
+    // If we do not want to instantiate this rule move on to next one,
+    // if no rules are explicitly specified, we instantiate all of them  
+    if( useRule && !(useRule[uqRule->getType()]) ) continue;
     // Go over our Expression Set (E), and replace uni. quant. vars.
     // in the rule with these expressions.
+    std::ostringstream ruleKey;
+    ruleKey << i << ':' << tupleKey;
+    size_t k1 = 0;
     for (std::set<Exp>::iterator it1=instExps.begin(); 
-             it1!=instExps.end(); it1++){
+             it1!=instExps.end(); it1++, k1++){
+      size_t k2 = 0;
       for (std::set<Exp>::iterator it2=instExps.begin(); 
-               it2!=instExps.end(); it2++){
-        instantiations.insert(instantiate(uqRule,*it1,*it2,
-                              ufcmap,origTupleDecl));
+               it2!=instExps.end(); it2++, k2++){
+        std::string key = ruleKey.str() + ':' + expKeys[k1] + 
+                          ':' + expKeys[k2];
+        std::pair <std::string,std::string> inst;
+        if (!cache.findInstantiation(key, inst, ufcmap)) {
+          UFCallMap ufcalls;
+          inst = instantiate(uqRule,*it1,*it2,&ufcalls,origTupleDecl);
+          cache.addInstantiation(key, inst, ufcalls);
+          ufcmap->merge(ufcalls);
+        }
+        instantiations.insert(inst);
       }
     }
   }
@@ -3670,6 +3985,17 @@ std::set<std::pair <std::string,std::string>> ruleInstantiation
 }
 
 
+// Prefix of the SatCache keys that records which rule types useRule
+// selects, NULL selects all of them.
+static std::string useRuleKey(bool *useRule){
+  std::string key(TheOthers + 2, '1');
+  if (useRule) {
+    for (int i = 0 ; i <= TheOthers ; i++ ){ key[i] = useRule[i] ? '1' : '0'; }
+  }
+  key[TheOthers + 1] = ':';
+  return key;
+}
+
 // Detect UnSat or MaySat for the set utilizing domain information 
 // that are stored as universally quantified rules in the environment.
 // To utilize the domain information, the function first gathers all 
@@ -3681,24 +4007,32 @@ std::set<std::pair <std::string,std::string>> ruleInstantiation
 // adds them the original relation and returns the result.
 Set* Set::detectUnsatOrFindEqualities(bool *useRule){
 
+  // Closely related sets are checked over and over during dependence
+  // testing, so results are cached under the current environment.
+  SatCache& cache = Context::current().env().satCache();
+  std::string key = useRuleKey(useRule) + prettyPrintString();
+  Set *result = NULL;
+  if (cache.findSet(key, result)) { return result; }
+
   // Gather all UFCall Parameters for Expression Set (E) for rule instantiation
-  VisitorGatherAllParameters *vGE = new VisitorGatherAllParameters;
-  this->acceptVisitor(vGE);
-  std::set<Exp> instExps = vGE->getExps();
+  VisitorGatherAllParameters vGE;
+  this->acceptVisitor(&vGE);
+  std::set<Exp> instExps = vGE.getExps();
   // Generate all instantiations of universialy quantified rules
   TupleDecl origTupleDecl = getTupleDecl();
   std::set<std::pair <std::string,std::string>> instantiations;
-  UFCallMap *ufcmap = new UFCallMap();
-  instantiations = ruleInstantiation(instExps, useRule, origTupleDecl, ufcmap);
+  UFCallMap ufcmap;
+  instantiations = ruleInstantiation(instExps, useRule, origTupleDecl, &ufcmap);
   // Use ISL to add useful instantiations, refer to instantiationSet
-  Set *supAffSet = superAffineSet(ufcmap);
+  Set *supAffSet = superAffineSet(&ufcmap);
   srParts supSetParts = getPartsFromStr(supAffSet->prettyPrintString());
-  isl_ctx* ctx = isl_ctx_alloc();
-  string syms = symsForInstantiationSet(boundDomainRange(), ufcmap);
+  delete supAffSet;
+  isl_ctx* ctx = islCtx();
+  string syms = symsForInstantiationSet(boundDomainRange(), &ufcmap);
   isl_set* set = instantiationSet(supSetParts, instantiations, syms, ctx);
-  Set *result = checkIslSet(set, ctx, ufcmap, this);
-  //isl_ctx_free(ctx);
+  result = checkIslSet(set, ctx, &ufcmap, this);
 
+  cache.addSet(key, result);
   return result;
 }
 
@@ -3706,16 +4040,21 @@ Set* Set::detectUnsatOrFindEqualities(bool *useRule){
 // Same as Set
 Relation* Relation::detectUnsatOrFindEqualities(bool *useRule){
 
+  SatCache& cache = Context::current().env().satCache();
+  std::string key = useRuleKey(useRule) + prettyPrintString();
+  Relation *result = NULL;
+  if (cache.findRelation(key, result)) { return result; }
+
   // Gather all UFCall Parameters for Expression Set (E) for rule instantiation
-  VisitorGatherAllParameters *vGE = new VisitorGatherAllParameters;
-  this->acceptVisitor(vGE);
-  std::set<Exp> instExps = vGE->getExps();
+  VisitorGatherAllParameters vGE;
+  this->acceptVisitor(&vGE);
+  std::set<Exp> instExps = vGE.getExps();
 
   // Generate all instantiations of universialy quantified rules
   TupleDecl origTupleDecl = getTupleDecl();
   std::set<std::pair <std::string,std::string>> instantiations;
-  UFCallMap *ufcmap = new UFCallMap();
-  instantiations = ruleInstantiation(instExps, useRule, origTupleDecl, ufcmap);
+  UFCallMap ufcmap;
+  instantiations = ruleInstantiation(instExps, useRule, origTupleDecl, &ufcmap);
 
   // Here, we are going to utlize same functions that as Set class.
   // Set::detectUnsatOrFindEqualities uses. Therefore, we temporary
@@ -3723,26 +4062,116 @@ Relation* Relation::detectUnsatOrFindEqualities(bool *useRule){
   // using relationStr2SetStr function found in isl_str_manipulation.
   Set *eqSet = new Set( relationStr2SetStr(prettyPrintString(), 
                                   inArity(), outArity()) );
-  Set *supAffSet = eqSet->superAffineSet(ufcmap);
+  Set *supAffSet = eqSet->superAffineSet(&ufcmap);
   srParts supSetParts = getPartsFromStr(supAffSet->prettyPrintString());
-  isl_ctx* ctx = isl_ctx_alloc();
-  string syms = symsForInstantiationSet(eqSet->boundDomainRange(), ufcmap);
+  delete supAffSet;
+  isl_ctx* ctx = islCtx();
+  string syms = symsForInstantiationSet(eqSet->boundDomainRange(), &ufcmap);
   isl_set* set = instantiationSet(supSetParts, instantiations, syms, ctx);
 
   // Check if the relation with new information is UnSat or MaySat
-  Set *resultSet = checkIslSet(set, ctx, ufcmap, eqSet);
-  //isl_ctx_free(ctx);
-  Relation *result = NULL;
+  Set *resultSet = checkIslSet(set, ctx, &ufcmap, eqSet);
+  delete eqSet;
   // Turning results back into a Relation
   if( resultSet ){
     result = new Relation( setStr2RelationStr(resultSet->prettyPrintString(),
                                   inArity(), outArity()) );
+    delete resultSet;
   }
+
+  cache.addRelation(key, result);
   return result;
 }
 
 
 
+// Applies op to every relation in rels on a pool of worker threads.
+// Inputs are handed to the workers as strings and parsed there, so the
+// workers never share Terms with the caller or with each other, which
+// also lets inputs that print the same be done once.
+static std::vector<Relation*> runRelationBatch(
+          const std::vector<Relation*>& rels,
+          std::function<Relation*(Relation*)> op, unsigned numThreads){
+
+  std::vector<std::string> inputs;
+  std::map<std::string, size_t> firstInput;
+  std::vector<size_t> inputOf(rels.size());
+  for (size_t i = 0; i < rels.size(); i++){
+    std::string str = rels[i]->prettyPrintString();
+    std::map<std::string, size_t>::iterator it = firstInput.find(str);
+    if (it == firstInput.end()) {
+      it = firstInput.insert(std::make_pair(str, inputs.size())).first;
+      inputs.push_back(str);
+    }
+    inputOf[i] = it->second;
+  }
+
+  if (numThreads == 0) { numThreads = std::thread::hardware_concurrency(); }
+  if (numThreads == 0) { numThreads = 1; }
+  if (numThreads > inputs.size()) { numThreads = inputs.size(); }
+
+  // Environments are copied here, on the calling thread.
+  std::vector<std::unique_ptr<Context> > contexts;
+  for (unsigned w = 0; w < numThreads; w++){
+    contexts.emplace_back(new Context(Context::current().env()));
+  }
+
+  std::vector<Relation*> outputs(inputs.size(), NULL);
+  std::vector<std::exception_ptr> errors(numThreads);
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> workers;
+  for (unsigned w = 0; w < numThreads; w++){
+    workers.push_back(std::thread([&, w](){
+      Context::Scope scope(*contexts[w]);
+      try {
+        for (size_t j = next++; j < inputs.size(); j = next++){
+          Relation input(inputs[j]);
+          outputs[j] = op(&input);
+        }
+      } catch (...) {
+        errors[w] = std::current_exception();
+      }
+    }));
+  }
+  for (size_t w = 0; w < workers.size(); w++){ workers[w].join(); }
+  // Cached copies of the outputs go away with the worker contexts.
+  contexts.clear();
+
+  for (size_t w = 0; w < errors.size(); w++){
+    if (errors[w]) {
+      for (size_t j = 0; j < outputs.size(); j++){ delete outputs[j]; }
+      std::rethrow_exception(errors[w]);
+    }
+  }
+
+  std::vector<Relation*> results(rels.size(), NULL);
+  std::vector<bool> handedOut(outputs.size(), false);
+  for (size_t i = 0; i < rels.size(); i++){
+    Relation* out = outputs[inputOf[i]];
+    if (out && handedOut[inputOf[i]]) { out = new Relation(*out); }
+    handedOut[inputOf[i]] = true;
+    results[i] = out;
+  }
+  return results;
+}
+
+std::vector<Relation*> batchDetectUnsatOrFindEqualities(
+          const std::vector<Relation*>& rels, bool *useRule,
+          unsigned numThreads){
+  return runRelationBatch(rels, [useRule](Relation* r){ 
+                            return r->detectUnsatOrFindEqualities(useRule); },
+                          numThreads);
+}
+
+std::vector<Relation*> batchSimplifyForPartialParallel(
+          const std::vector<Relation*>& rels, std::set<int> parallelTvs,
+          unsigned numThreads){
+  return runRelationBatch(rels, [&parallelTvs](Relation* r){ 
+                            return r->simplifyForPartialParallel(parallelTvs); },
+                          numThreads);
+}
+
+
 /*****************************************************************************/
 #pragma mark -
 /*************** VisitorGetString *****************************/
@@ -3757,6 +4186,7 @@ class VisitorGetString : public Visitor {
          bool firstConj;
          bool firstExp;
   public:
+         bool mutatesTerms() const { return false; }
          VisitorGetString(){ str = ""; firstConj = firstExp = true;}
 
          /*! We build our string one expression at a time before visiting 
@@ -103,9 +103,9 @@ public:
     */
     void addInequality(Exp* inequality);
 
-    const std::list<Exp*> &equalities() const { return mEqualities; }
+    const std::vector<Exp*> &equalities() const { return mEqualities; }
 
-    const std::list<Exp*> &inequalities() const { return mInequalities; }
+    const std::vector<Exp*> &inequalities() const { return mInequalities; }
 
     /*! substituteTupleDecl -- substitute TupleVarTerms in for any
     **  VarTerms in the expressions whose names match the corresponding
@@ -258,10 +258,14 @@ public:
 private:
 
     /// Set of equality constraints.
-    std::list<Exp*> mEqualities;
+    std::vector<Exp*> mEqualities;
 
     /// Set of inequality constraints.
-    std::list<Exp*> mInequalities;
+    std::vector<Exp*> mInequalities;
+
+    /// True while both constraint lists are known to be sorted, in which
+    /// case new constraints are placed by binary search.
+    bool mSorted;
 
     /// Tuple declaration for this conjunction
     TupleDecl mTupleDecl;
@@ -288,6 +292,10 @@ public:
     SparseConstraints(const SparseConstraints& other);
     virtual SparseConstraints& operator=(const SparseConstraints& other);
 
+    //! Takes over the conjunctions of other, leaving it empty.  Same result
+    //! as assigning other, but nothing is cloned.
+    void adoptConjunctions(SparseConstraints& other);
+
     void reset();
     virtual ~SparseConstraints();
 
@@ -794,18 +802,113 @@ private:
 };
 
 
+/*!
+ * \struct CostEstimate
+ *
+ * \brief Estimated cost of the loop nest that scans a Set or Relation,
+ * e.g. an inspector or executor, see CostModel::estimate.
+ */
+struct CostEstimate {
+    CostEstimate() : iterations(0), ufReads(0), bytes(0), bounded(true) {}
+
+    //! Average trip count of the loop over each tuple variable, 1 for
+    //! variables computed from an equality or fixed by the tuple.
+    //! With several conjunctions, the largest over all of them.
+    std::vector<double> tripCounts;
+    //! Number of times the loop body runs, summed over conjunctions.
+    double iterations;
+    //! Number of reads of UF (index array) values.
+    double ufReads;
+    //! Bytes read from UF index arrays.
+    double bytes;
+    //! False if some tuple variable is missing a lower or upper bound,
+    //! its trip count is then taken to be 1.
+    bool bounded;
+};
+
+/*!
+ * \class CostModel
+ *
+ * \brief Estimates iteration counts and index array traffic of Sets and
+ * Relations from the sizes of their symbolic constants and UFs, so that
+ * alternative inspectors and sparse formats can be compared before any
+ * code is generated.
+ *
+ * The loops are assumed to run in tuple order.  A tuple variable that an
+ * equality defines in terms of outer variables gets no loop, any other
+ * runs from its tightest lower to its tightest upper bound.  A UF is
+ * modelled as the linear function from its domain onto its range, so
+ * rowptr(i+1) - rowptr(i) averages nnz/n, and each distinct UF call is
+ * read once per iteration of the innermost loop its arguments use.
+ */
+class CostModel {
+public:
+    CostModel() {}
+
+    //! Sets the value of symbolic constant name, e.g. n or nnz.
+    void setSymbolic(const std::string& name, double value);
+
+    //! Sets the number of entries of UF name, the number of values it
+    //! ranges over, and the size of one entry.  UFs without a size here
+    //! are sized from their domain and range in the current environment.
+    void setUF(const std::string& name, double entries, double range,
+               double bytesPerEntry = sizeof(int));
+
+    //! Estimates the cost of scanning sc.  Throws an assert_exception if
+    //! a symbolic constant in sc has no value.
+    CostEstimate estimate(SparseConstraints* sc) const;
+
+private:
+    struct UFSize {
+        double entries;
+        double range;
+        double bytes;
+    };
+
+    UFSize ufSize(const std::string& name) const;
+    CostEstimate estimate(const Conjunction* conj) const;
+    double value(const Exp* exp, const std::vector<double>& means,
+                 const Term* skip = NULL) const;
+
+    std::map<std::string, double> mSymbolics;
+    std::map<std::string, UFSize> mUFs;
+};
+
 string passSetStrThruISL(string sstr);
 string passUnionSetStrThruISL(string sstr);
 string passRelationStrThruISL(string rstr);
 string passUnionRelationStrThruISL(string rstr);
 Set* passSetThruISL(Set* s);
 Relation* passRelationThruISL(Relation* r);
+isl_ctx* islCtx();
+isl_map* islMapFromConstraints(const SparseConstraints* sc, int inArity,
+                               int outArity, isl_ctx* ctx);
+Set* islSetToSet(isl_set* iset, const TupleDecl& tdecl);
+Relation* islMapToRelation(isl_map* imap, const TupleDecl& tdecl,
+                           int inArity, int outArity);
 std::pair <std::string,std::string> instantiate(
           UniQuantRule* uqRule, Exp x1, Exp x2, 
           UFCallMap *ufcmap, TupleDecl origTupleDecl);
 std::set<std::pair <std::string,std::string>> ruleInstantiation
                           (std::set<Exp> instExps, bool *useRule, 
                            TupleDecl origTupleDecl, UFCallMap *ufcmap);
+
+/*! Runs detectUnsatOrFindEqualities on every relation in rels and returns
+**  the results in the same order, NULL for the unsatisfiable ones.
+**  Relations that print the same are only checked once.  The work is
+**  spread over numThreads threads (0 picks the number of cores), each
+**  with its own Context holding a copy of the calling thread's
+**  environment.  The caller owns the returned relations; rels is not
+**  modified.  An exception thrown for any relation is rethrown here.
+*/
+std::vector<Relation*> batchDetectUnsatOrFindEqualities(
+          const std::vector<Relation*>& rels, bool *useRule=NULL,
+          unsigned numThreads=0);
+
+//! Same as batchDetectUnsatOrFindEqualities for simplifyForPartialParallel.
+std::vector<Relation*> batchSimplifyForPartialParallel(
+          const std::vector<Relation*>& rels, std::set<int> parallelTvs,
+          unsigned numThreads=0);
 }//end namespace iegenlib
 
 #endif /* SET_RELATION_H_ */
@@ -50,6 +50,13 @@ using iegenlib::UFCallMap;
 using iegenlib::UniQuantRuleType;
 using iegenlib::ruleInstantiation;
 using iegenlib::instantiate;
+using iegenlib::islCtx;
+using iegenlib::islMapFromConstraints;
+using iegenlib::islSetToSet;
+using iegenlib::passSetThruISL;
+using iegenlib::passSetStrThruISL;
+using iegenlib::passRelationThruISL;
+using iegenlib::islStringToSet;
 
 // This is just a test setup class that is used in the other tests in this
 // file.  Sets up some expressions for use in many of the tests.
@@ -4338,3 +4345,48 @@ TEST_F(SetRelationTest, getString){
    delete s1_ex;
    delete rel1_ex;
 }
+
+/*!
+ * Test that affine sets and relations round trip through isl objects
+ * directly, and agree with the string based path.
+ */
+TEST_F(SetRelationTest, islObjectBridge){
+
+   EXPECT_TRUE( islCtx() != NULL );
+   EXPECT_EQ( islCtx() , islCtx() );
+
+   Set *s1 = new Set("[n] -> {[i,j]: 0 <= i && i < n && i <= j && j < n}");
+   isl_map *m1 = islMapFromConstraints(s1, 0, s1->arity(), islCtx());
+   ASSERT_TRUE( m1 != NULL );
+   Set *s1_rt = islSetToSet(isl_map_range(m1),
+                            (*s1->conjunctionBegin())->getTupleDecl());
+   ASSERT_TRUE( s1_rt != NULL );
+   EXPECT_EQ( string("[ n ] -> { [i, j] : i >= 0 && -i + j >= 0 && "
+                     "-j + n - 1 >= 0 }") , s1_rt->toISLString() );
+
+   // Both paths may drop different redundant constraints, so compare them
+   // in isl.
+   Set *s1_isl = passSetThruISL(s1);
+   isl_set *direct = islStringToSet(s1_isl->toISLString(), islCtx());
+   isl_set *viaStr = islStringToSet(passSetStrThruISL(s1->toISLString()),
+                                    islCtx());
+   EXPECT_TRUE( isl_set_is_equal(direct, viaStr) == isl_bool_true );
+   isl_set_free(direct);
+   isl_set_free(viaStr);
+
+   Relation *r1 = new Relation("{[i,j] -> [k] : k = i + j && 0 <= i < 10}");
+   Relation *r1_isl = passRelationThruISL(r1);
+   EXPECT_EQ( string("{ [i, j] -> [k] : i + j - k = 0 && i >= 0 && "
+                     "-i + 9 >= 0 }") , r1_isl->toISLString() );
+
+   // UF calls cannot be translated directly.
+   Set *s2 = new Set("{[i]: 0 <= f(i)}");
+   EXPECT_TRUE( islMapFromConstraints(s2, 0, 1, islCtx()) == NULL );
+
+   delete s1;
+   delete s1_rt;
+   delete s1_isl;
+   delete r1;
+   delete r1_isl;
+   delete s2;
+}
@@ -59,7 +59,7 @@ void addUniQuantRules(json &uqCons){
     uqRule = new UniQuantRule(uqCons[j]["Type"].as<string>(), 
                 uqCons[j]["UniQuantVar"].as<string>(), 
                 uqCons[j]["p"].as<string>(), uqCons[j]["q"].as<string>());
-    currentEnv.addUniQuantRule( uqRule );
+    iegenlib::addUniQuantRule( uqRule );
   }
 }
 
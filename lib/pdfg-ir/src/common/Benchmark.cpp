@@ -29,14 +29,10 @@ void Benchmark::stop() {
 }
 
 double Benchmark::speedup() {
-    double p = _runTime;
-    double s = _evalTime;
+    // Ratio of the reference (evaluation) time to the run time.
     double r = 0.0;
-    //double n = (double) _config.getInt("num_threads");
-
-    // Amdahl's Law:
-    if (s != 0.0) {
-        r = (1.0 / (1.0 - p + (p/s)));
+    if (_runTime > 0.0) {
+        r = _evalTime / _runTime;
     }
 
     return r;
@@ -96,7 +92,7 @@ void Benchmark::run() {
 
             // If evaluation function did not calculate its own runtime, compute it now...
             if (_evalTime == 0.0) {
-                _evalTime = _stopTime = _startTime;
+                _evalTime = _stopTime - _startTime;
             }
 
             // Compare _outputData and _verifyData...
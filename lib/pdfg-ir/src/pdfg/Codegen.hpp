@@ -43,6 +43,10 @@ namespace pdfg {
         }
 
         string gen(const Space& space) {
+            string loops = space.to_loops();
+            if (!loops.empty()) {
+                return loops;
+            }
             string norm = _poly.add(space.to_iegen());
             string code = _poly.codegen(space.name());
             return code;
@@ -0,0 +1,214 @@
+/**
+ * \class ExprPool
+ *
+ * \ingroup PolyExt
+ * (Note, this needs exactly one \defgroup somewhere)
+ *
+ * \brief Hash-consed expression trees for the GraphIL eDSL.
+ *
+ * Every distinct expression is represented by exactly one ExprNode, so structural equality is pointer
+ * equality, and the set of symbols an expression references is computed once when its node is created.
+ */
+
+#ifndef POLYEXT_EXPRTREE_H
+#define POLYEXT_EXPRTREE_H
+
+#include <algorithm>
+using std::sort;
+using std::unique;
+#include <deque>
+using std::deque;
+#include <functional>
+using std::hash;
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+#include <set>
+using std::set;
+#include <string>
+using std::string;
+#include <unordered_map>
+using std::unordered_map;
+using std::unordered_multimap;
+#include <utility>
+using std::make_pair;
+#include <vector>
+using std::vector;
+
+namespace pdfg {
+    /// Interned symbol table, maps names, operators, and literals to dense ids. Safe to share between threads.
+    class Symbols {
+    public:
+        static Symbols& get() {
+            static Symbols instance;
+            return instance;
+        }
+
+        Symbols(Symbols const&) = delete;
+
+        void operator=(Symbols const&) = delete;
+
+        unsigned intern(const string& name) {
+            lock_guard<mutex> lock(_mutex);
+            auto itr = _ids.find(name);
+            if (itr != _ids.end()) {
+                return itr->second;
+            }
+            unsigned id = _names.size();
+            _names.push_back(name);
+            _ids[name] = id;
+            return id;
+        }
+
+        const string& name(unsigned id) const {
+            lock_guard<mutex> lock(_mutex);
+            return _names[id];
+        }
+
+    protected:
+        Symbols() {
+        }
+
+        unordered_map<string, unsigned> _ids;
+        deque<string> _names;               // References stay valid as names are added.
+        mutable mutex _mutex;
+    };
+
+    struct ExprNode {
+        char kind;                          // 'M' for operator nodes, 'T' for text leaves.
+        unsigned sym;                       // Interned operator or leaf text.
+        vector<const ExprNode*> kids;
+        vector<unsigned> syms;              // Sorted ids of all identifiers referenced in this subtree.
+        size_t hash;
+
+        bool references(unsigned id) const {
+            return std::binary_search(syms.begin(), syms.end(), id);
+        }
+
+        set<string> names() const {
+            set<string> out;
+            for (unsigned id : syms) {
+                out.insert(Symbols::get().name(id));
+            }
+            return out;
+        }
+    };
+
+    /// Process-wide pool of hash-consed nodes. Nodes are never freed before exit, so Exprs may be passed between
+    /// threads, and node creation is serialized.
+    class ExprPool {
+    public:
+        static ExprPool& get() {
+            static ExprPool instance;
+            return instance;
+        }
+
+        ExprPool(ExprPool const&) = delete;
+
+        void operator=(ExprPool const&) = delete;
+
+        ~ExprPool() {
+            for (auto& itr : _nodes) {
+                delete itr.second;
+            }
+        }
+
+        /// Return the unique node for operator 'oper' applied to (already hash-consed) children.
+        const ExprNode* make(const string& oper, const vector<const ExprNode*>& kids) {
+            lock_guard<mutex> lock(_mutex);
+            unsigned sym = Symbols::get().intern(oper);
+            size_t key = combine(hash<unsigned>()(sym), 'M');
+            for (const ExprNode* kid : kids) {
+                key = combine(key, kid->hash);
+            }
+
+            auto range = _nodes.equal_range(key);
+            for (auto itr = range.first; itr != range.second; ++itr) {
+                const ExprNode* node = itr->second;
+                if (node->kind == 'M' && node->sym == sym && node->kids == kids) {
+                    return node;
+                }
+            }
+
+            ExprNode* node = new ExprNode();
+            node->kind = 'M';
+            node->sym = sym;
+            node->kids = kids;
+            node->hash = key;
+            tokenize(oper, node->syms);     // Function-style operators, e.g., 'sqrt(', name a symbol too.
+            for (const ExprNode* kid : kids) {
+                node->syms.insert(node->syms.end(), kid->syms.begin(), kid->syms.end());
+            }
+            normalize(node->syms);
+            _nodes.insert(make_pair(key, node));
+            return node;
+        }
+
+        /// Return the unique leaf for an expression only known by its text, tokenizing it the first time.
+        const ExprNode* parse(const string& text) {
+            lock_guard<mutex> lock(_mutex);
+            unsigned sym = Symbols::get().intern(text);
+            auto itr = _leaves.find(sym);
+            if (itr != _leaves.end()) {
+                return itr->second;
+            }
+
+            ExprNode* node = new ExprNode();
+            node->kind = 'T';
+            node->sym = sym;
+            node->hash = combine(hash<unsigned>()(sym), 'T');
+
+            tokenize(text, node->syms);
+            normalize(node->syms);
+
+            _leaves[sym] = node;
+            _nodes.insert(make_pair(node->hash, node));
+            return node;
+        }
+
+        unsigned size() const {
+            lock_guard<mutex> lock(_mutex);
+            return _nodes.size();
+        }
+
+    protected:
+        ExprPool() {
+        }
+
+        // Same word characters as Strings::in(..., words=true).
+        static bool isWordChar(char chr) {
+            return (chr >= 'A' && chr <= 'Z') || (chr >= 'a' && chr <= 'z') ||
+                   (chr >= '0' && chr <= '9') || chr == '_';
+        }
+
+        static void tokenize(const string& text, vector<unsigned>& syms) {
+            string token;
+            for (char chr : text) {
+                if (isWordChar(chr)) {
+                    token += chr;
+                } else if (!token.empty()) {
+                    syms.push_back(Symbols::get().intern(token));
+                    token.clear();
+                }
+            }
+            if (!token.empty()) {
+                syms.push_back(Symbols::get().intern(token));
+            }
+        }
+
+        static void normalize(vector<unsigned>& syms) {
+            sort(syms.begin(), syms.end());
+            syms.erase(unique(syms.begin(), syms.end()), syms.end());
+        }
+
+        static size_t combine(size_t seed, size_t val) {
+            return seed ^ (val + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+        }
+
+        unordered_multimap<size_t, const ExprNode*> _nodes;
+        unordered_map<unsigned, const ExprNode*> _leaves;
+        mutable mutex _mutex;
+    };
+}
+
+#endif  // POLYEXT_EXPRTREE_H
@@ -34,7 +34,10 @@ using std::unordered_map;
 using std::unordered_set;
 #include <vector>
 using std::vector;
+#include <pdfg/ExprTree.hpp>
 #include <poly/PolyLib.hpp>
+using poly::CodeGenRequest;
+using poly::CodeGenResult;
 using poly::PolyLib;
 
 namespace pdfg {
@@ -64,7 +67,7 @@ namespace pdfg {
 
     struct Expr {
     public:
-        explicit Expr(const string &text = "", char type = 'E'): _text(text), _type(type) {
+        explicit Expr(const string &text = "", char type = 'E'): _text(text), _type(type), _node(nullptr) {
         }
 
         Expr(const Expr &other) {
@@ -106,6 +109,24 @@ namespace pdfg {
 
         virtual void text(const string& text) {
             _text = text;
+            _node = nullptr;
+        }
+
+        /// Hash-consed tree for this expression, built from its text the first time it is requested.
+        const ExprNode* node() const {
+            if (_node == nullptr) {
+                _node = ExprPool::get().parse(text());
+            }
+            return _node;
+        }
+
+        /// Names of all identifiers referenced by this expression.
+        set<string> symbols() const {
+            return node()->names();
+        }
+
+        bool references(const string& name) const {
+            return node()->references(Symbols::get().intern(name));
         }
 
         bool empty() const {
@@ -129,11 +150,12 @@ namespace pdfg {
         }
 
         virtual bool equals(const Expr &other) const {
-            return _text == other._text;
+            return (_node != nullptr && _node == other._node) || _text == other._text;
         }
 
         friend istream &operator>>(istream &is, Expr &expr) {
             is >> expr._text;
+            expr._node = nullptr;
             return is;
         }
 
@@ -141,10 +163,12 @@ namespace pdfg {
         void copy(const Expr &other) {
             _text = other._text;
             _type = other._type;
+            _node = other._node;
         }
 
         string _text;
         char _type;
+        mutable const ExprNode* _node;
     };
 
     ostream &operator<<(ostream &os, const Expr &expr) {
@@ -158,7 +182,7 @@ namespace pdfg {
     public:
         explicit Int(int val = 0) {
             _val = val;
-            _text = to_string(val);
+            Expr::text(to_string(val));
             _type = 'N';
         }
 
@@ -188,7 +212,7 @@ namespace pdfg {
     public:
         explicit Real(double val = 0.) {
             _val = val;
-            _text = to_string(val);
+            Expr::text(to_string(val));
             _type = 'R';
         }
 
@@ -218,7 +242,7 @@ namespace pdfg {
     public:
         explicit Pointer(void* ptr = nullptr) {
             _ptr = ptr;
-            _text = to_string(ptr);
+            Expr::text(to_string(ptr));
             _type = 'O';
         }
 
@@ -256,8 +280,9 @@ namespace pdfg {
             _lhs = lhs;
             _rhs = rhs;
             _oper = oper;
-            _text = stringify<Math>(*this);
+            Expr::text(stringify<Math>(*this));
             _type = 'M';
+            _node = ExprPool::get().make(oper, {lhs.node(), rhs.node()});
         }
 
         Math(const Math &other) {
@@ -541,7 +566,8 @@ namespace pdfg {
     struct Iter : public Expr {
     public:
         explicit Iter(const string &name = "") {
-            _name = _text = name;
+            _name = name;
+            Expr::text(name);
             _type = 'I';
             addIterator(*this);
         }
@@ -595,11 +621,12 @@ namespace pdfg {
         }
 
         void name(const char name) {
-            _name = _text = string(1, name);
+            this->name(string(1, name));
         }
 
         void name(const string& name) {
-            _name = _text = name;
+            _name = name;
+            Expr::text(name);
         }
 
     protected:
@@ -627,13 +654,13 @@ namespace pdfg {
                 _arity = arity;
             }
             _type = 'F';
-            _text = stringify<Func>(*this);
+            Expr::text(stringify<Func>(*this));
             addFunction(*this);
         }
 
         Func(const Func &other) : _arity(other._arity) {
             copy(other);
-            _text = stringify<Func>(*this);
+            Expr::text(stringify<Func>(*this));
         }
 
         Func(const Expr &expr) {
@@ -689,7 +716,7 @@ namespace pdfg {
         }
 
         virtual void eval() {
-            _text = stringify<Func>(*this);
+            Expr::text(stringify<Func>(*this));
         }
 
         unsigned arity() const {
@@ -718,6 +745,7 @@ namespace pdfg {
         friend istream &operator>>(istream &is, Func &func) {
             func._arity = 0;
             is >> func._text;
+            func._node = nullptr;
             bool inArgs = false;
             string arg;
             for (char chr : func._text) {
@@ -781,9 +809,9 @@ namespace pdfg {
             _val = val;
             _type = 'S';
             if (val == 0) {
-                _text = name;
+                Expr::text(name);
             } else {
-                _text = to_string(val);
+                Expr::text(to_string(val));
             }
             addConstant(*this);
         }
@@ -842,7 +870,7 @@ namespace pdfg {
             _args = args;
             _exprs = exprs;
             _type = '#';
-            _text = stringify<Macro>(*this);
+            Expr::text(stringify<Macro>(*this));
         }
 
         Macro(const string &name, initializer_list<Iter> iters, initializer_list<Expr> exprs) : Macro(name) {
@@ -870,7 +898,7 @@ namespace pdfg {
         }
 
         virtual void eval() {
-            _text = stringify<Macro>(*this);
+            Expr::text(stringify<Macro>(*this));
         }
 
     protected:
@@ -910,7 +938,7 @@ namespace pdfg {
     struct Constr : public Expr {
     public:
         explicit Constr() {
-            _text = "";
+            Expr::text("");
             _type = 'C';
         }
 
@@ -920,7 +948,7 @@ namespace pdfg {
             _relop = relop;
             _type = 'C';
             _inexists = inexists;
-            _text = stringify<Constr>(*this);
+            Expr::text(stringify<Constr>(*this));
         }
 
         Constr(const Constr &other) {
@@ -1192,7 +1220,7 @@ namespace pdfg {
     public:
         explicit Condition(const Constr &cond, const Expr& true_expr, const Expr& false_expr) {
             init(cond, true_expr, false_expr);
-            _text = stringify<Condition>(*this);
+            Expr::text(stringify<Condition>(*this));
         }
 
         explicit Condition(const Constr &cond, const Expr& expr) : Condition(cond, expr, Int(0)) {
@@ -1340,7 +1368,7 @@ namespace pdfg {
             for (const auto &expr : tuple) {
                 _tuple.push_back(expr);
             }
-            _text = stringify<Access>(*this);
+            Expr::text(stringify<Access>(*this));
             addAccess(*this);
         }
 
@@ -1350,7 +1378,7 @@ namespace pdfg {
             _refchar = other._refchar;
             _tuple = other._tuple;
             _offsets = other._offsets;
-            _text = stringify<Access>(*this);
+            Expr::text(stringify<Access>(*this));
         }
 
         string _space;
@@ -1755,6 +1783,176 @@ namespace pdfg {
             return os.str();
         }
 
+        /// Loop nest for a box or simple triangular space, printed exactly as Omega's codegen would print it,
+        /// or an empty string if the space needs the full polyhedral scanner. Each iterator must have one lower
+        /// and one upper bound that is an integer, a symbolic constant, or an outer iterator, and each range must
+        /// be known to be non-empty, either from its integer bounds, from a constraint on constants only, or from
+        /// an outer iterator's bound. Otherwise Omega would add guards or tighten the outer loops.
+        string to_loops() const {
+            struct Bound {
+                int constr = -1;    // Index of the bounding constraint
+                string text;        // Bound as written in the constraint
+                string base;        // Symbolic constant or loop variable, empty for integers
+                int offset = 0;
+                bool strict = false;
+            };
+
+            unsigned niters = _iterators.size();
+            if (niters < 1) {
+                return "";
+            }
+
+            map<string, int> levels;
+            for (unsigned n = 0; n < niters; n++) {
+                levels[_iterators[n].text()] = n;
+            }
+
+            auto operand = [&levels](const Expr& expr, Bound& bound, int& level) -> bool {
+                string text = expr.text();
+                level = -1;
+                bound.text = text;
+                if (text.empty()) {
+                    return false;
+                } else if (expr.is_iter()) {
+                    auto itr = levels.find(text);
+                    if (itr == levels.end()) {
+                        return false;
+                    }
+                    level = itr->second;
+                    bound.base = "t" + to_string(level + 1);
+                } else if (expr.type() != 'N' && expr.type() != 'S') {
+                    return false;
+                } else if (Strings::isDigit(text[0]) || (text[0] == '-' && text.size() > 1)) {
+                    if (!Strings::isDigit(text[0] == '-' ? text.substr(1) : text)) {
+                        return false;
+                    }
+                    bound.offset = unstring<int>(text);
+                } else {
+                    for (char chr : text) {
+                        if (!isalnum(chr) && chr != '_') {
+                            return false;
+                        }
+                    }
+                    bound.base = text;
+                }
+                return true;
+            };
+
+            vector<Bound> lowers(niters), uppers(niters);
+            vector<string> texts;
+            vector<bool> givens;
+            for (unsigned c = 0; c < _constraints.size(); c++) {
+                const Constr& constr = _constraints[c];
+                string relop = constr.relop();
+                texts.push_back(constr.lhs().text() + ' ' + relop + ' ' + constr.rhs().text());
+                givens.push_back(false);
+                if (find(texts.begin(), texts.end() - 1, texts.back()) != texts.end() - 1) {
+                    continue;       // Duplicate of an earlier constraint
+                }
+
+                bool less = (relop == "<" || relop == "<=");
+                if (constr.inexists() || (!less && relop != ">" && relop != ">=")) {
+                    return "";
+                }
+
+                Bound lhs, rhs;
+                int llevel, rlevel;
+                if (!operand(constr.lhs(), lhs, llevel) || !operand(constr.rhs(), rhs, rlevel)) {
+                    return "";
+                } else if (llevel < 0 && rlevel < 0) {
+                    givens.back() = true;
+                    continue;
+                } else if (llevel == rlevel) {
+                    return "";
+                }
+
+                // The constraint bounds the innermost iterator it mentions.
+                bool onLeft = llevel > rlevel;
+                int level = onLeft ? llevel : rlevel;
+                Bound& bound = (onLeft == less) ? uppers[level] : lowers[level];
+                if (bound.constr >= 0) {
+                    return "";      // Omega would print a min or max
+                }
+                bound = onLeft ? rhs : lhs;
+                bound.constr = c;
+                bound.strict = (relop.size() == 1);
+            }
+
+            auto bounds = [&lowers, &uppers](int c) -> bool {
+                for (unsigned n = 0; n < lowers.size(); n++) {
+                    if (lowers[n].constr == c || uppers[n].constr == c) {
+                        return true;
+                    }
+                }
+                return false;
+            };
+
+            auto print = [](const Bound& bound, int offset) -> string {
+                if (bound.base.empty()) {
+                    return to_string(bound.offset + offset);
+                } else if (offset > 0) {
+                    return bound.base + "+" + to_string(offset);
+                } else if (offset < 0) {
+                    return bound.base + to_string(offset);
+                }
+                return bound.base;
+            };
+
+            ostringstream os;
+            string indent;
+            for (unsigned n = 0; n < niters; n++) {
+                const Bound& lower = lowers[n];
+                const Bound& upper = uppers[n];
+                if (lower.constr < 0 || upper.constr < 0) {
+                    return "";
+                }
+
+                int lowoff = lower.offset + lower.strict;
+                int upoff = upper.offset - upper.strict;
+                if (lower.base.empty() && upper.base.empty()) {
+                    if (lowoff >= upoff) {
+                        return "";  // Omega prints a single iteration as an assignment
+                    }
+                } else if (lower.base.empty() || upper.base.empty() || lower.base != upper.base) {
+                    if (lower.strict && upper.strict) {
+                        return "";
+                    }
+                    string relop = (lower.strict || upper.strict) ? "<" : "<=";
+                    string flipped = (relop == "<") ? ">" : ">=";
+                    bool known = false;
+                    for (unsigned c = 0; c < texts.size() && !known; c++) {
+                        known = (givens[c] || bounds(c)) &&
+                                (texts[c] == lower.text + ' ' + relop + ' ' + upper.text ||
+                                 texts[c] == upper.text + ' ' + flipped + ' ' + lower.text);
+                    }
+                    if (!known) {
+                        return "";
+                    }
+                } else {
+                    return "";
+                }
+
+                string iter = "t" + to_string(n + 1);
+                string low = lower.base.empty() ? to_string(lowoff) : print(lower, lower.strict);
+                string high = upper.base.empty() ? to_string(upoff) : print(upper, -upper.strict);
+                os << indent << "for(" << iter << " = " << low << "; " << iter << " <= " << high << "; "
+                   << iter << "++) {\n";
+                indent += "  ";
+            }
+
+            os << indent << "s0(";
+            for (unsigned n = 0; n < niters; n++) {
+                os << (n > 0 ? "," : "") << 't' << n + 1;
+            }
+            os << ");\n";
+            for (unsigned n = niters; n > 0; n--) {
+                indent.resize(indent.size() - 2);
+                os << indent << "}\n";
+            }
+
+            return os.str();
+        }
+
         Math size() const {
             Math expr;
             for (unsigned n = 0; n < _constraints.size(); n += 2) {
@@ -1922,7 +2120,7 @@ namespace pdfg {
                 _name = "c" + to_string(_space_counter);
                 _space_counter += 1;
             }
-            _text = _name;
+            Expr::text(_name);
             _constraints = constraints;
             _type = 'P';
             for (const auto &iter : iterators) {
@@ -2727,7 +2925,7 @@ namespace pdfg {
                 _guards.emplace_back(Constr());
             }
             schedule();
-            _text = stringify<Comp>(*this);
+            Expr::text(stringify<Comp>(*this));
             addComputation(*this);
         }
 
@@ -2889,17 +3087,20 @@ namespace pdfg {
                 bool is_math = stmt.rhs().is_math();
 
                 if (is_math || stmt.rhs().is_func()) {
-                    // Assume write hand side contains reads...
-                    for (const auto &sit : _spaces) {
-                        if (Strings::in(expr, sit.first, true)) {
-                            readExprs.push_back(sit.second);
+                    // Assume write hand side contains reads, look up each symbol it references...
+                    set<string> symbols = stmt.rhs().symbols();
+                    for (const string& sym : symbols) {
+                        auto sit = _spaces.find(sym);
+                        if (sit != _spaces.end()) {
+                            readExprs.push_back(sit->second);
                         }
                     }
                     // Math expressions may need to be broken into multiple accesses...
                     if (is_math) {
-                        for (const auto &sit : _funcs) {
-                            if (Strings::in(expr, sit.first, true)) {
-                                readExprs.push_back(sit.second);
+                        for (const string& sym : symbols) {
+                            auto sit = _funcs.find(sym);
+                            if (sit != _funcs.end()) {
+                                readExprs.push_back(sit->second);
                             }
                         }
                     }
@@ -2909,17 +3110,20 @@ namespace pdfg {
                     for (const string& line : lines) {
                         size_t pos = line.find('=');
                         if (pos != string::npos) {
-                            string lhs = line.substr(0, pos);
-                            string rhs = line.substr(pos + 1);
-                            for (const auto &sit : _spaces) {
-                                if (marked.find(sit.first) == marked.end()) {
-                                    if (Strings::in(lhs, sit.first, true)) {
-                                        writeExprs.push_back(sit.second);
-                                        marked[sit.first] = true;
-                                    } else if (Strings::in(rhs, sit.first, true)) {
-                                        readExprs.push_back(sit.second);
-                                        marked[sit.first] = true;
+                            const ExprNode* lhs = ExprPool::get().parse(line.substr(0, pos));
+                            const ExprNode* rhs = ExprPool::get().parse(line.substr(pos + 1));
+                            set<string> symbols = lhs->names();
+                            set<string> rhsyms = rhs->names();
+                            symbols.insert(rhsyms.begin(), rhsyms.end());
+                            for (const string& sym : symbols) {
+                                auto sit = _spaces.find(sym);
+                                if (sit != _spaces.end() && marked.find(sym) == marked.end()) {
+                                    if (lhs->references(Symbols::get().intern(sym))) {
+                                        writeExprs.push_back(sit->second);
+                                    } else {
+                                        readExprs.push_back(sit->second);
                                     }
+                                    marked[sym] = true;
                                 }
                             }
                         }
@@ -3109,7 +3313,7 @@ namespace pdfg {
         }
 
         string codegen(const string& path = "", const string& name = "",
-                       const string& lang = "C", const string& ompsched = "") {
+                       const string& lang = "C", const string& ompsched = "", bool profile = false) {
             string cpath = path;
             bool isobj = (cpath.find(".o") != string::npos);
             if (!cpath.empty() && cpath.find('.') == string::npos) {
@@ -3120,8 +3324,9 @@ namespace pdfg {
 
             reschedule(name);       // Run scheduling pass.
             datareduce(name);       // Run data redux pass.
+            memshare(name);         // Run buffer sharing pass.
 
-            CodeGenVisitor cgen(cpath, lang); //, _iters.size());
+            CodeGenVisitor cgen(cpath, lang, profile); //, _iters.size());
             cgen.ompSchedule(ompsched);
 
 //            for (const auto& iter : _consts) {
@@ -3188,6 +3393,15 @@ namespace pdfg {
             }
         }
 
+        void memshare(const string& name = "") {
+            MemShareVisitor sharer;
+            if (name.empty()) {
+                sharer.walk(&_flowGraph);
+            } else {
+                sharer.walk(&_graphs[name]);
+            }
+        }
+
         Expr* getSize(const Comp& comp, const Func& func) {
             Expr* expr = nullptr;
             Math math;
@@ -3511,8 +3725,8 @@ namespace pdfg {
     }
 
     string codegen(const string& path = "", const string& name = "",
-                   const string& lang = "C", const string& ompsched = "") {
-        return GraphMaker::get().codegen(path, name, lang, ompsched);
+                   const string& lang = "C", const string& ompsched = "", bool profile = false) {
+        return GraphMaker::get().codegen(path, name, lang, ompsched, profile);
     }
 
     void perfmodel(const string& name = "") {
@@ -3527,6 +3741,10 @@ namespace pdfg {
         GraphMaker::get().datareduce(name);
     }
 
+    void memshare(const string& name = "") {
+        GraphMaker::get().memshare(name);
+    }
+
     void addIterator(const Iter& iter) {
         if (!iter.name().empty()) {
             GraphMaker::get().addIter(iter);
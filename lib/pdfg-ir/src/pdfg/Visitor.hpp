@@ -167,6 +167,7 @@ namespace pdfg {
             _graph = graph;
             addComment();
             addIncludes();
+            addProfiler();
             addTypeDefs();
             addFunctions();
         }
@@ -188,6 +189,10 @@ namespace pdfg {
                 // Output Data
                 string param = node->datatype() + "* " + label;
                 _params.push_back(param);
+            } else if (isShared(node)) {
+                // Temporary Data sharing the buffer of another temporary with a disjoint lifetime.
+                string line = _indent + node->datatype() + "* " + label + " = " + node->attr("buffer") + ";";
+                _aliases.push_back(line);
             } else if (node->alloc() != NONE) {
                 // Temporary Data
                 ostringstream os;
@@ -238,21 +243,30 @@ namespace pdfg {
         }
 
         void enter(CompNode* node) override {
-            vector<string> names;
-            map<string, vector<string> > guards;
-            map<string, vector<string> > statements;
-            map<string, vector<string> > schedules;
+            CodeGenRequest request;
+            request.ompSched = _ompsched;
 
-            updateComp((Comp*) node->expr(), names, statements, guards, schedules);
+            updateComp((Comp*) node->expr(), request);
             addMappings(node);
 
             for (CompNode* child : node->children()) {
-                updateComp((Comp*) child->expr(), names, statements, guards, schedules);
+                updateComp((Comp*) child->expr(), request);
                 addMappings(child);
             }
 
-            string code = _poly.codegen(names, statements, guards, schedules, _ompsched, "", true);
-            code = "// " + node->label() + "\n" + code;
+            // Unscheduled box and triangular spaces do not need the polyhedral scanner.
+            if (request.names.size() == 1 && request.schedules.empty()) {
+                request.loops = ((Comp*) node->expr())->space().to_loops();
+            }
+
+            // Loop nests are generated together in 'finish', keep a placeholder for this one in the body.
+            string code = "// " + node->label() + "\n" + initShared(node);
+            if (_profile) {
+                code += "prof_enter(\"" + node->label() + "\");\n";
+            }
+            _requests.push_back(request);
+            _slots.push_back(_body.size());
+            _regions.push_back(node->label());
             _body.push_back(code);
         }
 
@@ -261,6 +275,8 @@ namespace pdfg {
         }
 
         void finish(FlowGraph* graph) override {
+            addLoops();
+            _allocs.insert(_allocs.end(), _aliases.begin(), _aliases.end());
             addDefines();
             addHeader();
             addFooter();
@@ -311,7 +327,7 @@ namespace pdfg {
             // Add includes...
             include({"stdio", "stdlib", "stdint", "math"});
             if (_profile) {
-                include("sys/time");
+                include("time");
             }
 
             _indent = "    ";
@@ -377,6 +393,27 @@ namespace pdfg {
             }
         }
 
+        void addProfiler() {
+            // Region markers default to stderr timers, a host may define them first (see util/Profiler.hpp).
+            if (_profile) {
+                _header.emplace_back("#ifndef prof_enter");
+                // Start times are kept on a per-thread stack, so nested and OpenMP regions time independently.
+                _header.emplace_back("#define PROF_DEPTH 64");
+                _header.emplace_back("static __thread struct timespec __prof_t__[PROF_DEPTH];");
+                _header.emplace_back("static __thread int __prof_n__;");
+                _header.emplace_back("#define prof_enter(name) clock_gettime(CLOCK_MONOTONIC_RAW,"
+                                     "&__prof_t__[__prof_n__++%PROF_DEPTH])");
+                _header.emplace_back("#define prof_exit(name) do{struct timespec __t1__,*__t0__;"
+                                     "clock_gettime(CLOCK_MONOTONIC_RAW,&__t1__);"
+                                     "__t0__=&__prof_t__[--__prof_n__%PROF_DEPTH];"
+                                     "fprintf(stderr,\"[ PROFILE ] %s: %.9lf sec\\n\",(name),"
+                                     "(double)(__t1__.tv_sec-__t0__->tv_sec)+"
+                                     "1E-9*(__t1__.tv_nsec-__t0__->tv_nsec));}while(0)");
+                _header.emplace_back("#endif");
+                _header.emplace_back("");
+            }
+        }
+
         void addDefines() {
             for (const auto& itr : _poly.macros()) {
                 define(itr);
@@ -429,25 +466,66 @@ namespace pdfg {
             }
         }
 
-        void updateComp(Comp* comp, vector<string>& names,
-                        map<string, vector<string> >& statements,
-                        map<string, vector<string> >& guards,
-                        map<string, vector<string> >& schedules) {
+        bool isShared(DataNode* node) const {
+            string buffer = node->attr("buffer");
+            return !buffer.empty() && buffer != node->label();
+        }
+
+        // A shared buffer holds stale data from its previous owner, so reset it where its new lifetime begins.
+        string initShared(CompNode* node) {
+            vector<Edge*> edges = _graph->inedges(node);
+            vector<Edge*> outs = _graph->outedges(node);
+            edges.insert(edges.end(), outs.begin(), outs.end());
+
+            string init;
+            for (Edge* edge : edges) {
+                Node* other = (edge->source() == node) ? edge->dest() : edge->source();
+                if (other->is_data()) {
+                    DataNode* data = (DataNode*) other;
+                    if (isShared(data) && !data->defval().empty() && _inits.find(data->label()) == _inits.end()) {
+                        ostringstream os;
+                        os << "arrinit(" << data->label() << ',' << data->defval() << ',' << *data->size() << ");\n";
+                        init += os.str();
+                        _inits[data->label()] = true;
+                    }
+                }
+            }
+            return init;
+        }
+
+        void updateComp(Comp* comp, CodeGenRequest& request) {
             //string iegstr = Strings::replace(comp.space().to_iegen(), "N/8", "N_R");
-            string iegstr = comp->space().to_iegen();
-            string norm = _poly.add(iegstr);
             string sname = comp->space().name();
 
-            names.push_back(sname);
+            request.sets.push_back(comp->space().to_iegen());
+            request.names.push_back(sname);
             for (const Constr& guard : comp->guards()) {
-                guards[sname].emplace_back(stringify<Constr>(guard));
+                request.guards[sname].emplace_back(stringify<Constr>(guard));
             }
             for (const Math& statement : comp->statements()) {
-                statements[sname].emplace_back(stringify<Math>(statement));
+                request.statements[sname].emplace_back(stringify<Math>(statement));
             }
             for (const auto& schedule : comp->schedules()) {
-                schedules[sname].push_back(schedule.to_iegen());
+                request.schedules[sname].push_back(schedule.to_iegen());
+            }
+        }
+
+        void addLoops() {
+            vector<CodeGenResult> results = PolyLib::codegen(_requests);
+            for (size_t i = 0; i < results.size(); i++) {
+                string& code = _body[_slots[i]];
+                code += results[i].code;
+                if (_profile) {
+                    if (!code.empty() && code[code.size() - 1] != '\n') {
+                        code += '\n';
+                    }
+                    code += "prof_exit(\"" + _regions[i] + "\");";
+                }
+                _poly.addMacros(_poly.macros(), results[i].macros);
             }
+            _requests.clear();
+            _slots.clear();
+            _regions.clear();
         }
 
         void addMappings(CompNode* node) {
@@ -515,6 +593,7 @@ namespace pdfg {
         string _ompsched;
 
         map<string, string> _mappings;
+        map<string, bool> _inits;
         vector<pair<string, string> > _defines;
         vector<pair<string, string> > _typedefs;
         vector<pair<string, string> > _functions;
@@ -524,8 +603,13 @@ namespace pdfg {
         vector<string> _params;
         vector<string> _body;
         vector<string> _allocs;
+        vector<string> _aliases;
         vector<string> _frees;
 
+        vector<CodeGenRequest> _requests;
+        vector<size_t> _slots;
+        vector<string> _regions;
+
         PolyLib _poly;
     };
 
@@ -950,6 +1034,131 @@ namespace pdfg {
             }
         }
     };
+
+    struct LivenessVisitor : public DFGVisitor {
+    public:
+        explicit LivenessVisitor() {
+        }
+
+        void setup(FlowGraph* graph) override {
+            _graph = graph;
+            _order.clear();
+            _live.clear();
+        }
+
+        /// Number each computation node in schedule order, which is the order CodeGenVisitor emits loop nests.
+        /// \param node Computation node
+        void enter(CompNode* node) override {
+            unsigned pos = _order.size();
+            _order[node->label()] = pos;
+        }
+
+        /// Compute the live interval [first, last] of each temporary data node, i.e., the positions of the
+        /// first and last computations that produce or consume it.
+        void finish(FlowGraph* graph) override {
+            for (Node* node : graph->nodes()) {
+                if (node->is_data() && isTemp((DataNode*) node)) {
+                    pair<unsigned, unsigned> interval(_order.size(), 0);
+                    for (Edge* edge : graph->inedges(node)) {
+                        extend(edge->source(), interval);
+                    }
+                    for (Edge* edge : graph->outedges(node)) {
+                        extend(edge->dest(), interval);
+                    }
+                    if (interval.first <= interval.second) {
+                        // A value read in a later iteration of an enclosing (e.g., time) loop must survive every
+                        // computation in that loop, so keep such a temporary live for the whole schedule.
+                        if (carried((DataNode*) node)) {
+                            interval = make_pair(0u, (unsigned) _order.size() - 1);
+                        }
+                        _live[node->label()] = interval;
+                    }
+                }
+            }
+        }
+
+        const map<string, pair<unsigned, unsigned> >& liveness() const {
+            return _live;
+        }
+
+    protected:
+        // Only dynamically allocated temporaries are candidates, inputs and outputs belong to the caller.
+        bool isTemp(DataNode* node) {
+            return !_graph->isReturn(node) && !_graph->isSource(node) && !_graph->isSink(node) &&
+                   _graph->output(node->label()) < 0 && node->alloc() == DYNAMIC && !node->is_scalar();
+        }
+
+        // True if any computation accesses the node at a nonzero offset, e.g., x(t-1,i).
+        bool carried(DataNode* node) {
+            vector<Edge*> edges = _graph->inedges(node);
+            vector<Edge*> outs = _graph->outedges(node);
+            edges.insert(edges.end(), outs.begin(), outs.end());
+            for (Edge* edge : edges) {
+                Node* other = (edge->source() == node) ? edge->dest() : edge->source();
+                if (other->is_comp()) {
+                    for (Access* access : ((CompNode*) other)->accesses(node->label())) {
+                        for (int offset : to_int(access->tuple())) {
+                            if (offset != 0) {
+                                return true;
+                            }
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+
+        void extend(Node* node, pair<unsigned, unsigned>& interval) {
+            auto itr = _order.find(node->label());
+            if (itr != _order.end()) {
+                interval.first = (itr->second < interval.first) ? itr->second : interval.first;
+                interval.second = (itr->second > interval.second) ? itr->second : interval.second;
+            }
+        }
+
+        map<string, unsigned> _order;
+        map<string, pair<unsigned, unsigned> > _live;
+    };
+
+    struct MemShareVisitor : public LivenessVisitor {
+    public:
+        explicit MemShareVisitor() {
+        }
+
+        /// Assign temporaries with disjoint live intervals to shared buffers (left-edge interval coloring).
+        /// Each node is tagged with a 'buffer' attribute naming the node that owns its allocation.
+        void finish(FlowGraph* graph) override {
+            LivenessVisitor::finish(graph);
+
+            vector<pair<unsigned, string> > starts;
+            for (const auto& itr : _live) {
+                starts.push_back(make_pair(itr.second.first, itr.first));
+            }
+            std::sort(starts.begin(), starts.end());
+
+            // Buffers are only shared among nodes of the same type and size, each tracks (owner, last use).
+            map<string, vector<pair<string, unsigned> > > buffers;
+            for (const auto& start : starts) {
+                DataNode* node = (DataNode*) graph->get(start.second);
+                string key = node->datatype() + ":" + stringify<Expr>(*node->size());
+                unsigned last = _live[start.second].second;
+
+                bool shared = false;
+                for (auto& buffer : buffers[key]) {
+                    if (buffer.second < start.first) {
+                        node->attr("buffer", buffer.first);
+                        buffer.second = last;
+                        shared = true;
+                        break;
+                    }
+                }
+                if (!shared) {
+                    node->attr("buffer", node->label());
+                    buffers[key].push_back(make_pair(node->label(), last));
+                }
+            }
+        }
+    };
 }
 
 #endif  // POLYEXT_VISITOR_H
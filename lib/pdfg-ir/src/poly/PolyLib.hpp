@@ -1,15 +1,174 @@
 #ifndef POLYLIB_HPP
 #define POLYLIB_HPP
 
+#include <list>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <iegenlib/IEGenLib.hpp>
 #include <omega/OmegaLib.hpp>
 
+using std::list;
+using std::lock_guard;
+using std::mutex;
 using std::string;
+using std::unordered_map;
 using iegen::IEGenLib;
 using omglib::OmegaLib;
 
 namespace poly {
+    /// One loop nest to generate: the iegen sets and their names, plus the per-set statements, guards,
+    /// and schedules that are passed through to PolyLib::codegen.
+    struct CodeGenRequest {
+        vector<string> sets;
+        vector<string> names;
+        map<string, vector<string> > statements;
+        map<string, vector<string> > guards;
+        map<string, vector<string> > schedules;
+        string ompSched;
+        /// Loop nest already generated for a box or triangular space, skips IEGenLib and Omega.
+        string loops;
+
+        /// Canonical form of the request, every field is length-prefixed so distinct requests never collide.
+        string key() const {
+            ostringstream os;
+            add(os, ompSched);
+            add(os, loops);
+            os << sets.size() << '|';
+            for (const string& set : sets) {
+                add(os, set);
+            }
+            os << names.size() << '|';
+            for (const string& name : names) {
+                add(os, name);
+                add(os, statements, name);
+                add(os, guards, name);
+                add(os, schedules, name);
+            }
+            return os.str();
+        }
+
+    protected:
+        static void add(ostringstream& os, const string& item) {
+            os << item.size() << ':' << item;
+        }
+
+        static void add(ostringstream& os, const map<string, vector<string> >& items, const string& name) {
+            auto itr = items.find(name);
+            if (itr == items.end()) {
+                os << "0|";
+            } else {
+                os << itr->second.size() << '|';
+                for (const string& item : itr->second) {
+                    add(os, item);
+                }
+            }
+        }
+    };
+
+    /// Generated code for a request, and the macros (uninterpreted functions and guards) it relies on.
+    struct CodeGenResult {
+        string code;
+        map<string, string> macros;
+    };
+
+    /// Process-wide memo of generated loop nests, so identical spaces are only sent through Omega once.
+    /// Holds at most capacity() results and evicts the least recently used beyond that.
+    class CodeGenCache {
+    public:
+        static CodeGenCache& get() {
+            static CodeGenCache instance;
+            return instance;
+        }
+
+        CodeGenCache(CodeGenCache const&) = delete;
+
+        void operator=(CodeGenCache const&) = delete;
+
+        bool find(const string& key, CodeGenResult& result) {
+            lock_guard<mutex> lock(_mutex);
+            auto itr = _results.find(key);
+            if (itr == _results.end()) {
+                _misses += 1;
+                return false;
+            }
+            _hits += 1;
+            _uses.splice(_uses.begin(), _uses, itr->second.use);
+            result = itr->second.result;
+            return true;
+        }
+
+        void insert(const string& key, const CodeGenResult& result) {
+            lock_guard<mutex> lock(_mutex);
+            auto itr = _results.find(key);
+            if (itr != _results.end()) {
+                itr->second.result = result;
+                _uses.splice(_uses.begin(), _uses, itr->second.use);
+                return;
+            }
+            _uses.push_front(key);
+            _results[key] = {result, _uses.begin()};
+            evict();
+        }
+
+        void clear() {
+            lock_guard<mutex> lock(_mutex);
+            _results.clear();
+            _uses.clear();
+            _hits = _misses = 0;
+        }
+
+        unsigned hits() {
+            lock_guard<mutex> lock(_mutex);
+            return _hits;
+        }
+
+        unsigned misses() {
+            lock_guard<mutex> lock(_mutex);
+            return _misses;
+        }
+
+        unsigned size() {
+            lock_guard<mutex> lock(_mutex);
+            return _results.size();
+        }
+
+        unsigned capacity() {
+            lock_guard<mutex> lock(_mutex);
+            return _capacity;
+        }
+
+        void capacity(unsigned capacity) {
+            lock_guard<mutex> lock(_mutex);
+            _capacity = capacity;
+            evict();
+        }
+
+    protected:
+        struct Entry {
+            CodeGenResult result;
+            list<string>::iterator use;
+        };
+
+        CodeGenCache() : _capacity(256), _hits(0), _misses(0) {
+        }
+
+        /// Drops least recently used results until the cache fits its capacity, with _mutex held.
+        void evict() {
+            while (_results.size() > _capacity) {
+                _results.erase(_uses.back());
+                _uses.pop_back();
+            }
+        }
+
+        mutex _mutex;
+        unordered_map<string, Entry> _results;
+        list<string> _uses;         // keys, most recently used first
+        unsigned _capacity;
+        unsigned _hits;
+        unsigned _misses;
+    };
+
     struct PolyLib {
     protected:
         const int _max_iters = 10;      // TODO: Actually calculate this from the relation...
@@ -182,31 +341,95 @@ namespace poly {
                        const string& ompSched = "", const string& iterType = "", bool defineMacros = false) {
             string code = codegen(names, schedules);
             if (code.find("ERROR") == string::npos) {
-                string outIters = out_iterators(code);
-
-                if (!ompSched.empty()) {
-                    addPragma(ompSched, outIters, code);
-                }
-
-                if (!iterType.empty() && !outIters.empty()) {
-                    code = iterType + " " + outIters + ";\n" + code;
-                }
-
                 if (defineMacros) {
                     addMacros(_macros, _omega.macros());
                 }
+                code = decorate(code, names, statements, guards, schedules, ompSched, iterType);
+            }
+
+            return code;
+        }
+
+        /// Add the OpenMP pragma, iterator declarations, and statement macros to a generated loop nest.
+        string decorate(const string& loops, vector<string>& names, map<string, vector<string> >& statements,
+                        map<string, vector<string> >& guards, map<string, vector<string> >& schedules,
+                        const string& ompSched = "", const string& iterType = "") {
+            string code = loops;
+            string outIters = out_iterators(code);
 
-                string defines = "";
-                unsigned nstatements = 0;
-                for (const string& setname : names) {
-                    addStatements(nstatements, statements[setname], guards[setname], schedules[setname], defines);
-                    nstatements += statements[setname].size();
+            if (!ompSched.empty()) {
+                addPragma(ompSched, outIters, code);
+            }
+
+            if (!iterType.empty() && !outIters.empty()) {
+                code = iterType + " " + outIters + ";\n" + code;
+            }
+
+            string defines = "";
+            unsigned nstatements = 0;
+            for (const string& setname : names) {
+                addStatements(nstatements, statements[setname], guards[setname], schedules[setname], defines);
+                nstatements += statements[setname].size();
+            }
+
+            return defines + "\n" + code;
+        }
+
+        /// Generate a single request on this instance.
+        CodeGenResult codegen(CodeGenRequest& request) {
+            CodeGenResult result;
+            if (!request.loops.empty()) {
+                result.code = decorate(request.loops, request.names, request.statements, request.guards,
+                                       request.schedules, request.ompSched);
+                result.macros = _macros;
+                return result;
+            }
+
+            for (const string& set : request.sets) {
+                add(set);
+            }
+
+            result.code = codegen(request.names, request.statements, request.guards, request.schedules,
+                                  request.ompSched, "", true);
+            result.macros = _macros;
+            return result;
+        }
+
+        /// Generate a batch of independent requests. Results are memoized in the CodeGenCache, duplicate
+        /// requests within the batch are generated once, and each remaining miss gets a fresh PolyLib.
+        /// IEGenLib (currentEnv) and the Omega calculator keep process-wide state, so misses run serially.
+        static vector<CodeGenResult> codegen(vector<CodeGenRequest>& requests) {
+            vector<CodeGenResult> results(requests.size());
+            CodeGenCache& cache = CodeGenCache::get();
+
+            vector<string> keys;
+            vector<vector<size_t> > groups;
+            unordered_map<string, size_t> slots;
+            for (size_t i = 0; i < requests.size(); i++) {
+                string key = requests[i].key();
+                auto itr = slots.find(key);
+                if (itr != slots.end()) {
+                    groups[itr->second].push_back(i);
+                } else if (!cache.find(key, results[i])) {
+                    slots[key] = keys.size();
+                    keys.push_back(key);
+                    groups.push_back({i});
                 }
+            }
+
+            for (size_t n = 0; n < groups.size(); n++) {
+                size_t first = groups[n][0];
+                PolyLib poly;
+                results[first] = poly.codegen(requests[first]);
 
-                code = defines + "\n" + code;
+                const CodeGenResult& result = results[first];
+                cache.insert(keys[n], result);
+                for (size_t i = 1; i < groups[n].size(); i++) {
+                    results[groups[n][i]] = result;
+                }
             }
 
-            return code;
+            return results;
         }
 
         string codegen(const string& setName, const string& iterType, const string& ompSched = "",
@@ -0,0 +1,265 @@
+#ifndef _BENCHREPORT_HPP_
+#define _BENCHREPORT_HPP_
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+using std::ifstream;
+using std::ofstream;
+#include <iomanip>
+#include <iostream>
+using std::cerr;
+using std::endl;
+using std::ostream;
+#include <map>
+using std::map;
+#include <sstream>
+using std::ostringstream;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include <util/Stats.hpp>
+
+namespace util {
+    /// One benchmark measurement: timing statistics plus the rates derived from the performance model.
+    struct BenchResult {
+        string name;
+        unsigned threads = 1;
+        Stats stats;
+        double bytes = 0.0;         // Memory traffic per run (Q), e.g. from PerfModelVisitor sizes.
+        double flops = 0.0;         // Work per run (W).
+
+        double gbytes() const {
+            return (bytes > 0.0 && stats.median > 0.0) ? bytes / stats.median * 1E-9 : 0.0;
+        }
+
+        double gflops() const {
+            return (flops > 0.0 && stats.median > 0.0) ? flops / stats.median * 1E-9 : 0.0;
+        }
+
+        /// Key used to match results against a baseline.
+        string key() const {
+            return name + "@" + std::to_string(threads);
+        }
+
+        friend ostream& operator<<(ostream& os, const BenchResult& res) {
+            os << std::setprecision(9)
+               << "{\"name\": \"" << res.name << "\", \"threads\": " << res.threads
+               << ", \"runs\": " << res.stats.runs << ", \"outliers\": " << res.stats.outliers
+               << ", \"median\": " << res.stats.median << ", \"mad\": " << res.stats.mad
+               << ", \"mean\": " << res.stats.mean << ", \"ci\": " << res.stats.ci
+               << ", \"min\": " << res.stats.min << ", \"max\": " << res.stats.max
+               << ", \"bytes\": " << res.bytes << ", \"flops\": " << res.flops
+               << ", \"gbytes\": " << res.gbytes() << ", \"gflops\": " << res.gflops() << "}";
+            return os;
+        }
+    };
+
+    /// Collection of results that can be written to and read from JSON, and compared against a baseline.
+    class BenchReport {
+    public:
+        void add(const BenchResult& result) {
+            _results.push_back(result);
+        }
+
+        const vector<BenchResult>& results() const {
+            return _results;
+        }
+
+        bool save(const string& path) const {
+            ofstream fout(path.c_str());
+            if (!fout) {
+                cerr << "[ BENCH ] Unable to write '" << path << "'" << endl;
+                return false;
+            }
+            fout << *this;
+            return true;
+        }
+
+        bool load(const string& path) {
+            ifstream fin(path.c_str());
+            if (!fin) {
+                return false;
+            }
+            ostringstream os;
+            os << fin.rdbuf();
+            return parse(os.str());
+        }
+
+        /// Parse the JSON written by operator<<, unknown keys are ignored.
+        bool parse(const string& json) {
+            _results.clear();
+            size_t pos = json.find('[');
+            if (pos == string::npos) {
+                return false;
+            }
+            while ((pos = json.find('{', pos)) != string::npos) {
+                size_t end = json.find('}', pos);
+                if (end == string::npos) {
+                    return false;
+                }
+                map<string, string> fields = parseObject(json.substr(pos + 1, end - pos - 1));
+                BenchResult res;
+                res.name = fields["name"];
+                res.threads = (unsigned) number(fields["threads"]);
+                res.stats.runs = (unsigned) number(fields["runs"]);
+                res.stats.outliers = (unsigned) number(fields["outliers"]);
+                res.stats.median = number(fields["median"]);
+                res.stats.mad = number(fields["mad"]);
+                res.stats.mean = number(fields["mean"]);
+                res.stats.ci = number(fields["ci"]);
+                res.stats.min = number(fields["min"]);
+                res.stats.max = number(fields["max"]);
+                res.bytes = number(fields["bytes"]);
+                res.flops = number(fields["flops"]);
+                _results.push_back(res);
+                pos = end + 1;
+            }
+            return true;
+        }
+
+        /// Results that are slower than the baseline by more than 'tolerance' (relative) and by more than
+        /// the combined noise (MAD) of both measurements.
+        vector<string> regressions(const BenchReport& baseline, double tolerance = 0.05) const {
+            map<string, const BenchResult*> bases;
+            for (const BenchResult& res : baseline._results) {
+                bases[res.key()] = &res;
+            }
+
+            vector<string> slower;
+            for (const BenchResult& res : _results) {
+                auto itr = bases.find(res.key());
+                if (itr != bases.end()) {
+                    const Stats& base = itr->second->stats;
+                    double delta = res.stats.median - base.median;
+                    if (delta > tolerance * base.median && delta > res.stats.mad + base.mad) {
+                        ostringstream os;
+                        os << res.key() << ": " << res.stats.median << " s vs. baseline " << base.median
+                           << " s (+" << std::setprecision(3) << (delta / base.median) * 100.0 << "%)";
+                        slower.push_back(os.str());
+                    }
+                }
+            }
+            return slower;
+        }
+
+        friend ostream& operator<<(ostream& os, const BenchReport& report) {
+            os << "{\"results\": [";
+            for (size_t i = 0; i < report._results.size(); i++) {
+                os << (i > 0 ? ",\n  " : "\n  ") << report._results[i];
+            }
+            os << "\n]}\n";
+            return os;
+        }
+
+        /// Evaluate a size expression from the performance model, e.g. "(N+M*K)*8", binding named constants.
+        static double evaluate(const string& expr, const map<string, double>& consts) {
+            size_t pos = 0;
+            return sum(expr, pos, consts);
+        }
+
+    protected:
+        static map<string, string> parseObject(const string& body) {
+            map<string, string> fields;
+            size_t pos = 0;
+            while ((pos = body.find('"', pos)) != string::npos) {
+                size_t kend = body.find('"', pos + 1);
+                string key = body.substr(pos + 1, kend - pos - 1);
+                size_t vpos = body.find(':', kend) + 1;
+                while (vpos < body.size() && body[vpos] == ' ') {
+                    vpos += 1;
+                }
+                size_t vend;
+                if (body[vpos] == '"') {
+                    vend = body.find('"', vpos + 1);
+                    fields[key] = body.substr(vpos + 1, vend - vpos - 1);
+                    vend += 1;
+                } else {
+                    vend = body.find(',', vpos);
+                    if (vend == string::npos) {
+                        vend = body.size();
+                    }
+                    fields[key] = body.substr(vpos, vend - vpos);
+                }
+                pos = vend;
+            }
+            return fields;
+        }
+
+        static double number(const string& text) {
+            return text.empty() ? 0.0 : std::strtod(text.c_str(), nullptr);
+        }
+
+        static void skip(const string& expr, size_t& pos) {
+            while (pos < expr.size() && isspace(expr[pos])) {
+                pos += 1;
+            }
+        }
+
+        static double sum(const string& expr, size_t& pos, const map<string, double>& consts) {
+            double value = product(expr, pos, consts);
+            for (skip(expr, pos); pos < expr.size() && (expr[pos] == '+' || expr[pos] == '-'); skip(expr, pos)) {
+                char oper = expr[pos++];
+                double rhs = product(expr, pos, consts);
+                value = (oper == '+') ? value + rhs : value - rhs;
+            }
+            return value;
+        }
+
+        static double product(const string& expr, size_t& pos, const map<string, double>& consts) {
+            double value = factor(expr, pos, consts);
+            for (skip(expr, pos); pos < expr.size() && (expr[pos] == '*' || expr[pos] == '/'); skip(expr, pos)) {
+                char oper = expr[pos++];
+                double rhs = factor(expr, pos, consts);
+                value = (oper == '*') ? value * rhs : value / rhs;
+            }
+            return value;
+        }
+
+        static double factor(const string& expr, size_t& pos, const map<string, double>& consts) {
+            skip(expr, pos);
+            if (pos >= expr.size()) {
+                return 0.0;
+            }
+            char chr = expr[pos];
+            if (chr == '(') {
+                pos += 1;
+                double value = sum(expr, pos, consts);
+                skip(expr, pos);
+                pos += 1;       // ')'
+                return value;
+            }
+            if (chr == '-') {
+                pos += 1;
+                return -factor(expr, pos, consts);
+            }
+            size_t start = pos;
+            if (isdigit(chr) || chr == '.') {
+                while (pos < expr.size() && (isdigit(expr[pos]) || expr[pos] == '.')) {
+                    pos += 1;
+                }
+                return std::strtod(expr.substr(start, pos - start).c_str(), nullptr);
+            }
+            while (pos < expr.size() && (isalnum(expr[pos]) || expr[pos] == '_')) {
+                pos += 1;
+            }
+            string name = expr.substr(start, pos - start);
+            auto itr = consts.find(name);
+            if (itr == consts.end()) {
+                cerr << "[ BENCH ] Unbound constant '" << name << "' in '" << expr << "'" << endl;
+                if (name.empty()) {
+                    pos += 1;
+                }
+                return 0.0;
+            }
+            return itr->second;
+        }
+
+        vector<BenchResult> _results;
+    };
+}
+
+#endif // _BENCHREPORT_HPP_
@@ -110,6 +110,30 @@ public:
         return retval;
     }
 
+    /// Read the running counters without stopping them, in the order the events were added.
+    int read(vector<long long>& values) {
+        values.resize(_event_codes.size());
+        if (values.empty()) {
+            return PAPI_OK;
+        }
+        int retval = PAPI_read(_eventSet, (long_long*) values.data());
+        if (retval != PAPI_OK) {
+            error("Counter read failed", retval);
+        }
+        return retval;
+    }
+
+    vector<string> events() const {
+        vector<string> names;
+        char event_name[PAPI_MAX_STR_LEN];
+        for (int code : _event_codes) {
+            if (PAPI_event_code_to_name(code, event_name) == PAPI_OK) {
+                names.emplace_back(event_name);
+            }
+        }
+        return names;
+    }
+
     void report() {
         for (const auto& iter : _papi_data) {
             cout << iter.first << " = " << iter.second << endl;
@@ -2,6 +2,19 @@
 #define _PROFILER_HPP_
 
 #include <sys/time.h>
+#include <time.h>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#ifdef PAPI_ON
+#include <util/PAPI.hpp>
+#endif
 
 #define MICRO 1e-6
 #ifndef NULL
@@ -53,4 +66,261 @@ class Profiler
         struct timeval _stopTime;
 };
 
+namespace util {
+    /// Monotonic time in nanoseconds, not subject to NTP adjustments.
+    inline uint64_t nanotime() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+    }
+
+    /// Node in a call tree of named regions, owns its children. Movable but not copyable.
+    struct Region {
+        string name;
+        Region* parent;
+        uint64_t count;
+        uint64_t total;             // Inclusive nanoseconds.
+        uint64_t start;
+        vector<long long> counters; // Inclusive PAPI counter deltas.
+        vector<long long> marks;
+        map<string, unique_ptr<Region> > children;
+
+        explicit Region(const string& name = "", Region* parent = nullptr) :
+                name(name), parent(parent), count(0), total(0), start(0) {
+        }
+
+        Region(const Region&) = delete;
+
+        Region& operator=(const Region&) = delete;
+
+        Region(Region&& other) : parent(nullptr) {
+            *this = std::move(other);
+        }
+
+        Region& operator=(Region&& other) {
+            name = std::move(other.name);
+            parent = other.parent;
+            count = other.count;
+            total = other.total;
+            start = other.start;
+            counters = std::move(other.counters);
+            marks = std::move(other.marks);
+            children = std::move(other.children);
+            for (auto& itr : children) {
+                itr.second->parent = this;
+            }
+            return *this;
+        }
+
+        Region* child(const string& cname) {
+            unique_ptr<Region>& region = children[cname];
+            if (!region) {
+                region.reset(new Region(cname, this));
+            }
+            return region.get();
+        }
+
+        /// Exclusive nanoseconds, i.e., not spent in any child region.
+        uint64_t self() const {
+            uint64_t inner = 0;
+            for (const auto& itr : children) {
+                inner += itr.second->total;
+            }
+            return (inner < total) ? total - inner : 0;
+        }
+
+        void merge(const Region& other) {
+            count += other.count;
+            total += other.total;
+            if (counters.size() < other.counters.size()) {
+                counters.resize(other.counters.size(), 0);
+            }
+            for (size_t i = 0; i < other.counters.size(); i++) {
+                counters[i] += other.counters[i];
+            }
+            for (const auto& itr : other.children) {
+                child(itr.first)->merge(*itr.second);
+            }
+        }
+
+        void clear() {
+            children.clear();
+            count = total = 0;
+            counters.clear();
+        }
+    };
+
+    /// Hierarchical region profiler. Each thread records into its own call tree, so entering and exiting
+    /// regions never takes a lock; trees are only merged when a report is written, which should happen
+    /// after the profiled threads have joined.
+    class RegionProfiler {
+    public:
+        static RegionProfiler& get() {
+            static RegionProfiler instance;
+            return instance;
+        }
+
+        RegionProfiler(RegionProfiler const&) = delete;
+
+        void operator=(RegionProfiler const&) = delete;
+
+        ~RegionProfiler() {
+            for (Regions* regions : _threads) {
+                delete regions;
+            }
+        }
+
+        void enter(const string& name) {
+            Regions& regions = local();
+            Region* region = regions.current->child(name);
+            regions.current = region;
+#ifdef PAPI_ON
+            regions.papi.read(region->marks);
+#endif
+            region->start = nanotime();
+        }
+
+        void exit() {
+            uint64_t stop = nanotime();
+            Regions& regions = local();
+            Region* region = regions.current;
+            if (region->parent == nullptr) {
+                cerr << "[ PROFILE ] exit() without matching enter()" << endl;
+                return;
+            }
+            region->total += stop - region->start;
+            region->count += 1;
+#ifdef PAPI_ON
+            vector<long long> values;
+            regions.papi.read(values);
+            if (region->counters.size() < values.size()) {
+                region->counters.resize(values.size(), 0);
+            }
+            for (size_t i = 0; i < values.size() && i < region->marks.size(); i++) {
+                region->counters[i] += values[i] - region->marks[i];
+            }
+#endif
+            regions.current = region->parent;
+        }
+
+        /// Discard all recorded regions, no region may be open on any thread.
+        void clear() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (Regions* regions : _threads) {
+                regions->root.clear();
+                regions->current = &regions->root;
+            }
+        }
+
+        /// Call tree merged over all threads.
+        Region merged() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            Region root("all");
+            for (Regions* regions : _threads) {
+                root.merge(regions->root);
+            }
+            return root;
+        }
+
+        /// Indented tree of regions with call counts, inclusive and exclusive seconds.
+        void report(ostream& os) {
+            Region root = merged();
+            vector<string> events;
+#ifdef PAPI_ON
+            events = local().papi.events();
+#endif
+            os << std::left << std::setw(40) << "region" << std::right << std::setw(10) << "count"
+               << std::setw(14) << "total(s)" << std::setw(14) << "self(s)";
+            for (const string& event : events) {
+                os << std::setw(16) << event;
+            }
+            os << endl;
+            for (const auto& itr : root.children) {
+                report(os, *itr.second, 0, events.size());
+            }
+        }
+
+        /// Folded stacks ('a;b;c <usec>') of exclusive time, the input format of flamegraph.pl and speedscope.
+        void flamegraph(ostream& os) {
+            Region root = merged();
+            for (const auto& itr : root.children) {
+                flamegraph(os, *itr.second, "");
+            }
+        }
+
+    protected:
+        struct Regions {
+            Region root;
+            Region* current;
+#ifdef PAPI_ON
+            PAPI papi;
+#endif
+            Regions() : current(&root) {
+#ifdef PAPI_ON
+                papi.start();
+#endif
+            }
+        };
+
+        RegionProfiler() {
+        }
+
+        Regions& local() {
+            thread_local Regions* regions = nullptr;
+            if (regions == nullptr) {
+                regions = new Regions();
+                std::lock_guard<std::mutex> lock(_mutex);
+                _threads.push_back(regions);
+            }
+            return *regions;
+        }
+
+        void report(ostream& os, const Region& region, unsigned depth, size_t nevents) {
+            string label = string(depth * 2, ' ') + region.name;
+            os << std::left << std::setw(40) << label << std::right << std::setw(10) << region.count
+               << std::setw(14) << std::fixed << std::setprecision(6) << (double) region.total * 1E-9
+               << std::setw(14) << (double) region.self() * 1E-9;
+            for (size_t i = 0; i < nevents; i++) {
+                os << std::setw(16) << (i < region.counters.size() ? region.counters[i] : 0);
+            }
+            os << endl;
+            for (const auto& itr : region.children) {
+                report(os, *itr.second, depth + 1, nevents);
+            }
+        }
+
+        void flamegraph(ostream& os, const Region& region, const string& prefix) {
+            string stack = prefix.empty() ? region.name : prefix + ";" + region.name;
+            uint64_t usec = region.self() / 1000;
+            if (usec > 0) {
+                os << stack << ' ' << usec << endl;
+            }
+            for (const auto& itr : region.children) {
+                flamegraph(os, *itr.second, stack);
+            }
+        }
+
+        std::mutex _mutex;
+        vector<Regions*> _threads;
+    };
+
+    /// Region that is open for the lifetime of the scope.
+    struct ProfileScope {
+        explicit ProfileScope(const string& name) {
+            RegionProfiler::get().enter(name);
+        }
+
+        ~ProfileScope() {
+            RegionProfiler::get().exit();
+        }
+    };
+}
+
+// Markers emitted by CodeGenVisitor around each loop nest when profiling; including this header before
+// the generated code routes them into the RegionProfiler instead of the generated stderr timers.
+#ifndef prof_enter
+#define prof_enter(name) util::RegionProfiler::get().enter((name))
+#define prof_exit(name) util::RegionProfiler::get().exit()
+#endif
+
 #endif // _PROFILER_HPP_
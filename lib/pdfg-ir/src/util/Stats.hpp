@@ -0,0 +1,150 @@
+#ifndef _STATS_HPP_
+#define _STATS_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+using std::function;
+#include <vector>
+using std::vector;
+#include <time.h>
+
+namespace util {
+    /// Summary statistics of a set of timing samples (in seconds).
+    struct Stats {
+        unsigned runs = 0;          // Samples kept after outlier rejection.
+        unsigned outliers = 0;      // Samples rejected.
+        double median = 0.0;
+        double mad = 0.0;           // Median absolute deviation, scaled to estimate the standard deviation.
+        double mean = 0.0;
+        double stdev = 0.0;
+        double ci = 0.0;            // Half-width of the 95% confidence interval of the mean.
+        double min = 0.0;
+        double max = 0.0;
+
+        /// Relative half-width of the confidence interval.
+        double relci() const {
+            return (mean > 0.0) ? ci / mean : 0.0;
+        }
+
+        static double median_of(vector<double> values) {
+            if (values.empty()) {
+                return 0.0;
+            }
+            size_t mid = values.size() / 2;
+            std::nth_element(values.begin(), values.begin() + mid, values.end());
+            double med = values[mid];
+            if (values.size() % 2 == 0) {
+                med = (med + *std::max_element(values.begin(), values.begin() + mid)) * 0.5;
+            }
+            return med;
+        }
+
+        static double mad_of(const vector<double>& values, double med) {
+            vector<double> devs;
+            devs.reserve(values.size());
+            for (double value : values) {
+                devs.push_back(std::fabs(value - med));
+            }
+            return 1.4826 * median_of(devs);
+        }
+
+        /// Two-sided 95% critical value of Student's t distribution.
+        static double tcrit(unsigned dof) {
+            static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                           2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                           2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+            if (dof < 1) {
+                return 0.0;
+            }
+            return (dof <= 30) ? table[dof - 1] : 1.960;
+        }
+
+        /// Compute statistics over 'samples', rejecting those more than 'cutoff' MADs from the median.
+        static Stats compute(const vector<double>& samples, double cutoff = 3.0) {
+            Stats stats;
+            if (samples.empty()) {
+                return stats;
+            }
+
+            double med = median_of(samples);
+            double mad = mad_of(samples, med);
+            vector<double> kept;
+            for (double sample : samples) {
+                if (mad <= 0.0 || std::fabs(sample - med) <= cutoff * mad) {
+                    kept.push_back(sample);
+                }
+            }
+
+            stats.runs = kept.size();
+            stats.outliers = samples.size() - kept.size();
+            stats.median = median_of(kept);
+            stats.mad = mad_of(kept, stats.median);
+            stats.min = *std::min_element(kept.begin(), kept.end());
+            stats.max = *std::max_element(kept.begin(), kept.end());
+
+            double sum = 0.0;
+            for (double value : kept) {
+                sum += value;
+            }
+            stats.mean = sum / kept.size();
+
+            if (kept.size() > 1) {
+                double sqsum = 0.0;
+                for (double value : kept) {
+                    sqsum += (value - stats.mean) * (value - stats.mean);
+                }
+                stats.stdev = std::sqrt(sqsum / (kept.size() - 1));
+                stats.ci = tcrit(kept.size() - 1) * stats.stdev / std::sqrt((double) kept.size());
+            }
+
+            return stats;
+        }
+    };
+
+    /// Repeats a measurement after some warmup runs until the confidence interval of the mean is within
+    /// 'rel_ci' of the mean, or until 'max_runs' samples or 'max_time' seconds have been spent.
+    struct Sampler {
+        unsigned warmup = 0;
+        unsigned min_runs = 1;
+        unsigned max_runs = 1;
+        double max_time = 60.0;
+        double rel_ci = 0.02;
+        double cutoff = 3.0;
+
+        vector<double> samples;
+
+        /// 'run' performs one repetition and returns its time in seconds.
+        Stats measure(const function<double()>& run) {
+            samples.clear();
+            for (unsigned i = 0; i < warmup; i++) {
+                run();
+            }
+
+            Stats stats;
+            double spent = 0.0;
+            unsigned limit = std::max(max_runs, min_runs);
+            while (samples.size() < limit) {
+                double sample = run();
+                samples.push_back(sample);
+                spent += sample;
+                if (samples.size() >= min_runs) {
+                    stats = Stats::compute(samples, cutoff);
+                    if ((stats.runs > 1 && stats.relci() <= rel_ci) || spent >= max_time) {
+                        break;
+                    }
+                }
+            }
+
+            return Stats::compute(samples, cutoff);
+        }
+
+        static double now() {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (double) ts.tv_sec + ((double) ts.tv_nsec) * 1E-9;
+        }
+    };
+}
+
+#endif // _STATS_HPP_
@@ -1,6 +1,7 @@
 #ifndef _BENCHMARKTEST_HPP_
 #define _BENCHMARKTEST_HPP_
 
+#include <algorithm>
 #include <initializer_list>
 using std::initializer_list;
 #include <map>
@@ -34,7 +35,13 @@ using namespace testing;
 using util::PAPI;
 #endif
 
+#include <util/BenchReport.hpp>
+#include <util/Stats.hpp>
 #include <util/Strings.hpp>
+using util::BenchReport;
+using util::BenchResult;
+using util::Sampler;
+using util::Stats;
 
 #ifndef EPSILON
 #define EPSILON 0.001
@@ -60,20 +67,40 @@ namespace test {
 
         void NumRuns(unsigned nRuns) {
             _nRuns = nRuns;
+            _sampler.min_runs = _sampler.max_runs = nRuns;
         }
 
+        /// Repeat runs (at least nRuns, at most maxRuns or maxTime seconds) until the 95% confidence interval
+        /// of the mean is within relCI of the mean, after 'warmup' discarded runs.
+        void Adaptive(unsigned warmup = 2, double relCI = 0.02, unsigned maxRuns = 100, double maxTime = 30.0) {
+            _sampler.warmup = warmup;
+            _sampler.rel_ci = relCI;
+            _sampler.min_runs = std::max(_nRuns, 3u);
+            _sampler.max_runs = maxRuns;
+            _sampler.max_time = maxTime;
+        }
+
+        const Stats& RunStats() const {
+            return _runStats;
+        }
+
+        const Stats& EvalStats() const {
+            return _evalStats;
+        }
+
+        /// Speedup of the generated code over the reference (Evaluate) implementation, from median times.
         double Speedup() const {
-            double p = _runTime;
-            double s = _evalTime;
-            double r = 0.0;
-            //double n = (double) GetNumThreads();
-
-            // Amdahl's Law:
-            if (s != 0.0) {
-                r = (1.0 / (1.0 - p + (p/s)));
-            }
+            return (_runTime > 0.0) ? _evalTime / _runTime : 0.0;
+        }
+
+        /// Memory traffic (Q) and work (W) of one run, e.g. the PerfModelVisitor 'fsize_in'/'flops' attributes
+        /// evaluated with BenchReport::evaluate, used to report GB/s and GFLOP/s.
+        void Traffic(double bytes) {
+            _bytes = bytes;
+        }
 
-            return r;
+        void Work(double flops) {
+            _flops = flops;
         }
 
         virtual int MaxThreads() const {
@@ -99,7 +126,9 @@ namespace test {
         }
 
     protected:
-        BenchmarkTest(const string& name = "", unsigned nRuns = 1, unsigned nThreads = 1) : _name(name), _nRuns(nRuns) {
+        BenchmarkTest(const string& name = "", unsigned nRuns = 1, unsigned nThreads = 1) : _name(name), _nRuns(nRuns),
+            _nThreads(1), _runTime(0.0), _evalTime(0.0), _bytes(0.0), _flops(0.0) {
+            NumRuns(nRuns);
             NumThreads(nThreads);
         }
 
@@ -135,16 +164,13 @@ namespace test {
         }
 
         double Now() {
-            struct timeval tv;
-            gettimeofday(&tv, NULL);
-            return (double) tv.tv_sec + (((double) tv.tv_usec) * 1E-6);
+            return Sampler::now();
         }
 
         virtual void Execute() = 0;
 
         virtual void Run() {
-            double  timeSum = 0.0;
-            for (unsigned i = 0; i < _nRuns; i++) {
+            _runStats = _sampler.measure([this]() {
 #ifdef PAPI_ON
                 _papi.start();
 #endif
@@ -158,32 +184,84 @@ namespace test {
 #ifdef PAPI_ON
                 _papi.stop();
 #endif
-                timeSum += _runTime;
-            }
-            _runTime = timeSum / (double) _nRuns;
+                return _runTime;
+            });
+            _runTime = _runStats.median;
         }
 
         virtual void Evaluate() = 0;
 
         virtual void Verify() {
             double saveTime = _runTime;
-            double  timeSum = 0.0;
-            for (unsigned i = 0; i < _nRuns; i++) {
+            _evalStats = _sampler.measure([this]() {
                 Start();
                 Evaluate();
                 Stop();
-                timeSum += _runTime;
-            }
-            _evalTime = timeSum / (double) _nRuns;
+                return _runTime;
+            });
+            _evalTime = _evalStats.median;
             _runTime = saveTime;
 
-            GTEST_COUT << "RunTime(" << _nRuns << ") = " << _runTime << ", EvalTime = " << _evalTime
-                       << ", Ratio = " << _evalTime / _runTime << endl;
+            GTEST_COUT << "RunTime(" << _runStats.runs << ") = " << _runTime << " +/- " << _runStats.mad
+                       << ", EvalTime(" << _evalStats.runs << ") = " << _evalTime << " +/- " << _evalStats.mad
+                       << ", Speedup = " << Speedup() << endl;
 #ifdef PAPI_ON
             _papi.report();
 #endif
         }
 
+        /// Add the last Run() to the report, with rates derived from Traffic() and Work().
+        virtual BenchResult Record() {
+            BenchResult result;
+            result.name = _name;
+            result.threads = _nThreads;
+            result.stats = _runStats;
+            result.bytes = _bytes;
+            result.flops = _flops;
+            _report.add(result);
+            GTEST_COUT << _name << "(" << _nThreads << " threads): median = " << _runStats.median
+                       << " s, MAD = " << _runStats.mad << " s, CI = +/-" << _runStats.relci() * 100.0 << "%";
+            if (result.gbytes() > 0.0) {
+                cout << ", " << result.gbytes() << " GB/s";
+            }
+            if (result.gflops() > 0.0) {
+                cout << ", " << result.gflops() << " GFLOP/s";
+            }
+            cout << endl;
+            return result;
+        }
+
+        /// Run and record once per thread count.
+        virtual void Sweep(const vector<int>& threads) {
+            int saveThreads = _nThreads;
+            for (int nThreads : threads) {
+                if (NumThreads(nThreads)) {
+                    Run();
+                    Record();
+                }
+            }
+            NumThreads(saveThreads);
+        }
+
+        /// Write the recorded results as JSON. When 'baseline' exists, report results that regressed by
+        /// more than 'tolerance' and return their number.
+        virtual unsigned Report(const string& path, const string& baseline = "", double tolerance = 0.05) {
+            unsigned nslower = 0;
+            if (!baseline.empty()) {
+                BenchReport base;
+                if (base.load(baseline)) {
+                    for (const string& slower : _report.regressions(base, tolerance)) {
+                        GTEST_CERR << "Regression " << slower << endl;
+                        nslower += 1;
+                    }
+                }
+            }
+            if (!path.empty()) {
+                _report.save(path);
+            }
+            return nslower;
+        }
+
         virtual void Assert() {};
 
         virtual int Compare(const double* testData, const double* refData, unsigned size, double eps = EPSILON) {
@@ -230,6 +308,13 @@ namespace test {
         double _stopTime;
         double _runTime;
         double _evalTime;
+        double _bytes;
+        double _flops;
+
+        Sampler _sampler;
+        Stats _runStats;
+        Stats _evalStats;
+        BenchReport _report;
 
         map<string, string> _args;
 #ifdef PAPI_ON
@@ -6,12 +6,22 @@
 #include <pdfg/Codegen.hpp>
 #include <pdfg/GraphIL.hpp>
 #include <poly/PolyLib.hpp>
+#include <util/BenchReport.hpp>
+#include <util/Profiler.hpp>
 //#include <pdfg/FlowGraph.hpp>
 //#include <isl/IntSetLib.hpp>
 //#include <solve/Z3Lib.hpp>
 
 using namespace pdfg;
 using namespace poly;
+using util::BenchReport;
+using util::BenchResult;
+using util::ProfileScope;
+using util::Region;
+using util::RegionProfiler;
+using util::Sampler;
+using util::Stats;
+using util::nanotime;
 using namespace std;
 
 TEST(eDSLTest, Dense) {
@@ -24,6 +34,25 @@ TEST(eDSLTest, Dense) {
     ASSERT_EQ(result, expected);
 }
 
+TEST(eDSLTest, BoxLoops) {
+    Iter i("i"), j("j"), k("k");
+    Const N("N"), M("M");
+
+    // Box and triangular spaces skip Omega, but must print the same loops.
+    vector<Space> fast = {Space("Ibox", 0 <= i < N ^ 0 <= j < M), Space("Itri", 0 <= i < N ^ 0 <= j <= i),
+                          Space("Iupr", 0 <= i < N ^ i <= j < N ^ 0 <= k < M)};
+    for (const Space& space : fast) {
+        PolyLib poly;
+        poly.add(space.to_iegen());
+        ASSERT_FALSE(space.to_loops().empty());
+        ASSERT_EQ(space.to_loops(), poly.codegen(space.name()));
+    }
+
+    // Omega would tighten the outer loop to make the inner one non-empty.
+    Space strict("Istr", 0 <= i < N ^ 0 <= j < i);
+    ASSERT_TRUE(strict.to_loops().empty());
+}
+
 TEST(eDSLTest, COO) {
     Iter i("i"), n("n"), j("j");
     Func row("row"), col("col");
@@ -634,6 +663,43 @@ TEST(eDSLTest, CP_ALS) {
     ASSERT_TRUE(!result.empty());
 }
 
+TEST(eDSLTest, MemShare) {
+    Iter i('i');
+    Const N('N');
+    Space vec("vec", 0 <= i < N);
+    Space x("x", N), y("y", N), u("u", N), v("v", N), w("w", N);
+
+    init("memshare", "", "d", "", {"y"});
+    Comp usq("usq", vec, (u[i] = x[i] * x[i]));
+    Comp vadd("vadd", vec, (v[i] = u[i] + x[i]));
+    Comp wsq("wsq", vec, (w[i] = v[i] * v[i]));
+    Comp yadd("yadd", vec, (y[i] = w[i] + x[i]));
+
+    // 'u' is dead once 'vadd' completes, so 'w' can reuse its buffer.
+    string result = codegen();
+    //cerr << result << endl;
+    ASSERT_TRUE(result.find("double* w = u;") != string::npos);
+    ASSERT_TRUE(result.find("free(w)") == string::npos);
+}
+
+TEST(eDSLTest, MemShareTimeLoop) {
+    Iter t('t'), i('i');
+    Const N('N'), T('T');
+    Space vec("vec", 1 <= t <= T ^ 0 <= i < N);
+    Space x("x", N), y("y", T, N), u("u", T, N), v("v", T, N), w("w", T, N);
+
+    init("memshare_time", "", "d", "", {"y"});
+    Comp usq("usq", vec, (u(t,i) = x(i) * x(i)));
+    Comp vadd("vadd", vec, (v(t,i) = u(t-1,i) + x(i)));
+    Comp wsq("wsq", vec, (w(t,i) = v(t,i) * v(t,i)));
+    Comp yadd("yadd", vec, (y(t,i) = w(t,i) + x(i)));
+
+    // 'u' is read one time step after it is written, so its buffer must not be handed to 'w'.
+    string result = codegen();
+    //cerr << result << endl;
+    ASSERT_TRUE(result.find("double* w = u;") == string::npos);
+}
+
 TEST(eDSLTest, SGeMM) {
     // C(i,j) = C(i,j) * beta + alpha * A(i,k) * B(k,j)
 //    for (i = 0; i < N; i++) {
@@ -798,4 +864,169 @@ TEST(eDSLTest, CSR_BSR_Insp) {
     cerr << result << endl;
 
     ASSERT_TRUE(!result.empty());
-}
\ No newline at end of file
+}
+
+TEST(eDSLTest, ExprTree) {
+    Iter i('i');
+    Const N('N');
+    Space xt("xt", N), yt("yt", N);
+
+    // Structurally identical expressions share one node, and know which symbols they reference.
+    Math lhs = xt[i] * yt[i] + 1;
+    Math rhs = xt[i] * yt[i] + 1;
+    ASSERT_EQ(lhs.node(), rhs.node());
+    ASSERT_TRUE(lhs.equals(rhs));
+    ASSERT_TRUE(lhs.references("xt") && lhs.references("yt") && lhs.references("i"));
+    ASSERT_FALSE(lhs.references("x"));
+    ASSERT_NE(lhs.node(), (xt[i] * yt[i]).node());
+}
+
+TEST(eDSLTest, ExprTreeMutation) {
+    Iter i('i'), j('j');
+
+    // Changing an expression's text must drop the node built for its old text.
+    Func f("f", 1, {i});
+    ASSERT_TRUE(f.references("i"));
+    Func g = f;
+    ASSERT_TRUE(f.equals(g));
+    f.add(j);
+    f.eval();
+    ASSERT_FALSE(f.equals(g));
+    ASSERT_TRUE(f.references("j"));
+
+    Access a("xa", {i});
+    Access b("xb", {j});
+    ASSERT_TRUE(a.references("xa") && b.references("xb"));
+    Access c = a;
+    ASSERT_TRUE(a.equals(c));
+    a = b;
+    ASSERT_TRUE(a.equals(b));
+    ASSERT_FALSE(a.equals(c));
+    ASSERT_TRUE(a.references("xb") && !a.references("xa"));
+}
+
+TEST(eDSLTest, CodeGenCache) {
+    Iter i('i');
+    Const N('N');
+    Space vec("vec", 0 <= i < N);
+    Space x("x", N), y("y", N), z("z", N);
+
+    CodeGenCache& cache = CodeGenCache::get();
+    cache.clear();
+
+    init("cgcache");
+    Comp xmul("xmul", vec, (y[i] = x[i] * x[i]));
+    Comp yadd("yadd", vec, (z[i] = y[i] + x[i]));
+    string first = codegen();
+    unsigned misses = cache.misses();
+    ASSERT_EQ(cache.hits(), 0u);
+    ASSERT_EQ(cache.size(), misses);
+
+    // Rebuilding the same graph reuses every generated loop nest.
+    init("cgcache");
+    Comp xmul2("xmul", vec, (y[i] = x[i] * x[i]));
+    Comp yadd2("yadd", vec, (z[i] = y[i] + x[i]));
+    string second = codegen();
+    ASSERT_EQ(cache.hits(), misses);
+    ASSERT_EQ(first.substr(first.find('\n')), second.substr(second.find('\n')));
+
+    // A bounded cache drops the least recently used nests first.
+    unsigned capacity = cache.capacity();
+    cache.capacity(1);
+    ASSERT_EQ(cache.size(), 1u);
+    init("cgcache");
+    Comp xmul3("xmul", vec, (y[i] = x[i] * x[i]));
+    Comp yadd3("yadd", vec, (z[i] = y[i] + x[i]));
+    string third = codegen();
+    ASSERT_LE(cache.size(), 1u);
+    ASSERT_EQ(first.substr(first.find('\n')), third.substr(third.find('\n')));
+    cache.capacity(capacity);
+}
+
+TEST(eDSLTest, Profiler) {
+    Iter i('i');
+    Const N('N');
+    Space vec("vec", 0 <= i < N);
+    Space x("x", N), y("y", N), z("z", N);
+
+    init("profiled");
+    Comp xmul("xmul", vec, (y[i] = x[i] * x[i]));
+    Comp yadd("yadd", vec, (z[i] = y[i] + x[i]));
+    string result = codegen("out/profiled.c", "", "C", "", true);
+    //cerr << result << endl;
+    ASSERT_TRUE(result.find("#define prof_enter(name)") != string::npos);
+    ASSERT_TRUE(result.find("prof_enter(\"") != string::npos);
+    ASSERT_TRUE(result.find("prof_exit(\"") != string::npos);
+    ASSERT_TRUE(result.find("static __thread int __prof_n__;") != string::npos);
+
+    // Spin on the profiler's own clock, so each inner region lasts at least 1 ms.
+    RegionProfiler& profiler = RegionProfiler::get();
+    profiler.clear();
+    for (unsigned n = 0; n < 3; n++) {
+        ProfileScope outer("outer");
+        {
+            ProfileScope inner("inner");
+            uint64_t until = nanotime() + 1000000;
+            while (nanotime() < until);
+        }
+    }
+
+    ostringstream os;
+    profiler.flamegraph(os);
+    ASSERT_TRUE(os.str().find("outer;inner ") != string::npos);
+    Region root = profiler.merged();
+    Region* outer = root.children["outer"].get();
+    Region* inner = outer->children["inner"].get();
+    ASSERT_EQ(outer->count, 3u);
+    ASSERT_EQ(inner->count, 3u);
+    ASSERT_EQ(inner->parent, outer);
+    ASSERT_GE(inner->total, 3000000u);
+    ASSERT_GE(outer->total, inner->total);
+}
+
+TEST(eDSLTest, BenchStats) {
+    // The 5.0 sample is an outlier and should not move the median or the confidence interval.
+    Stats stats = Stats::compute({1.0, 1.1, 0.9, 1.05, 0.95, 5.0});
+    ASSERT_EQ(stats.runs, 5);
+    ASSERT_EQ(stats.outliers, 1);
+    ASSERT_NEAR(stats.median, 1.0, 1E-9);
+    ASSERT_NEAR(stats.mean, 1.0, 1E-9);
+    ASSERT_GT(stats.ci, 0.0);
+
+    // Constant samples converge as soon as the minimum number of runs is reached.
+    Sampler sampler;
+    sampler.warmup = 2;
+    sampler.min_runs = 3;
+    sampler.max_runs = 50;
+    unsigned calls = 0;
+    stats = sampler.measure([&calls]() { calls += 1; return 0.5; });
+    ASSERT_EQ(calls, 5);
+    ASSERT_EQ(stats.runs, 3);
+
+    map<string, double> consts = {{"N", 1000}, {"M", 10}};
+    ASSERT_EQ(BenchReport::evaluate("(N+M*2)*8", consts), 8160.0);
+
+    BenchResult base;
+    base.name = "spmv";
+    base.threads = 4;
+    base.stats = Stats::compute({1.0, 1.01, 0.99});
+    base.bytes = 8160.0;
+    BenchReport baseline;
+    baseline.add(base);
+
+    ostringstream os;
+    os << baseline;
+    BenchReport loaded;
+    ASSERT_TRUE(loaded.parse(os.str()));
+    ASSERT_EQ(loaded.results().size(), 1);
+    ASSERT_EQ(loaded.results()[0].key(), "spmv@4");
+    ASSERT_NEAR(loaded.results()[0].stats.median, 1.0, 1E-9);
+    ASSERT_NEAR(loaded.results()[0].gbytes(), 8.16E-6, 1E-12);
+
+    BenchResult slow = base;
+    slow.stats = Stats::compute({1.2, 1.21, 1.19});
+    BenchReport current;
+    current.add(slow);
+    ASSERT_EQ(current.regressions(loaded).size(), 1);
+    ASSERT_TRUE(loaded.regressions(loaded).empty());
+}
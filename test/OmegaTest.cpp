@@ -0,0 +1,634 @@
+#include <gtest/gtest.h>
+#include <omega.h>
+#include <omega/code_gen/include/codegen.h>
+#include <omega/omega_core/oc_i.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace omega;
+using std::string;
+using std::thread;
+using std::vector;
+
+static const char* varName(unsigned int v, void* args) {
+    static const char* names[] = {"0", "a", "b", "c", "d", "e"};
+    return names[v];
+}
+
+// 0 <= a - 2b, a - 2b <= k, a <= 3c, with a the only variable of interest.
+static void buildProblem(Problem& p, int k) {
+    p.nVars = 3;
+    p.safeVars = 1;
+    p.get_var_name = varName;
+    p.getVarNameArgs = NULL;
+    p.initializeVariables();
+    for (int i = 0; i <= 3; i++) {
+        p.var[i] = i;
+        p.forwardingAddress[i] = i;
+    }
+    int e = p.newGEQ();
+    eqnnzero(&p.GEQs[e], 3);
+    p.GEQs[e].coef[1] = 1;
+    p.GEQs[e].coef[2] = -2;
+    p.GEQs[e].touched = 1;
+    e = p.newGEQ();
+    eqnnzero(&p.GEQs[e], 3);
+    p.GEQs[e].coef[0] = k;
+    p.GEQs[e].coef[1] = -1;
+    p.GEQs[e].coef[2] = 2;
+    p.GEQs[e].touched = 1;
+    e = p.newGEQ();
+    eqnnzero(&p.GEQs[e], 3);
+    p.GEQs[e].coef[1] = -1;
+    p.GEQs[e].coef[3] = 3;
+    p.GEQs[e].touched = 1;
+}
+
+static string simplified(int k) {
+    Problem p(0, 4);
+    buildProblem(p, k);
+    if (!p.simplifyProblem(0, 0, 0)) {
+        return "FALSE";
+    }
+    return p.prettyPrintProblemToString();
+}
+
+// Problems simplified on two threads at once give what they give alone.
+TEST(OmegaTest, SimplifyConcurrent) {
+    const int kinds = 7, rounds = 300;
+    vector<string> expected;
+    for (int k = 0; k < kinds; k++) {
+        expected.push_back(simplified(k));
+    }
+    vector<string> results[2];
+    vector<thread> threads;
+    for (int t = 0; t < 2; t++) {
+        threads.push_back(thread([&results, t]() {
+            for (int r = 0; r < rounds; r++) {
+                results[t].push_back(simplified((r + t) % kinds));
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    for (int t = 0; t < 2; t++) {
+        ASSERT_EQ(rounds, (int) results[t].size());
+        for (int r = 0; r < rounds; r++) {
+            EXPECT_EQ(expected[(r + t) % kinds], results[t][r]);
+        }
+    }
+}
+
+// A problem made on a thread that has exited can still be used and copied.
+TEST(OmegaTest, ProblemOutlivesThread) {
+    Problem* p = NULL;
+    thread worker([&p]() {
+        p = new Problem(0, 4);
+        buildProblem(*p, 3);
+    });
+    worker.join();
+    Problem copy(*p);
+    ASSERT_TRUE(p->simplifyProblem(0, 0, 0));
+    ASSERT_TRUE(copy.simplifyProblem(0, 0, 0));
+    EXPECT_EQ(simplified(3), p->prettyPrintProblemToString());
+    EXPECT_EQ(p->prettyPrintProblemToString(),
+              copy.prettyPrintProblemToString());
+    delete p;
+}
+
+// 0 <= a_1 <= a_2 <= ... <= a_n <= 10 for some a, with x = a_1.
+static Relation chain(int n) {
+    Relation r(1);
+    F_Exists* ex = r.add_and()->add_exists();
+    vector<Variable_ID> a;
+    for (int i = 0; i < n; i++) {
+        a.push_back(ex->declare());
+    }
+    F_And* f = ex->add_and();
+    EQ_Handle x = f->add_EQ();
+    x.update_coef(r.set_var(1), 1);
+    x.update_coef(a[0], -1);
+    GEQ_Handle lo = f->add_GEQ();
+    lo.update_coef(a[0], 1);
+    GEQ_Handle hi = f->add_GEQ();
+    hi.update_coef(a[n - 1], -1);
+    hi.update_const(10);
+    for (int i = 0; i + 1 < n; i++) {
+        GEQ_Handle g = f->add_GEQ();
+        g.update_coef(a[i + 1], 1);
+        g.update_coef(a[i], -1);
+    }
+    return r;
+}
+
+// Conjunctions are not limited to a fixed number of variables.
+TEST(OmegaTest, ManyVariables) {
+    Relation small = chain(5);
+    small.simplify();
+    Relation large = chain(150);
+    large.simplify();
+    EXPECT_EQ(small.print_with_subs_to_string(),
+              large.print_with_subs_to_string());
+    EXPECT_TRUE(Must_Be_Subset(copy(large), copy(small)));
+    EXPECT_TRUE(Must_Be_Subset(copy(small), copy(large)));
+
+    Relation empty = chain(150);
+    GEQ_Handle g = empty.and_with_GEQ();
+    g.update_coef(empty.set_var(1), -1);
+    g.update_const(-11);
+    EXPECT_FALSE(empty.is_satisfiable());
+
+    const int n = 120;
+    Relation id(n, n);
+    F_And* f = id.add_and();
+    for (int i = 1; i <= n; i++) {
+        EQ_Handle e = f->add_EQ();
+        e.update_coef(id.input_var(i), 1);
+        e.update_coef(id.output_var(i), -1);
+    }
+    Relation twice = Composition(copy(id), copy(id));
+    EXPECT_EQ(n, twice.n_inp());
+    EXPECT_TRUE(Must_Be_Subset(copy(twice), copy(id)));
+    EXPECT_TRUE(Must_Be_Subset(copy(id), copy(twice)));
+}
+
+#if defined HAVE_WIDE_COEF && LONG_LONG_COEF
+// A combination that overflows coef_t is redone wide and divided by the
+// gcd of its variable coefficients, rounding the constant down.
+TEST(OmegaTest, CombineGEQOverflow) {
+    const coef_t big = static_cast<coef_t>(1) << 40;
+    EqnBuffer rows(3, 2);
+    eqn &a = rows[0], &b = rows[1], &d = rows[2];
+    eqnnzero(&a, 2);
+    eqnnzero(&b, 2);
+
+    // big * (-7 + 3big x + 6big y) + big * (1 + 3big x - 3big y)
+    //   = -6big + 6big^2 x + 3big^2 y >= 0, i.e. -1 + 2x + y >= 0
+    a.coef[0] = -7;
+    a.coef[1] = 3 * big;
+    a.coef[2] = 6 * big;
+    b.coef[0] = 1;
+    b.coef[1] = 3 * big;
+    b.coef[2] = -3 * big;
+    EXPECT_THROW(check_mul(a.coef[1], big), std::overflow_error);
+    combineGEQ(&d, &a, big, &b, big, 2);
+    EXPECT_EQ(-1, d.coef[0]);
+    EXPECT_EQ(2, d.coef[1]);
+    EXPECT_EQ(1, d.coef[2]);
+
+    // big * (big x + y) + (x) = (big^2 + 1) x + big y has no common factor
+    eqnnzero(&a, 2);
+    eqnnzero(&b, 2);
+    a.coef[1] = big;
+    a.coef[2] = 1;
+    b.coef[1] = 1;
+    EXPECT_THROW(combineGEQ(&d, &a, big, &b, 1, 2), std::overflow_error);
+
+    // without overflow the row is the plain combination, even in place
+    a.coef[0] = 5;
+    combineGEQ(&a, &a, 2, &b, 3, 2, -1);
+    EXPECT_EQ(9, a.coef[0]);
+    EXPECT_EQ(2 * big + 3, a.coef[1]);
+    EXPECT_EQ(2, a.coef[2]);
+}
+#endif
+
+typedef vector<coef_t> Row;
+
+static vector<Row> sorted(vector<Row> rows) {
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+// Normalizes and quick-kills the GEQs rows over n variables, leaving the
+// surviving rows sorted in kept.
+static int quickKilled(int n, const vector<Row>& rows, vector<Row>& kept) {
+    Problem p(0, rows.size());
+    p.reserveVars(n);
+    p.nVars = n;
+    p.safeVars = n;
+    p.initializeVariables();
+    p.varsOfInterest = n;
+    for (int i = 0; i <= n; i++) {
+        p.var[i] = i;
+        p.forwardingAddress[i] = i;
+    }
+    for (size_t r = 0; r < rows.size(); r++) {
+        int e = p.newGEQ();
+        eqnnzero(&p.GEQs[e], n);
+        for (int i = 0; i <= n; i++) {
+            p.GEQs[e].coef[i] = rows[r][i];
+        }
+        p.GEQs[e].touched = 1;
+        p.GEQs[e].color = EQ_BLACK;
+    }
+    EXPECT_NE(normalize_false, p.normalize());
+    int result = p.quickKill(0);
+    kept.clear();
+    for (int e = 0; e < p.nGEQs; e++) {
+        kept.push_back(Row(p.GEQs[e].coef, p.GEQs[e].coef + n + 1));
+    }
+    kept = sorted(kept);
+    return result;
+}
+
+// c + a x_i + b x_j over n variables.
+static Row row(int n, coef_t c, int i, coef_t a, int j = 0, coef_t b = 0) {
+    Row r(n + 1);
+    r[0] = c;
+    r[i] += a;
+    r[j] += b;
+    return r;
+}
+
+// Quick kill drops the GEQs implied by one or two others, and only those,
+// whichever signature word their variables fall in.
+TEST(OmegaTest, QuickKillRedundantGEQs) {
+    vector<Row> kept;
+
+    // x >= 0, y >= 0 imply x + y >= 0
+    EXPECT_EQ(2, quickKilled(2, {row(2, 0, 1, 1), row(2, 0, 2, 1),
+                                 row(2, 0, 1, 1, 2, 1)}, kept));
+    EXPECT_EQ(sorted({row(2, 0, 1, 1), row(2, 0, 2, 1)}), kept);
+
+    // x - y >= 0, y - z >= 0 imply x - z >= -2
+    quickKilled(3, {row(3, 0, 1, 1, 2, -1), row(3, 0, 2, 1, 3, -1),
+                    row(3, 2, 1, 1, 3, -1)}, kept);
+    EXPECT_EQ(sorted({row(3, 0, 1, 1, 2, -1), row(3, 0, 2, 1, 3, -1)}), kept);
+
+    // 2x + y >= 3, x + 2y >= 3 imply x + y >= 2
+    EXPECT_EQ(2, quickKilled(2, {row(2, -3, 1, 2, 2, 1),
+                                 row(2, -3, 1, 1, 2, 2),
+                                 row(2, -2, 1, 1, 2, 1)}, kept));
+    EXPECT_EQ(sorted({row(2, -3, 1, 2, 2, 1), row(2, -3, 1, 1, 2, 2)}), kept);
+
+    // x >= 0, y >= 0 say nothing about x - y >= -5
+    vector<Row> none = {row(2, 0, 1, 1), row(2, 0, 2, 1),
+                        row(2, 5, 1, 1, 2, -1)};
+    EXPECT_EQ(1, quickKilled(2, none, kept));
+    EXPECT_EQ(sorted(none), kept);
+
+    // x1 >= 0, x70 >= 0 imply x1 + x70 >= -1 across signature words
+    const int n = 70;
+    vector<Row> wide = {row(n, 0, 1, 1), row(n, 0, n, 1),
+                        row(n, 4, 65, -1), row(n, 0, 65, 1, 3, -1)};
+    vector<Row> rows = wide;
+    rows.push_back(row(n, 1, 1, 1, n, 1));
+    EXPECT_EQ(2, quickKilled(n, rows, kept));
+    EXPECT_EQ(sorted(wide), kept);
+}
+
+int omega_run(std::istream* is, std::ostream* os);
+extern CodeGenMemo codegenMemo;
+
+namespace omega {
+extern std::vector<std::vector<std::string> > loopIdxNames;
+}
+
+// {[i]: lo <= i <= hi} with the identity as its transformation.
+static void addStatement(vector<Relation>& xforms, vector<Relation>& IS,
+                         int lo, int hi) {
+    Relation s(1);
+    F_And* f = s.add_and();
+    GEQ_Handle l = f->add_GEQ();
+    l.update_coef(s.set_var(1), 1);
+    l.update_const(-lo);
+    GEQ_Handle h = f->add_GEQ();
+    h.update_coef(s.set_var(1), -1);
+    h.update_const(hi);
+    IS.push_back(s);
+    xforms.push_back(Identity(1));
+}
+
+// A hit returns the code a fresh CodeGen prints and leaves the globals be.
+TEST(OmegaTest, CodeGenMemoHit) {
+    vector<Relation> xforms, IS;
+    addStatement(xforms, IS, 0, 9);
+    addStatement(xforms, IS, 5, 14);
+    CodeGen codegen(xforms, IS);
+    CG_result* cgr = codegen.buildAST(1);
+    ASSERT_TRUE(cgr != NULL);
+    string expected = cgr->printString();
+    delete cgr;
+
+    CodeGenMemo memo(2);
+    string first, second;
+    ASSERT_TRUE(memo.printString(xforms, IS, Relation::Null(), 1, first));
+    loopIdxNames.assign(1, vector<string>(1, "x"));
+    ASSERT_TRUE(memo.printString(xforms, IS, Relation::Null(), 1, second));
+    EXPECT_EQ(expected, first);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(1, memo.hits());
+    EXPECT_EQ(1, memo.misses());
+    ASSERT_EQ(1u, loopIdxNames.size());
+    EXPECT_EQ("x", loopIdxNames[0][0]);
+
+    // other settings and efforts are other entries, and the oldest goes first
+    CodeGenMemo::IndexNames names(2, vector<string>(1, "x"));
+    ASSERT_TRUE(memo.printString(xforms, IS, Relation::Null(), 1, second,
+                                 CodeGenMemo::SplitLevels(), names));
+    EXPECT_EQ(2, memo.misses());
+    ASSERT_TRUE(memo.printString(xforms, IS, Relation::Null(), 2, second,
+                                 CodeGenMemo::SplitLevels(), names));
+    EXPECT_EQ(3, memo.misses());
+    EXPECT_EQ(2, memo.size());
+    ASSERT_TRUE(memo.printString(xforms, IS, Relation::Null(), 1, second));
+    EXPECT_EQ(4, memo.misses());
+    EXPECT_EQ(first, second);
+    EXPECT_EQ("x", loopIdxNames[0][0]);
+
+    // entries hold no relations, so they outlive the ones they came from
+    xforms.clear();
+    IS.clear();
+    addStatement(xforms, IS, 0, 9);
+    addStatement(xforms, IS, 5, 14);
+    ASSERT_TRUE(memo.printString(xforms, IS, Relation::Null(), 1, second));
+    EXPECT_EQ(2, memo.hits());
+    EXPECT_EQ(expected, second);
+    memo.clear();
+    EXPECT_EQ(0, memo.size());
+}
+
+// The code printed for a calculator script, without its echoed commands.
+static string runScript(const string& script) {
+    std::istringstream is(script);
+    std::ostringstream os;
+    omega_run(&is, &os);
+    std::istringstream out(os.str());
+    string line, code;
+    while (std::getline(out, line)) {
+        if (!line.empty() && line.compare(0, 3, ">>>") != 0) {
+            code += line + "\n";
+        }
+    }
+    return code;
+}
+
+// Split conditions built by negating a single GEQ give the code that
+// Complement/Difference gave.
+TEST(OmegaTest, CodeGenSplitConditions) {
+    EXPECT_EQ(
+        "for(t1 = M; t1 <= min(-1,N-1); t1++) {\n"
+        "  s1(t1);\n"
+        "}\n"
+        "for(t1 = 0; t1 <= min(M-1,N-1); t1++) {\n"
+        "  s0(t1);\n"
+        "  s2(t1);\n"
+        "}\n"
+        "for(t1 = max(M,0); t1 <= N-1; t1++) {\n"
+        "  s0(t1);\n"
+        "  s1(t1);\n"
+        "}\n"
+        "for(t1 = max(N,0); t1 <= M-1; t1++) {\n"
+        "  s2(t1);\n"
+        "}\n",
+        runScript("symbolic N,M;\n"
+                  "I1 := {[i]: 0 <= i < N};\n"
+                  "I2 := {[i]: M <= i < N};\n"
+                  "I3 := {[i]: 0 <= i < M};\n"
+                  "codegen I1,I2,I3;\n"));
+    EXPECT_EQ(
+        "for(t1 = 0; t1 <= min(4,N-1); t1++) {\n"
+        "  for(t2 = 0; t2 <= t1; t2++) {\n"
+        "    s0(t1,t2);\n"
+        "  }\n"
+        "}\n"
+        "for(t1 = 5; t1 <= N-1; t1++) {\n"
+        "  for(t2 = 0; t2 <= t1-6; t2++) {\n"
+        "    s0(t1,t2);\n"
+        "  }\n"
+        "  for(t2 = t1-5; t2 <= t1; t2++) {\n"
+        "    s0(t1,t2);\n"
+        "    s1(t1,t2);\n"
+        "  }\n"
+        "  for(t2 = t1+1; t2 <= N-1; t2++) {\n"
+        "    s1(t1,t2);\n"
+        "  }\n"
+        "}\n"
+        "for(t1 = max(N,5); t1 <= N+4; t1++) {\n"
+        "  for(t2 = t1-5; t2 <= N-1; t2++) {\n"
+        "    s1(t1,t2);\n"
+        "  }\n"
+        "}\n",
+        runScript("symbolic N;\n"
+                  "I1 := {[i,j]: 0 <= i < N && 0 <= j <= i};\n"
+                  "I2 := {[i,j]: 5 <= i < N+5 && i-5 <= j < N};\n"
+                  "codegen 2 I1,I2;\n"));
+    EXPECT_EQ(
+        "for(t1 = 0; t1 <= min(2,N-1,intFloor(M-1,2)); t1++) {\n"
+        "  for(t2 = 2*t1; t2 <= M-1; t2++) {\n"
+        "    s0(t1,t2);\n"
+        "  }\n"
+        "}\n"
+        "for(t1 = 3; t1 <= N-1; t1++) {\n"
+        "  for(t2 = 0; t2 <= min(M-1,2*t1-1); t2++) {\n"
+        "    s1(t1,t2);\n"
+        "  }\n"
+        "  for(t2 = 2*t1; t2 <= min(M-1,3*t1-1); t2++) {\n"
+        "    s0(t1,t2);\n"
+        "    s1(t1,t2);\n"
+        "  }\n"
+        "  for(t2 = 3*t1; t2 <= M-1; t2++) {\n"
+        "    s0(t1,t2);\n"
+        "  }\n"
+        "  for(t2 = max(0,M); t2 <= 3*t1-1; t2++) {\n"
+        "    s1(t1,t2);\n"
+        "  }\n"
+        "}\n",
+        runScript("symbolic N,M;\n"
+                  "I1 := {[i,j]: 0 <= i < N && 2i <= j < M};\n"
+                  "I2 := {[i,j]: 3 <= i < N && 0 <= j < 3i};\n"
+                  "codegen 2 I1,I2;\n"));
+}
+
+// Sibling subtrees built on helper threads come back in the same order.
+TEST(OmegaTest, CodeGenSiblingThreads) {
+    const string script =
+        "symbolic N,M;\n"
+        "A1 := {[i,j]: 0 <= i < N && 0 <= j < M};\n"
+        "A2 := {[i,j]: N <= i < 2N && 0 <= j < M};\n"
+        "A3 := {[i,j]: 2N <= i < 3N && 0 <= j <= i};\n"
+        "A4 := {[i,j]: 0 <= i < 10 && 0 <= j < 5};\n"
+        "A5 := {[i,j]: 20 <= i < 30 && 0 <= j < M};\n"
+        "codegen A1,A2,A3;\n"
+        "codegen A4,A5;\n"
+        "codegen A1,A2,A3,A4,A5;\n";
+    codegenMemo.clear();
+    string expected = runScript(script);
+    ASSERT_FALSE(expected.empty());
+    for (int threads = 2; threads <= 4; threads++) {
+        CodeGen::build_threads = threads;
+        codegenMemo.clear();
+        EXPECT_EQ(expected, runScript(script));
+    }
+    CodeGen::build_threads = 1;
+}
+
+// Calculator runs declare their own symbolics, yet a later run with the
+// same spaces reuses the code printed by an earlier one.
+TEST(OmegaTest, CodeGenMemoAcrossRuns) {
+    const string script =
+        "symbolic N;\n"
+        "I1 := {[i]: 0 <= i < N};\n"
+        "I2 := {[i]: 10 <= i < 2N};\n"
+        "codegen I1,I2;\n"
+        "codegen 2 I1,I2;\n";
+    codegenMemo.clear();
+    int hits = codegenMemo.hits(), misses = codegenMemo.misses();
+    string first = runScript(script);
+    ASSERT_FALSE(first.empty());
+    EXPECT_EQ(misses + 2, codegenMemo.misses());
+    EXPECT_EQ(2, codegenMemo.size());
+    EXPECT_EQ(first, runScript(script));
+    EXPECT_EQ(hits + 2, codegenMemo.hits());
+    EXPECT_EQ(misses + 2, codegenMemo.misses());
+    EXPECT_NE(first, runScript("symbolic M;\n"
+                               "I1 := {[i]: 0 <= i < M};\n"
+                               "I2 := {[i]: 10 <= i < 2M};\n"
+                               "codegen I1,I2;\n"));
+    EXPECT_EQ(misses + 3, codegenMemo.misses());
+}
+
+// in * i_level + out * i'_level + c = 0, or >= 0.
+struct Probe {
+    bool eq;
+    int level;
+    coef_t in, out, c;
+};
+
+// Whether r is satisfiable with the probes added, asked the usual way.
+static bool satisfiable(const Relation& r, const vector<Probe>& probes) {
+    Relation t = copy(r);
+    F_And* f = t.and_with_and();
+    for (size_t i = 0; i < probes.size(); i++) {
+        const Probe& p = probes[i];
+        Constraint_Handle h = p.eq ? (Constraint_Handle) f->add_EQ()
+                                   : (Constraint_Handle) f->add_GEQ();
+        h.update_coef(t.input_var(p.level), p.in);
+        h.update_coef(t.output_var(p.level), p.out);
+        h.update_const(p.c);
+    }
+    return t.is_satisfiable();
+}
+
+static void add(Relation_Solver& s, Relation& r, const Probe& p) {
+    Relation_Solver::Terms terms;
+    terms.push_back(std::make_pair(r.input_var(p.level), p.in));
+    terms.push_back(std::make_pair(r.output_var(p.level), p.out));
+    if (p.eq) {
+        s.add_EQ(terms, p.c);
+    } else {
+        s.add_GEQ(terms, p.c);
+    }
+}
+
+// A dependence [i,j] -> [i',j'] within 0 <= i,i' < N, 0 <= j,j' < 8.
+static Relation dependence(Free_Var_Decl& n, int kind) {
+    Relation r(2, 2);
+    F_Or* o = r.add_and()->add_or();
+    F_And* f = o->add_and();
+    for (int l = 1; l <= 2; l++) {
+        Variable_ID vs[] = {r.input_var(l), r.output_var(l)};
+        for (int v = 0; v < 2; v++) {
+            GEQ_Handle lo = f->add_GEQ();
+            lo.update_coef(vs[v], 1);
+            GEQ_Handle hi = f->add_GEQ();
+            hi.update_coef(vs[v], -1);
+            if (l == 1) {
+                hi.update_coef(r.get_local(&n), 1);
+                hi.update_const(-1);
+            } else {
+                hi.update_const(7);
+            }
+        }
+    }
+    Variable_ID i = r.input_var(1), i2 = r.output_var(1);
+    Variable_ID j = r.input_var(2), j2 = r.output_var(2);
+    if (kind == 0) {
+        // i' = i, j' > j
+        EQ_Handle e = f->add_EQ();
+        e.update_coef(i, 1);
+        e.update_coef(i2, -1);
+        GEQ_Handle g = f->add_GEQ();
+        g.update_coef(j2, 1);
+        g.update_coef(j, -1);
+        g.update_const(-1);
+    } else if (kind == 1) {
+        // i' = i + 2a, j' = j + 1
+        F_Exists* x = f->add_exists();
+        Variable_ID a = x->declare();
+        F_And* g = x->add_and();
+        EQ_Handle e = g->add_EQ();
+        e.update_coef(i2, 1);
+        e.update_coef(i, -1);
+        e.update_coef(a, -2);
+        e = g->add_EQ();
+        e.update_coef(j2, 1);
+        e.update_coef(j, -1);
+        e.update_const(-1);
+    } else if (kind == 2) {
+        // i' + j' = i + j, with i' >= i + 1 or i' <= i - 3
+        EQ_Handle e = f->add_EQ();
+        e.update_coef(i2, 1);
+        e.update_coef(j2, 1);
+        e.update_coef(i, -1);
+        e.update_coef(j, -1);
+        F_And* g = o->add_and();
+        GEQ_Handle h = g->add_GEQ();
+        h.update_coef(i2, 1);
+        h.update_coef(i, -1);
+        h.update_const(-1);
+        F_And* k = o->add_and();
+        h = k->add_GEQ();
+        h.update_coef(i, 1);
+        h.update_coef(i2, -1);
+        h.update_const(-3);
+    } else {
+        // 2i' = 2i + 3, which no integer pair meets
+        EQ_Handle e = f->add_EQ();
+        e.update_coef(i2, 2);
+        e.update_coef(i, -2);
+        e.update_const(-3);
+    }
+    r.finalize();
+    return r;
+}
+
+// Incremental answers agree with Relation::is_satisfiable() on the
+// direction probes relation2dependences makes and on pairs of them.
+TEST(OmegaTest, RelationSolverMatchesRelation) {
+    Free_Var_Decl n("N");
+    vector<Probe> probes;
+    for (int l = 1; l <= 2; l++) {
+        probes.push_back(Probe{false, l, 1, -1, -1});
+        probes.push_back(Probe{false, l, -1, 1, -1});
+        probes.push_back(Probe{true, l, 1, -1, 0});
+        probes.push_back(Probe{false, l, -1, 1, -4});
+    }
+    for (int kind = 0; kind < 4; kind++) {
+        Relation r = dependence(n, kind);
+        Relation_Solver s(r);
+        EXPECT_EQ(satisfiable(r, {}), s.is_satisfiable()) << kind;
+        for (size_t p = 0; p < probes.size(); p++) {
+            s.push();
+            add(s, r, probes[p]);
+            EXPECT_EQ(satisfiable(r, {probes[p]}), s.is_satisfiable())
+                << kind << " " << p;
+            for (size_t q = 0; q < probes.size(); q++) {
+                s.push();
+                add(s, r, probes[q]);
+                EXPECT_EQ(satisfiable(r, {probes[p], probes[q]}),
+                          s.is_satisfiable())
+                    << kind << " " << p << " " << q;
+                s.pop();
+            }
+            EXPECT_EQ(1, s.depth());
+            s.pop();
+        }
+        EXPECT_EQ(0, s.depth());
+    }
+}